@@ -0,0 +1,165 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+// Whole-frame benchmark: SampleBitMap drawing into a headless window, from
+// the posted draw command to the flushed buffer, with vsync taken out.
+// Usage: render_headless_bench [width height [frames]]
+#include "render/headless/headless_backend.h"
+#include "render/sample_bitmap.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <fcntl.h>
+#include <mutex>
+#include <unistd.h>
+
+namespace {
+
+class FrameWaiter : public FrameListener {
+public:
+    void OnFrameDone(void* request, bool presented, const FrameTiming& timing, RenderPath path) override
+    {
+        (void)request;
+        (void)path;
+        std::lock_guard<std::mutex> lock(mutex_);
+        done_++;
+        presented_ += presented ? 1 : 0;
+        total_.prepareUs += timing.prepareUs;
+        total_.rasterUs += timing.rasterUs;
+        total_.blitUs += timing.blitUs;
+        total_.flushUs += timing.flushUs;
+        changed_.notify_all();
+    }
+
+    void WaitFor(int count)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        changed_.wait(lock, [&] { return done_ >= count; });
+    }
+
+    // Summed over frames, then cleared
+    FrameTiming TakeTotal(int& presented)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        FrameTiming total = total_;
+        presented = presented_;
+        total_ = FrameTiming {};
+        presented_ = 0;
+        return total;
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    int done_ = 0;
+    int presented_ = 0;
+    FrameTiming total_ {};
+};
+
+// The renderer logs every frame to stdout; keep that out of the results
+class QuietStdout {
+public:
+    QuietStdout()
+    {
+        fflush(stdout);
+        saved_ = dup(STDOUT_FILENO);
+        int null = open("/dev/null", O_WRONLY);
+        if (null >= 0) {
+            dup2(null, STDOUT_FILENO);
+            close(null);
+        }
+    }
+
+    ~QuietStdout()
+    {
+        fflush(stdout);
+        if (saved_ >= 0) {
+            dup2(saved_, STDOUT_FILENO);
+            close(saved_);
+        }
+    }
+
+private:
+    int saved_ = -1;
+};
+
+void Run(const char* name, SampleBitMap& render, FrameWaiter& waiter, RenderCommandType type, int& posted,
+    int frames)
+{
+    int token = 0;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point end;
+    {
+        QuietStdout quiet;
+        // Warm-up: caches, atlas and buffer mappings
+        render.PostCommand(RenderCommand {type, nullptr, 0, 0, &token});
+        waiter.WaitFor(++posted);
+        int ignored = 0;
+        waiter.TakeTotal(ignored);
+
+        start = std::chrono::steady_clock::now();
+        // One at a time, so each frame is measured on its own rather than merged
+        for (int i = 0; i < frames; i++) {
+            render.PostCommand(RenderCommand {type, nullptr, 0, 0, &token});
+            waiter.WaitFor(++posted);
+        }
+        end = std::chrono::steady_clock::now();
+    }
+
+    int presented = 0;
+    FrameTiming total = waiter.TakeTotal(presented);
+    double us = std::chrono::duration<double, std::micro>(end - start).count() / frames;
+    printf("%-14s %9.1f us/frame  prepare %7.1f  raster %7.1f  blit %7.1f  flush %6.1f  (%d/%d presented)\n",
+        name, us, static_cast<double>(total.prepareUs) / frames, static_cast<double>(total.rasterUs) / frames,
+        static_cast<double>(total.blitUs) / frames, static_cast<double>(total.flushUs) / frames, presented, frames);
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    uint32_t width = 1280;
+    uint32_t height = 720;
+    int frames = 200;
+    if (argc >= 3) {
+        width = static_cast<uint32_t>(atoi(argv[1]));
+        height = static_cast<uint32_t>(atoi(argv[2]));
+    }
+    if (argc >= 4) {
+        frames = atoi(argv[3]);
+    }
+    if ((width == 0) || (height == 0) || (frames <= 0)) {
+        fprintf(stderr, "usage: %s [width height [frames]]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    HeadlessVsync::SetPeriod(std::chrono::nanoseconds(0));
+    printf("%ux%u, %d frames per case\n", width, height, frames);
+
+    const RenderCommandType types[] = {RenderCommandType::DRAW_PATTERN, RenderCommandType::DRAW_TEXT};
+    const char* names[] = {"pattern", "text"};
+    const int32_t formats[] = {NATIVEBUFFER_PIXEL_FMT_RGBA_8888, NATIVEBUFFER_PIXEL_FMT_BGRA_8888};
+    const char* formatNames[] = {"RGBA window, zero-copy", "BGRA window, staging"};
+    for (size_t f = 0; f < sizeof(formats) / sizeof(formats[0]); f++) {
+        printf("%s\n", formatNames[f]);
+        HeadlessWindow window(width, height, SampleBitMap::MAX_BUFFERS_IN_FLIGHT, formats[f]);
+        auto render = std::make_shared<SampleBitMap>("render_headless_bench");
+        FrameWaiter* waiter = new FrameWaiter();
+        render->SetFrameListener(std::unique_ptr<FrameListener>(waiter));
+        int posted = 0;
+        {
+            QuietStdout quiet;
+            render->PostCommand(RenderCommand {RenderCommandType::SURFACE_CREATED, window.GetNativeWindow(), width,
+                height, nullptr});
+        }
+        for (size_t t = 0; t < sizeof(types) / sizeof(types[0]); t++) {
+            Run(names[t], *render, *waiter, types[t], posted, frames);
+        }
+        QuietStdout quiet;
+        render->Shutdown();
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+// Benchmark for the tile rasterizer: one frame of filled and stroked
+// polygons, rasterized on the calling thread and on pools of growing size,
+// then on the calling thread at each anti-aliasing quality.
+// Usage: tile_raster_bench [width height [iterations]]
+#include "render/tile_raster.h"
+#include "render/work_stealing_pool.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <thread>
+#include <vector>
+
+namespace {
+
+struct Shape {
+    RasterPath path;
+    bool stroke;
+    uint32_t color;
+};
+
+// The pattern frame, scaled up to the surface, plus a field of small shapes
+std::vector<Shape> BuildScene(uint32_t width, uint32_t height)
+{
+    std::vector<Shape> scene;
+    uint32_t seed = 7;
+    auto next = [&seed](float range) {
+        seed = seed * 1664525u + 1013904223u;
+        return (seed >> 8) / static_cast<float>(1u << 24) * range;
+    };
+    for (int i = 0; i < 200; i++) {
+        Shape shape;
+        float cx = next(static_cast<float>(width));
+        float cy = next(static_cast<float>(height));
+        float radius = 20 + next(static_cast<float>(height) / 6);
+        int sides = 3 + static_cast<int>(next(6));
+        for (int s = 0; s < sides; s++) {
+            float angle = 6.2831853f * s / sides;
+            float x = cx + radius * std::cos(angle);
+            float y = cy + radius * std::sin(angle);
+            if (s == 0) {
+                shape.path.MoveTo(x, y);
+            } else {
+                shape.path.LineTo(x, y);
+            }
+        }
+        shape.path.Close();
+        shape.stroke = (i % 2) == 1;
+        shape.color = 0xC0000000 | static_cast<uint32_t>(next(16777216.0f));
+        scene.push_back(std::move(shape));
+    }
+    return scene;
+}
+
+double MeasureUs(int iterations, TileRasterizer& raster, const PixelSurface& surface,
+    const std::vector<Shape>& scene, WorkStealingPool* pool)
+{
+    auto frame = [&] {
+        raster.Begin(surface);
+        for (const Shape& shape : scene) {
+            if (shape.stroke) {
+                raster.Stroke(shape.path, 10.0f, shape.color);
+            } else {
+                raster.Fill(shape.path, shape.color);
+            }
+        }
+        raster.Flush(pool);
+    };
+    frame();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; i++) {
+        frame();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() / iterations;
+}
+
+} // namespace
+
+int main(int argc, char** argv)
+{
+    uint32_t width = 2560;
+    uint32_t height = 1600;
+    int iterations = 20;
+    if (argc >= 3) {
+        width = static_cast<uint32_t>(atoi(argv[1]));
+        height = static_cast<uint32_t>(atoi(argv[2]));
+    }
+    if (argc >= 4) {
+        iterations = atoi(argv[3]);
+    }
+    if ((width == 0) || (height == 0) || (iterations <= 0)) {
+        fprintf(stderr, "usage: %s [width height [iterations]]\n", argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<uint32_t> pixels(static_cast<size_t>(width) * height, 0xFFFFFFFF);
+    PixelSurface surface {pixels.data(), width, height, width * 4, PixelFormat::RGBA_8888};
+    std::vector<Shape> scene = BuildScene(width, height);
+    TileRasterizer raster;
+
+    printf("%ux%u, %zu shapes, %u performance cores, %d iterations\n", width, height, scene.size(),
+        WorkStealingPool::GetPerformanceCoreCount(), iterations);
+    double serial = MeasureUs(iterations, raster, surface, scene, nullptr);
+    printf("%-20s %10.1f us/frame  (%u tiles)\n", "calling thread", serial, raster.GetLastTileCount());
+
+    uint32_t maxThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    for (uint32_t threads = 2; threads <= maxThreads; threads *= 2) {
+        WorkStealingPool pool(threads - 1);
+        double us = MeasureUs(iterations, raster, surface, scene, &pool);
+        char name[32];
+        snprintf(name, sizeof(name), "%u threads", threads);
+        printf("%-20s %10.1f us/frame  %5.2fx\n", name, us, serial / us);
+    }
+
+    const AaQuality qualities[] = {AaQuality::NONE, AaQuality::LOW, AaQuality::MEDIUM, AaQuality::HIGH};
+    const char* names[] = {"quality none", "quality low", "quality medium", "quality high"};
+    for (int q = 0; q < 4; q++) {
+        raster.SetQuality(qualities[q]);
+        double us = MeasureUs(iterations, raster, surface, scene, nullptr);
+        printf("%-20s %10.1f us/frame  (%s, %u sample rows)\n", names[q], us, BlitIsaName(GetBlitIsa()),
+            GetAaSampleRows(qualities[q]));
+    }
+    return EXIT_SUCCESS;
+}
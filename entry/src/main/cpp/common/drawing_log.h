@@ -0,0 +1,176 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#ifndef DRAWING_LOG_H
+#define DRAWING_LOG_H
+
+// Logging for the native code, shared by every translation unit:
+//
+//   DRAWING_LOGD / LOGI / LOGW / LOGE (fmt, ...)       printf-style
+//   DRAWING_LOGW_LIMITED / LOGE_LIMITED (fmt, ...)     at most once per
+//                                                       DRAWING_LOG_LIMIT_MS per call site
+//
+// Levels below DRAWING_LOG_LEVEL compile to nothing: the arguments are still
+// type-checked against the format, but never evaluated. Release builds
+// (NDEBUG) keep warnings and errors only, so debug and info messages cost
+// nothing in the frame loop. Output goes to hilog on the device and to
+// stderr on the host.
+
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#if defined(__OHOS__)
+#include <hilog/log.h>
+#endif
+
+#define DRAWING_LOG_LEVEL_DEBUG 0
+#define DRAWING_LOG_LEVEL_INFO 1
+#define DRAWING_LOG_LEVEL_WARN 2
+#define DRAWING_LOG_LEVEL_ERROR 3
+#define DRAWING_LOG_LEVEL_NONE 4
+
+#ifndef DRAWING_LOG_LEVEL
+#ifdef NDEBUG
+#define DRAWING_LOG_LEVEL DRAWING_LOG_LEVEL_WARN
+#else
+#define DRAWING_LOG_LEVEL DRAWING_LOG_LEVEL_DEBUG
+#endif
+#endif
+
+#ifndef DRAWING_LOG_LIMIT_MS
+#define DRAWING_LOG_LIMIT_MS 1000
+#endif
+
+#if defined(__GNUC__)
+#define DRAWING_LOG_PRINTF(fmtIndex, argIndex) __attribute__((format(printf, fmtIndex, argIndex)))
+#else
+#define DRAWING_LOG_PRINTF(fmtIndex, argIndex)
+#endif
+
+namespace DrawingLog {
+
+// hilog domain and tag of the app's messages
+constexpr unsigned int HILOG_DOMAIN = 0xFF00;
+constexpr const char* HILOG_TAG = "DrawingSample";
+// Longer messages are cut
+constexpr size_t MAX_MESSAGE = 512;
+
+// Lets through one message per interval from a call site and counts the
+// rest. Constant-initialized, so a function-local static needs no guard.
+class RateLimit {
+public:
+    constexpr RateLimit() = default;
+
+    // On true, suppressed is how many were held back since the last one let through
+    bool Allow(int64_t nowMs, int64_t intervalMs, uint32_t& suppressed)
+    {
+        int64_t next = nextMs_.load(std::memory_order_relaxed);
+        if ((nowMs < next) || !nextMs_.compare_exchange_strong(next, nowMs + intervalMs, std::memory_order_relaxed)) {
+            suppressed_.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+        suppressed = suppressed_.exchange(0, std::memory_order_relaxed);
+        return true;
+    }
+
+private:
+    std::atomic<int64_t> nextMs_ {0};
+    std::atomic<uint32_t> suppressed_ {0};
+};
+
+inline int64_t NowMs()
+{
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// level is one of DRAWING_LOG_LEVEL_DEBUG to DRAWING_LOG_LEVEL_ERROR
+inline void Write(int level, uint32_t suppressed, const char* fmt, ...) DRAWING_LOG_PRINTF(3, 4);
+
+inline void Write(int level, uint32_t suppressed, const char* fmt, ...)
+{
+    char message[MAX_MESSAGE];
+    va_list args;
+    va_start(args, fmt);
+    int length = vsnprintf(message, sizeof(message), fmt, args);
+    va_end(args);
+    if (length < 0) {
+        return;
+    }
+    // Messages are written with a trailing newline; both sinks add their own
+    size_t end = strnlen(message, sizeof(message));
+    if ((end > 0) && (message[end - 1] == '\n')) {
+        message[end - 1] = '\0';
+    }
+    if (suppressed != 0) {
+        end = strnlen(message, sizeof(message));
+        snprintf(message + end, sizeof(message) - end, " (%u more suppressed)", suppressed);
+    }
+
+#if defined(__OHOS__)
+    static const LogLevel levels[] = {LOG_DEBUG, LOG_INFO, LOG_WARN, LOG_ERROR};
+    // Formatted here, so the whole text is the one public argument
+    OH_LOG_Print(LOG_APP, levels[level], HILOG_DOMAIN, HILOG_TAG, "%{public}s", message);
+#else
+    static const char* const names[] = {"DEBUG", "INFO", "WARN", "ERROR"};
+    fprintf(stderr, "%s: %s\n", names[level], message);
+#endif
+}
+
+// Never called; lets a compiled-out message keep its format checked
+inline void Discard(const char* fmt, ...) DRAWING_LOG_PRINTF(1, 2);
+inline void Discard(const char*, ...) {}
+
+} // namespace DrawingLog
+
+#define DRAWING_LOG_WRITE_(level, ...) DrawingLog::Write(level, 0, __VA_ARGS__)
+#define DRAWING_LOG_LIMITED_(level, ...)                                                  \
+    do {                                                                                  \
+        static DrawingLog::RateLimit drawingLogLimit_;                                    \
+        uint32_t drawingLogSuppressed_ = 0;                                               \
+        int64_t drawingLogNow_ = DrawingLog::NowMs();                                     \
+        if (drawingLogLimit_.Allow(drawingLogNow_, DRAWING_LOG_LIMIT_MS, drawingLogSuppressed_)) { \
+            DrawingLog::Write(level, drawingLogSuppressed_, __VA_ARGS__);                 \
+        }                                                                                 \
+    } while (0)
+#define DRAWING_LOG_OFF_(...)                                                             \
+    do {                                                                                  \
+        if (false) {                                                                      \
+            DrawingLog::Discard(__VA_ARGS__);                                             \
+        }                                                                                 \
+    } while (0)
+
+#if DRAWING_LOG_LEVEL <= DRAWING_LOG_LEVEL_DEBUG
+#define DRAWING_LOGD(...) DRAWING_LOG_WRITE_(DRAWING_LOG_LEVEL_DEBUG, __VA_ARGS__)
+#else
+#define DRAWING_LOGD(...) DRAWING_LOG_OFF_(__VA_ARGS__)
+#endif
+
+#if DRAWING_LOG_LEVEL <= DRAWING_LOG_LEVEL_INFO
+#define DRAWING_LOGI(...) DRAWING_LOG_WRITE_(DRAWING_LOG_LEVEL_INFO, __VA_ARGS__)
+#else
+#define DRAWING_LOGI(...) DRAWING_LOG_OFF_(__VA_ARGS__)
+#endif
+
+#if DRAWING_LOG_LEVEL <= DRAWING_LOG_LEVEL_WARN
+#define DRAWING_LOGW(...) DRAWING_LOG_WRITE_(DRAWING_LOG_LEVEL_WARN, __VA_ARGS__)
+#define DRAWING_LOGW_LIMITED(...) DRAWING_LOG_LIMITED_(DRAWING_LOG_LEVEL_WARN, __VA_ARGS__)
+#else
+#define DRAWING_LOGW(...) DRAWING_LOG_OFF_(__VA_ARGS__)
+#define DRAWING_LOGW_LIMITED(...) DRAWING_LOG_OFF_(__VA_ARGS__)
+#endif
+
+#if DRAWING_LOG_LEVEL <= DRAWING_LOG_LEVEL_ERROR
+#define DRAWING_LOGE(...) DRAWING_LOG_WRITE_(DRAWING_LOG_LEVEL_ERROR, __VA_ARGS__)
+#define DRAWING_LOGE_LIMITED(...) DRAWING_LOG_LIMITED_(DRAWING_LOG_LEVEL_ERROR, __VA_ARGS__)
+#else
+#define DRAWING_LOGE(...) DRAWING_LOG_OFF_(__VA_ARGS__)
+#define DRAWING_LOGE_LIMITED(...) DRAWING_LOG_OFF_(__VA_ARGS__)
+#endif
+
+#endif // DRAWING_LOG_H
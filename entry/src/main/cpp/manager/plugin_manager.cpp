@@ -1,10 +1,7 @@
 // cpp/manager/plugin_manager.cpp
 
 #include "plugin_manager.h"
-#include <cstdio>
-
-#define DRAWING_LOGI(...) printf("INFO: " __VA_ARGS__)
-#define DRAWING_LOGE(...) printf("ERROR: " __VA_ARGS__)
+#include "common/drawing_log.h"
 
 // Initialize the static instance pointer
 PluginManager* PluginManager::instance_ = nullptr;
@@ -19,48 +16,18 @@ PluginManager* PluginManager::GetInstance()
 
 PluginManager::~PluginManager()
 {
-    // Clean up all SampleBitMap instances in the map
-    for (auto& pair : pluginRenderMap_) {
-        if (pair.second != nullptr) {
-            delete pair.second;
-            pair.second = nullptr;
-        }
-    }
-    pluginRenderMap_.clear();
-
+    // Stop every render thread now; each SampleBitMap is deleted as soon as
+    // no thread holds a handle to it any more.
     // Note: We don't delete nativeXComponent objects as they are owned by the system
-    nativeXComponentMap_.clear();
+    SampleBitMap::ReleaseAll();
     
     // Reset the static instance
     instance_ = nullptr;
 }
 
-void PluginManager::SetNativeXComponent(std::string& id, OH_NativeXComponent* nativeXComponent)
-{
-    if (nativeXComponent == nullptr) {
-        DRAWING_LOGE("SetNativeXComponent: nativeXComponent is null\n");
-        return;
-    }
-
-    nativeXComponentMap_[id] = nativeXComponent;
-
-    // Create a SampleBitMap for this component if it doesn't exist
-    if (pluginRenderMap_.find(id) == pluginRenderMap_.end()) {
-        pluginRenderMap_[id] = SampleBitMap::GetInstance(id);
-    }
-}
-
-SampleBitMap* PluginManager::GetRender(std::string& id)
+std::shared_ptr<SampleBitMap> PluginManager::GetRender(const std::string& id)
 {
-    auto it = pluginRenderMap_.find(id);
-    if (it != pluginRenderMap_.end()) {
-        return it->second;
-    }
-    
-    // If not found, create a new instance and store it
-    SampleBitMap* render = SampleBitMap::GetInstance(id);
-    pluginRenderMap_[id] = render;
-    return render;
+    return SampleBitMap::GetInstance(id);
 }
 
 void PluginManager::Export(napi_env env, napi_value exports)
@@ -92,11 +59,10 @@ void PluginManager::Export(napi_env env, napi_value exports)
     std::string id(idStr);
     auto context = PluginManager::GetInstance();
     if ((context != nullptr) && (nativeXComponent != nullptr)) {
-        context->SetNativeXComponent(id, nativeXComponent);
         auto render = context->GetRender(id);
         if (render != nullptr) {
             render->RegisterCallback(nativeXComponent);
-            render->Export(env, exports);
+            ExportSampleBitMap(env, exports, render);
         } else {
             DRAWING_LOGE("Export: render is nullptr\n");
         }
@@ -6,11 +6,12 @@
 #ifndef PLUGIN_MANAGER_H
 #define PLUGIN_MANAGER_H
 
-#include <unordered_map>
+#include <memory>
 #include <string>
 #include <ace/xcomponent/native_interface_xcomponent.h>
 #include "napi/native_api.h"
 #include "render/sample_bitmap.h"
+#include "render/sample_bitmap_napi.h"
 
 
 class PluginManager {
@@ -18,15 +19,14 @@ public:
     ~PluginManager();
     static PluginManager* GetInstance();
     
-    void SetNativeXComponent(std::string& id, OH_NativeXComponent* nativeXComponent);
-    SampleBitMap* GetRender(std::string& id);
+    // The render for an XComponent id, created on first use. Renders live in
+    // the SampleBitMap instance registry; the manager keeps no map of its own.
+    std::shared_ptr<SampleBitMap> GetRender(const std::string& id);
     void Export(napi_env env, napi_value exports);
 
 private:
     PluginManager() = default;
     static PluginManager* instance_;
-    std::unordered_map<std::string, OH_NativeXComponent*> nativeXComponentMap_;
-    std::unordered_map<std::string, SampleBitMap*> pluginRenderMap_;
 };
 
 #endif // PLUGIN_MANAGER_H
\ No newline at end of file
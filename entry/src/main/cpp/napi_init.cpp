@@ -1,5 +1,6 @@
 
 #include "napi/native_api.h"
+#include "manager/plugin_manager.h"
 
 static napi_value Add(napi_env env, napi_callback_info info)
 {
@@ -34,6 +35,8 @@ static napi_value Init(napi_env env, napi_value exports)
         { "add", nullptr, Add, nullptr, nullptr, nullptr, napi_default, nullptr }
     };
     napi_define_properties(env, exports, sizeof(desc) / sizeof(desc[0]), desc);
+    // Loaded by an XComponent: bind its renderer and define the drawing methods
+    PluginManager::GetInstance()->Export(env, exports);
     return exports;
 }
 EXTERN_C_END
@@ -0,0 +1,120 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#include "buffer_pool.h"
+#include "common/drawing_log.h"
+#include <sys/mman.h>
+
+BufferPool::~BufferPool() noexcept
+{
+    Clear();
+}
+
+uint32_t* BufferPool::Map(const BufferHandle* handle)
+{
+    if (handle == nullptr) {
+        DRAWING_LOGE("BufferPool::Map: handle is null\n");
+        return nullptr;
+    }
+
+    auto iter = entries_.find(handle->fd);
+    if (iter != entries_.end()) {
+        if (iter->second.size == static_cast<size_t>(handle->size)) {
+            return iter->second.mappedAddr;
+        }
+        // Same fd, different buffer: the old mapping is stale
+        ReleaseEntry(iter->first, iter->second);
+        entries_.erase(iter);
+    }
+
+    if (entries_.size() >= MAX_ENTRIES) {
+        DRAWING_LOGW("BufferPool::Map: more than %zu buffers seen, dropping old mappings\n", MAX_ENTRIES);
+        Clear();
+    }
+
+    void* addr = mmap(handle->virAddr, handle->size, PROT_READ | PROT_WRITE, MAP_SHARED, handle->fd, 0);
+    if (addr == MAP_FAILED) {
+        DRAWING_LOGE_LIMITED("BufferPool::Map: mmap failed for fd %d\n", handle->fd);
+        return nullptr;
+    }
+
+    Entry entry {static_cast<uint32_t*>(addr), static_cast<size_t>(handle->size), nullptr, 0, 0, 0};
+    entries_.emplace(handle->fd, entry);
+    return entry.mappedAddr;
+}
+
+OH_Drawing_Bitmap* BufferPool::GetDirectBitmap(const BufferHandle* handle, uint32_t width, uint32_t height)
+{
+    if (handle == nullptr) {
+        return nullptr;
+    }
+
+    auto iter = entries_.find(handle->fd);
+    if (iter == entries_.end()) {
+        DRAWING_LOGE("BufferPool::GetDirectBitmap: fd %d is not mapped\n", handle->fd);
+        return nullptr;
+    }
+
+    Entry& entry = iter->second;
+    if ((entry.directBitmap != nullptr) && (entry.directWidth == width) && (entry.directHeight == height)) {
+        return entry.directBitmap;
+    }
+
+    if (entry.directBitmap != nullptr) {
+        OH_Drawing_BitmapDestroy(entry.directBitmap);
+        entry.directBitmap = nullptr;
+    }
+
+    OH_Drawing_Image_Info info {static_cast<int32_t>(width), static_cast<int32_t>(height),
+        COLOR_FORMAT_RGBA_8888, ALPHA_FORMAT_OPAQUE};
+    entry.directBitmap = OH_Drawing_BitmapCreateFromPixels(&info, entry.mappedAddr, handle->stride);
+    if (entry.directBitmap == nullptr) {
+        DRAWING_LOGE_LIMITED("BufferPool::GetDirectBitmap: BitmapCreateFromPixels failed for fd %d\n", handle->fd);
+        return nullptr;
+    }
+    entry.directWidth = width;
+    entry.directHeight = height;
+    return entry.directBitmap;
+}
+
+uint64_t BufferPool::GetContentFrame(const BufferHandle* handle) const
+{
+    if (handle == nullptr) {
+        return 0;
+    }
+    auto iter = entries_.find(handle->fd);
+    return (iter != entries_.end()) ? iter->second.contentFrame : 0;
+}
+
+void BufferPool::SetContentFrame(const BufferHandle* handle, uint64_t frame)
+{
+    if (handle == nullptr) {
+        return;
+    }
+    auto iter = entries_.find(handle->fd);
+    if (iter != entries_.end()) {
+        iter->second.contentFrame = frame;
+    }
+}
+
+void BufferPool::ReleaseEntry(int fd, Entry& entry)
+{
+    // The bitmap only borrows the mapping, so it has to go first
+    if (entry.directBitmap != nullptr) {
+        OH_Drawing_BitmapDestroy(entry.directBitmap);
+        entry.directBitmap = nullptr;
+    }
+    if (munmap(entry.mappedAddr, entry.size) == -1) {
+        DRAWING_LOGE_LIMITED("BufferPool: munmap failed for fd %d\n", fd);
+    }
+}
+
+void BufferPool::Clear()
+{
+    for (auto& pair : entries_) {
+        ReleaseEntry(pair.first, pair.second);
+    }
+    entries_.clear();
+}
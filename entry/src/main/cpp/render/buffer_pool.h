@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#ifndef BUFFER_POOL_H
+#define BUFFER_POOL_H
+
+#include <native_window/external_window.h>
+#include <native_drawing/drawing_bitmap.h>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+
+// Keeps every window buffer handed out by the native window mapped for its
+// whole life, keyed by the BufferHandle fd. The window cycles through a small,
+// fixed set of buffers, so after the first few frames Map() is a lookup.
+class BufferPool {
+public:
+    struct Entry {
+        uint32_t* mappedAddr;
+        size_t size;
+        // Bitmap wrapping mappedAddr for zero-copy rendering, created on demand
+        OH_Drawing_Bitmap* directBitmap;
+        uint32_t directWidth;
+        uint32_t directHeight;
+        // Number of the frame whose pixels the buffer holds, 0 if unknown
+        uint64_t contentFrame;
+    };
+
+    BufferPool() = default;
+    ~BufferPool() noexcept;
+
+    BufferPool(const BufferPool&) = delete;
+    BufferPool& operator=(const BufferPool&) = delete;
+
+    // Return the mapping for this buffer, creating it on first use.
+    // Returns nullptr if the buffer could not be mapped.
+    uint32_t* Map(const BufferHandle* handle);
+
+    // Return a bitmap whose pixels are the mapped buffer itself, laid out with
+    // the buffer stride. The buffer must already be mapped through Map().
+    // Returns nullptr if the bitmap could not be created.
+    OH_Drawing_Bitmap* GetDirectBitmap(const BufferHandle* handle, uint32_t width, uint32_t height);
+
+    // Track which frame a buffer was last rendered with, so a partial update
+    // knows how far behind the buffer is. Unknown buffers report 0.
+    uint64_t GetContentFrame(const BufferHandle* handle) const;
+    void SetContentFrame(const BufferHandle* handle, uint64_t frame);
+
+    // Unmap every buffer. Called when the surface changes or goes away.
+    void Clear();
+
+    size_t Size() const
+    {
+        return entries_.size();
+    }
+
+private:
+    // A window never cycles through more buffers than this; if we see more,
+    // fds are being recycled and the old mappings are stale.
+    static constexpr size_t MAX_ENTRIES = 8;
+
+    static void ReleaseEntry(int fd, Entry& entry);
+
+    std::unordered_map<int, Entry> entries_;
+};
+
+#endif // BUFFER_POOL_H
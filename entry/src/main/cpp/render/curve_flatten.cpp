@@ -0,0 +1,222 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#include "curve_flatten.h"
+#include "pixel_blit.h"
+#include <algorithm>
+#include <cmath>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define CURVE_FLATTEN_X86 1
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(__ARM_NEON)
+#define CURVE_FLATTEN_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+constexpr float PI = 3.14159265358979f;
+
+// x(t) = ((ax t + bx) t + cx) t + dx, and the same for y
+struct Polynomial {
+    float ax;
+    float bx;
+    float cx;
+    float dx;
+    float ay;
+    float by;
+    float cy;
+    float dy;
+};
+
+// Writes the points at t = (i + 1) * dt for i in [first, count)
+using EvalFn = void (*)(const Polynomial& p, float dt, uint32_t first, uint32_t count, RasterPoint* out);
+
+void EvalScalar(const Polynomial& p, float dt, uint32_t first, uint32_t count, RasterPoint* out)
+{
+    for (uint32_t i = first; i < count; i++) {
+        float t = static_cast<float>(i + 1) * dt;
+        out[i].x = ((p.ax * t + p.bx) * t + p.cx) * t + p.dx;
+        out[i].y = ((p.ay * t + p.by) * t + p.cy) * t + p.dy;
+    }
+}
+
+#if defined(CURVE_FLATTEN_X86)
+void EvalSse2(const Polynomial& p, float dt, uint32_t first, uint32_t count, RasterPoint* out)
+{
+    const __m128 ax = _mm_set1_ps(p.ax);
+    const __m128 bx = _mm_set1_ps(p.bx);
+    const __m128 cx = _mm_set1_ps(p.cx);
+    const __m128 dx = _mm_set1_ps(p.dx);
+    const __m128 ay = _mm_set1_ps(p.ay);
+    const __m128 by = _mm_set1_ps(p.by);
+    const __m128 cy = _mm_set1_ps(p.cy);
+    const __m128 dy = _mm_set1_ps(p.dy);
+    const __m128 lanes = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+    const __m128 step = _mm_set1_ps(dt);
+    uint32_t i = first;
+    for (; i + 4 <= count; i += 4) {
+        __m128 t = _mm_mul_ps(_mm_add_ps(_mm_set1_ps(static_cast<float>(i + 1)), lanes), step);
+        __m128 x = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(ax, t), bx), t), cx), t), dx);
+        __m128 y = _mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_add_ps(_mm_mul_ps(ay, t), by), t), cy), t), dy);
+        // x0 y0 x1 y1, x2 y2 x3 y3
+        float* dst = reinterpret_cast<float*>(out + i);
+        _mm_storeu_ps(dst, _mm_unpacklo_ps(x, y));
+        _mm_storeu_ps(dst + 4, _mm_unpackhi_ps(x, y));
+    }
+    EvalScalar(p, dt, i, count, out);
+}
+#endif // CURVE_FLATTEN_X86
+
+#if defined(CURVE_FLATTEN_NEON)
+void EvalNeon(const Polynomial& p, float dt, uint32_t first, uint32_t count, RasterPoint* out)
+{
+    const float32x4_t ax = vdupq_n_f32(p.ax);
+    const float32x4_t bx = vdupq_n_f32(p.bx);
+    const float32x4_t cx = vdupq_n_f32(p.cx);
+    const float32x4_t dx = vdupq_n_f32(p.dx);
+    const float32x4_t ay = vdupq_n_f32(p.ay);
+    const float32x4_t by = vdupq_n_f32(p.by);
+    const float32x4_t cy = vdupq_n_f32(p.cy);
+    const float32x4_t dy = vdupq_n_f32(p.dy);
+    const float laneValues[4] = {0.0f, 1.0f, 2.0f, 3.0f};
+    const float32x4_t lanes = vld1q_f32(laneValues);
+    const float32x4_t step = vdupq_n_f32(dt);
+    uint32_t i = first;
+    for (; i + 4 <= count; i += 4) {
+        float32x4_t t = vmulq_f32(vaddq_f32(vdupq_n_f32(static_cast<float>(i + 1)), lanes), step);
+        float32x4x2_t xy;
+        xy.val[0] = vmlaq_f32(dx, vmlaq_f32(cx, vmlaq_f32(bx, ax, t), t), t);
+        xy.val[1] = vmlaq_f32(dy, vmlaq_f32(cy, vmlaq_f32(by, ay, t), t), t);
+        // Interleaved on the way out
+        vst2q_f32(reinterpret_cast<float*>(out + i), xy);
+    }
+    EvalScalar(p, dt, i, count, out);
+}
+#endif // CURVE_FLATTEN_NEON
+
+EvalFn KernelFor(BlitIsa isa)
+{
+    switch (isa) {
+#if defined(CURVE_FLATTEN_X86)
+        case BlitIsa::SSE2:
+        case BlitIsa::AVX2:
+            return EvalSse2;
+#endif
+#if defined(CURVE_FLATTEN_NEON)
+        case BlitIsa::NEON:
+            return EvalNeon;
+#endif
+        default:
+            return EvalScalar;
+    }
+}
+
+void EvalPolynomial(const Polynomial& p, const RasterPoint& end, uint32_t segments, RasterPoint* out)
+{
+    segments = std::max(segments, 1u);
+    KernelFor(GetBlitIsa())(p, 1.0f / segments, 0, segments - 1, out);
+    // No rounding drift at the end, so the next segment starts where it should
+    out[segments - 1] = end;
+}
+
+// n rounded up to a whole number of segments in [minimum, MAX_FLATTEN_SEGMENTS];
+// also the maximum for anything not finite
+uint32_t ClampSegments(float n, uint32_t minimum)
+{
+    if (!(n < static_cast<float>(MAX_FLATTEN_SEGMENTS))) {
+        return MAX_FLATTEN_SEGMENTS;
+    }
+    return std::max(static_cast<uint32_t>(std::ceil(std::max(n, 0.0f))), std::max(minimum, 1u));
+}
+
+float Length(float x, float y)
+{
+    return std::sqrt(x * x + y * y);
+}
+
+// Length of the second difference p0 - 2 p1 + p2, which bounds how far the
+// curve bends away from its chords
+float SecondDifference(const RasterPoint& p0, const RasterPoint& p1, const RasterPoint& p2)
+{
+    return Length(p0.x - 2 * p1.x + p2.x, p0.y - 2 * p1.y + p2.y);
+}
+
+} // namespace
+
+uint32_t GetArcSegments(float radius, float sweep, float tolerance)
+{
+    float angle = std::fabs(sweep);
+    if (!(radius > 0) || !(angle > 0)) {
+        return 1;
+    }
+    uint32_t quarters = ClampSegments(angle / (PI / 2) - 1e-4f, 1);
+    if (!(tolerance > 0)) {
+        return MAX_FLATTEN_SEGMENTS;
+    }
+    // A chord over angle a is at most radius * (1 - cos(a / 2)) from the arc
+    float step = (tolerance < radius) ? 2 * std::acos(1 - tolerance / radius) : PI;
+    return ClampSegments(angle / step, quarters);
+}
+
+uint32_t GetQuadSegments(const RasterPoint& p0, const RasterPoint& p1, const RasterPoint& p2, float tolerance)
+{
+    if (!(tolerance > 0)) {
+        return MAX_FLATTEN_SEGMENTS;
+    }
+    // Wang's formula for degree 2
+    return ClampSegments(std::sqrt(SecondDifference(p0, p1, p2) / (4 * tolerance)), 1);
+}
+
+uint32_t GetCubicSegments(const RasterPoint& p0, const RasterPoint& p1, const RasterPoint& p2, const RasterPoint& p3,
+    float tolerance)
+{
+    if (!(tolerance > 0)) {
+        return MAX_FLATTEN_SEGMENTS;
+    }
+    // Wang's formula for degree 3
+    float bend = std::max(SecondDifference(p0, p1, p2), SecondDifference(p1, p2, p3));
+    return ClampSegments(std::sqrt(3 * bend / (4 * tolerance)), 1);
+}
+
+void FlattenQuad(const RasterPoint& p0, const RasterPoint& p1, const RasterPoint& p2, uint32_t segments,
+    RasterPoint* out)
+{
+    Polynomial p {0, p0.x - 2 * p1.x + p2.x, 2 * (p1.x - p0.x), p0.x, 0, p0.y - 2 * p1.y + p2.y, 2 * (p1.y - p0.y),
+        p0.y};
+    EvalPolynomial(p, p2, segments, out);
+}
+
+void FlattenCubic(const RasterPoint& p0, const RasterPoint& p1, const RasterPoint& p2, const RasterPoint& p3,
+    uint32_t segments, RasterPoint* out)
+{
+    Polynomial p {p3.x - p0.x + 3 * (p1.x - p2.x), 3 * (p0.x - 2 * p1.x + p2.x), 3 * (p1.x - p0.x), p0.x,
+        p3.y - p0.y + 3 * (p1.y - p2.y), 3 * (p0.y - 2 * p1.y + p2.y), 3 * (p1.y - p0.y), p0.y};
+    EvalPolynomial(p, p3, segments, out);
+}
+
+void FlattenArc(float cx, float cy, float radius, float startAngle, float sweep, uint32_t segments,
+    RasterPoint* out)
+{
+    segments = std::max(segments, 1u);
+    // Rotating in double keeps the drift over MAX_FLATTEN_SEGMENTS steps far
+    // below any tolerance
+    double step = static_cast<double>(sweep) / segments;
+    double cosStep = std::cos(step);
+    double sinStep = std::sin(step);
+    double dx = radius * std::cos(static_cast<double>(startAngle));
+    double dy = radius * std::sin(static_cast<double>(startAngle));
+    out[0] = RasterPoint {cx + static_cast<float>(dx), cy + static_cast<float>(dy)};
+    for (uint32_t i = 1; i < segments; i++) {
+        double x = dx * cosStep - dy * sinStep;
+        dy = dx * sinStep + dy * cosStep;
+        dx = x;
+        out[i] = RasterPoint {cx + static_cast<float>(dx), cy + static_cast<float>(dy)};
+    }
+    double endAngle = static_cast<double>(startAngle) + sweep;
+    out[segments] = RasterPoint {cx + static_cast<float>(radius * std::cos(endAngle)),
+        cy + static_cast<float>(radius * std::sin(endAngle))};
+}
@@ -0,0 +1,52 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#ifndef CURVE_FLATTEN_H
+#define CURVE_FLATTEN_H
+
+#include <cstdint>
+
+struct RasterPoint {
+    float x;
+    float y;
+};
+
+// Arcs and Bezier curves turned into line segments ("flattened") just fine
+// enough that no segment strays more than a tolerance from the curve. The
+// tolerance is in the units of the points: a path drawn at scale s is
+// flattened with the pixel tolerance divided by s, so a small shape gets a
+// few segments and a large one as many as it needs.
+//
+// Arcs take one sin and cos per arc, each point being the previous one
+// rotated by a fixed step. Curve points are evaluated four at a time with
+// the instruction set of the blit kernels (see GetBlitIsa()).
+
+// Distance from the curve, in pixels, the renderer flattens to
+constexpr float FLATTEN_TOLERANCE = 0.2f;
+
+// Most segments one curve or arc is cut into, whatever its size
+constexpr uint32_t MAX_FLATTEN_SEGMENTS = 1024;
+
+// Segments to flatten a curve into, from 1 to MAX_FLATTEN_SEGMENTS; an arc
+// gets at least one per quarter turn. sweep is in radians, either sign.
+uint32_t GetArcSegments(float radius, float sweep, float tolerance);
+uint32_t GetQuadSegments(const RasterPoint& p0, const RasterPoint& p1, const RasterPoint& p2, float tolerance);
+uint32_t GetCubicSegments(const RasterPoint& p0, const RasterPoint& p1, const RasterPoint& p2, const RasterPoint& p3,
+    float tolerance);
+
+// The points ending each of segments equal steps in t, into out: segments
+// points, not counting p0, the last exactly the end point
+void FlattenQuad(const RasterPoint& p0, const RasterPoint& p1, const RasterPoint& p2, uint32_t segments,
+    RasterPoint* out);
+void FlattenCubic(const RasterPoint& p0, const RasterPoint& p1, const RasterPoint& p2, const RasterPoint& p3,
+    uint32_t segments, RasterPoint* out);
+
+// segments + 1 points of the arc of radius around (cx, cy) from startAngle
+// through sweep radians, into out, start and end included. Angles grow from
+// +x towards +y: clockwise on screen.
+void FlattenArc(float cx, float cy, float radius, float startAngle, float sweep, uint32_t segments,
+    RasterPoint* out);
+
+#endif // CURVE_FLATTEN_H
@@ -0,0 +1,155 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#include "dirty_region.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Bounds are clamped to this before becoming pixels, so any finite float
+// fits and rect edges (x + w) cannot overflow
+constexpr float MAX_COORDINATE = static_cast<float>(1u << 30);
+
+float ClampCoordinate(float value)
+{
+    return std::min(std::max(value, 0.0f), MAX_COORDINATE);
+}
+
+uint64_t RectArea(const BlitRect& rect)
+{
+    return static_cast<uint64_t>(rect.w) * rect.h;
+}
+
+BlitRect Union(const BlitRect& a, const BlitRect& b)
+{
+    uint32_t left = std::min(a.x, b.x);
+    uint32_t top = std::min(a.y, b.y);
+    uint32_t right = std::max(a.x + a.w, b.x + b.w);
+    uint32_t bottom = std::max(a.y + a.h, b.y + b.h);
+    return BlitRect {left, top, right - left, bottom - top};
+}
+
+// Overlapping or sharing an edge; merging such rects never adds much area
+bool Touches(const BlitRect& a, const BlitRect& b)
+{
+    return (a.x <= b.x + b.w) && (b.x <= a.x + a.w) && (a.y <= b.y + b.h) && (b.y <= a.y + a.h);
+}
+
+} // namespace
+
+void DirtyRegion::Clear()
+{
+    count_ = 0;
+    full_ = false;
+}
+
+void DirtyRegion::SetFull(uint32_t width, uint32_t height)
+{
+    rects_[0] = BlitRect {0, 0, width, height};
+    count_ = ((width > 0) && (height > 0)) ? 1 : 0;
+    full_ = true;
+}
+
+void DirtyRegion::Add(const BlitRect& rect)
+{
+    if (full_ || (rect.w == 0) || (rect.h == 0)) {
+        return;
+    }
+    Insert(rect);
+}
+
+void DirtyRegion::Add(const DirtyRegion& other)
+{
+    if (full_) {
+        return;
+    }
+    if (other.full_) {
+        *this = other;
+        return;
+    }
+    for (int i = 0; i < other.count_; i++) {
+        Insert(other.rects_[i]);
+    }
+}
+
+void DirtyRegion::AddBounds(float left, float top, float right, float bottom, float outset)
+{
+    if ((right < left) || (bottom < top)) {
+        return;
+    }
+    float l = ClampCoordinate(std::floor(left - outset));
+    float t = ClampCoordinate(std::floor(top - outset));
+    float r = ClampCoordinate(std::ceil(right + outset));
+    float b = ClampCoordinate(std::ceil(bottom + outset));
+    Add(BlitRect {static_cast<uint32_t>(l), static_cast<uint32_t>(t),
+        static_cast<uint32_t>(r - l), static_cast<uint32_t>(b - t)});
+}
+
+void DirtyRegion::Clip(uint32_t width, uint32_t height)
+{
+    int kept = 0;
+    for (int i = 0; i < count_; i++) {
+        BlitRect rect = rects_[i];
+        if ((rect.x >= width) || (rect.y >= height)) {
+            continue;
+        }
+        rect.w = std::min(rect.w, width - rect.x);
+        rect.h = std::min(rect.h, height - rect.y);
+        rects_[kept++] = rect;
+    }
+    count_ = kept;
+}
+
+uint64_t DirtyRegion::Area() const
+{
+    uint64_t area = 0;
+    for (int i = 0; i < count_; i++) {
+        area += RectArea(rects_[i]);
+    }
+    return area;
+}
+
+void DirtyRegion::Insert(BlitRect rect)
+{
+    // Absorb every rect this one touches; the grown rect may touch more
+    bool merged = true;
+    while (merged) {
+        merged = false;
+        for (int i = 0; i < count_; i++) {
+            if (Touches(rects_[i], rect)) {
+                rect = Union(rects_[i], rect);
+                rects_[i] = rects_[--count_];
+                merged = true;
+                break;
+            }
+        }
+    }
+
+    if (count_ == MAX_RECTS) {
+        MergeCheapestPair();
+    }
+    rects_[count_++] = rect;
+}
+
+void DirtyRegion::MergeCheapestPair()
+{
+    int bestA = 0;
+    int bestB = 1;
+    int64_t bestGrowth = INT64_MAX;
+    for (int a = 0; a < count_; a++) {
+        for (int b = a + 1; b < count_; b++) {
+            int64_t growth = static_cast<int64_t>(RectArea(Union(rects_[a], rects_[b]))) -
+                static_cast<int64_t>(RectArea(rects_[a])) - static_cast<int64_t>(RectArea(rects_[b]));
+            if (growth < bestGrowth) {
+                bestGrowth = growth;
+                bestA = a;
+                bestB = b;
+            }
+        }
+    }
+    rects_[bestA] = Union(rects_[bestA], rects_[bestB]);
+    rects_[bestB] = rects_[--count_];
+}
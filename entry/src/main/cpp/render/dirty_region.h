@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#ifndef DIRTY_REGION_H
+#define DIRTY_REGION_H
+
+#include "pixel_blit.h"
+#include <cstdint>
+
+// A small set of non-overlapping-ish rectangles covering the pixels a frame
+// touched. Overlapping rects are merged as they are added, and once the set is
+// full the pair whose union grows the least is merged, so the region stays a
+// handful of rects that over-approximates what was drawn.
+class DirtyRegion {
+public:
+    static constexpr int MAX_RECTS = 8;
+
+    DirtyRegion() = default;
+
+    void Clear();
+
+    // Cover the whole surface
+    void SetFull(uint32_t width, uint32_t height);
+
+    bool IsFull() const
+    {
+        return full_;
+    }
+
+    bool IsEmpty() const
+    {
+        return count_ == 0;
+    }
+
+    void Add(const BlitRect& rect);
+    void Add(const DirtyRegion& other);
+
+    // Add float bounds, grown by outset (half a stroke width, anti-aliasing)
+    // and snapped outwards to whole pixels
+    void AddBounds(float left, float top, float right, float bottom, float outset);
+
+    // Drop everything outside a width x height surface
+    void Clip(uint32_t width, uint32_t height);
+
+    int Count() const
+    {
+        return count_;
+    }
+
+    const BlitRect& Rect(int index) const
+    {
+        return rects_[index];
+    }
+
+    // Sum of rect areas; rects may overlap slightly, so this is an upper bound
+    uint64_t Area() const;
+
+private:
+    void Insert(BlitRect rect);
+    void MergeCheapestPair();
+
+    BlitRect rects_[MAX_RECTS] = {};
+    int count_ = 0;
+    bool full_ = false;
+};
+
+#endif // DIRTY_REGION_H
@@ -0,0 +1,430 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#include "display_list.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// Argument words following each opcode, indexed by opcode; 0 is not an opcode
+constexpr int OP_ARG_COUNT[] = {-1, 1, 1, 1, 2, 2, 0, 0, 0, 4, 6, 5, 5, 1, 0};
+constexpr uint32_t OP_LAST = static_cast<uint32_t>(DisplayListOp::LAYER_END);
+
+float WordToFloat(uint32_t word)
+{
+    float value;
+    memcpy(&value, &word, sizeof(value));
+    return value;
+}
+
+// Ops that add to the current path
+bool IsPathOp(DisplayListOp type)
+{
+    return (type == DisplayListOp::MOVE_TO) || (type == DisplayListOp::LINE_TO) || (type == DisplayListOp::QUAD_TO) ||
+        (type == DisplayListOp::CUBIC_TO) || (type == DisplayListOp::ARC_TO) || (type == DisplayListOp::ROUND_RECT) ||
+        (type == DisplayListOp::CLOSE);
+}
+
+// Extent of the points added to the current path
+struct PathExtent {
+    DrawBounds bounds;
+    bool empty;
+
+    void Reset()
+    {
+        empty = true;
+    }
+
+    void Add(float x, float y)
+    {
+        if (empty) {
+            bounds = DrawBounds {x, y, x, y};
+            empty = false;
+            return;
+        }
+        bounds.left = std::min(bounds.left, x);
+        bounds.top = std::min(bounds.top, y);
+        bounds.right = std::max(bounds.right, x);
+        bounds.bottom = std::max(bounds.bottom, y);
+    }
+
+    // What a path op adds: its points, curves with their control points and
+    // arcs with their whole circle
+    void AddOp(DisplayListOp type, const uint32_t* args)
+    {
+        switch (type) {
+            case DisplayListOp::CUBIC_TO:
+                Add(WordToFloat(args[4]), WordToFloat(args[5]));
+                [[fallthrough]];
+            case DisplayListOp::QUAD_TO:
+                Add(WordToFloat(args[2]), WordToFloat(args[3]));
+                [[fallthrough]];
+            case DisplayListOp::MOVE_TO:
+            case DisplayListOp::LINE_TO:
+                Add(WordToFloat(args[0]), WordToFloat(args[1]));
+                break;
+            case DisplayListOp::ARC_TO: {
+                float radius = WordToFloat(args[2]);
+                Add(WordToFloat(args[0]) - radius, WordToFloat(args[1]) - radius);
+                Add(WordToFloat(args[0]) + radius, WordToFloat(args[1]) + radius);
+                break;
+            }
+            case DisplayListOp::ROUND_RECT:
+                Add(WordToFloat(args[0]), WordToFloat(args[1]));
+                Add(WordToFloat(args[2]), WordToFloat(args[3]));
+                break;
+            default:
+                break;
+        }
+    }
+};
+
+// The layer whose LAYER_BEGIN is at words[begin]: where its LAYER_END is,
+// what it draws over and a hash of everything its pixels depend on
+struct LayerScan {
+    size_t end;
+    PathExtent extent;
+    uint64_t content;
+};
+
+LayerScan ScanLayer(const std::vector<uint32_t>& words, size_t begin, uint32_t color, float width)
+{
+    // FNV-1a over the words inside and the color and width each draw uses
+    constexpr uint64_t fnvOffset = 14695981039346656037ull;
+    constexpr uint64_t fnvPrime = 1099511628211ull;
+    LayerScan scan {begin, {}, fnvOffset};
+    scan.extent.Reset();
+    auto hash = [&scan](uint32_t word) {
+        scan.content = (scan.content ^ word) * fnvPrime;
+    };
+    // Load() has checked that the layer ends
+    PathExtent path {};
+    path.Reset();
+    size_t i = begin + 1 + OP_ARG_COUNT[words[begin]];
+    while (words[i] != static_cast<uint32_t>(DisplayListOp::LAYER_END)) {
+        uint32_t op = words[i];
+        const uint32_t* args = &words[i + 1];
+        for (int arg = 0; arg <= OP_ARG_COUNT[op]; arg++) {
+            hash(words[i + arg]);
+        }
+        DisplayListOp type = static_cast<DisplayListOp>(op);
+        if (type == DisplayListOp::COLOR) {
+            color = args[0];
+        } else if (type == DisplayListOp::WIDTH) {
+            width = WordToFloat(args[0]);
+        } else if (IsPathOp(type)) {
+            path.AddOp(type, args);
+        } else if ((type == DisplayListOp::FILL) || (type == DisplayListOp::STROKE)) {
+            // A draw looks like the color and width in effect, wherever set
+            uint32_t widthWord;
+            memcpy(&widthWord, &width, sizeof(widthWord));
+            hash(color);
+            hash((type == DisplayListOp::STROKE) ? widthWord : 0);
+            if (!path.empty) {
+                // Round joins keep a stroke within half its width of the path
+                float outset = (type == DisplayListOp::STROKE) ? width / 2 : 0.0f;
+                scan.extent.Add(path.bounds.left - outset, path.bounds.top - outset);
+                scan.extent.Add(path.bounds.right + outset, path.bounds.bottom + outset);
+            }
+            path.Reset();
+        }
+        i += 1 + OP_ARG_COUNT[op];
+    }
+    scan.end = i;
+    return scan;
+}
+
+} // namespace
+
+bool DisplayList::Load(const void* data, size_t size)
+{
+    words_.clear();
+    if ((size % sizeof(uint32_t) != 0) || (size / sizeof(uint32_t) > MAX_WORDS) || ((data == nullptr) && (size != 0))) {
+        return false;
+    }
+    // The format is little-endian like every target this builds for, so the
+    // words are used as they are
+    size_t count = size / sizeof(uint32_t);
+    words_.resize(count);
+    if (count != 0) {
+        memcpy(words_.data(), data, size);
+    }
+
+    size_t i = 0;
+    bool pathOpen = false;
+    bool inLayer = false;
+    while (i < count) {
+        uint32_t op = words_[i];
+        if ((op == 0) || (op > OP_LAST) || (count - i - 1 < static_cast<size_t>(OP_ARG_COUNT[op]))) {
+            words_.clear();
+            return false;
+        }
+        DisplayListOp type = static_cast<DisplayListOp>(op);
+        bool hasFloats = (type == DisplayListOp::WIDTH) || (IsPathOp(type) && (type != DisplayListOp::CLOSE));
+        for (int arg = 1; hasFloats && (arg <= OP_ARG_COUNT[op]); arg++) {
+            if (!std::isfinite(WordToFloat(words_[i + arg]))) {
+                words_.clear();
+                return false;
+            }
+        }
+        // The radius is the third argument of ARC_TO and the last of ROUND_RECT
+        int radiusArg = (type == DisplayListOp::ARC_TO) ? 3 : ((type == DisplayListOp::ROUND_RECT) ? 5 : 0);
+        if ((radiusArg != 0) && (WordToFloat(words_[i + radiusArg]) < 0)) {
+            words_.clear();
+            return false;
+        }
+
+        bool layerOk = true;
+        if (type == DisplayListOp::LAYER_BEGIN) {
+            layerOk = !inLayer && !pathOpen && (words_[i + 1] < MAX_LAYER_ID);
+            inLayer = true;
+        } else if (type == DisplayListOp::LAYER_END) {
+            layerOk = inLayer && !pathOpen;
+            inLayer = false;
+        } else if (type == DisplayListOp::CLEAR) {
+            layerOk = !inLayer;
+        }
+        if (!layerOk) {
+            words_.clear();
+            return false;
+        }
+        if (IsPathOp(type)) {
+            pathOpen = true;
+        } else if ((type == DisplayListOp::FILL) || (type == DisplayListOp::STROKE)) {
+            pathOpen = false;
+        }
+        i += 1 + OP_ARG_COUNT[op];
+    }
+    if (inLayer) {
+        words_.clear();
+        return false;
+    }
+    return true;
+}
+
+bool DisplayList::Equals(const void* data, size_t size) const
+{
+    if (size != SizeInBytes()) {
+        return false;
+    }
+    return (size == 0) || (memcmp(words_.data(), data, size) == 0);
+}
+
+void DisplayList::Replay(DisplayListSink& sink) const
+{
+    // Defaults match a fresh pen and brush
+    uint32_t color = 0xFF000000;
+    float width = 1.0f;
+    PathExtent extent;
+    extent.Reset();
+    // Outside the layer being replayed
+    uint32_t outerColor = color;
+    float outerWidth = width;
+    bool layerBegun = false;
+
+    // Load() has checked every opcode and argument count
+    size_t count = words_.size();
+    size_t i = 0;
+    while (i < count) {
+        uint32_t op = words_[i];
+        const uint32_t* args = &words_[i + 1];
+        DisplayListOp type = static_cast<DisplayListOp>(op);
+        if (IsPathOp(type)) {
+            extent.AddOp(type, args);
+        }
+        switch (type) {
+            case DisplayListOp::CLEAR:
+                sink.Clear(args[0]);
+                break;
+            case DisplayListOp::COLOR:
+                color = args[0];
+                break;
+            case DisplayListOp::WIDTH:
+                width = WordToFloat(args[0]);
+                break;
+            case DisplayListOp::MOVE_TO:
+                sink.MoveTo(WordToFloat(args[0]), WordToFloat(args[1]));
+                break;
+            case DisplayListOp::LINE_TO:
+                sink.LineTo(WordToFloat(args[0]), WordToFloat(args[1]));
+                break;
+            case DisplayListOp::QUAD_TO:
+                sink.QuadTo(WordToFloat(args[0]), WordToFloat(args[1]), WordToFloat(args[2]), WordToFloat(args[3]));
+                break;
+            case DisplayListOp::CUBIC_TO:
+                sink.CubicTo(WordToFloat(args[0]), WordToFloat(args[1]), WordToFloat(args[2]), WordToFloat(args[3]),
+                    WordToFloat(args[4]), WordToFloat(args[5]));
+                break;
+            case DisplayListOp::ARC_TO:
+                sink.ArcTo(WordToFloat(args[0]), WordToFloat(args[1]), WordToFloat(args[2]), WordToFloat(args[3]),
+                    WordToFloat(args[4]));
+                break;
+            case DisplayListOp::ROUND_RECT:
+                sink.RoundRect(WordToFloat(args[0]), WordToFloat(args[1]), WordToFloat(args[2]), WordToFloat(args[3]),
+                    WordToFloat(args[4]));
+                break;
+            case DisplayListOp::CLOSE:
+                sink.Close();
+                break;
+            case DisplayListOp::FILL:
+                // An empty path draws nothing, but the sink still resets it
+                sink.Fill(color, extent.empty ? DrawBounds {0, 0, 0, 0} : extent.bounds);
+                extent.Reset();
+                break;
+            case DisplayListOp::STROKE:
+                sink.Stroke(color, width, extent.empty ? DrawBounds {0, 0, 0, 0} : extent.bounds);
+                extent.Reset();
+                break;
+            case DisplayListOp::LAYER_BEGIN: {
+                outerColor = color;
+                outerWidth = width;
+                LayerScan scan = ScanLayer(words_, i, color, width);
+                // A layer that draws nothing, or one the sink has already,
+                // is passed over
+                layerBegun = !scan.extent.empty && sink.BeginLayer(args[0], scan.extent.bounds, scan.content);
+                if (!layerBegun) {
+                    i = scan.end;
+                    continue;
+                }
+                break;
+            }
+            case DisplayListOp::LAYER_END:
+                color = outerColor;
+                width = outerWidth;
+                if (layerBegun) {
+                    sink.EndLayer();
+                    layerBegun = false;
+                }
+                break;
+        }
+        i += 1 + OP_ARG_COUNT[op];
+    }
+}
+
+DisplayListBuilder& DisplayListBuilder::Clear(uint32_t color)
+{
+    PushOp(DisplayListOp::CLEAR);
+    words_.push_back(color);
+    return *this;
+}
+
+DisplayListBuilder& DisplayListBuilder::Color(uint32_t color)
+{
+    PushOp(DisplayListOp::COLOR);
+    words_.push_back(color);
+    return *this;
+}
+
+DisplayListBuilder& DisplayListBuilder::Width(float width)
+{
+    PushOp(DisplayListOp::WIDTH);
+    PushFloat(width);
+    return *this;
+}
+
+DisplayListBuilder& DisplayListBuilder::MoveTo(float x, float y)
+{
+    PushOp(DisplayListOp::MOVE_TO);
+    PushFloat(x);
+    PushFloat(y);
+    return *this;
+}
+
+DisplayListBuilder& DisplayListBuilder::LineTo(float x, float y)
+{
+    PushOp(DisplayListOp::LINE_TO);
+    PushFloat(x);
+    PushFloat(y);
+    return *this;
+}
+
+DisplayListBuilder& DisplayListBuilder::QuadTo(float x1, float y1, float x2, float y2)
+{
+    PushOp(DisplayListOp::QUAD_TO);
+    PushFloat(x1);
+    PushFloat(y1);
+    PushFloat(x2);
+    PushFloat(y2);
+    return *this;
+}
+
+DisplayListBuilder& DisplayListBuilder::CubicTo(float x1, float y1, float x2, float y2, float x3, float y3)
+{
+    PushOp(DisplayListOp::CUBIC_TO);
+    PushFloat(x1);
+    PushFloat(y1);
+    PushFloat(x2);
+    PushFloat(y2);
+    PushFloat(x3);
+    PushFloat(y3);
+    return *this;
+}
+
+DisplayListBuilder& DisplayListBuilder::ArcTo(float cx, float cy, float radius, float startAngle, float sweep)
+{
+    PushOp(DisplayListOp::ARC_TO);
+    PushFloat(cx);
+    PushFloat(cy);
+    PushFloat(radius);
+    PushFloat(startAngle);
+    PushFloat(sweep);
+    return *this;
+}
+
+DisplayListBuilder& DisplayListBuilder::RoundRect(float left, float top, float right, float bottom, float radius)
+{
+    PushOp(DisplayListOp::ROUND_RECT);
+    PushFloat(left);
+    PushFloat(top);
+    PushFloat(right);
+    PushFloat(bottom);
+    PushFloat(radius);
+    return *this;
+}
+
+DisplayListBuilder& DisplayListBuilder::LayerBegin(uint32_t id)
+{
+    PushOp(DisplayListOp::LAYER_BEGIN);
+    words_.push_back(id);
+    return *this;
+}
+
+DisplayListBuilder& DisplayListBuilder::LayerEnd()
+{
+    PushOp(DisplayListOp::LAYER_END);
+    return *this;
+}
+
+DisplayListBuilder& DisplayListBuilder::Close()
+{
+    PushOp(DisplayListOp::CLOSE);
+    return *this;
+}
+
+DisplayListBuilder& DisplayListBuilder::Fill()
+{
+    PushOp(DisplayListOp::FILL);
+    return *this;
+}
+
+DisplayListBuilder& DisplayListBuilder::Stroke()
+{
+    PushOp(DisplayListOp::STROKE);
+    return *this;
+}
+
+void DisplayListBuilder::PushOp(DisplayListOp op)
+{
+    words_.push_back(static_cast<uint32_t>(op));
+}
+
+void DisplayListBuilder::PushFloat(float value)
+{
+    uint32_t word;
+    memcpy(&word, &value, sizeof(word));
+    words_.push_back(word);
+}
@@ -0,0 +1,171 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#ifndef DISPLAY_LIST_H
+#define DISPLAY_LIST_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Binary display-list format, filled in by ArkTS and handed over as one
+// ArrayBuffer. The list is a stream of little-endian 32-bit words: an opcode
+// word followed by that opcode's arguments. Coordinates and widths are
+// float32, colors are 0xAARRGGBB.
+//
+//   CLEAR   color      fill the whole surface, dropping everything drawn so far
+//   COLOR   color      color used by the following FILL/STROKE
+//   WIDTH   width      stroke width used by the following STROKE
+//   MOVE_TO x y        start a new sub-path
+//   LINE_TO x y
+//   QUAD_TO x1 y1 x2 y2         quadratic Bezier from the current point
+//   CUBIC_TO x1 y1 x2 y2 x3 y3  cubic Bezier from the current point
+//   ARC_TO cx cy radius start sweep
+//                      a line from the current point to the start of the arc
+//                      of radius around (cx, cy), then the arc; angles in
+//                      radians, clockwise from +x, sweep negative to go back
+//   ROUND_RECT left top right bottom radius
+//                      a closed sub-path of its own; radius 0 is a plain rect
+//   CLOSE              close the current sub-path
+//   FILL               fill the current path, then start an empty one
+//   STROKE             stroke the current path, then start an empty one
+//   LAYER_BEGIN id     start static content, kept as layer id
+//   LAYER_END          end it
+//
+// Radii are never negative.
+//
+// What lies between LAYER_BEGIN and LAYER_END is static: a renderer may draw
+// it once into a layer and composite that onto later frames, until the
+// content changes. Layers start with the COLOR and WIDTH in effect, and
+// changes inside them end with them. They do not nest, hold no CLEAR, start
+// and end with no path under construction, and have ids below
+// MAX_LAYER_ID.
+enum class DisplayListOp : uint32_t {
+    CLEAR = 1,
+    COLOR = 2,
+    WIDTH = 3,
+    MOVE_TO = 4,
+    LINE_TO = 5,
+    CLOSE = 6,
+    FILL = 7,
+    STROKE = 8,
+    QUAD_TO = 9,
+    CUBIC_TO = 10,
+    ARC_TO = 11,
+    ROUND_RECT = 12,
+    LAYER_BEGIN = 13,
+    LAYER_END = 14,
+};
+
+// Float bounds of the path a FILL or STROKE draws, before stroke outset.
+// Curves count with their control points, which contain them, and arcs
+// with their whole circle.
+struct DrawBounds {
+    float left;
+    float top;
+    float right;
+    float bottom;
+};
+
+// Receives a display list as it is replayed. Path calls build the current
+// path; Fill/Stroke draw it with the state in effect and then reset it.
+class DisplayListSink {
+public:
+    virtual ~DisplayListSink() = default;
+
+    virtual void Clear(uint32_t color) = 0;
+    virtual void MoveTo(float x, float y) = 0;
+    virtual void LineTo(float x, float y) = 0;
+    virtual void QuadTo(float x1, float y1, float x2, float y2) = 0;
+    virtual void CubicTo(float x1, float y1, float x2, float y2, float x3, float y3) = 0;
+    virtual void ArcTo(float cx, float cy, float radius, float startAngle, float sweep) = 0;
+    virtual void RoundRect(float left, float top, float right, float bottom, float radius) = 0;
+    virtual void Close() = 0;
+    virtual void Fill(uint32_t color, const DrawBounds& bounds) = 0;
+    virtual void Stroke(uint32_t color, float width, const DrawBounds& bounds) = 0;
+
+    // A layer's content draws within bounds, strokes included; content
+    // changes whenever what it draws does. Return false to skip it, e.g.
+    // when a copy drawn earlier is composited instead; EndLayer() follows a
+    // true return. By default layers are drawn like the rest of the list.
+    virtual bool BeginLayer(uint32_t, const DrawBounds&, uint64_t)
+    {
+        return true;
+    }
+    virtual void EndLayer()
+    {
+    }
+};
+
+// A validated, immutable copy of one display list
+class DisplayList {
+public:
+    // Longest list accepted, in words; bounds what one NAPI call can allocate
+    static constexpr size_t MAX_WORDS = 1u << 22;
+    static constexpr uint32_t MAX_LAYER_ID = 1u << 31;
+
+    DisplayList() = default;
+
+    // Copy and validate a list. Fails, leaving the list empty, on a size that
+    // is not a whole number of words, an unknown opcode, a truncated argument
+    // list, a non-finite coordinate, a negative radius or a layer that breaks
+    // the rules above.
+    bool Load(const void* data, size_t size);
+
+    // Whether data holds exactly the bytes this list was loaded from
+    bool Equals(const void* data, size_t size) const;
+
+    void Replay(DisplayListSink& sink) const;
+
+    size_t SizeInBytes() const
+    {
+        return words_.size() * sizeof(uint32_t);
+    }
+
+    bool IsEmpty() const
+    {
+        return words_.empty();
+    }
+
+private:
+    std::vector<uint32_t> words_;
+};
+
+// Builds a list in the binary format, for native callers and tests
+class DisplayListBuilder {
+public:
+    DisplayListBuilder& Clear(uint32_t color);
+    DisplayListBuilder& Color(uint32_t color);
+    DisplayListBuilder& Width(float width);
+    DisplayListBuilder& MoveTo(float x, float y);
+    DisplayListBuilder& LineTo(float x, float y);
+    DisplayListBuilder& QuadTo(float x1, float y1, float x2, float y2);
+    DisplayListBuilder& CubicTo(float x1, float y1, float x2, float y2, float x3, float y3);
+    DisplayListBuilder& ArcTo(float cx, float cy, float radius, float startAngle, float sweep);
+    DisplayListBuilder& RoundRect(float left, float top, float right, float bottom, float radius);
+    DisplayListBuilder& LayerBegin(uint32_t id);
+    DisplayListBuilder& LayerEnd();
+    DisplayListBuilder& Close();
+    DisplayListBuilder& Fill();
+    DisplayListBuilder& Stroke();
+
+    const void* Data() const
+    {
+        return words_.data();
+    }
+
+    size_t Size() const
+    {
+        return words_.size() * sizeof(uint32_t);
+    }
+
+private:
+    void PushOp(DisplayListOp op);
+    void PushFloat(float value);
+
+    std::vector<uint32_t> words_;
+};
+
+#endif // DISPLAY_LIST_H
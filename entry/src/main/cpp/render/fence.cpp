@@ -0,0 +1,42 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#include "fence.h"
+#include <cerrno>
+#include <poll.h>
+#include <unistd.h>
+
+FenceStatus PollFence(int fenceFd)
+{
+    return WaitFence(fenceFd, 0);
+}
+
+FenceStatus WaitFence(int fenceFd, int timeoutMs)
+{
+    if (fenceFd < 0) {
+        return FenceStatus::SIGNALED;
+    }
+    struct pollfd fd = {fenceFd, POLLIN, 0};
+    int ready;
+    do {
+        ready = poll(&fd, 1, timeoutMs);
+    } while ((ready < 0) && (errno == EINTR));
+
+    if (ready == 0) {
+        return FenceStatus::PENDING;
+    }
+    if ((ready < 0) || ((fd.revents & (POLLERR | POLLNVAL)) != 0)) {
+        return FenceStatus::INVALID;
+    }
+    return FenceStatus::SIGNALED;
+}
+
+void CloseFence(int& fenceFd)
+{
+    if (fenceFd >= 0) {
+        close(fenceFd);
+        fenceFd = -1;
+    }
+}
@@ -0,0 +1,28 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#ifndef FENCE_H
+#define FENCE_H
+
+// Sync fences as handed out with window buffers: a pollable fd that becomes
+// readable once the other side is done with the buffer. -1 means no fence,
+// which counts as signaled.
+enum class FenceStatus {
+    SIGNALED,
+    PENDING,
+    // Not a usable fence; waiting on it would never end
+    INVALID,
+};
+
+// Whether the fence has signaled, without waiting
+FenceStatus PollFence(int fenceFd);
+
+// Wait up to timeoutMs for the fence (-1 waits for as long as it takes)
+FenceStatus WaitFence(int fenceFd, int timeoutMs);
+
+// Close the fence if there is one, leaving fenceFd at -1
+void CloseFence(int& fenceFd);
+
+#endif // FENCE_H
@@ -0,0 +1,100 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#include "frame_arena.h"
+#include "staging_memory.h"
+#include <algorithm>
+
+namespace {
+
+// Block data starts past the header at the largest alignment handed out
+constexpr size_t BLOCK_HEADER = (sizeof(void*) + sizeof(size_t) + alignof(std::max_align_t) - 1) /
+    alignof(std::max_align_t) * alignof(std::max_align_t);
+
+} // namespace
+
+FrameArena::~FrameArena() noexcept
+{
+    Release();
+}
+
+uint8_t* FrameArena::BlockData(Block* block)
+{
+    return reinterpret_cast<uint8_t*>(block) + BLOCK_HEADER;
+}
+
+void* FrameArena::Allocate(size_t bytes, size_t alignment)
+{
+    size_t start = (offset_ + alignment - 1) & ~(alignment - 1);
+    if ((current_ == nullptr) || (start + bytes > current_->size)) {
+        // The rest of the current block, if any, goes unused this frame
+        if (current_ != nullptr) {
+            used_ += current_->size - offset_;
+        }
+        AddBlock(bytes);
+        start = 0;
+    }
+    used_ += start + bytes - offset_;
+    offset_ = start + bytes;
+    return BlockData(current_) + start;
+}
+
+void FrameArena::AddBlock(size_t minBytes)
+{
+    // Each block at least doubles what the arena holds, so a frame needs
+    // few of them however far it outgrows the last one
+    size_t held = static_cast<size_t>(capacity_.load(std::memory_order_relaxed));
+    size_t size = StagingMemory::SizeClass(std::max({minBytes, MIN_BLOCK_SIZE, held}));
+    // Out of memory is reported the way the containers using the arena would
+    Block* block = static_cast<Block*>(::operator new(BLOCK_HEADER + size));
+    block->next = nullptr;
+    block->size = size;
+    if (current_ == nullptr) {
+        first_ = block;
+    } else {
+        current_->next = block;
+    }
+    current_ = block;
+    offset_ = 0;
+    capacity_.fetch_add(size, std::memory_order_relaxed);
+    blockAllocations_.fetch_add(1, std::memory_order_relaxed);
+    frameBlocks_++;
+}
+
+void FrameArena::Reset()
+{
+    uint64_t peak = peak_.load(std::memory_order_relaxed);
+    if ((frameBlocks_ != 0) && (used_ <= peak)) {
+        steadyAllocations_.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (used_ > peak) {
+        peak_.store(used_, std::memory_order_relaxed);
+    }
+
+    // A frame that spilled over into more blocks gets them as one from now
+    // on, with a quarter of headroom
+    if ((first_ != nullptr) && (first_->next != nullptr)) {
+        size_t wanted = used_ + used_ / 4;
+        Release();
+        AddBlock(wanted);
+    }
+    current_ = first_;
+    offset_ = 0;
+    used_ = 0;
+    frameBlocks_ = 0;
+}
+
+void FrameArena::Release()
+{
+    while (first_ != nullptr) {
+        Block* next = first_->next;
+        ::operator delete(first_);
+        first_ = next;
+    }
+    current_ = nullptr;
+    offset_ = 0;
+    used_ = 0;
+    capacity_.store(0, std::memory_order_relaxed);
+}
@@ -0,0 +1,151 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#ifndef FRAME_ARENA_H
+#define FRAME_ARENA_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <vector>
+
+struct FrameArenaStats {
+    // Bytes the blocks held now can hand out
+    uint64_t capacity;
+    // Most bytes any frame has used
+    uint64_t peakBytes;
+    // Blocks taken from the heap over the lifetime
+    uint64_t blockAllocations;
+    // Frames that took a block from the heap although they used no more
+    // than an earlier frame. Always 0 unless the arena sizes its blocks
+    // wrong: steady-state frames must not allocate.
+    uint64_t steadyAllocations;
+};
+
+// Bump allocator for data that lives for one frame. Allocating moves a
+// pointer; freeing does nothing; Reset() takes everything back at once.
+//
+// Memory comes from blocks. A frame that outgrows the current block gets
+// another one, and the Reset() after it replaces the blocks with a single
+// one big enough for that frame plus headroom. From then on a frame that
+// needs no more than any earlier one allocates nothing from the heap.
+//
+// Used from one thread; GetStats() may be called from any thread.
+class FrameArena {
+public:
+    // Smallest block taken from the heap
+    static constexpr size_t MIN_BLOCK_SIZE = 64 * 1024;
+
+    FrameArena() = default;
+    ~FrameArena() noexcept;
+
+    FrameArena(const FrameArena&) = delete;
+    FrameArena& operator=(const FrameArena&) = delete;
+
+    // bytes at a multiple of alignment, a power of two up to
+    // alignof(std::max_align_t). Fails as operator new does.
+    void* Allocate(size_t bytes, size_t alignment);
+
+    // Make all memory handed out since the last Reset() available again
+    void Reset();
+
+    // Give every block back to the heap; what was handed out is gone, as
+    // after Reset()
+    void Release();
+
+    // Bytes handed out since the last Reset(), alignment included
+    size_t GetUsedBytes() const
+    {
+        return used_;
+    }
+    FrameArenaStats GetStats() const
+    {
+        return FrameArenaStats {capacity_.load(std::memory_order_relaxed), peak_.load(std::memory_order_relaxed),
+            blockAllocations_.load(std::memory_order_relaxed), steadyAllocations_.load(std::memory_order_relaxed)};
+    }
+
+private:
+    struct Block {
+        Block* next;
+        size_t size;
+    };
+
+    void AddBlock(size_t minBytes);
+    static uint8_t* BlockData(Block* block);
+
+    // Oldest first; current_, the last, is the one being bumped through
+    Block* first_ = nullptr;
+    Block* current_ = nullptr;
+    size_t offset_ = 0;
+    size_t used_ = 0;
+    uint64_t frameBlocks_ = 0;
+    std::atomic<uint64_t> capacity_ {0};
+    std::atomic<uint64_t> peak_ {0};
+    std::atomic<uint64_t> blockAllocations_ {0};
+    std::atomic<uint64_t> steadyAllocations_ {0};
+};
+
+// Standard allocator over a FrameArena, for containers of per-frame data.
+// Without an arena it falls back to the heap, so containers built before
+// an arena is set keep working. Memory from an arena is only valid until
+// its next Reset(): the container has to be dropped or replaced by then.
+template <typename T>
+class FrameAllocator {
+public:
+    using value_type = T;
+    // Moving or swapping containers carries the arena with the memory
+    using propagate_on_container_copy_assignment = std::true_type;
+    using propagate_on_container_move_assignment = std::true_type;
+    using propagate_on_container_swap = std::true_type;
+
+    FrameAllocator() noexcept = default;
+    explicit FrameAllocator(FrameArena* arena) noexcept : arena_(arena) {}
+    template <typename U>
+    FrameAllocator(const FrameAllocator<U>& other) noexcept : arena_(other.GetArena())
+    {
+    }
+
+    T* allocate(size_t count)
+    {
+        if (arena_ == nullptr) {
+            return static_cast<T*>(::operator new(count * sizeof(T)));
+        }
+        return static_cast<T*>(arena_->Allocate(count * sizeof(T), alignof(T)));
+    }
+    void deallocate(T* pointer, size_t) noexcept
+    {
+        // Arena memory comes back all at once in Reset()
+        if (arena_ == nullptr) {
+            ::operator delete(pointer);
+        }
+    }
+
+    FrameArena* GetArena() const noexcept
+    {
+        return arena_;
+    }
+
+private:
+    FrameArena* arena_ = nullptr;
+};
+
+template <typename T, typename U>
+bool operator==(const FrameAllocator<T>& a, const FrameAllocator<U>& b) noexcept
+{
+    return a.GetArena() == b.GetArena();
+}
+
+template <typename T, typename U>
+bool operator!=(const FrameAllocator<T>& a, const FrameAllocator<U>& b) noexcept
+{
+    return a.GetArena() != b.GetArena();
+}
+
+template <typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+
+#endif // FRAME_ARENA_H
@@ -0,0 +1,134 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#include "frame_scheduler.h"
+
+TimerVsyncSource::TimerVsyncSource(std::chrono::nanoseconds period, Callback callback)
+    : period_(period), callback_(std::move(callback))
+{
+    thread_ = std::thread(&TimerVsyncSource::Run, this);
+}
+
+TimerVsyncSource::~TimerVsyncSource() noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    wakeup_.notify_one();
+    thread_.join();
+}
+
+bool TimerVsyncSource::RequestVsync()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (stopping_) {
+            return false;
+        }
+        requested_ = true;
+    }
+    wakeup_.notify_one();
+    return true;
+}
+
+void TimerVsyncSource::Run()
+{
+    using Clock = std::chrono::steady_clock;
+    const Clock::time_point origin = Clock::now();
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        wakeup_.wait(lock, [this] { return requested_ || stopping_; });
+        if (stopping_) {
+            return;
+        }
+        // Like a display, tick on a fixed grid rather than a period after the request
+        Clock::time_point now = Clock::now();
+        Clock::time_point next = origin + ((now - origin) / period_ + 1) * period_;
+        if (wakeup_.wait_until(lock, next, [this] { return stopping_; })) {
+            return;
+        }
+        requested_ = false;
+        lock.unlock();
+        callback_(std::chrono::duration_cast<std::chrono::nanoseconds>(next.time_since_epoch()).count());
+        lock.lock();
+    }
+}
+
+FrameScheduler::FrameScheduler(std::function<void()> wake) : wake_(std::move(wake))
+{
+}
+
+void FrameScheduler::SetVsyncSource(VsyncSource* source)
+{
+    source_ = source;
+}
+
+void FrameScheduler::RequestFrame()
+{
+    requests_.fetch_add(1, std::memory_order_relaxed);
+    pending_.store(true, std::memory_order_release);
+    RequestVsync();
+}
+
+void FrameScheduler::OnVsync(int64_t timestampNs)
+{
+    vsyncTimestamp_.store(timestampNs, std::memory_order_relaxed);
+    // Cleared before waking the render thread, so a request that comes in
+    // while the frame is drawn asks for the next vsync
+    vsyncRequested_.store(false, std::memory_order_release);
+    vsyncArrived_.store(true, std::memory_order_release);
+    wake_();
+}
+
+bool FrameScheduler::FrameDue()
+{
+    if (!vsyncArrived_.exchange(false, std::memory_order_acq_rel)) {
+        return false;
+    }
+    return pending_.exchange(false, std::memory_order_acq_rel);
+}
+
+void FrameScheduler::FrameDone()
+{
+    frames_.fetch_add(1, std::memory_order_relaxed);
+}
+
+void FrameScheduler::SkipFrame()
+{
+    skipped_.fetch_add(1, std::memory_order_relaxed);
+    pending_.store(true, std::memory_order_release);
+    RequestVsync();
+}
+
+void FrameScheduler::ThrottleFrame()
+{
+    throttled_.fetch_add(1, std::memory_order_relaxed);
+    pending_.store(true, std::memory_order_release);
+}
+
+void FrameScheduler::ResumeFrame()
+{
+    if (pending_.load(std::memory_order_acquire)) {
+        RequestVsync();
+    }
+}
+
+FrameSchedulerStats FrameScheduler::GetStats() const
+{
+    return FrameSchedulerStats {requests_.load(std::memory_order_relaxed), frames_.load(std::memory_order_relaxed),
+        skipped_.load(std::memory_order_relaxed), throttled_.load(std::memory_order_relaxed)};
+}
+
+void FrameScheduler::RequestVsync()
+{
+    // One vsync in flight at a time; everything until it arrives shares it
+    if (vsyncRequested_.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+    if ((source_ == nullptr) || !source_->RequestVsync()) {
+        vsyncRequested_.store(false, std::memory_order_release);
+    }
+}
@@ -0,0 +1,132 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#ifndef FRAME_SCHEDULER_H
+#define FRAME_SCHEDULER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+// Delivers vsync signals, one per RequestVsync(), to the callback given at
+// construction. The callback runs on a thread owned by the source.
+class VsyncSource {
+public:
+    using Callback = std::function<void(int64_t timestampNs)>;
+
+    virtual ~VsyncSource() = default;
+
+    // Ask for one callback at the next vsync. False if it cannot be delivered.
+    virtual bool RequestVsync() = 0;
+};
+
+// Stand-in for the display's vsync on hosts and when the native one is not
+// available: ticks every period, on its own thread, while someone asked.
+class TimerVsyncSource : public VsyncSource {
+public:
+    TimerVsyncSource(std::chrono::nanoseconds period, Callback callback);
+    ~TimerVsyncSource() noexcept override;
+
+    TimerVsyncSource(const TimerVsyncSource&) = delete;
+    TimerVsyncSource& operator=(const TimerVsyncSource&) = delete;
+
+    bool RequestVsync() override;
+
+private:
+    void Run();
+
+    const std::chrono::nanoseconds period_;
+    Callback callback_;
+    std::mutex mutex_;
+    std::condition_variable wakeup_;
+    bool requested_ = false;
+    bool stopping_ = false;
+    std::thread thread_;
+};
+
+struct FrameSchedulerStats {
+    // Calls to RequestFrame()
+    uint64_t requests;
+    // Frames actually drawn; requests - frames were merged into other frames
+    uint64_t frames;
+    // Vsyncs passed up because the previous buffer was still in use
+    uint64_t skipped;
+    // Vsyncs passed up on purpose: to draw a background surface less often,
+    // or to redraw for a resize that cannot apply yet
+    uint64_t throttled;
+};
+
+// Paces drawing to vsync. Every RequestFrame() made before the next vsync is
+// served by one frame, drawn on the render thread after that vsync:
+//
+//   any thread:     RequestFrame()
+//   vsync thread:   OnVsync()  -> wake(), which should wake the render thread
+//   render thread:  if (FrameDue()) { draw; FrameDone() } or SkipFrame()
+//
+// If the render thread cannot draw when the frame is due, e.g. because the
+// consumer still holds the buffer it would draw into, SkipFrame() moves the
+// frame to the following vsync instead of blocking the thread. ThrottleFrame()
+// keeps a frame the render thread chooses to draw later pending without
+// asking for any vsync; ResumeFrame() asks for one once it is time, and so
+// does the next RequestFrame().
+class FrameScheduler {
+public:
+    explicit FrameScheduler(std::function<void()> wake);
+
+    FrameScheduler(const FrameScheduler&) = delete;
+    FrameScheduler& operator=(const FrameScheduler&) = delete;
+
+    // Where vsyncs are requested from. Set before the first RequestFrame().
+    void SetVsyncSource(VsyncSource* source);
+
+    // Any thread
+    void RequestFrame();
+
+    // Vsync thread; the source's callback
+    void OnVsync(int64_t timestampNs);
+
+    // Render thread. True if a vsync has passed with a frame pending; the
+    // caller then draws it and calls FrameDone(), or calls SkipFrame() or
+    // ThrottleFrame().
+    bool FrameDue();
+    void FrameDone();
+    void SkipFrame();
+    void ThrottleFrame();
+    // Any thread
+    void ResumeFrame();
+
+    // Timestamp of the vsync the current frame is for
+    int64_t GetVsyncTimestamp() const
+    {
+        return vsyncTimestamp_.load(std::memory_order_relaxed);
+    }
+
+    FrameSchedulerStats GetStats() const;
+
+private:
+    void RequestVsync();
+
+    std::function<void()> wake_;
+    VsyncSource* source_ = nullptr;
+
+    // Requests not served by a frame yet
+    std::atomic<bool> pending_ {false};
+    // A vsync has been asked for and has not arrived
+    std::atomic<bool> vsyncRequested_ {false};
+    // A vsync arrived and the render thread has not looked at it
+    std::atomic<bool> vsyncArrived_ {false};
+    std::atomic<int64_t> vsyncTimestamp_ {0};
+
+    std::atomic<uint64_t> requests_ {0};
+    std::atomic<uint64_t> frames_ {0};
+    std::atomic<uint64_t> skipped_ {0};
+    std::atomic<uint64_t> throttled_ {0};
+};
+
+#endif // FRAME_SCHEDULER_H
@@ -0,0 +1,77 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#include "frame_stats.h"
+#include <algorithm>
+
+namespace {
+
+// Nearest rank: the smallest sample with at least percent of them at or below it
+uint32_t Percentile(const uint32_t* sorted, uint32_t count, uint32_t percent)
+{
+    uint32_t rank = (count * percent + 99) / 100;
+    return sorted[std::max(rank, 1u) - 1];
+}
+
+FramePercentiles SummarizePhase(uint32_t* samples, uint32_t count)
+{
+    if (count == 0) {
+        return FramePercentiles {0, 0, 0};
+    }
+    std::sort(samples, samples + count);
+    return FramePercentiles {Percentile(samples, count, 50), Percentile(samples, count, 95),
+        Percentile(samples, count, 99)};
+}
+
+} // namespace
+
+void FrameStats::Record(const FrameTiming& timing, int64_t vsyncPeriodNs)
+{
+    if (static_cast<int64_t>(timing.totalUs) * 1000 > vsyncPeriodNs) {
+        late_.fetch_add(1, std::memory_order_relaxed);
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    ring_[recorded_ % CAPACITY] = timing;
+    recorded_++;
+}
+
+void FrameStats::CountDropped()
+{
+    dropped_.fetch_add(1, std::memory_order_relaxed);
+}
+
+FrameStatsSummary FrameStats::Summarize() const
+{
+    std::array<FrameTiming, CAPACITY> frames;
+    uint64_t recorded = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        frames = ring_;
+        recorded = recorded_;
+    }
+    uint32_t count = static_cast<uint32_t>(std::min<uint64_t>(recorded, CAPACITY));
+
+    FrameStatsSummary summary {};
+    summary.sampled = count;
+    summary.presented = recorded;
+    summary.late = late_.load(std::memory_order_relaxed);
+    summary.dropped = dropped_.load(std::memory_order_relaxed);
+
+    std::array<uint32_t, CAPACITY> samples;
+    auto phase = [&frames, &samples, count](uint32_t FrameTiming::*field) {
+        for (uint32_t i = 0; i < count; i++) {
+            samples[i] = frames[i].*field;
+        }
+        return SummarizePhase(samples.data(), count);
+    };
+    summary.acquire = phase(&FrameTiming::acquireUs);
+    summary.prepare = phase(&FrameTiming::prepareUs);
+    summary.raster = phase(&FrameTiming::rasterUs);
+    summary.blit = phase(&FrameTiming::blitUs);
+    summary.flush = phase(&FrameTiming::flushUs);
+    summary.total = phase(&FrameTiming::totalUs);
+    summary.slot = phase(&FrameTiming::slotUs);
+    return summary;
+}
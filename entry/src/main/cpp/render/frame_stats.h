@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#ifndef FRAME_STATS_H
+#define FRAME_STATS_H
+
+#include "frame_timing.h"
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#if defined(__OHOS__)
+#include <hitrace/trace.h>
+#endif
+
+// A hitrace span over a scope on the device, so frame phases show up in
+// traces; nothing on the host. Spans nest, and must, being scopes.
+class FrameTraceScope {
+public:
+    explicit FrameTraceScope(const char* name)
+    {
+#if defined(__OHOS__)
+        OH_HiTrace_StartTrace(name);
+#else
+        (void)name;
+#endif
+    }
+
+    ~FrameTraceScope() noexcept
+    {
+#if defined(__OHOS__)
+        OH_HiTrace_FinishTrace();
+#endif
+    }
+
+    FrameTraceScope(const FrameTraceScope&) = delete;
+    FrameTraceScope& operator=(const FrameTraceScope&) = delete;
+};
+
+struct FramePercentiles {
+    uint32_t p50Us;
+    uint32_t p95Us;
+    uint32_t p99Us;
+};
+
+struct FrameStatsSummary {
+    // Presented frames the percentiles are over: the latest, up to FrameStats::CAPACITY
+    uint32_t sampled;
+    FramePercentiles acquire;
+    FramePercentiles prepare;
+    FramePercentiles raster;
+    FramePercentiles blit;
+    FramePercentiles flush;
+    FramePercentiles total;
+    FramePercentiles slot;
+    // Frames presented since the start
+    uint64_t presented;
+    // Presented frames that took longer than a vsync period
+    uint64_t late;
+    // Draw requests turned away by a full render queue, and frames that
+    // failed to present
+    uint64_t dropped;
+    // Vsyncs passed up because the buffer was still in use; filled in by
+    // the owner, which has the scheduler
+    uint64_t skipped;
+    // Vsyncs passed up on purpose, e.g. for a background surface; filled in
+    // the same way
+    uint64_t throttled;
+};
+
+// Timing of the latest frames, kept in a fixed ring so recording never
+// allocates:
+//
+//   render thread:  Record(timing, period) per presented frame
+//   any thread:     CountDropped() per request lost, Summarize()
+//
+// Summarize() copies the ring out under a lock held only for the copy, and
+// works out the percentiles outside it.
+class FrameStats {
+public:
+    // Four seconds at 60 Hz
+    static constexpr size_t CAPACITY = 256;
+
+    FrameStats() = default;
+    FrameStats(const FrameStats&) = delete;
+    FrameStats& operator=(const FrameStats&) = delete;
+
+    void Record(const FrameTiming& timing, int64_t vsyncPeriodNs);
+    void CountDropped();
+
+    FrameStatsSummary Summarize() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::array<FrameTiming, CAPACITY> ring_ {};
+    // Frames recorded; the ring holds the last min(recorded_, CAPACITY)
+    uint64_t recorded_ = 0;
+
+    std::atomic<uint64_t> late_ {0};
+    std::atomic<uint64_t> dropped_ {0};
+};
+
+#endif // FRAME_STATS_H
@@ -0,0 +1,38 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#ifndef FRAME_TIMING_H
+#define FRAME_TIMING_H
+
+#include <chrono>
+#include <cstdint>
+
+// Wall time spent in each phase of one frame, in microseconds
+struct FrameTiming {
+    // RequestBuffer, and the wait for its release fence
+    uint32_t acquireUs;
+    // Mapping the buffer, canvas setup
+    uint32_t prepareUs;
+    // Canvas draw calls
+    uint32_t rasterUs;
+    // Copy from the staging bitmap into the window buffer (0 when zero-copy)
+    uint32_t blitUs;
+    // FlushBuffer
+    uint32_t flushUs;
+    // From the vsync being handled to the flush, all of the above included
+    uint32_t totalUs;
+    // Waiting for a raster slot while other surfaces' frames drew; part of
+    // totalUs
+    uint32_t slotUs;
+};
+
+using FrameClock = std::chrono::steady_clock;
+
+inline uint32_t ElapsedUs(FrameClock::time_point start, FrameClock::time_point end)
+{
+    return static_cast<uint32_t>(std::chrono::duration_cast<std::chrono::microseconds>(end - start).count());
+}
+
+#endif // FRAME_TIMING_H
@@ -0,0 +1,136 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#ifndef GEOMETRY_CACHE_H
+#define GEOMETRY_CACHE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Identifies one piece of built geometry. Geometry is laid out from the
+// surface size, so the size is part of the key; style is whatever else the
+// caller's geometry depends on.
+struct GeometryKey {
+    uint32_t shapeId;
+    uint32_t width;
+    uint32_t height;
+    uint32_t style;
+
+    bool operator==(const GeometryKey& other) const
+    {
+        return (shapeId == other.shapeId) && (width == other.width) && (height == other.height) &&
+            (style == other.style);
+    }
+};
+
+struct GeometryCacheStats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    uint32_t size;
+    uint32_t capacity;
+};
+
+// Small memo of built geometry (paths and the like), least recently used
+// entry evicted first. Lookups are a linear scan: the cache holds a handful
+// of static shapes, not a scene. Used from one thread; GetStats() may be
+// called from any thread.
+template <typename T>
+class GeometryCache {
+public:
+    // Frees a value when it is evicted or cleared
+    using Releaser = void (*)(T& value);
+
+    static constexpr size_t DEFAULT_CAPACITY = 16;
+
+    explicit GeometryCache(Releaser release, size_t capacity = DEFAULT_CAPACITY)
+        : release_(release), capacity_(capacity == 0 ? 1 : capacity)
+    {
+        entries_.reserve(capacity_);
+    }
+
+    ~GeometryCache() noexcept
+    {
+        Clear();
+    }
+
+    GeometryCache(const GeometryCache&) = delete;
+    GeometryCache& operator=(const GeometryCache&) = delete;
+
+    // The cached value for key, or nullptr. Counts a hit or a miss.
+    T* Find(const GeometryKey& key)
+    {
+        for (Entry& entry : entries_) {
+            if (entry.key == key) {
+                entry.lastUse = ++useClock_;
+                hits_.fetch_add(1, std::memory_order_relaxed);
+                return &entry.value;
+            }
+        }
+        misses_.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    // Store a value the caller has just built after a miss; the cache owns it
+    // from here on. Returns where it is stored.
+    T* Insert(const GeometryKey& key, T value)
+    {
+        if (entries_.size() == capacity_) {
+            size_t oldest = 0;
+            for (size_t i = 1; i < entries_.size(); i++) {
+                if (entries_[i].lastUse < entries_[oldest].lastUse) {
+                    oldest = i;
+                }
+            }
+            release_(entries_[oldest].value);
+            entries_[oldest] = entries_.back();
+            entries_.pop_back();
+            evictions_.fetch_add(1, std::memory_order_relaxed);
+        }
+        entries_.push_back(Entry {key, value, ++useClock_});
+        size_.store(static_cast<uint32_t>(entries_.size()), std::memory_order_relaxed);
+        return &entries_.back().value;
+    }
+
+    // Drop every entry, e.g. when the surface size changes. The counters are
+    // kept; they describe the whole lifetime of the cache.
+    void Clear()
+    {
+        for (Entry& entry : entries_) {
+            release_(entry.value);
+        }
+        entries_.clear();
+        size_.store(0, std::memory_order_relaxed);
+    }
+
+    GeometryCacheStats GetStats() const
+    {
+        return GeometryCacheStats {hits_.load(std::memory_order_relaxed), misses_.load(std::memory_order_relaxed),
+            evictions_.load(std::memory_order_relaxed), size_.load(std::memory_order_relaxed),
+            static_cast<uint32_t>(capacity_)};
+    }
+
+private:
+    struct Entry {
+        GeometryKey key;
+        T value;
+        uint64_t lastUse;
+    };
+
+    Releaser release_;
+    size_t capacity_;
+    std::vector<Entry> entries_;
+    uint64_t useClock_ = 0;
+
+    // Written by the owning thread, read by GetStats() from anywhere
+    std::atomic<uint64_t> hits_ {0};
+    std::atomic<uint64_t> misses_ {0};
+    std::atomic<uint64_t> evictions_ {0};
+    std::atomic<uint32_t> size_ {0};
+};
+
+#endif // GEOMETRY_CACHE_H
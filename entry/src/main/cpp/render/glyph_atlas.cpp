@@ -0,0 +1,161 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#include "glyph_atlas.h"
+#include "stroke_font.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Distance from (px, py) to the segment (x0, y0)-(x1, y1)
+float SegmentDistance(float px, float py, float x0, float y0, float x1, float y1)
+{
+    float dx = x1 - x0;
+    float dy = y1 - y0;
+    float lengthSq = dx * dx + dy * dy;
+    float t = (lengthSq > 0.0f) ? ((px - x0) * dx + (py - y0) * dy) / lengthSq : 0.0f;
+    t = std::min(std::max(t, 0.0f), 1.0f);
+    float ex = px - (x0 + t * dx);
+    float ey = py - (y0 + t * dy);
+    return std::sqrt(ex * ex + ey * ey);
+}
+
+uint8_t Blend(uint32_t src, uint32_t dst, uint32_t alpha)
+{
+    return static_cast<uint8_t>((src * alpha + dst * (255 - alpha) + 127) / 255);
+}
+
+} // namespace
+
+void GlyphAtlas::Build(float capHeight)
+{
+    capHeight = std::min(std::max(capHeight, MIN_CAP_HEIGHT), MAX_CAP_HEIGHT);
+    if (IsBuilt() && (capHeight == capHeight_)) {
+        return;
+    }
+
+    float scale = capHeight / StrokeFont::GLYPH_HEIGHT;
+    float halfStroke = std::max(capHeight / 10.0f, 1.0f) / 2;
+    // Room around the glyph box for half a stroke plus anti-aliasing
+    uint32_t pad = static_cast<uint32_t>(std::ceil(halfStroke)) + 1;
+
+    capHeight_ = capHeight;
+    cellWidth_ = static_cast<uint32_t>(std::ceil(StrokeFont::GLYPH_WIDTH * scale)) + 2 * pad;
+    cellHeight_ = static_cast<uint32_t>(std::ceil(StrokeFont::GLYPH_HEIGHT * scale)) + 2 * pad;
+    advance_ = static_cast<uint32_t>(std::lround(StrokeFont::GLYPH_ADVANCE * scale));
+
+    size_t cellSize = static_cast<size_t>(cellWidth_) * cellHeight_;
+    int glyphCount = StrokeFont::GetGlyphCount();
+    coverage_.assign(cellSize * glyphCount, 0);
+
+    for (int glyph = 0; glyph < glyphCount; glyph++) {
+        uint8_t* cell = &coverage_[cellSize * glyph];
+        StrokeFont::ForEachSegment(StrokeFont::GetGlyphAt(glyph), [&](int ux0, int uy0, int ux1, int uy1) {
+            float x0 = pad + ux0 * scale;
+            float y0 = pad + uy0 * scale;
+            float x1 = pad + ux1 * scale;
+            float y1 = pad + uy1 * scale;
+            // Only the pixels near the segment can be covered by it
+            int left = std::max(static_cast<int>(std::floor(std::min(x0, x1) - halfStroke)) - 1, 0);
+            int top = std::max(static_cast<int>(std::floor(std::min(y0, y1) - halfStroke)) - 1, 0);
+            int right = std::min(static_cast<int>(std::ceil(std::max(x0, x1) + halfStroke)) + 1,
+                static_cast<int>(cellWidth_));
+            int bottom = std::min(static_cast<int>(std::ceil(std::max(y0, y1) + halfStroke)) + 1,
+                static_cast<int>(cellHeight_));
+            for (int y = top; y < bottom; y++) {
+                for (int x = left; x < right; x++) {
+                    float distance = SegmentDistance(x + 0.5f, y + 0.5f, x0, y0, x1, y1);
+                    float coverage = std::min(std::max(halfStroke + 0.5f - distance, 0.0f), 1.0f);
+                    uint8_t value = static_cast<uint8_t>(std::lround(coverage * 255));
+                    uint8_t& texel = cell[y * cellWidth_ + x];
+                    texel = std::max(texel, value);
+                }
+            }
+        });
+    }
+}
+
+uint32_t GlyphAtlas::MeasureWidth(const std::string& text) const
+{
+    if (text.empty() || !IsBuilt()) {
+        return 0;
+    }
+    return static_cast<uint32_t>(text.size() - 1) * advance_ + cellWidth_;
+}
+
+uint8_t GlyphAtlas::CoverageAt(char c, uint32_t x, uint32_t y) const
+{
+    if (!IsBuilt() || (x >= cellWidth_) || (y >= cellHeight_)) {
+        return 0;
+    }
+    size_t cellSize = static_cast<size_t>(cellWidth_) * cellHeight_;
+    return coverage_[cellSize * StrokeFont::GetGlyphIndex(c) + y * cellWidth_ + x];
+}
+
+BlitRect GlyphAtlas::DrawText(const PixelSurface& dst, int32_t x, int32_t y, const std::string& text,
+    uint32_t color) const
+{
+    uint32_t alpha = color >> 24;
+    if (!IsBuilt() || text.empty() || (alpha == 0) || (dst.pixels == nullptr)) {
+        return BlitRect {0, 0, 0, 0};
+    }
+
+    // Color channels in the byte order of dst
+    uint8_t red = static_cast<uint8_t>(color >> 16);
+    uint8_t green = static_cast<uint8_t>(color >> 8);
+    uint8_t blue = static_cast<uint8_t>(color);
+    uint8_t channels[4] = {red, green, blue, 0};
+    if (dst.format == PixelFormat::BGRA_8888) {
+        channels[0] = blue;
+        channels[2] = red;
+    }
+
+    int32_t penX = x;
+    for (char c : text) {
+        DrawGlyph(dst, penX, y, StrokeFont::GetGlyphIndex(c), channels, alpha);
+        penX += static_cast<int32_t>(advance_);
+    }
+
+    // The box of the whole string, clipped to dst
+    int64_t left = std::max<int64_t>(x, 0);
+    int64_t top = std::max<int64_t>(y, 0);
+    int64_t right = std::min<int64_t>(static_cast<int64_t>(x) + MeasureWidth(text), dst.width);
+    int64_t bottom = std::min<int64_t>(static_cast<int64_t>(y) + cellHeight_, dst.height);
+    if ((right <= left) || (bottom <= top)) {
+        return BlitRect {0, 0, 0, 0};
+    }
+    return BlitRect {static_cast<uint32_t>(left), static_cast<uint32_t>(top), static_cast<uint32_t>(right - left),
+        static_cast<uint32_t>(bottom - top)};
+}
+
+void GlyphAtlas::DrawGlyph(const PixelSurface& dst, int32_t x, int32_t y, int glyphIndex, const uint8_t channels[4],
+    uint32_t alpha) const
+{
+    // Clip the cell against dst
+    int64_t left = std::max<int64_t>(x, 0);
+    int64_t top = std::max<int64_t>(y, 0);
+    int64_t right = std::min<int64_t>(static_cast<int64_t>(x) + cellWidth_, dst.width);
+    int64_t bottom = std::min<int64_t>(static_cast<int64_t>(y) + cellHeight_, dst.height);
+    if ((right <= left) || (bottom <= top)) {
+        return;
+    }
+
+    const uint8_t* cell = &coverage_[static_cast<size_t>(cellWidth_) * cellHeight_ * glyphIndex];
+    for (int64_t row = top; row < bottom; row++) {
+        const uint8_t* src = cell + (row - y) * cellWidth_ + (left - x);
+        uint8_t* out = static_cast<uint8_t*>(dst.pixels) + row * dst.stride + left * 4;
+        for (int64_t col = left; col < right; col++, src++, out += 4) {
+            if (*src == 0) {
+                continue;
+            }
+            uint32_t a = (*src * alpha + 127) / 255;
+            out[0] = Blend(channels[0], out[0], a);
+            out[1] = Blend(channels[1], out[1], a);
+            out[2] = Blend(channels[2], out[2], a);
+            out[3] = static_cast<uint8_t>(a + (out[3] * (255 - a) + 127) / 255);
+        }
+    }
+}
@@ -0,0 +1,66 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#ifndef GLYPH_ATLAS_H
+#define GLYPH_ATLAS_H
+
+#include "pixel_blit.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Every glyph of the stroke font rasterized once, at one size, into an 8-bit
+// coverage atlas. Drawing text is then a masked color blend per character,
+// with no path building or stroking per frame.
+class GlyphAtlas {
+public:
+    // Sizes outside this range are clamped; keeps the atlas a few hundred KB
+    static constexpr float MIN_CAP_HEIGHT = 6.0f;
+    static constexpr float MAX_CAP_HEIGHT = 160.0f;
+
+    GlyphAtlas() = default;
+
+    // Rasterize the font with capital letters capHeight pixels tall. A no-op
+    // if the atlas is already at that size.
+    void Build(float capHeight);
+
+    bool IsBuilt() const
+    {
+        return !coverage_.empty();
+    }
+
+    float GetCapHeight() const
+    {
+        return capHeight_;
+    }
+
+    // Width and height in pixels of the box DrawText covers for text
+    uint32_t MeasureWidth(const std::string& text) const;
+    uint32_t GetLineHeight() const
+    {
+        return cellHeight_;
+    }
+
+    // Blend text in color (0xAARRGGBB) onto dst, with the top-left of the
+    // first glyph's box at (x, y). Anything outside dst is clipped. Returns
+    // the part of dst that was touched (w == 0 when nothing was).
+    BlitRect DrawText(const PixelSurface& dst, int32_t x, int32_t y, const std::string& text, uint32_t color) const;
+
+    // Coverage of one atlas pixel, for tests
+    uint8_t CoverageAt(char c, uint32_t x, uint32_t y) const;
+
+private:
+    void DrawGlyph(const PixelSurface& dst, int32_t x, int32_t y, int glyphIndex, const uint8_t channels[4],
+        uint32_t alpha) const;
+
+    float capHeight_ = 0.0f;
+    // Every glyph gets a cellWidth_ x cellHeight_ cell, one after another
+    uint32_t cellWidth_ = 0;
+    uint32_t cellHeight_ = 0;
+    uint32_t advance_ = 0;
+    std::vector<uint8_t> coverage_;
+};
+
+#endif // GLYPH_ATLAS_H
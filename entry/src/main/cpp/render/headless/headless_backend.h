@@ -0,0 +1,83 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#ifndef HEADLESS_BACKEND_H
+#define HEADLESS_BACKEND_H
+
+#include <native_window/external_window.h>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Headless backend: the parts of the OpenHarmony NDK the renderer talks to
+// (native window, native drawing, native vsync), implemented in memory and
+// on the CPU so the render code builds, runs and benchmarks on plain Linux.
+// The device build never sees any of this.
+
+// An in-memory window. Its buffers are anonymous shared memory (memfd), so
+// they are mapped through their fd exactly like real window buffers, and a
+// flushed buffer counts as on screen until the next flush replaces it.
+// Buffers are never held by a compositor, so release fences are always -1.
+class HeadlessWindow {
+public:
+    HeadlessWindow(uint32_t width, uint32_t height, uint32_t bufferCount = 3,
+        int32_t format = NATIVEBUFFER_PIXEL_FMT_RGBA_8888);
+    ~HeadlessWindow() noexcept;
+
+    HeadlessWindow(const HeadlessWindow&) = delete;
+    HeadlessWindow& operator=(const HeadlessWindow&) = delete;
+
+    // What SampleBitMap gets as its window
+    OHNativeWindow* GetNativeWindow();
+
+    // Size and format of the buffers handed out from the next request on
+    void SetGeometry(uint32_t width, uint32_t height);
+    void GetGeometry(uint32_t& width, uint32_t& height) const;
+    void SetFormat(int32_t format);
+    int32_t GetFormat() const;
+    uint32_t GetBufferCount() const;
+
+    // Copy the buffer on screen into pixels, width * height tightly packed in
+    // the buffer's byte order. False if nothing has been flushed yet.
+    bool ReadFrame(std::vector<uint32_t>& pixels, uint32_t& width, uint32_t& height) const;
+
+    uint64_t GetFlushCount() const;
+    // SetGeometry calls that changed the size: buffer reallocations
+    uint64_t GetGeometryChanges() const;
+    // Damage rects passed with the last flush; 0 means the whole buffer
+    int32_t GetLastDamageCount() const;
+
+    // The C entry points in headless_window.cpp go through these
+    int32_t RequestBuffer(OHNativeWindowBuffer** buffer, int* fenceFd);
+    int32_t FlushBuffer(OHNativeWindowBuffer* buffer, const Region& region);
+    int32_t AbortBuffer(OHNativeWindowBuffer* buffer);
+
+private:
+    bool Allocate(OHNativeWindowBuffer& buffer);
+    static void Free(OHNativeWindowBuffer& buffer);
+
+    mutable std::mutex mutex_;
+    std::unique_ptr<OHNativeWindow> window_;
+    std::vector<std::unique_ptr<OHNativeWindowBuffer>> buffers_;
+    uint32_t width_;
+    uint32_t height_;
+    int32_t format_;
+    OHNativeWindowBuffer* presented_ = nullptr;
+    uint64_t flushCount_ = 0;
+    uint64_t geometryChanges_ = 0;
+    int32_t lastDamageCount_ = 0;
+};
+
+// Simulated vsync for OH_NativeVSync. With a zero period (the default) a
+// requested frame is delivered right away, so benchmarks run as fast as the
+// renderer can draw; otherwise on a fixed grid like a display.
+namespace HeadlessVsync {
+void SetPeriod(std::chrono::nanoseconds period);
+std::chrono::nanoseconds GetPeriod();
+} // namespace HeadlessVsync
+
+#endif // HEADLESS_BACKEND_H
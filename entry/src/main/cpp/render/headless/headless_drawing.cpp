@@ -0,0 +1,557 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#include <native_drawing/drawing_bitmap.h>
+#include <native_drawing/drawing_brush.h>
+#include <native_drawing/drawing_canvas.h>
+#include <native_drawing/drawing_color.h>
+#include <native_drawing/drawing_path.h>
+#include <native_drawing/drawing_pen.h>
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+// A minimal CPU rasterizer behind the native drawing calls the renderer
+// makes. Paths are polygons; fills are nonzero scanline with 4 vertical
+// subsamples and exact horizontal coverage when anti-aliased. Strokes are
+// filled as the union of one quad per segment and one disc per vertex, so
+// every join and cap is round whatever the pen asks for.
+
+namespace {
+
+constexpr uint32_t AA_SUBSAMPLES = 4;
+constexpr float PI = 3.14159265358979f;
+// Chord length the discs of a stroke are approximated with, in pixels
+constexpr float DISC_CHORD = 2.0f;
+constexpr int MIN_DISC_SEGMENTS = 8;
+constexpr int MAX_DISC_SEGMENTS = 64;
+constexpr uint32_t DEFAULT_COLOR = 0xFF000000;
+
+struct Point {
+    float x;
+    float y;
+};
+
+using Polygon = std::vector<Point>;
+
+struct Edge {
+    float x0;
+    float y0;
+    float x1;
+    float y1;
+    // +1 going down, -1 going up
+    int winding;
+};
+
+struct Crossing {
+    float x;
+    int winding;
+};
+
+uint8_t Blend(uint32_t src, uint32_t dst, uint32_t alpha)
+{
+    return static_cast<uint8_t>((src * alpha + dst * (255 - alpha) + 127) / 255);
+}
+
+float SignedArea(const Polygon& polygon)
+{
+    float area = 0;
+    for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++) {
+        area += polygon[j].x * polygon[i].y - polygon[i].x * polygon[j].y;
+    }
+    return area / 2;
+}
+
+// All the same way round, so overlapping polygons add up rather than cancel
+void Orient(Polygon& polygon)
+{
+    if (SignedArea(polygon) < 0) {
+        std::reverse(polygon.begin(), polygon.end());
+    }
+}
+
+} // namespace
+
+struct OH_Drawing_Bitmap {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    uint32_t rowBytes = 0;
+    OH_Drawing_ColorFormat format = COLOR_FORMAT_UNKNOWN;
+    // Empty when the pixels are borrowed
+    std::vector<uint8_t> storage;
+    uint8_t* pixels = nullptr;
+};
+
+struct OH_Drawing_Pen {
+    bool antiAlias = false;
+    uint32_t color = DEFAULT_COLOR;
+    // 0 is a hairline
+    float width = 0;
+    OH_Drawing_PenLineJoinStyle join = LINE_MITER_JOIN;
+};
+
+struct OH_Drawing_Brush {
+    bool antiAlias = false;
+    uint32_t color = DEFAULT_COLOR;
+};
+
+struct OH_Drawing_Path {
+    struct Contour {
+        size_t start;
+        bool closed;
+    };
+
+    std::vector<Point> points;
+    std::vector<Contour> contours;
+    // Where a LineTo with no open contour starts from
+    Point lastMove {0, 0};
+    bool open = false;
+};
+
+// Pen and brush are copied when attached, like the native canvas does
+struct OH_Drawing_Canvas {
+    OH_Drawing_Bitmap* bitmap = nullptr;
+    OH_Drawing_Pen pen;
+    OH_Drawing_Brush brush;
+    bool hasPen = false;
+    bool hasBrush = false;
+};
+
+namespace {
+
+// Byte offsets of red, green and blue in a pixel
+struct ChannelOrder {
+    int r;
+    int g;
+    int b;
+};
+
+ChannelOrder GetChannelOrder(const OH_Drawing_Bitmap& bitmap)
+{
+    return (bitmap.format == COLOR_FORMAT_BGRA_8888) ? ChannelOrder {2, 1, 0} : ChannelOrder {0, 1, 2};
+}
+
+std::vector<Polygon> GetContours(const OH_Drawing_Path& path)
+{
+    std::vector<Polygon> polygons;
+    for (size_t i = 0; i < path.contours.size(); i++) {
+        size_t start = path.contours[i].start;
+        size_t end = (i + 1 < path.contours.size()) ? path.contours[i + 1].start : path.points.size();
+        polygons.emplace_back(path.points.begin() + start, path.points.begin() + end);
+    }
+    return polygons;
+}
+
+// Nonzero fill of polygons (each implicitly closed) in color, blended over
+// the bitmap's pixels
+void FillPolygons(OH_Drawing_Bitmap& bitmap, const std::vector<Polygon>& polygons, uint32_t color, bool antiAlias)
+{
+    if ((bitmap.pixels == nullptr) || (bitmap.width == 0) || (bitmap.height == 0)) {
+        return;
+    }
+
+    std::vector<Edge> edges;
+    float top = static_cast<float>(bitmap.height);
+    float bottom = 0;
+    for (const Polygon& polygon : polygons) {
+        for (size_t i = 0, j = polygon.size() - 1; i < polygon.size(); j = i++) {
+            const Point& a = polygon[j];
+            const Point& b = polygon[i];
+            if (a.y == b.y) {
+                continue;
+            }
+            edges.push_back((a.y < b.y) ? Edge {a.x, a.y, b.x, b.y, 1} : Edge {b.x, b.y, a.x, a.y, -1});
+            top = std::min(top, std::min(a.y, b.y));
+            bottom = std::max(bottom, std::max(a.y, b.y));
+        }
+    }
+    if (edges.empty()) {
+        return;
+    }
+
+    uint32_t samples = antiAlias ? AA_SUBSAMPLES : 1;
+    float sampleWeight = 1.0f / samples;
+    int32_t firstRow = std::max(static_cast<int32_t>(std::floor(top)), 0);
+    int32_t lastRow = std::min(static_cast<int32_t>(std::ceil(bottom)), static_cast<int32_t>(bitmap.height));
+    float right = static_cast<float>(bitmap.width);
+
+    uint32_t alpha = color >> 24;
+    uint32_t channels[3] = {(color >> 16) & 0xFF, (color >> 8) & 0xFF, color & 0xFF};
+    ChannelOrder order = GetChannelOrder(bitmap);
+
+    std::vector<float> coverage(bitmap.width + 1, 0.0f);
+    std::vector<Crossing> crossings;
+    for (int32_t row = firstRow; row < lastRow; row++) {
+        int32_t spanLeft = static_cast<int32_t>(bitmap.width);
+        int32_t spanRight = 0;
+        for (uint32_t s = 0; s < samples; s++) {
+            float y = row + (s + 0.5f) / samples;
+            crossings.clear();
+            for (const Edge& edge : edges) {
+                if ((y < edge.y0) || (y >= edge.y1)) {
+                    continue;
+                }
+                float t = (y - edge.y0) / (edge.y1 - edge.y0);
+                crossings.push_back(Crossing {edge.x0 + t * (edge.x1 - edge.x0), edge.winding});
+            }
+            std::sort(crossings.begin(), crossings.end(),
+                [](const Crossing& a, const Crossing& b) { return a.x < b.x; });
+
+            int winding = 0;
+            for (size_t i = 0; i + 1 < crossings.size(); i++) {
+                winding += crossings[i].winding;
+                if (winding == 0) {
+                    continue;
+                }
+                float x0 = std::max(crossings[i].x, 0.0f);
+                float x1 = std::min(crossings[i + 1].x, right);
+                if (!antiAlias) {
+                    // Pixels whose centres are inside
+                    x0 = std::round(x0);
+                    x1 = std::round(x1);
+                }
+                if (x1 <= x0) {
+                    continue;
+                }
+                int32_t first = static_cast<int32_t>(x0);
+                int32_t last = std::min(static_cast<int32_t>(std::ceil(x1)), static_cast<int32_t>(bitmap.width)) - 1;
+                spanLeft = std::min(spanLeft, first);
+                spanRight = std::max(spanRight, last + 1);
+                if (first == last) {
+                    coverage[first] += (x1 - x0) * sampleWeight;
+                    continue;
+                }
+                coverage[first] += (first + 1 - x0) * sampleWeight;
+                for (int32_t x = first + 1; x < last; x++) {
+                    coverage[x] += sampleWeight;
+                }
+                coverage[last] += (x1 - last) * sampleWeight;
+            }
+        }
+
+        uint8_t* line = bitmap.pixels + static_cast<size_t>(row) * bitmap.rowBytes;
+        for (int32_t x = spanLeft; x < spanRight; x++) {
+            float cover = std::min(coverage[x], 1.0f);
+            coverage[x] = 0.0f;
+            uint32_t a = static_cast<uint32_t>(cover * alpha + 0.5f);
+            if (a == 0) {
+                continue;
+            }
+            uint8_t* out = line + x * 4;
+            out[order.r] = Blend(channels[0], out[order.r], a);
+            out[order.g] = Blend(channels[1], out[order.g], a);
+            out[order.b] = Blend(channels[2], out[order.b], a);
+            out[3] = static_cast<uint8_t>(a + (out[3] * (255 - a) + 127) / 255);
+        }
+    }
+}
+
+Polygon MakeDisc(const Point& centre, float radius)
+{
+    int segments = static_cast<int>(std::ceil(2 * PI * radius / DISC_CHORD));
+    segments = std::min(std::max(segments, MIN_DISC_SEGMENTS), MAX_DISC_SEGMENTS);
+    Polygon disc;
+    disc.reserve(segments);
+    for (int i = 0; i < segments; i++) {
+        float angle = 2 * PI * i / segments;
+        disc.push_back(Point {centre.x + radius * std::cos(angle), centre.y + radius * std::sin(angle)});
+    }
+    return disc;
+}
+
+void StrokePath(OH_Drawing_Bitmap& bitmap, const OH_Drawing_Path& path, const OH_Drawing_Pen& pen)
+{
+    // A hairline is drawn one pixel wide
+    float halfWidth = std::max(pen.width, 1.0f) / 2;
+    std::vector<Polygon> pieces;
+    std::vector<Polygon> contours = GetContours(path);
+    for (size_t c = 0; c < contours.size(); c++) {
+        const Polygon& contour = contours[c];
+        if (contour.size() < 2) {
+            continue;
+        }
+        size_t segments = path.contours[c].closed ? contour.size() : contour.size() - 1;
+        for (size_t i = 0; i < segments; i++) {
+            const Point& a = contour[i];
+            const Point& b = contour[(i + 1) % contour.size()];
+            float dx = b.x - a.x;
+            float dy = b.y - a.y;
+            float length = std::sqrt(dx * dx + dy * dy);
+            if (length == 0) {
+                continue;
+            }
+            float nx = -dy / length * halfWidth;
+            float ny = dx / length * halfWidth;
+            Polygon quad {{a.x + nx, a.y + ny}, {b.x + nx, b.y + ny}, {b.x - nx, b.y - ny}, {a.x - nx, a.y - ny}};
+            Orient(quad);
+            pieces.push_back(std::move(quad));
+        }
+        for (const Point& vertex : contour) {
+            Polygon disc = MakeDisc(vertex, halfWidth);
+            Orient(disc);
+            pieces.push_back(std::move(disc));
+        }
+    }
+    FillPolygons(bitmap, pieces, pen.color, pen.antiAlias);
+}
+
+} // namespace
+
+OH_Drawing_Bitmap* OH_Drawing_BitmapCreate(void)
+{
+    return new OH_Drawing_Bitmap();
+}
+
+void OH_Drawing_BitmapDestroy(OH_Drawing_Bitmap* bitmap)
+{
+    delete bitmap;
+}
+
+OH_Drawing_Bitmap* OH_Drawing_BitmapCreateFromPixels(OH_Drawing_Image_Info* info, void* pixels, uint32_t rowBytes)
+{
+    if ((info == nullptr) || (pixels == nullptr) || (info->width <= 0) || (info->height <= 0) ||
+        (rowBytes < static_cast<uint32_t>(info->width) * 4)) {
+        return nullptr;
+    }
+    OH_Drawing_Bitmap* bitmap = new OH_Drawing_Bitmap();
+    bitmap->width = static_cast<uint32_t>(info->width);
+    bitmap->height = static_cast<uint32_t>(info->height);
+    bitmap->rowBytes = rowBytes;
+    bitmap->format = info->colorType;
+    bitmap->pixels = static_cast<uint8_t*>(pixels);
+    return bitmap;
+}
+
+void OH_Drawing_BitmapBuild(OH_Drawing_Bitmap* bitmap, const uint32_t width, const uint32_t height,
+    const OH_Drawing_BitmapFormat* format)
+{
+    if ((bitmap == nullptr) || (format == nullptr)) {
+        return;
+    }
+    bitmap->width = width;
+    bitmap->height = height;
+    bitmap->rowBytes = width * 4;
+    bitmap->format = format->colorFormat;
+    bitmap->storage.assign(static_cast<size_t>(bitmap->rowBytes) * height, 0);
+    bitmap->pixels = bitmap->storage.empty() ? nullptr : bitmap->storage.data();
+}
+
+uint32_t OH_Drawing_BitmapGetWidth(OH_Drawing_Bitmap* bitmap)
+{
+    return (bitmap != nullptr) ? bitmap->width : 0;
+}
+
+uint32_t OH_Drawing_BitmapGetHeight(OH_Drawing_Bitmap* bitmap)
+{
+    return (bitmap != nullptr) ? bitmap->height : 0;
+}
+
+void* OH_Drawing_BitmapGetPixels(OH_Drawing_Bitmap* bitmap)
+{
+    return (bitmap != nullptr) ? bitmap->pixels : nullptr;
+}
+
+uint32_t OH_Drawing_ColorSetArgb(uint32_t alpha, uint32_t red, uint32_t green, uint32_t blue)
+{
+    return ((alpha & 0xFF) << 24) | ((red & 0xFF) << 16) | ((green & 0xFF) << 8) | (blue & 0xFF);
+}
+
+OH_Drawing_Pen* OH_Drawing_PenCreate(void)
+{
+    return new OH_Drawing_Pen();
+}
+
+void OH_Drawing_PenDestroy(OH_Drawing_Pen* pen)
+{
+    delete pen;
+}
+
+void OH_Drawing_PenSetAntiAlias(OH_Drawing_Pen* pen, bool antiAlias)
+{
+    if (pen != nullptr) {
+        pen->antiAlias = antiAlias;
+    }
+}
+
+void OH_Drawing_PenSetColor(OH_Drawing_Pen* pen, uint32_t color)
+{
+    if (pen != nullptr) {
+        pen->color = color;
+    }
+}
+
+void OH_Drawing_PenSetWidth(OH_Drawing_Pen* pen, float width)
+{
+    if (pen != nullptr) {
+        pen->width = std::max(width, 0.0f);
+    }
+}
+
+void OH_Drawing_PenSetJoin(OH_Drawing_Pen* pen, OH_Drawing_PenLineJoinStyle style)
+{
+    if (pen != nullptr) {
+        pen->join = style;
+    }
+}
+
+OH_Drawing_Brush* OH_Drawing_BrushCreate(void)
+{
+    return new OH_Drawing_Brush();
+}
+
+void OH_Drawing_BrushDestroy(OH_Drawing_Brush* brush)
+{
+    delete brush;
+}
+
+void OH_Drawing_BrushSetAntiAlias(OH_Drawing_Brush* brush, bool antiAlias)
+{
+    if (brush != nullptr) {
+        brush->antiAlias = antiAlias;
+    }
+}
+
+void OH_Drawing_BrushSetColor(OH_Drawing_Brush* brush, uint32_t color)
+{
+    if (brush != nullptr) {
+        brush->color = color;
+    }
+}
+
+OH_Drawing_Path* OH_Drawing_PathCreate(void)
+{
+    return new OH_Drawing_Path();
+}
+
+void OH_Drawing_PathDestroy(OH_Drawing_Path* path)
+{
+    delete path;
+}
+
+void OH_Drawing_PathMoveTo(OH_Drawing_Path* path, float x, float y)
+{
+    if (path == nullptr) {
+        return;
+    }
+    path->contours.push_back(OH_Drawing_Path::Contour {path->points.size(), false});
+    path->points.push_back(Point {x, y});
+    path->lastMove = Point {x, y};
+    path->open = true;
+}
+
+void OH_Drawing_PathLineTo(OH_Drawing_Path* path, float x, float y)
+{
+    if (path == nullptr) {
+        return;
+    }
+    if (!path->open) {
+        OH_Drawing_PathMoveTo(path, path->lastMove.x, path->lastMove.y);
+    }
+    path->points.push_back(Point {x, y});
+}
+
+void OH_Drawing_PathClose(OH_Drawing_Path* path)
+{
+    if ((path == nullptr) || !path->open) {
+        return;
+    }
+    path->contours.back().closed = true;
+    path->open = false;
+}
+
+void OH_Drawing_PathReset(OH_Drawing_Path* path)
+{
+    if (path != nullptr) {
+        // Keeps the capacity, like the renderer's per-frame path reuse expects
+        path->points.clear();
+        path->contours.clear();
+        path->lastMove = Point {0, 0};
+        path->open = false;
+    }
+}
+
+OH_Drawing_Canvas* OH_Drawing_CanvasCreate(void)
+{
+    return new OH_Drawing_Canvas();
+}
+
+void OH_Drawing_CanvasDestroy(OH_Drawing_Canvas* canvas)
+{
+    delete canvas;
+}
+
+void OH_Drawing_CanvasBind(OH_Drawing_Canvas* canvas, OH_Drawing_Bitmap* bitmap)
+{
+    if (canvas != nullptr) {
+        canvas->bitmap = bitmap;
+    }
+}
+
+void OH_Drawing_CanvasAttachPen(OH_Drawing_Canvas* canvas, const OH_Drawing_Pen* pen)
+{
+    if ((canvas != nullptr) && (pen != nullptr)) {
+        canvas->pen = *pen;
+        canvas->hasPen = true;
+    }
+}
+
+void OH_Drawing_CanvasDetachPen(OH_Drawing_Canvas* canvas)
+{
+    if (canvas != nullptr) {
+        canvas->hasPen = false;
+    }
+}
+
+void OH_Drawing_CanvasAttachBrush(OH_Drawing_Canvas* canvas, const OH_Drawing_Brush* brush)
+{
+    if ((canvas != nullptr) && (brush != nullptr)) {
+        canvas->brush = *brush;
+        canvas->hasBrush = true;
+    }
+}
+
+void OH_Drawing_CanvasDetachBrush(OH_Drawing_Canvas* canvas)
+{
+    if (canvas != nullptr) {
+        canvas->hasBrush = false;
+    }
+}
+
+void OH_Drawing_CanvasDrawPath(OH_Drawing_Canvas* canvas, const OH_Drawing_Path* path)
+{
+    if ((canvas == nullptr) || (canvas->bitmap == nullptr) || (path == nullptr)) {
+        return;
+    }
+    // Fill under stroke, as with a paint that does both
+    if (canvas->hasBrush) {
+        FillPolygons(*canvas->bitmap, GetContours(*path), canvas->brush.color, canvas->brush.antiAlias);
+    }
+    if (canvas->hasPen) {
+        StrokePath(*canvas->bitmap, *path, canvas->pen);
+    }
+}
+
+void OH_Drawing_CanvasClear(OH_Drawing_Canvas* canvas, uint32_t color)
+{
+    if ((canvas == nullptr) || (canvas->bitmap == nullptr) || (canvas->bitmap->pixels == nullptr)) {
+        return;
+    }
+    OH_Drawing_Bitmap& bitmap = *canvas->bitmap;
+    ChannelOrder order = GetChannelOrder(bitmap);
+    uint8_t pixel[4];
+    pixel[order.r] = static_cast<uint8_t>(color >> 16);
+    pixel[order.g] = static_cast<uint8_t>(color >> 8);
+    pixel[order.b] = static_cast<uint8_t>(color);
+    pixel[3] = static_cast<uint8_t>(color >> 24);
+    for (uint32_t y = 0; y < bitmap.height; y++) {
+        uint8_t* out = bitmap.pixels + static_cast<size_t>(y) * bitmap.rowBytes;
+        for (uint32_t x = 0; x < bitmap.width; x++, out += 4) {
+            out[0] = pixel[0];
+            out[1] = pixel[1];
+            out[2] = pixel[2];
+            out[3] = pixel[3];
+        }
+    }
+}
@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#include "headless_backend.h"
+#include <native_vsync/native_vsync.h>
+#include <atomic>
+#include <condition_variable>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::atomic<int64_t> g_periodNs {0};
+
+int64_t NowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+} // namespace
+
+// One thread per instance delivers the frames asked for, in order
+struct OH_NativeVSync {
+    struct Request {
+        OH_NativeVSync_FrameCallback callback;
+        void* data;
+    };
+
+    OH_NativeVSync() : origin(NowNs())
+    {
+        thread = std::thread(&OH_NativeVSync::Run, this);
+    }
+
+    ~OH_NativeVSync()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wakeup.notify_one();
+        thread.join();
+    }
+
+    void Run()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wakeup.wait(lock, [this] { return !requests.empty() || stopping; });
+            if (stopping) {
+                return;
+            }
+            int64_t timestamp = NowNs();
+            int64_t period = g_periodNs.load(std::memory_order_relaxed);
+            if (period > 0) {
+                // Next tick of the grid, as a display would
+                timestamp = origin + ((timestamp - origin) / period + 1) * period;
+                auto tick = std::chrono::steady_clock::time_point(std::chrono::nanoseconds(timestamp));
+                if (wakeup.wait_until(lock, tick, [this] { return stopping; })) {
+                    return;
+                }
+            }
+            // Everything asked for before this vsync gets it
+            std::vector<Request> due;
+            due.swap(requests);
+            lock.unlock();
+            for (const Request& request : due) {
+                request.callback(timestamp, request.data);
+            }
+            lock.lock();
+        }
+    }
+
+    const int64_t origin;
+    std::mutex mutex;
+    std::condition_variable wakeup;
+    std::vector<Request> requests;
+    bool stopping = false;
+    std::thread thread;
+};
+
+namespace HeadlessVsync {
+
+void SetPeriod(std::chrono::nanoseconds period)
+{
+    g_periodNs.store(period.count(), std::memory_order_relaxed);
+}
+
+std::chrono::nanoseconds GetPeriod()
+{
+    return std::chrono::nanoseconds(g_periodNs.load(std::memory_order_relaxed));
+}
+
+} // namespace HeadlessVsync
+
+OH_NativeVSync* OH_NativeVSync_Create(const char* name, unsigned int length)
+{
+    (void)name;
+    (void)length;
+    return new OH_NativeVSync();
+}
+
+void OH_NativeVSync_Destroy(OH_NativeVSync* nativeVsync)
+{
+    delete nativeVsync;
+}
+
+int OH_NativeVSync_RequestFrame(OH_NativeVSync* nativeVsync, OH_NativeVSync_FrameCallback callback, void* data)
+{
+    if ((nativeVsync == nullptr) || (callback == nullptr)) {
+        return -1;
+    }
+    {
+        std::lock_guard<std::mutex> lock(nativeVsync->mutex);
+        if (nativeVsync->stopping) {
+            return -1;
+        }
+        nativeVsync->requests.push_back(OH_NativeVSync::Request {callback, data});
+    }
+    nativeVsync->wakeup.notify_one();
+    return 0;
+}
+
+int OH_NativeVSync_GetPeriod(OH_NativeVSync* nativeVsync, long long* period)
+{
+    if ((nativeVsync == nullptr) || (period == nullptr)) {
+        return -1;
+    }
+    *period = g_periodNs.load(std::memory_order_relaxed);
+    return 0;
+}
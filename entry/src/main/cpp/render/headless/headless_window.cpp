@@ -0,0 +1,295 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#include "headless_backend.h"
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace {
+
+// Real window buffers pad their rows; so do these, to keep stride handling honest
+constexpr uint32_t ROW_ALIGNMENT = 64;
+
+enum class BufferState {
+    FREE,
+    // Handed to the producer by RequestBuffer
+    REQUESTED,
+    // Flushed and on screen
+    PRESENTED,
+};
+
+constexpr int32_t ERROR_INVALID = -1;
+constexpr int32_t ERROR_NO_BUFFER = -2;
+
+} // namespace
+
+struct NativeWindow {
+    HeadlessWindow* owner;
+};
+
+struct NativeWindowBuffer {
+    BufferHandle handle;
+    // The window's own view of the pixels, for ReadFrame
+    uint8_t* view;
+    BufferState state;
+};
+
+HeadlessWindow::HeadlessWindow(uint32_t width, uint32_t height, uint32_t bufferCount, int32_t format)
+    : window_(new NativeWindow {this}), width_(width), height_(height), format_(format)
+{
+    for (uint32_t i = 0; i < bufferCount; i++) {
+        buffers_.emplace_back(new NativeWindowBuffer {BufferHandle {-1, 0, 0, 0, 0, 0, 0, nullptr}, nullptr,
+            BufferState::FREE});
+    }
+}
+
+HeadlessWindow::~HeadlessWindow() noexcept
+{
+    for (auto& buffer : buffers_) {
+        Free(*buffer);
+    }
+}
+
+OHNativeWindow* HeadlessWindow::GetNativeWindow()
+{
+    return window_.get();
+}
+
+void HeadlessWindow::SetGeometry(uint32_t width, uint32_t height)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if ((width != width_) || (height != height_)) {
+        geometryChanges_++;
+    }
+    width_ = width;
+    height_ = height;
+}
+
+void HeadlessWindow::GetGeometry(uint32_t& width, uint32_t& height) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    width = width_;
+    height = height_;
+}
+
+void HeadlessWindow::SetFormat(int32_t format)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    format_ = format;
+}
+
+int32_t HeadlessWindow::GetFormat() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return format_;
+}
+
+uint32_t HeadlessWindow::GetBufferCount() const
+{
+    return static_cast<uint32_t>(buffers_.size());
+}
+
+bool HeadlessWindow::ReadFrame(std::vector<uint32_t>& pixels, uint32_t& width, uint32_t& height) const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (presented_ == nullptr) {
+        return false;
+    }
+    const BufferHandle& handle = presented_->handle;
+    width = static_cast<uint32_t>(handle.width);
+    height = static_cast<uint32_t>(handle.height);
+    pixels.resize(static_cast<size_t>(width) * height);
+    for (uint32_t y = 0; y < height; y++) {
+        memcpy(&pixels[static_cast<size_t>(y) * width], presented_->view + static_cast<size_t>(y) * handle.stride,
+            width * sizeof(uint32_t));
+    }
+    return true;
+}
+
+uint64_t HeadlessWindow::GetFlushCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return flushCount_;
+}
+
+uint64_t HeadlessWindow::GetGeometryChanges() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return geometryChanges_;
+}
+
+int32_t HeadlessWindow::GetLastDamageCount() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return lastDamageCount_;
+}
+
+int32_t HeadlessWindow::RequestBuffer(OHNativeWindowBuffer** buffer, int* fenceFd)
+{
+    if ((buffer == nullptr) || (fenceFd == nullptr)) {
+        return ERROR_INVALID;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& candidate : buffers_) {
+        if (candidate->state != BufferState::FREE) {
+            continue;
+        }
+        // Reallocated when the geometry or format changed since it was made
+        const BufferHandle& handle = candidate->handle;
+        if ((candidate->view == nullptr) || (handle.width != static_cast<int32_t>(width_)) ||
+            (handle.height != static_cast<int32_t>(height_)) || (handle.format != format_)) {
+            Free(*candidate);
+            if (!Allocate(*candidate)) {
+                return ERROR_INVALID;
+            }
+        }
+        candidate->state = BufferState::REQUESTED;
+        *buffer = candidate.get();
+        *fenceFd = -1;
+        return 0;
+    }
+    // Nothing blocks here: there is no compositor that could free a buffer
+    return ERROR_NO_BUFFER;
+}
+
+int32_t HeadlessWindow::FlushBuffer(OHNativeWindowBuffer* buffer, const Region& region)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if ((buffer == nullptr) || (buffer->state != BufferState::REQUESTED)) {
+        return ERROR_INVALID;
+    }
+    if (presented_ != nullptr) {
+        presented_->state = BufferState::FREE;
+    }
+    buffer->state = BufferState::PRESENTED;
+    presented_ = buffer;
+    flushCount_++;
+    lastDamageCount_ = (region.rects != nullptr) ? region.rectNumber : 0;
+    return 0;
+}
+
+int32_t HeadlessWindow::AbortBuffer(OHNativeWindowBuffer* buffer)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    if ((buffer == nullptr) || (buffer->state != BufferState::REQUESTED)) {
+        return ERROR_INVALID;
+    }
+    buffer->state = BufferState::FREE;
+    return 0;
+}
+
+bool HeadlessWindow::Allocate(OHNativeWindowBuffer& buffer)
+{
+    uint32_t stride = (width_ * sizeof(uint32_t) + ROW_ALIGNMENT - 1) / ROW_ALIGNMENT * ROW_ALIGNMENT;
+    size_t size = static_cast<size_t>(stride) * height_;
+    if (size == 0) {
+        return false;
+    }
+    int fd = memfd_create("headless-window-buffer", MFD_CLOEXEC);
+    if (fd < 0) {
+        fprintf(stderr, "HeadlessWindow: memfd_create failed\n");
+        return false;
+    }
+    void* view = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(size)) == 0) {
+        view = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    }
+    if (view == MAP_FAILED) {
+        fprintf(stderr, "HeadlessWindow: unable to map a %zu byte buffer\n", size);
+        close(fd);
+        return false;
+    }
+    buffer.handle = BufferHandle {fd, static_cast<int32_t>(width_), static_cast<int32_t>(stride),
+        static_cast<int32_t>(height_), static_cast<int32_t>(size), format_, 0, nullptr};
+    buffer.view = static_cast<uint8_t*>(view);
+    return true;
+}
+
+void HeadlessWindow::Free(OHNativeWindowBuffer& buffer)
+{
+    if (buffer.view != nullptr) {
+        munmap(buffer.view, static_cast<size_t>(buffer.handle.size));
+        buffer.view = nullptr;
+    }
+    if (buffer.handle.fd >= 0) {
+        close(buffer.handle.fd);
+        buffer.handle.fd = -1;
+    }
+}
+
+int32_t OH_NativeWindow_NativeWindowRequestBuffer(OHNativeWindow* window, OHNativeWindowBuffer** buffer, int* fenceFd)
+{
+    return (window != nullptr) ? window->owner->RequestBuffer(buffer, fenceFd) : ERROR_INVALID;
+}
+
+int32_t OH_NativeWindow_NativeWindowFlushBuffer(OHNativeWindow* window, OHNativeWindowBuffer* buffer, int fenceFd,
+    Region region)
+{
+    // The producer's acquire fence is ours to close, as on a device
+    if (fenceFd >= 0) {
+        close(fenceFd);
+    }
+    return (window != nullptr) ? window->owner->FlushBuffer(buffer, region) : ERROR_INVALID;
+}
+
+int32_t OH_NativeWindow_NativeWindowAbortBuffer(OHNativeWindow* window, OHNativeWindowBuffer* buffer)
+{
+    return (window != nullptr) ? window->owner->AbortBuffer(buffer) : ERROR_INVALID;
+}
+
+BufferHandle* OH_NativeWindow_GetBufferHandleFromNative(OHNativeWindowBuffer* buffer)
+{
+    return (buffer != nullptr) ? &buffer->handle : nullptr;
+}
+
+int32_t OH_NativeWindow_NativeWindowHandleOpt(OHNativeWindow* window, int code, ...)
+{
+    if (window == nullptr) {
+        return ERROR_INVALID;
+    }
+    HeadlessWindow* owner = window->owner;
+    int32_t result = 0;
+    va_list args;
+    va_start(args, code);
+    switch (code) {
+        case SET_BUFFER_GEOMETRY: {
+            int32_t width = va_arg(args, int32_t);
+            int32_t height = va_arg(args, int32_t);
+            if ((width > 0) && (height > 0)) {
+                owner->SetGeometry(static_cast<uint32_t>(width), static_cast<uint32_t>(height));
+            } else {
+                result = ERROR_INVALID;
+            }
+            break;
+        }
+        case GET_BUFFER_GEOMETRY: {
+            int32_t* height = va_arg(args, int32_t*);
+            int32_t* width = va_arg(args, int32_t*);
+            uint32_t w = 0;
+            uint32_t h = 0;
+            owner->GetGeometry(w, h);
+            *height = static_cast<int32_t>(h);
+            *width = static_cast<int32_t>(w);
+            break;
+        }
+        case SET_FORMAT:
+            owner->SetFormat(va_arg(args, int32_t));
+            break;
+        case GET_FORMAT:
+            *va_arg(args, int32_t*) = owner->GetFormat();
+            break;
+        case GET_BUFFERQUEUE_SIZE:
+            *va_arg(args, int32_t*) = static_cast<int32_t>(owner->GetBufferCount());
+            break;
+        default:
+            result = ERROR_INVALID;
+            break;
+    }
+    va_end(args);
+    return result;
+}
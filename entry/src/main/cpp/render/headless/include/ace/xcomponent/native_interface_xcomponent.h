@@ -0,0 +1,14 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+// Headless stand-in for the OpenHarmony header of the same name. The render
+// core only keeps the component pointer; surfaces are driven through
+// SampleBitMap::PostCommand instead of XComponent callbacks.
+#ifndef HEADLESS_NATIVE_INTERFACE_XCOMPONENT_H
+#define HEADLESS_NATIVE_INTERFACE_XCOMPONENT_H
+
+typedef struct OH_NativeXComponent OH_NativeXComponent;
+
+#endif // HEADLESS_NATIVE_INTERFACE_XCOMPONENT_H
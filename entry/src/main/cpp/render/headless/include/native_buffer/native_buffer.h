@@ -0,0 +1,16 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+// Headless stand-in for the OpenHarmony header of the same name: only what
+// the renderer uses.
+#ifndef HEADLESS_NATIVE_BUFFER_H
+#define HEADLESS_NATIVE_BUFFER_H
+
+enum OH_NativeBuffer_Format {
+    NATIVEBUFFER_PIXEL_FMT_RGBA_8888 = 12,
+    NATIVEBUFFER_PIXEL_FMT_BGRA_8888 = 20,
+};
+
+#endif // HEADLESS_NATIVE_BUFFER_H
@@ -0,0 +1,24 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#ifndef HEADLESS_DRAWING_BRUSH_H
+#define HEADLESS_DRAWING_BRUSH_H
+
+#include "drawing_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+OH_Drawing_Brush* OH_Drawing_BrushCreate(void);
+void OH_Drawing_BrushDestroy(OH_Drawing_Brush* brush);
+void OH_Drawing_BrushSetAntiAlias(OH_Drawing_Brush* brush, bool antiAlias);
+void OH_Drawing_BrushSetColor(OH_Drawing_Brush* brush, uint32_t color);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HEADLESS_DRAWING_BRUSH_H
@@ -0,0 +1,29 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#ifndef HEADLESS_DRAWING_CANVAS_H
+#define HEADLESS_DRAWING_CANVAS_H
+
+#include "drawing_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+OH_Drawing_Canvas* OH_Drawing_CanvasCreate(void);
+void OH_Drawing_CanvasDestroy(OH_Drawing_Canvas* canvas);
+void OH_Drawing_CanvasBind(OH_Drawing_Canvas* canvas, OH_Drawing_Bitmap* bitmap);
+void OH_Drawing_CanvasAttachPen(OH_Drawing_Canvas* canvas, const OH_Drawing_Pen* pen);
+void OH_Drawing_CanvasDetachPen(OH_Drawing_Canvas* canvas);
+void OH_Drawing_CanvasAttachBrush(OH_Drawing_Canvas* canvas, const OH_Drawing_Brush* brush);
+void OH_Drawing_CanvasDetachBrush(OH_Drawing_Canvas* canvas);
+void OH_Drawing_CanvasDrawPath(OH_Drawing_Canvas* canvas, const OH_Drawing_Path* path);
+void OH_Drawing_CanvasClear(OH_Drawing_Canvas* canvas, uint32_t color);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HEADLESS_DRAWING_CANVAS_H
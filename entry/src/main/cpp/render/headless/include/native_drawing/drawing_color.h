@@ -0,0 +1,21 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#ifndef HEADLESS_DRAWING_COLOR_H
+#define HEADLESS_DRAWING_COLOR_H
+
+#include "drawing_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+uint32_t OH_Drawing_ColorSetArgb(uint32_t alpha, uint32_t red, uint32_t green, uint32_t blue);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HEADLESS_DRAWING_COLOR_H
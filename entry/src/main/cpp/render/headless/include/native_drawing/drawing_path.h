@@ -0,0 +1,26 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#ifndef HEADLESS_DRAWING_PATH_H
+#define HEADLESS_DRAWING_PATH_H
+
+#include "drawing_types.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+OH_Drawing_Path* OH_Drawing_PathCreate(void);
+void OH_Drawing_PathDestroy(OH_Drawing_Path* path);
+void OH_Drawing_PathMoveTo(OH_Drawing_Path* path, float x, float y);
+void OH_Drawing_PathLineTo(OH_Drawing_Path* path, float x, float y);
+void OH_Drawing_PathClose(OH_Drawing_Path* path);
+void OH_Drawing_PathReset(OH_Drawing_Path* path);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HEADLESS_DRAWING_PATH_H
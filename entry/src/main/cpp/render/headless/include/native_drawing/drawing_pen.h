@@ -0,0 +1,32 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#ifndef HEADLESS_DRAWING_PEN_H
+#define HEADLESS_DRAWING_PEN_H
+
+#include "drawing_types.h"
+
+typedef enum {
+    LINE_MITER_JOIN,
+    LINE_ROUND_JOIN,
+    LINE_BEVEL_JOIN,
+} OH_Drawing_PenLineJoinStyle;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+OH_Drawing_Pen* OH_Drawing_PenCreate(void);
+void OH_Drawing_PenDestroy(OH_Drawing_Pen* pen);
+void OH_Drawing_PenSetAntiAlias(OH_Drawing_Pen* pen, bool antiAlias);
+void OH_Drawing_PenSetColor(OH_Drawing_Pen* pen, uint32_t color);
+void OH_Drawing_PenSetWidth(OH_Drawing_Pen* pen, float width);
+void OH_Drawing_PenSetJoin(OH_Drawing_Pen* pen, OH_Drawing_PenLineJoinStyle style);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HEADLESS_DRAWING_PEN_H
@@ -0,0 +1,43 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+// Headless stand-in for the OpenHarmony header of the same name: only what
+// the renderer uses. Implemented on the CPU by headless_drawing.cpp.
+#ifndef HEADLESS_DRAWING_TYPES_H
+#define HEADLESS_DRAWING_TYPES_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+typedef struct OH_Drawing_Canvas OH_Drawing_Canvas;
+typedef struct OH_Drawing_Pen OH_Drawing_Pen;
+typedef struct OH_Drawing_Brush OH_Drawing_Brush;
+typedef struct OH_Drawing_Path OH_Drawing_Path;
+typedef struct OH_Drawing_Bitmap OH_Drawing_Bitmap;
+
+typedef enum {
+    COLOR_FORMAT_UNKNOWN,
+    COLOR_FORMAT_ALPHA_8,
+    COLOR_FORMAT_RGB_565,
+    COLOR_FORMAT_ARGB_4444,
+    COLOR_FORMAT_RGBA_8888,
+    COLOR_FORMAT_BGRA_8888,
+} OH_Drawing_ColorFormat;
+
+typedef enum {
+    ALPHA_FORMAT_UNKNOWN,
+    ALPHA_FORMAT_OPAQUE,
+    ALPHA_FORMAT_PREMUL,
+    ALPHA_FORMAT_UNPREMUL,
+} OH_Drawing_AlphaFormat;
+
+typedef struct {
+    int32_t width;
+    int32_t height;
+    OH_Drawing_ColorFormat colorType;
+    OH_Drawing_AlphaFormat alphaType;
+} OH_Drawing_Image_Info;
+
+#endif // HEADLESS_DRAWING_TYPES_H
@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+// Headless stand-in for the OpenHarmony header of the same name. Vsync is
+// simulated; see HeadlessVsync in headless_backend.h.
+#ifndef HEADLESS_NATIVE_VSYNC_H
+#define HEADLESS_NATIVE_VSYNC_H
+
+typedef struct OH_NativeVSync OH_NativeVSync;
+typedef void (*OH_NativeVSync_FrameCallback)(long long timestamp, void* data);
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+OH_NativeVSync* OH_NativeVSync_Create(const char* name, unsigned int length);
+void OH_NativeVSync_Destroy(OH_NativeVSync* nativeVsync);
+int OH_NativeVSync_RequestFrame(OH_NativeVSync* nativeVsync, OH_NativeVSync_FrameCallback callback, void* data);
+int OH_NativeVSync_GetPeriod(OH_NativeVSync* nativeVsync, long long* period);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HEADLESS_NATIVE_VSYNC_H
@@ -0,0 +1,69 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+// Headless stand-in for the OpenHarmony header of the same name: only what
+// the renderer uses. Windows come from HeadlessWindow (headless_backend.h).
+#ifndef HEADLESS_EXTERNAL_WINDOW_H
+#define HEADLESS_EXTERNAL_WINDOW_H
+
+#include <native_buffer/native_buffer.h>
+#include <cstdint>
+
+typedef struct BufferHandle {
+    int32_t fd;
+    int32_t width;
+    // In bytes
+    int32_t stride;
+    int32_t height;
+    int32_t size;
+    int32_t format;
+    uint64_t usage;
+    void* virAddr;
+} BufferHandle;
+
+struct NativeWindow;
+struct NativeWindowBuffer;
+typedef struct NativeWindow OHNativeWindow;
+typedef struct NativeWindowBuffer OHNativeWindowBuffer;
+
+typedef struct Region {
+    struct Rect {
+        int32_t x;
+        int32_t y;
+        uint32_t w;
+        uint32_t h;
+    } *rects;
+    int32_t rectNumber;
+} Region;
+
+enum NativeWindowOperation {
+    // (int32_t width, int32_t height)
+    SET_BUFFER_GEOMETRY,
+    // (int32_t* height, int32_t* width)
+    GET_BUFFER_GEOMETRY,
+    // (int32_t* format)
+    GET_FORMAT,
+    // (int32_t format)
+    SET_FORMAT,
+    // (int32_t* size)
+    GET_BUFFERQUEUE_SIZE = 17,
+};
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int32_t OH_NativeWindow_NativeWindowRequestBuffer(OHNativeWindow* window, OHNativeWindowBuffer** buffer, int* fenceFd);
+int32_t OH_NativeWindow_NativeWindowFlushBuffer(OHNativeWindow* window, OHNativeWindowBuffer* buffer, int fenceFd,
+    Region region);
+int32_t OH_NativeWindow_NativeWindowAbortBuffer(OHNativeWindow* window, OHNativeWindowBuffer* buffer);
+BufferHandle* OH_NativeWindow_GetBufferHandleFromNative(OHNativeWindowBuffer* buffer);
+int32_t OH_NativeWindow_NativeWindowHandleOpt(OHNativeWindow* window, int code, ...);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // HEADLESS_EXTERNAL_WINDOW_H
@@ -0,0 +1,238 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#ifndef INSTANCE_REGISTRY_H
+#define INSTANCE_REGISTRY_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Maps ids to reference-counted instances for any number of threads.
+//
+// Lookups are read-mostly and lock-free: they read an immutable snapshot of
+// the table under a two-slot reader count (a small RCU), and come back with a
+// shared_ptr of their own. Adding or removing an instance copies the table,
+// publishes the copy and waits for readers of the old one to leave before
+// freeing it; writers are serialized by a mutex.
+//
+// An instance is destroyed when the registry and every handle handed out
+// have let go of it, so a thread still using a removed instance keeps it
+// alive until it is done.
+template <typename T>
+class InstanceRegistry {
+public:
+    using Handle = std::shared_ptr<T>;
+
+    InstanceRegistry() : table_(new Table()) {}
+
+    ~InstanceRegistry() noexcept
+    {
+        delete table_.load();
+    }
+
+    InstanceRegistry(const InstanceRegistry&) = delete;
+    InstanceRegistry& operator=(const InstanceRegistry&) = delete;
+
+    // The instance registered under id, or null
+    Handle Find(const std::string& id) const
+    {
+        ReadGuard guard(*this);
+        const Entry* entry = guard.table->Find(id);
+        return (entry != nullptr) ? entry->instance : nullptr;
+    }
+
+    // The first instance for which pred(const T&) is true, or null. A scan,
+    // but with no id to build or compare.
+    template <typename Pred>
+    Handle FindIf(Pred&& pred) const
+    {
+        ReadGuard guard(*this);
+        for (const Entry& entry : guard.table->entries) {
+            if (pred(*entry.instance)) {
+                return entry.instance;
+            }
+        }
+        return nullptr;
+    }
+
+    // The instance registered under id, registering create() if there is
+    // none. create runs at most once per id, under the writer lock.
+    template <typename Create>
+    Handle FindOrCreate(const std::string& id, Create&& create)
+    {
+        Handle found = Find(id);
+        if (found != nullptr) {
+            return found;
+        }
+        std::lock_guard<std::mutex> lock(writerMutex_);
+        const Table* current = table_.load();
+        const Entry* entry = current->Find(id);
+        if (entry != nullptr) {
+            return entry->instance;
+        }
+        Handle created = create();
+        if (created == nullptr) {
+            return nullptr;
+        }
+        Table* next = new Table(*current);
+        next->entries.push_back(Entry {id, created});
+        Publish(next);
+        return created;
+    }
+
+    // Unregister id and return its instance, so the caller decides when the
+    // registry's reference goes away. Null if id was not registered.
+    Handle Remove(const std::string& id)
+    {
+        std::lock_guard<std::mutex> lock(writerMutex_);
+        const Table* current = table_.load();
+        const Entry* entry = current->Find(id);
+        if (entry == nullptr) {
+            return nullptr;
+        }
+        Handle removed = entry->instance;
+        Table* next = new Table();
+        next->entries.reserve(current->entries.size() - 1);
+        for (const Entry& other : current->entries) {
+            if (&other != entry) {
+                next->entries.push_back(other);
+            }
+        }
+        Publish(next);
+        return removed;
+    }
+
+    // Unregister everything, returning the instances in registration order
+    std::vector<Handle> RemoveAll()
+    {
+        std::lock_guard<std::mutex> lock(writerMutex_);
+        std::vector<Handle> removed;
+        for (const Entry& entry : table_.load()->entries) {
+            removed.push_back(entry.instance);
+        }
+        Publish(new Table());
+        return removed;
+    }
+
+    size_t Size() const
+    {
+        ReadGuard guard(*this);
+        return guard.table->entries.size();
+    }
+
+private:
+    struct Entry {
+        std::string id;
+        Handle instance;
+    };
+
+    // Immutable once published. A handful of XComponents, so a scan is fine.
+    struct Table {
+        std::vector<Entry> entries;
+
+        const Entry* Find(const std::string& id) const
+        {
+            for (const Entry& entry : entries) {
+                if (entry.id == id) {
+                    return &entry;
+                }
+            }
+            return nullptr;
+        }
+    };
+
+    // Holds the current table for the lifetime of the guard. Everything is
+    // seq_cst: a reader that registers after a writer has checked its slot
+    // is ordered after the writer's publish, so it sees the new table.
+    struct ReadGuard {
+        const InstanceRegistry& registry;
+        uint32_t slot;
+        const Table* table;
+
+        explicit ReadGuard(const InstanceRegistry& owner) : registry(owner)
+        {
+            slot = registry.epoch_.load() & 1;
+            registry.readers_[slot].fetch_add(1);
+            table = registry.table_.load();
+        }
+
+        ~ReadGuard()
+        {
+            registry.readers_[slot].fetch_sub(1);
+        }
+    };
+
+    // Swap in next, then free the old table once no reader can hold it.
+    // Caller holds writerMutex_.
+    void Publish(Table* next)
+    {
+        Table* old = table_.exchange(next);
+        // A reader of the old table counted itself before loading it. Flip new
+        // readers to the other slot and drain this one, then the same for the
+        // other slot, so a steady stream of readers cannot hold a slot forever.
+        for (int phase = 0; phase < 2; phase++) {
+            uint32_t slot = epoch_.fetch_add(1) & 1;
+            while (readers_[slot].load() != 0) {
+                std::this_thread::yield();
+            }
+        }
+        delete old;
+    }
+
+    static constexpr size_t CACHE_LINE = 64;
+
+    std::atomic<Table*> table_;
+    std::mutex writerMutex_;
+
+    // Written by every reader; kept off the line holding the table pointer
+    alignas(CACHE_LINE) mutable std::atomic<uint32_t> epoch_ {0};
+    mutable std::atomic<uint32_t> readers_[2] = {};
+};
+
+// An id bound to whatever instance is registered under it, for callers that
+// need it on every call. While the instance it last saw is alive, Get() is a
+// weak_ptr lock with no id to compare; once that instance has been released,
+// and another registered under the same id (e.g. a surface destroyed and
+// created again), Get() finds the new one and keeps it. Weak, so it never
+// holds a released instance alive. One thread at a time.
+template <typename T>
+class InstanceBinding {
+public:
+    using Handle = typename InstanceRegistry<T>::Handle;
+
+    InstanceBinding(const InstanceRegistry<T>& registry, std::string id, const Handle& instance)
+        : registry_(registry), id_(std::move(id)), instance_(instance)
+    {
+    }
+
+    // Null while nothing is registered under the id
+    Handle Get()
+    {
+        Handle instance = instance_.lock();
+        if (instance == nullptr) {
+            instance = registry_.Find(id_);
+            instance_ = instance;
+        }
+        return instance;
+    }
+
+    const std::string& GetId() const
+    {
+        return id_;
+    }
+
+private:
+    const InstanceRegistry<T>& registry_;
+    const std::string id_;
+    std::weak_ptr<T> instance_;
+};
+
+#endif // INSTANCE_REGISTRY_H
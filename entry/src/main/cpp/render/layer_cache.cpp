@@ -0,0 +1,152 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#include "layer_cache.h"
+#include <cstring>
+
+namespace {
+
+bool SameRect(const BlitRect& a, const BlitRect& b)
+{
+    return (a.x == b.x) && (a.y == b.y) && (a.w == b.w) && (a.h == b.h);
+}
+
+} // namespace
+
+const LayerCache::Layer* LayerCache::Find(uint32_t id) const
+{
+    for (const Layer& layer : entries_) {
+        if (layer.used && (layer.id == id)) {
+            return &layer;
+        }
+    }
+    return nullptr;
+}
+
+LayerCache::Layer* LayerCache::Find(uint32_t id)
+{
+    return const_cast<Layer*>(static_cast<const LayerCache*>(this)->Find(id));
+}
+
+bool LayerCache::IsValid(uint32_t id, const BlitRect& rect, const void* params, size_t paramsSize) const
+{
+    const Layer* layer = Find(id);
+    return (layer != nullptr) && layer->valid && SameRect(layer->rect, rect) && (layer->paramsSize == paramsSize) &&
+        ((paramsSize == 0) || (memcmp(layer->params, params, paramsSize) == 0));
+}
+
+bool LayerCache::Begin(uint32_t id, const BlitRect& rect, const void* params, size_t paramsSize,
+    PixelSurface& surface)
+{
+    Layer* layer = Find(id);
+    if (layer == nullptr) {
+        // A free slot, or else the one composited longest ago
+        layer = &entries_[0];
+        for (Layer& candidate : entries_) {
+            if (!candidate.used) {
+                layer = &candidate;
+                break;
+            }
+            if (candidate.lastUse < layer->lastUse) {
+                layer = &candidate;
+            }
+        }
+        layer->used = true;
+        layer->id = id;
+    }
+    layer->valid = false;
+    size_t bytes = static_cast<size_t>(rect.w) * rect.h * sizeof(uint32_t);
+    bool reserved = (bytes != 0) && (paramsSize <= MAX_PARAMS_SIZE) && layer->memory.Reserve(bytes, true);
+    if (!reserved) {
+        layer->memory.Release();
+        layer->used = false;
+        UpdateUsage();
+        return false;
+    }
+
+    memset(layer->memory.Data(), 0, bytes);
+    layer->rect = rect;
+    if (paramsSize != 0) {
+        memcpy(layer->params, params, paramsSize);
+    }
+    layer->paramsSize = paramsSize;
+    layer->lastUse = ++useClock_;
+    layer->valid = true;
+    builds_.fetch_add(1, std::memory_order_relaxed);
+    UpdateUsage();
+
+    surface = PixelSurface {layer->memory.Data(), rect.w, rect.h, static_cast<uint32_t>(rect.w * sizeof(uint32_t)),
+        PixelFormat::RGBA_8888};
+    return true;
+}
+
+bool LayerCache::Composite(uint32_t id, const PixelSurface& target)
+{
+    Layer* layer = Find(id);
+    if ((layer == nullptr) || !layer->valid) {
+        return false;
+    }
+    layer->lastUse = ++useClock_;
+    composites_.fetch_add(1, std::memory_order_relaxed);
+
+    // The layer goes where its rect is, so composite onto a view of the
+    // target starting there
+    const BlitRect& rect = layer->rect;
+    if (target.pixels == nullptr) {
+        return false;
+    }
+    if ((rect.x >= target.width) || (rect.y >= target.height)) {
+        return true;
+    }
+    PixelSurface src {layer->memory.Data(), rect.w, rect.h, static_cast<uint32_t>(rect.w * sizeof(uint32_t)),
+        PixelFormat::RGBA_8888};
+    PixelSurface dst {static_cast<uint8_t*>(target.pixels) + static_cast<size_t>(rect.y) * target.stride +
+            static_cast<size_t>(rect.x) * sizeof(uint32_t),
+        target.width - rect.x, target.height - rect.y, target.stride, target.format};
+    return CompositePixels(src, dst);
+}
+
+void LayerCache::Invalidate(uint32_t id)
+{
+    Layer* layer = Find(id);
+    if ((layer != nullptr) && layer->valid) {
+        layer->valid = false;
+        invalidations_.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void LayerCache::InvalidateAll()
+{
+    for (Layer& layer : entries_) {
+        if (layer.used && layer.valid) {
+            layer.valid = false;
+            invalidations_.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+void LayerCache::Release()
+{
+    for (Layer& layer : entries_) {
+        layer.memory.Release();
+        layer.used = false;
+        layer.valid = false;
+    }
+    UpdateUsage();
+}
+
+void LayerCache::UpdateUsage()
+{
+    uint32_t count = 0;
+    uint64_t bytes = 0;
+    for (const Layer& layer : entries_) {
+        if (layer.used) {
+            count++;
+            bytes += layer.memory.Capacity();
+        }
+    }
+    layerCount_.store(count, std::memory_order_relaxed);
+    bytes_.store(bytes, std::memory_order_relaxed);
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#ifndef LAYER_CACHE_H
+#define LAYER_CACHE_H
+
+#include "pixel_blit.h"
+#include "staging_memory.h"
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+struct LayerCacheStats {
+    // Times a layer was drawn, and composited onto a frame; every composite
+    // past the first of each build saved drawing it again
+    uint64_t builds;
+    uint64_t composites;
+    uint64_t invalidations;
+    uint32_t layers;
+    // Pixel memory held by all layers
+    uint64_t bytes;
+};
+
+// Static sub-scenes drawn once into pixels of their own, then composited
+// onto every frame that shows them. A layer is identified by the caller's
+// id and covers a rect of the frame; it is drawn again when it is
+// invalidated, or used with another rect or other params (the bytes of
+// whatever else its content depends on: colors, widths, quality):
+//
+//   if (!cache.IsValid(id, rect, &params, sizeof(params))) {
+//       PixelSurface layer;
+//       cache.Begin(id, rect, &params, sizeof(params), layer);
+//       ... draw into layer, offset by -rect.x, -rect.y ...
+//   }
+//   cache.Composite(id, target);
+//
+// Layers are premultiplied RGBA_8888, transparent where nothing was drawn:
+// what drawing source-over onto a cleared layer produces. Composite() blends
+// them with CompositePixels().
+//
+// Used from one thread; GetStats() may be called from any thread.
+class LayerCache {
+public:
+    static constexpr uint32_t MAX_LAYERS = 8;
+    static constexpr size_t MAX_PARAMS_SIZE = 64;
+
+    LayerCache() = default;
+    LayerCache(const LayerCache&) = delete;
+    LayerCache& operator=(const LayerCache&) = delete;
+
+    // Whether layer id holds what was drawn for rect and params
+    bool IsValid(uint32_t id, const BlitRect& rect, const void* params, size_t paramsSize) const;
+
+    // Clear layer id, taking the least recently composited one's place if
+    // there is none, and set surface to its pixels for the caller to draw.
+    // False if rect is empty, params are too large or the memory cannot be
+    // had; the layer is then dropped.
+    bool Begin(uint32_t id, const BlitRect& rect, const void* params, size_t paramsSize, PixelSurface& surface);
+
+    // Composite layer id onto target at its rect. False, with target
+    // untouched, if the layer is not valid.
+    bool Composite(uint32_t id, const PixelSurface& target);
+
+    // Have layer id, or every layer, drawn again on next use. The memory is
+    // kept for it.
+    void Invalidate(uint32_t id);
+    void InvalidateAll();
+
+    // Drop every layer and its memory
+    void Release();
+
+    LayerCacheStats GetStats() const
+    {
+        return LayerCacheStats {builds_.load(std::memory_order_relaxed), composites_.load(std::memory_order_relaxed),
+            invalidations_.load(std::memory_order_relaxed), layerCount_.load(std::memory_order_relaxed),
+            bytes_.load(std::memory_order_relaxed)};
+    }
+
+private:
+    struct Layer {
+        bool used = false;
+        bool valid = false;
+        uint32_t id = 0;
+        BlitRect rect {0, 0, 0, 0};
+        uint8_t params[MAX_PARAMS_SIZE] = {};
+        size_t paramsSize = 0;
+        uint64_t lastUse = 0;
+        StagingMemory memory;
+    };
+
+    const Layer* Find(uint32_t id) const;
+    Layer* Find(uint32_t id);
+    void UpdateUsage();
+
+    Layer entries_[MAX_LAYERS];
+    uint64_t useClock_ = 0;
+
+    // Written by the owning thread, read by GetStats() from anywhere
+    std::atomic<uint64_t> builds_ {0};
+    std::atomic<uint64_t> composites_ {0};
+    std::atomic<uint64_t> invalidations_ {0};
+    std::atomic<uint32_t> layerCount_ {0};
+    std::atomic<uint64_t> bytes_ {0};
+};
+
+#endif // LAYER_CACHE_H
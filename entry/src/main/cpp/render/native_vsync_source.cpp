@@ -0,0 +1,37 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#include "native_vsync_source.h"
+#include <cstring>
+
+std::unique_ptr<NativeVsyncSource> NativeVsyncSource::Create(const char* name, Callback callback)
+{
+    OH_NativeVSync* vsync = OH_NativeVSync_Create(name, static_cast<unsigned int>(strlen(name)));
+    if (vsync == nullptr) {
+        return nullptr;
+    }
+    return std::unique_ptr<NativeVsyncSource>(new NativeVsyncSource(vsync, std::move(callback)));
+}
+
+NativeVsyncSource::NativeVsyncSource(OH_NativeVSync* vsync, Callback callback)
+    : vsync_(vsync), callback_(std::move(callback))
+{
+}
+
+NativeVsyncSource::~NativeVsyncSource() noexcept
+{
+    OH_NativeVSync_Destroy(vsync_);
+}
+
+bool NativeVsyncSource::RequestVsync()
+{
+    // One-shot: the system calls back once per request
+    return OH_NativeVSync_RequestFrame(vsync_, OnFrame, this) == 0;
+}
+
+void NativeVsyncSource::OnFrame(long long timestamp, void* data)
+{
+    static_cast<NativeVsyncSource*>(data)->callback_(static_cast<int64_t>(timestamp));
+}
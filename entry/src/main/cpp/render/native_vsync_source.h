@@ -0,0 +1,33 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#ifndef NATIVE_VSYNC_SOURCE_H
+#define NATIVE_VSYNC_SOURCE_H
+
+#include "frame_scheduler.h"
+#include <native_vsync/native_vsync.h>
+#include <memory>
+
+// The display's vsync, through OH_NativeVSync
+class NativeVsyncSource : public VsyncSource {
+public:
+    // Null if the system has no vsync to give
+    static std::unique_ptr<NativeVsyncSource> Create(const char* name, Callback callback);
+    ~NativeVsyncSource() noexcept override;
+
+    NativeVsyncSource(const NativeVsyncSource&) = delete;
+    NativeVsyncSource& operator=(const NativeVsyncSource&) = delete;
+
+    bool RequestVsync() override;
+
+private:
+    NativeVsyncSource(OH_NativeVSync* vsync, Callback callback);
+    static void OnFrame(long long timestamp, void* data);
+
+    OH_NativeVSync* vsync_;
+    Callback callback_;
+};
+
+#endif // NATIVE_VSYNC_SOURCE_H
@@ -0,0 +1,526 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#include "pixel_blit.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define PIXEL_BLIT_X86 1
+#include <immintrin.h>
+#elif defined(__aarch64__) || defined(__ARM_NEON)
+#define PIXEL_BLIT_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+// Converts count pixels from src to dst; the two never overlap
+using RowFn = void (*)(const uint32_t* src, uint32_t* dst, uint32_t count);
+
+struct RowKernels {
+    RowFn swapRb;
+    RowFn premultiply;
+    RowFn swapRbPremultiply;
+    // These write over what dst holds
+    RowFn composite;
+    RowFn swapRbComposite;
+};
+
+// Exact round(x / 255) for x <= 255 * 255
+inline uint32_t Div255(uint32_t x)
+{
+    x += 128;
+    return (x + (x >> 8)) >> 8;
+}
+
+inline uint32_t SwapRbPixel(uint32_t p)
+{
+    return (p & 0xFF00FF00u) | ((p >> 16) & 0xFFu) | ((p & 0xFFu) << 16);
+}
+
+inline uint32_t PremultiplyPixel(uint32_t p)
+{
+    uint32_t a = p >> 24;
+    uint32_t c0 = Div255((p & 0xFFu) * a);
+    uint32_t c1 = Div255(((p >> 8) & 0xFFu) * a);
+    uint32_t c2 = Div255(((p >> 16) & 0xFFu) * a);
+    return (a << 24) | (c2 << 16) | (c1 << 8) | c0;
+}
+
+void SwapRbScalar(const uint32_t* src, uint32_t* dst, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        dst[i] = SwapRbPixel(src[i]);
+    }
+}
+
+void PremultiplyScalar(const uint32_t* src, uint32_t* dst, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        dst[i] = PremultiplyPixel(src[i]);
+    }
+}
+
+void SwapRbPremultiplyScalar(const uint32_t* src, uint32_t* dst, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        dst[i] = SwapRbPixel(PremultiplyPixel(src[i]));
+    }
+}
+
+// Premultiplied source-over; channels add up to at most 255 for a valid
+// premultiplied src, and saturate otherwise
+inline uint32_t CompositePixel(uint32_t s, uint32_t d)
+{
+    uint32_t inverse = 255 - (s >> 24);
+    uint32_t out = 0;
+    for (uint32_t shift = 0; shift < 32; shift += 8) {
+        uint32_t c = ((s >> shift) & 0xFFu) + Div255(((d >> shift) & 0xFFu) * inverse);
+        out |= std::min(c, 255u) << shift;
+    }
+    return out;
+}
+
+template <bool SWAP_RB>
+void CompositeScalar(const uint32_t* src, uint32_t* dst, uint32_t count)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t s = src[i];
+        uint32_t a = s >> 24;
+        if (a == 0) {
+            continue;
+        }
+        s = SWAP_RB ? SwapRbPixel(s) : s;
+        dst[i] = (a == 255) ? s : CompositePixel(s, dst[i]);
+    }
+}
+
+#if defined(PIXEL_BLIT_X86)
+inline __m128i SwapRbSse2(__m128i v)
+{
+    const __m128i agMask = _mm_set1_epi32(static_cast<int>(0xFF00FF00u));
+    const __m128i rbMask = _mm_set1_epi32(0x00FF00FF);
+    __m128i ag = _mm_and_si128(v, agMask);
+    __m128i rb = _mm_and_si128(v, rbMask);
+    rb = _mm_or_si128(_mm_slli_epi32(rb, 16), _mm_srli_epi32(rb, 16));
+    return _mm_or_si128(ag, rb);
+}
+
+// Multiplies four 16-bit channels of two pixels by their alpha, leaving alpha as is
+inline __m128i PremultiplyHalfSse2(__m128i px)
+{
+    const __m128i alphaLane = _mm_set_epi16(255, 0, 0, 0, 255, 0, 0, 0);
+    const __m128i bias = _mm_set1_epi16(128);
+    __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(px, 0xFF), 0xFF);
+    alpha = _mm_or_si128(alpha, alphaLane);
+    __m128i t = _mm_add_epi16(_mm_mullo_epi16(px, alpha), bias);
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+inline __m128i PremultiplySse2(__m128i v)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i lo = PremultiplyHalfSse2(_mm_unpacklo_epi8(v, zero));
+    __m128i hi = PremultiplyHalfSse2(_mm_unpackhi_epi8(v, zero));
+    return _mm_packus_epi16(lo, hi);
+}
+
+void SwapRbSse2Row(const uint32_t* src, uint32_t* dst, uint32_t count)
+{
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), SwapRbSse2(v));
+    }
+    SwapRbScalar(src + i, dst + i, count - i);
+}
+
+void PremultiplySse2Row(const uint32_t* src, uint32_t* dst, uint32_t count)
+{
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), PremultiplySse2(v));
+    }
+    PremultiplyScalar(src + i, dst + i, count - i);
+}
+
+void SwapRbPremultiplySse2Row(const uint32_t* src, uint32_t* dst, uint32_t count)
+{
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), SwapRbSse2(PremultiplySse2(v)));
+    }
+    SwapRbPremultiplyScalar(src + i, dst + i, count - i);
+}
+
+// round(d * (255 - src alpha) / 255) for four 16-bit channels of two pixels
+inline __m128i AttenuateHalfSse2(__m128i s, __m128i d)
+{
+    const __m128i full = _mm_set1_epi16(255);
+    const __m128i bias = _mm_set1_epi16(128);
+    __m128i alpha = _mm_shufflehi_epi16(_mm_shufflelo_epi16(s, 0xFF), 0xFF);
+    __m128i t = _mm_add_epi16(_mm_mullo_epi16(d, _mm_sub_epi16(full, alpha)), bias);
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+template <bool SWAP_RB>
+void CompositeSse2Row(const uint32_t* src, uint32_t* dst, uint32_t count)
+{
+    const __m128i alphaMask = _mm_set1_epi32(static_cast<int>(0xFF000000u));
+    const __m128i zero = _mm_setzero_si128();
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i s = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        __m128i alpha = _mm_and_si128(s, alphaMask);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, zero)) == 0xFFFF) {
+            continue;
+        }
+        s = SWAP_RB ? SwapRbSse2(s) : s;
+        __m128i* out = reinterpret_cast<__m128i*>(dst + i);
+        if (_mm_movemask_epi8(_mm_cmpeq_epi32(alpha, alphaMask)) == 0xFFFF) {
+            _mm_storeu_si128(out, s);
+            continue;
+        }
+        __m128i d = _mm_loadu_si128(out);
+        __m128i lo = AttenuateHalfSse2(_mm_unpacklo_epi8(s, zero), _mm_unpacklo_epi8(d, zero));
+        __m128i hi = AttenuateHalfSse2(_mm_unpackhi_epi8(s, zero), _mm_unpackhi_epi8(d, zero));
+        _mm_storeu_si128(out, _mm_adds_epu8(s, _mm_packus_epi16(lo, hi)));
+    }
+    CompositeScalar<SWAP_RB>(src + i, dst + i, count - i);
+}
+
+#define PIXEL_BLIT_AVX2 __attribute__((target("avx2")))
+
+PIXEL_BLIT_AVX2 inline __m256i SwapRbAvx2(__m256i v)
+{
+    const __m256i shuffle = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+        2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+    return _mm256_shuffle_epi8(v, shuffle);
+}
+
+PIXEL_BLIT_AVX2 inline __m256i PremultiplyHalfAvx2(__m256i px)
+{
+    const __m256i alphaLane = _mm256_set_epi16(255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0, 255, 0, 0, 0);
+    const __m256i bias = _mm256_set1_epi16(128);
+    __m256i alpha = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(px, 0xFF), 0xFF);
+    alpha = _mm256_or_si256(alpha, alphaLane);
+    __m256i t = _mm256_add_epi16(_mm256_mullo_epi16(px, alpha), bias);
+    return _mm256_srli_epi16(_mm256_add_epi16(t, _mm256_srli_epi16(t, 8)), 8);
+}
+
+PIXEL_BLIT_AVX2 inline __m256i PremultiplyAvx2(__m256i v)
+{
+    // unpack and pack both work within 128-bit lanes, so pixel order is kept
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i lo = PremultiplyHalfAvx2(_mm256_unpacklo_epi8(v, zero));
+    __m256i hi = PremultiplyHalfAvx2(_mm256_unpackhi_epi8(v, zero));
+    return _mm256_packus_epi16(lo, hi);
+}
+
+PIXEL_BLIT_AVX2 void SwapRbAvx2Row(const uint32_t* src, uint32_t* dst, uint32_t count)
+{
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), SwapRbAvx2(v));
+    }
+    SwapRbScalar(src + i, dst + i, count - i);
+}
+
+PIXEL_BLIT_AVX2 void PremultiplyAvx2Row(const uint32_t* src, uint32_t* dst, uint32_t count)
+{
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), PremultiplyAvx2(v));
+    }
+    PremultiplyScalar(src + i, dst + i, count - i);
+}
+
+PIXEL_BLIT_AVX2 void SwapRbPremultiplyAvx2Row(const uint32_t* src, uint32_t* dst, uint32_t count)
+{
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), SwapRbAvx2(PremultiplyAvx2(v)));
+    }
+    SwapRbPremultiplyScalar(src + i, dst + i, count - i);
+}
+#endif // PIXEL_BLIT_X86
+
+#if defined(PIXEL_BLIT_NEON)
+inline uint8x16_t PremultiplyChannelNeon(uint8x16_t c, uint8x16_t a)
+{
+    uint16x8_t lo = vmull_u8(vget_low_u8(c), vget_low_u8(a));
+    uint16x8_t hi = vmull_u8(vget_high_u8(c), vget_high_u8(a));
+    // (t + ((t + 128) >> 8) + 128) >> 8, the same rounding as Div255
+    return vcombine_u8(vrshrn_n_u16(vrsraq_n_u16(lo, lo, 8), 8), vrshrn_n_u16(vrsraq_n_u16(hi, hi, 8), 8));
+}
+
+void SwapRbNeonRow(const uint32_t* src, uint32_t* dst, uint32_t count)
+{
+    uint32_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        uint8x16x4_t px = vld4q_u8(reinterpret_cast<const uint8_t*>(src + i));
+        uint8x16_t tmp = px.val[0];
+        px.val[0] = px.val[2];
+        px.val[2] = tmp;
+        vst4q_u8(reinterpret_cast<uint8_t*>(dst + i), px);
+    }
+    SwapRbScalar(src + i, dst + i, count - i);
+}
+
+void PremultiplyNeonRow(const uint32_t* src, uint32_t* dst, uint32_t count)
+{
+    uint32_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        uint8x16x4_t px = vld4q_u8(reinterpret_cast<const uint8_t*>(src + i));
+        px.val[0] = PremultiplyChannelNeon(px.val[0], px.val[3]);
+        px.val[1] = PremultiplyChannelNeon(px.val[1], px.val[3]);
+        px.val[2] = PremultiplyChannelNeon(px.val[2], px.val[3]);
+        vst4q_u8(reinterpret_cast<uint8_t*>(dst + i), px);
+    }
+    PremultiplyScalar(src + i, dst + i, count - i);
+}
+
+void SwapRbPremultiplyNeonRow(const uint32_t* src, uint32_t* dst, uint32_t count)
+{
+    uint32_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        uint8x16x4_t px = vld4q_u8(reinterpret_cast<const uint8_t*>(src + i));
+        uint8x16_t c0 = PremultiplyChannelNeon(px.val[0], px.val[3]);
+        px.val[1] = PremultiplyChannelNeon(px.val[1], px.val[3]);
+        px.val[0] = PremultiplyChannelNeon(px.val[2], px.val[3]);
+        px.val[2] = c0;
+        vst4q_u8(reinterpret_cast<uint8_t*>(dst + i), px);
+    }
+    SwapRbPremultiplyScalar(src + i, dst + i, count - i);
+}
+
+template <bool SWAP_RB>
+void CompositeNeonRow(const uint32_t* src, uint32_t* dst, uint32_t count)
+{
+    uint32_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        uint8x16x4_t s = vld4q_u8(reinterpret_cast<const uint8_t*>(src + i));
+        uint64x2_t alpha = vreinterpretq_u64_u8(s.val[3]);
+        uint64_t low = vgetq_lane_u64(alpha, 0);
+        uint64_t high = vgetq_lane_u64(alpha, 1);
+        if ((low | high) == 0) {
+            continue;
+        }
+        if (SWAP_RB) {
+            uint8x16_t tmp = s.val[0];
+            s.val[0] = s.val[2];
+            s.val[2] = tmp;
+        }
+        uint8_t* out = reinterpret_cast<uint8_t*>(dst + i);
+        if ((low & high) == ~0ull) {
+            vst4q_u8(out, s);
+            continue;
+        }
+        uint8x16x4_t d = vld4q_u8(out);
+        uint8x16_t inverse = vmvnq_u8(s.val[3]);
+        for (int c = 0; c < 4; c++) {
+            d.val[c] = vqaddq_u8(s.val[c], PremultiplyChannelNeon(d.val[c], inverse));
+        }
+        vst4q_u8(out, d);
+    }
+    CompositeScalar<SWAP_RB>(src + i, dst + i, count - i);
+}
+#endif // PIXEL_BLIT_NEON
+
+bool IsaSupported(BlitIsa isa)
+{
+    switch (isa) {
+        case BlitIsa::SCALAR:
+            return true;
+#if defined(PIXEL_BLIT_X86)
+        case BlitIsa::SSE2:
+            return __builtin_cpu_supports("sse2");
+        case BlitIsa::AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+#if defined(PIXEL_BLIT_NEON)
+        case BlitIsa::NEON:
+            return true;
+#endif
+        default:
+            return false;
+    }
+}
+
+BlitIsa DetectIsa()
+{
+    const BlitIsa candidates[] = {BlitIsa::AVX2, BlitIsa::NEON, BlitIsa::SSE2};
+    for (BlitIsa isa : candidates) {
+        if (IsaSupported(isa)) {
+            return isa;
+        }
+    }
+    return BlitIsa::SCALAR;
+}
+
+RowKernels KernelsFor(BlitIsa isa)
+{
+    switch (isa) {
+#if defined(PIXEL_BLIT_X86)
+        case BlitIsa::SSE2:
+            return {SwapRbSse2Row, PremultiplySse2Row, SwapRbPremultiplySse2Row, CompositeSse2Row<false>,
+                CompositeSse2Row<true>};
+        case BlitIsa::AVX2:
+            // Compositing has no AVX2 kernel of its own
+            return {SwapRbAvx2Row, PremultiplyAvx2Row, SwapRbPremultiplyAvx2Row, CompositeSse2Row<false>,
+                CompositeSse2Row<true>};
+#endif
+#if defined(PIXEL_BLIT_NEON)
+        case BlitIsa::NEON:
+            return {SwapRbNeonRow, PremultiplyNeonRow, SwapRbPremultiplyNeonRow, CompositeNeonRow<false>,
+                CompositeNeonRow<true>};
+#endif
+        default:
+            return {SwapRbScalar, PremultiplyScalar, SwapRbPremultiplyScalar, CompositeScalar<false>,
+                CompositeScalar<true>};
+    }
+}
+
+std::atomic<int>& ActiveIsa()
+{
+    static std::atomic<int> isa {static_cast<int>(DetectIsa())};
+    return isa;
+}
+
+// Clip rect against a surface; false if nothing is left
+bool ClipRect(const PixelSurface& surface, BlitRect& rect)
+{
+    if ((rect.x >= surface.width) || (rect.y >= surface.height)) {
+        return false;
+    }
+    rect.w = std::min(rect.w, surface.width - rect.x);
+    rect.h = std::min(rect.h, surface.height - rect.y);
+    return (rect.w > 0) && (rect.h > 0);
+}
+
+bool ValidSurface(const PixelSurface& surface)
+{
+    return (surface.pixels != nullptr) && (surface.stride % sizeof(uint32_t) == 0) &&
+        (static_cast<uint64_t>(surface.stride) >= static_cast<uint64_t>(surface.width) * sizeof(uint32_t));
+}
+
+} // namespace
+
+bool BlitPixels(const PixelSurface& src, const PixelSurface& dst, const BlitRect& rect, bool premultiply)
+{
+    if (!ValidSurface(src) || !ValidSurface(dst)) {
+        return false;
+    }
+
+    BlitRect clipped = rect;
+    if (!ClipRect(src, clipped) || !ClipRect(dst, clipped)) {
+        // Nothing to copy is not an error
+        return true;
+    }
+
+    const uint8_t* srcRow = static_cast<const uint8_t*>(src.pixels) +
+        static_cast<size_t>(clipped.y) * src.stride + static_cast<size_t>(clipped.x) * sizeof(uint32_t);
+    uint8_t* dstRow = static_cast<uint8_t*>(dst.pixels) +
+        static_cast<size_t>(clipped.y) * dst.stride + static_cast<size_t>(clipped.x) * sizeof(uint32_t);
+    const size_t rowBytes = static_cast<size_t>(clipped.w) * sizeof(uint32_t);
+    const bool swapRb = src.format != dst.format;
+
+    if (!swapRb && !premultiply) {
+        // Plain copy: one memcpy when both sides are contiguous, one per row
+        // otherwise. This is the fast path on every ISA; a kernel of our own
+        // would not beat the platform's vectorized memcpy.
+        if ((src.stride == rowBytes) && (dst.stride == rowBytes)) {
+            memcpy(dstRow, srcRow, rowBytes * clipped.h);
+            return true;
+        }
+        for (uint32_t y = 0; y < clipped.h; y++) {
+            memcpy(dstRow, srcRow, rowBytes);
+            srcRow += src.stride;
+            dstRow += dst.stride;
+        }
+        return true;
+    }
+
+    RowKernels kernels = KernelsFor(static_cast<BlitIsa>(ActiveIsa().load(std::memory_order_relaxed)));
+    RowFn row = swapRb ? (premultiply ? kernels.swapRbPremultiply : kernels.swapRb) : kernels.premultiply;
+    for (uint32_t y = 0; y < clipped.h; y++) {
+        row(reinterpret_cast<const uint32_t*>(srcRow), reinterpret_cast<uint32_t*>(dstRow), clipped.w);
+        srcRow += src.stride;
+        dstRow += dst.stride;
+    }
+    return true;
+}
+
+bool BlitPixels(const PixelSurface& src, const PixelSurface& dst, bool premultiply)
+{
+    BlitRect rect {0, 0, std::min(src.width, dst.width), std::min(src.height, dst.height)};
+    return BlitPixels(src, dst, rect, premultiply);
+}
+
+bool CompositePixels(const PixelSurface& src, const PixelSurface& dst, const BlitRect& rect)
+{
+    if (!ValidSurface(src) || !ValidSurface(dst)) {
+        return false;
+    }
+
+    BlitRect clipped = rect;
+    if (!ClipRect(src, clipped) || !ClipRect(dst, clipped)) {
+        return true;
+    }
+
+    const uint8_t* srcRow = static_cast<const uint8_t*>(src.pixels) +
+        static_cast<size_t>(clipped.y) * src.stride + static_cast<size_t>(clipped.x) * sizeof(uint32_t);
+    uint8_t* dstRow = static_cast<uint8_t*>(dst.pixels) +
+        static_cast<size_t>(clipped.y) * dst.stride + static_cast<size_t>(clipped.x) * sizeof(uint32_t);
+    RowKernels kernels = KernelsFor(static_cast<BlitIsa>(ActiveIsa().load(std::memory_order_relaxed)));
+    RowFn row = (src.format != dst.format) ? kernels.swapRbComposite : kernels.composite;
+    for (uint32_t y = 0; y < clipped.h; y++) {
+        row(reinterpret_cast<const uint32_t*>(srcRow), reinterpret_cast<uint32_t*>(dstRow), clipped.w);
+        srcRow += src.stride;
+        dstRow += dst.stride;
+    }
+    return true;
+}
+
+bool CompositePixels(const PixelSurface& src, const PixelSurface& dst)
+{
+    BlitRect rect {0, 0, std::min(src.width, dst.width), std::min(src.height, dst.height)};
+    return CompositePixels(src, dst, rect);
+}
+
+BlitIsa GetBlitIsa()
+{
+    return static_cast<BlitIsa>(ActiveIsa().load(std::memory_order_relaxed));
+}
+
+bool SetBlitIsa(BlitIsa isa)
+{
+    if (!IsaSupported(isa)) {
+        return false;
+    }
+    ActiveIsa().store(static_cast<int>(isa), std::memory_order_relaxed);
+    return true;
+}
+
+const char* BlitIsaName(BlitIsa isa)
+{
+    switch (isa) {
+        case BlitIsa::SSE2:
+            return "sse2";
+        case BlitIsa::AVX2:
+            return "avx2";
+        case BlitIsa::NEON:
+            return "neon";
+        default:
+            return "scalar";
+    }
+}
@@ -0,0 +1,73 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#ifndef PIXEL_BLIT_H
+#define PIXEL_BLIT_H
+
+#include <cstdint>
+
+// Byte order of a 32-bit pixel in memory
+enum class PixelFormat {
+    RGBA_8888,
+    BGRA_8888,
+};
+
+// A block of 32-bit pixels. stride is in bytes and may be larger than width * 4.
+struct PixelSurface {
+    void* pixels;
+    uint32_t width;
+    uint32_t height;
+    uint32_t stride;
+    PixelFormat format;
+};
+
+struct BlitRect {
+    uint32_t x;
+    uint32_t y;
+    uint32_t w;
+    uint32_t h;
+};
+
+// Instruction set the blit kernels run with
+enum class BlitIsa {
+    SCALAR,
+    SSE2,
+    AVX2,
+    NEON,
+};
+
+// Copy rect from src to the same position in dst, row by row, honouring both
+// strides. When the formats differ the red and blue channels are swapped;
+// when premultiply is set the color channels are multiplied by alpha.
+// The rect is clipped to both surfaces. Returns false on invalid input.
+// A plain copy (same format, no premultiply) is memcpy whatever the
+// instruction set: libc's is already vectorized, and the kernels below are
+// only for the conversions.
+bool BlitPixels(const PixelSurface& src, const PixelSurface& dst, const BlitRect& rect, bool premultiply = false);
+
+// Whole-surface variant of the above
+bool BlitPixels(const PixelSurface& src, const PixelSurface& dst, bool premultiply = false);
+
+// Composite rect of src, premultiplied, source-over onto the same position
+// in dst: dst = src + round(dst * (255 - src alpha) / 255) per channel,
+// alpha included. Runs of src that are fully transparent are skipped and
+// fully opaque ones copied. When the formats differ the red and blue
+// channels of src are swapped. The rect is clipped to both surfaces.
+// Returns false on invalid input.
+bool CompositePixels(const PixelSurface& src, const PixelSurface& dst, const BlitRect& rect);
+
+// Whole-surface variant of the above
+bool CompositePixels(const PixelSurface& src, const PixelSurface& dst);
+
+// The best instruction set available on this CPU, detected once
+BlitIsa GetBlitIsa();
+
+// Force a specific instruction set, e.g. to compare kernels in tests and
+// benchmarks. Returns false, leaving the current one, if it is not supported here.
+bool SetBlitIsa(BlitIsa isa);
+
+const char* BlitIsaName(BlitIsa isa);
+
+#endif // PIXEL_BLIT_H
@@ -0,0 +1,123 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#include "raster_scheduler.h"
+#include <algorithm>
+
+namespace {
+
+constexpr uint32_t MAX_SHARED_WORKERS = 7;
+
+uint32_t Index(SurfacePriority priority)
+{
+    return std::min(static_cast<uint32_t>(priority), SURFACE_PRIORITY_COUNT - 1);
+}
+
+uint32_t SharedWorkerCount()
+{
+    return std::min(WorkStealingPool::GetPerformanceCoreCount() - 1, MAX_SHARED_WORKERS);
+}
+
+} // namespace
+
+RasterScheduler::Turn::Turn(RasterScheduler& scheduler, SurfacePriority priority)
+    : scheduler_(scheduler), pool_(nullptr)
+{
+    scheduler_.Acquire(priority);
+    if ((priority != SurfacePriority::BACKGROUND) && (scheduler_.pool_.GetWorkerCount() > 0)) {
+        pool_ = &scheduler_.pool_;
+    }
+}
+
+RasterScheduler::Turn::~Turn() noexcept
+{
+    scheduler_.Release();
+}
+
+RasterScheduler::RasterScheduler(uint32_t slots, uint32_t workerCount, const std::vector<uint32_t>& workerCpus)
+    : slots_(std::max(slots, 1u)), pool_(workerCount, workerCpus)
+{
+}
+
+RasterScheduler& RasterScheduler::GetShared()
+{
+    static RasterScheduler scheduler(WorkStealingPool::GetPerformanceCoreCount() - SharedWorkerCount(),
+        SharedWorkerCount(), WorkStealingPool::GetCpuTopology().performance);
+    return scheduler;
+}
+
+void RasterScheduler::MoveThread(SurfacePriority priority)
+{
+    const CpuTopology& topology = WorkStealingPool::GetCpuTopology();
+    if (topology.efficiency.empty()) {
+        return;
+    }
+    // Only when it changes: render threads call this every frame
+    thread_local bool inBackground = false;
+    bool background = priority == SurfacePriority::BACKGROUND;
+    if (background == inBackground) {
+        return;
+    }
+    inBackground = background;
+    if (background) {
+        WorkStealingPool::SetThreadCpus(topology.efficiency);
+        return;
+    }
+    std::vector<uint32_t> all(topology.performance);
+    all.insert(all.end(), topology.efficiency.begin(), topology.efficiency.end());
+    WorkStealingPool::SetThreadCpus(all);
+}
+
+void RasterScheduler::Acquire(SurfacePriority priority)
+{
+    uint32_t index = Index(priority);
+    std::unique_lock<std::mutex> lock(mutex_);
+    uint64_t ticket = tickets_[index]++;
+    waiting_[index]++;
+    auto admissible = [this, index, ticket]() {
+        if ((running_ >= slots_) || (serving_[index] != ticket)) {
+            return false;
+        }
+        for (uint32_t higher = 0; higher < index; higher++) {
+            if (waiting_[higher] != 0) {
+                return false;
+            }
+        }
+        return true;
+    };
+    bool waited = !admissible();
+    slotFreed_.wait(lock, admissible);
+    waiting_[index]--;
+    serving_[index]++;
+    running_++;
+    frames_[index]++;
+    if (waited) {
+        waited_++;
+    }
+    // The next in line may fit in another free slot
+    if (running_ < slots_) {
+        slotFreed_.notify_all();
+    }
+}
+
+void RasterScheduler::Release()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        running_--;
+    }
+    slotFreed_.notify_all();
+}
+
+RasterSchedulerStats RasterScheduler::GetStats() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    RasterSchedulerStats stats {slots_, pool_.GetWorkerCount(), running_, 0, {}, waited_};
+    for (uint32_t i = 0; i < SURFACE_PRIORITY_COUNT; i++) {
+        stats.waiting += waiting_[i];
+        stats.frames[i] = frames_[i];
+    }
+    return stats;
+}
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#ifndef RASTER_SCHEDULER_H
+#define RASTER_SCHEDULER_H
+
+#include "work_stealing_pool.h"
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+// How much a surface's frames matter, most first
+enum class SurfacePriority : uint32_t {
+    // Visible and has input focus
+    FOCUSED = 0,
+    VISIBLE,
+    // Hidden or offscreen: drawn rarely, and never on the shared workers
+    BACKGROUND,
+};
+
+constexpr uint32_t SURFACE_PRIORITY_COUNT = 3;
+
+struct RasterSchedulerStats {
+    // Frames drawn at once at most, and the workers they share
+    uint32_t slots;
+    uint32_t workers;
+    uint32_t running;
+    uint32_t waiting;
+    // Frames admitted, by SurfacePriority
+    uint64_t frames[SURFACE_PRIORITY_COUNT];
+    // Of those, frames that had to wait for a slot
+    uint64_t waited;
+};
+
+// Shares the CPU between every surface of the process. Each surface draws on
+// its own render thread, but only slots frames are drawn at once; the rest
+// wait, and are let in by priority, first come first served within one.
+// Tiles go to one pool of workers kept on the performance cores, rather than
+// a pool per surface:
+//
+//   RasterScheduler::Turn turn(RasterScheduler::GetShared(), priority);
+//   ... draw, flushing tiles to turn.GetPool() ...
+//
+// Background surfaces get no pool: their tiles are drawn on their own thread,
+// which MoveThread() keeps on the efficiency cores, and SampleBitMap draws
+// them at most every BACKGROUND_FRAME_INTERVAL.
+class RasterScheduler {
+public:
+    static constexpr std::chrono::milliseconds BACKGROUND_FRAME_INTERVAL {100};
+
+    // A frame slot, held for the object's life. The constructor blocks until
+    // the slot is free.
+    class Turn {
+    public:
+        Turn(RasterScheduler& scheduler, SurfacePriority priority);
+        ~Turn() noexcept;
+
+        Turn(const Turn&) = delete;
+        Turn& operator=(const Turn&) = delete;
+
+        // Workers for the frame's tiles; null for background frames, and
+        // when there are no workers
+        WorkStealingPool* GetPool() const
+        {
+            return pool_;
+        }
+
+    private:
+        RasterScheduler& scheduler_;
+        WorkStealingPool* pool_;
+    };
+
+    // workerCpus empty: workers run anywhere
+    RasterScheduler(uint32_t slots, uint32_t workerCount, const std::vector<uint32_t>& workerCpus = {});
+
+    RasterScheduler(const RasterScheduler&) = delete;
+    RasterScheduler& operator=(const RasterScheduler&) = delete;
+
+    // One worker per performance core less one, kept on those cores, and a
+    // slot for each core they leave: a frame's own thread rasters tiles
+    // too, so slot holders and workers together never outnumber the cores
+    static RasterScheduler& GetShared();
+
+    // Keep the calling render thread on the efficiency cores while its
+    // surface is in the background, anywhere otherwise. Does nothing on
+    // CPUs with a single cluster.
+    static void MoveThread(SurfacePriority priority);
+
+    RasterSchedulerStats GetStats() const;
+
+private:
+    void Acquire(SurfacePriority priority);
+    void Release();
+
+    const uint32_t slots_;
+    WorkStealingPool pool_;
+
+    mutable std::mutex mutex_;
+    std::condition_variable slotFreed_;
+    uint32_t running_ = 0;
+    // Waiters are numbered per priority as they arrive; serving_ is the
+    // number of the next one to let in
+    uint32_t waiting_[SURFACE_PRIORITY_COUNT] = {};
+    uint64_t tickets_[SURFACE_PRIORITY_COUNT] = {};
+    uint64_t serving_[SURFACE_PRIORITY_COUNT] = {};
+    uint64_t frames_[SURFACE_PRIORITY_COUNT] = {};
+    uint64_t waited_ = 0;
+};
+
+#endif // RASTER_SCHEDULER_H
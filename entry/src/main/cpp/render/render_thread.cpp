@@ -0,0 +1,133 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#include "render_thread.h"
+
+RenderThread::RenderThread(Handler handler) : handler_(std::move(handler))
+{
+}
+
+RenderThread::~RenderThread() noexcept
+{
+    Stop();
+}
+
+void RenderThread::Start()
+{
+    if (running_.exchange(true, std::memory_order_acq_rel)) {
+        return;
+    }
+    thread_ = std::thread(&RenderThread::Run, this);
+}
+
+bool RenderThread::Post(const RenderCommand& command)
+{
+    {
+        std::lock_guard<std::mutex> lock(postMutex_);
+        if (!queue_.TryPush(command)) {
+            return false;
+        }
+    }
+    WakeConsumer();
+    return true;
+}
+
+void RenderThread::PostBlocking(const RenderCommand& command)
+{
+    while (true) {
+        {
+            // Not held while waiting, so other threads' Post() still fail fast
+            std::lock_guard<std::mutex> lock(postMutex_);
+            if (queue_.TryPush(command)) {
+                break;
+            }
+        }
+        WakeConsumer();
+        std::this_thread::yield();
+    }
+    WakeConsumer();
+}
+
+void RenderThread::SetTickHandler(std::function<void()> tick)
+{
+    // Only before Start(); the thread reads tick_ without a lock
+    if (!running_.load(std::memory_order_acquire)) {
+        tick_ = std::move(tick);
+    }
+}
+
+void RenderThread::RequestTick()
+{
+    if (!tickRequested_.exchange(true, std::memory_order_acq_rel)) {
+        WakeConsumer();
+    }
+}
+
+void RenderThread::RequestTickAt(std::chrono::steady_clock::time_point when)
+{
+    if (!tickScheduled_ || (when < tickTime_)) {
+        tickScheduled_ = true;
+        tickTime_ = when;
+    }
+}
+
+void RenderThread::Stop()
+{
+    if (!running_.load(std::memory_order_acquire)) {
+        return;
+    }
+    PostBlocking(RenderCommand {RenderCommandType::STOP, nullptr, 0, 0, nullptr});
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+    running_.store(false, std::memory_order_release);
+}
+
+void RenderThread::WakeConsumer()
+{
+    // Pairs with the fence in Run(): either we see the consumer going to
+    // sleep, or it sees the command or tick we just queued
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (sleeping_.load(std::memory_order_relaxed)) {
+        std::lock_guard<std::mutex> lock(mutex_);
+        wakeup_.notify_one();
+    }
+}
+
+void RenderThread::Run()
+{
+    RenderCommand command;
+    while (true) {
+        if (tickScheduled_ && (std::chrono::steady_clock::now() >= tickTime_)) {
+            tickScheduled_ = false;
+            tickRequested_.store(true, std::memory_order_release);
+        }
+        // Ticks go first, so a burst of commands cannot push a frame late
+        if (tickRequested_.exchange(false, std::memory_order_acq_rel) && tick_) {
+            tick_();
+        }
+        if (!queue_.TryPop(command)) {
+            std::unique_lock<std::mutex> lock(mutex_);
+            sleeping_.store(true, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            auto ready = [this] {
+                return !queue_.Empty() || tickRequested_.load(std::memory_order_relaxed);
+            };
+            // Until the scheduled tick at the latest
+            if (tickScheduled_) {
+                wakeup_.wait_until(lock, tickTime_, ready);
+            } else {
+                wakeup_.wait(lock, ready);
+            }
+            sleeping_.store(false, std::memory_order_relaxed);
+            continue;
+        }
+
+        if (command.type == RenderCommandType::STOP) {
+            break;
+        }
+        handler_(command);
+    }
+}
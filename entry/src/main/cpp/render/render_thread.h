@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#ifndef RENDER_THREAD_H
+#define RENDER_THREAD_H
+
+#include "spsc_queue.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+
+enum class RenderCommandType {
+    DRAW_PATTERN,
+    DRAW_TEXT,
+    // payload carries the display list to replay
+    DRAW_DISPLAY_LIST,
+    // Internal: the touch ink, queued by touch input rather than posted
+    DRAW_INK,
+    // payload is a heap std::string, the label for later DRAW_TEXTs
+    SET_TEXT,
+    SURFACE_CREATED,
+    SURFACE_CHANGED,
+    SURFACE_DESTROYED,
+    // Internal: draw the frame still waiting for its vsync right away;
+    // posted by SampleBitMap::Shutdown before STOP
+    DRAIN,
+    // Internal: ends the thread once everything queued before it has run
+    STOP,
+};
+
+// Plain value posted from the producer thread; no ownership is transferred
+struct RenderCommand {
+    RenderCommandType type;
+    void* window;
+    uint64_t width;
+    uint64_t height;
+    // Owned by whoever handles the command, e.g. an async draw request
+    void* payload;
+};
+
+// One thread that executes RenderCommands in the order they were posted.
+// Post() and PostBlocking() are safe from any thread: the queue has a single
+// producer side, which posting threads take turns on.
+class RenderThread {
+public:
+    using Handler = std::function<void(const RenderCommand&)>;
+
+    explicit RenderThread(Handler handler);
+    ~RenderThread() noexcept;
+
+    RenderThread(const RenderThread&) = delete;
+    RenderThread& operator=(const RenderThread&) = delete;
+
+    void Start();
+
+    // Queue a command without blocking. Returns false if the queue is full.
+    bool Post(const RenderCommand& command);
+
+    // Queue a command, waiting for room if the queue is full
+    void PostBlocking(const RenderCommand& command);
+
+    // Called on the render thread for each RequestTick(). Set before Start().
+    void SetTickHandler(std::function<void()> tick);
+
+    // Run the tick handler soon, once. Safe from any thread; requests made
+    // before the tick runs are merged into it.
+    void RequestTick();
+
+    // Run the tick handler once when is reached, or at the earliest of
+    // several such requests. Render thread only, e.g. from the tick itself.
+    void RequestTickAt(std::chrono::steady_clock::time_point when);
+
+    // Run everything already queued, then stop and join the thread.
+    // Safe to call more than once.
+    void Stop();
+
+    bool IsRunning() const
+    {
+        return running_.load(std::memory_order_acquire);
+    }
+
+private:
+    static constexpr size_t QUEUE_CAPACITY = 64;
+
+    void Run();
+    void WakeConsumer();
+
+    Handler handler_;
+    std::function<void()> tick_;
+    std::atomic<bool> tickRequested_ {false};
+    // Only touched on the render thread
+    bool tickScheduled_ = false;
+    std::chrono::steady_clock::time_point tickTime_;
+    SpscQueue<RenderCommand, QUEUE_CAPACITY> queue_;
+    // Held by a posting thread while it pushes
+    std::mutex postMutex_;
+    std::thread thread_;
+    std::atomic<bool> running_ {false};
+
+    // Only used to park the thread while there is nothing to do
+    std::atomic<bool> sleeping_ {false};
+    std::mutex mutex_;
+    std::condition_variable wakeup_;
+};
+
+#endif // RENDER_THREAD_H
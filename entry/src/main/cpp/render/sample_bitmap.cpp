@@ -1,137 +1,151 @@
-
-/*
- * Copyright (c) 2023 Your Organization
- * Licensed under the Apache License, Version 2.0
- */
-// sample bitmap header:
 /*
  * Copyright (c) 2023 Your Organization
  * Licensed under the Apache License, Version 2.0
  */
 
-#ifndef SAMPLE_BITMAP_H
-#define SAMPLE_BITMAP_H
-
-#include <ace/xcomponent/native_interface_xcomponent.h>
-#include <native_window/external_window.h>
-#include <native_drawing/drawing_bitmap.h>
-#include <native_drawing/drawing_color.h>
-#include <native_drawing/drawing_canvas.h>
-#include <native_drawing/drawing_pen.h>
-#include <native_drawing/drawing_brush.h>
-#include <native_drawing/drawing_path.h>
-#include <native_drawing/drawing_bitmap.h>
-#include <native_drawing/drawing_color.h>
-#include <native_drawing/drawing_canvas.h>
-#include <native_drawing/drawing_pen.h>
-#include <native_drawing/drawing_brush.h>
-#include <native_drawing/drawing_path.h>
-#include <native_drawing/drawing_text_typography.h>
-#include "napi/native_api.h"
-#include <string>
-
-// Forward declarations for callbacks
-void OnSurfaceCreatedCB(OH_NativeXComponent* component, void* window);
-void OnSurfaceChangedCB(OH_NativeXComponent* component, void* window);
-void OnSurfaceDestroyedCB(OH_NativeXComponent* component, void* window);
-void DispatchTouchEventCB(OH_NativeXComponent* component, void* window);
-
-class SampleBitMap {
-public:
-    SampleBitMap();
-    ~SampleBitMap() noexcept;
-
-    // Static methods for instance management
-    static SampleBitMap* GetInstance(const std::string& id);
-    static void Release(const std::string& id);
-
-    // Setters for window and dimensions
-    void SetNativeWindow(OHNativeWindow* window);
-    void SetWidth(uint64_t width);
-    void SetHeight(uint64_t height);
-
-    // Register callbacks with XComponent
-    void RegisterCallback(OH_NativeXComponent* nativeXComponent);
-
-    // Drawing methods
-    void DrawPattern();
-    void DrawText();
-
-    // Export NAPI interface
-    void Export(napi_env env, napi_value exports);
-
-    // NAPI methods for JavaScript
-    static napi_value NapiDrawPattern(napi_env env, napi_callback_info info);
-    static napi_value NapiDrawText(napi_env env, napi_callback_info info);
-
-private:
-    // Helper methods for drawing
-    bool PrepareDrawing();
-    void FinishDrawing();
-    void ReleaseBitmapResources();
-
-    // XComponent callback structure
-    OH_NativeXComponent_Callback renderCallback_;
-
-    // Window dimensions
-    uint64_t width_;
-    uint64_t height_;
-
-    // Drawing resources
-    OH_Drawing_Bitmap* cBitmap_;
-    OH_Drawing_Canvas* cCanvas_;
-    OH_Drawing_Path* cPath_;
-    OH_Drawing_Brush* cBrush_;
-    OH_Drawing_Pen* cPen_;
-
-    // Native window resources
-    OHNativeWindow* nativeWindow_;
-    uint32_t* mappedAddr_;
-    BufferHandle* bufferHandle_;
-    struct NativeWindowBuffer* buffer_;
-    int fenceFd_;
-};
-
-#endif // SAMPLE_BITMAP_H
- 
- 
 // sample_bitmap for drawing the cpp file
 #include "sample_bitmap.h"
-#include <unordered_map>
+#include "common/drawing_log.h"
+#include "native_vsync_source.h"
+#include "pixel_blit.h"
+#include <native_buffer/native_buffer.h>
 #include <stdint.h>
-#include <sys/mman.h>
 #include <cmath>
 #include <algorithm>
 
-#define DRAWING_LOGI(...) printf("INFO: " __VA_ARGS__)
-#define DRAWING_LOGE(...) printf("ERROR: " __VA_ARGS__)
+// Map a window buffer format onto a blit format; false if the blit cannot write it
+static bool GetBlitFormat(int32_t bufferFormat, PixelFormat& format)
+{
+    switch (bufferFormat) {
+        case NATIVEBUFFER_PIXEL_FMT_RGBA_8888:
+            format = PixelFormat::RGBA_8888;
+            return true;
+        case NATIVEBUFFER_PIXEL_FMT_BGRA_8888:
+            format = PixelFormat::BGRA_8888;
+            return true;
+        default:
+            return false;
+    }
+}
+
+// Vsync period assumed when the display's vsync is not available
+static constexpr std::chrono::nanoseconds FALLBACK_VSYNC_PERIOD {16666667};
+
+// Shortest gap between frames taken for the vsync period, i.e. 240 Hz
+static constexpr int64_t MIN_VSYNC_PERIOD_NS = 4000000;
+
+// Touch ink: dark strokes on white, the oldest dropped beyond MAX_INK_STROKES
+static constexpr uint32_t INK_BACKGROUND = 0xFFFFFFFF;
+static constexpr uint32_t INK_COLOR = 0xFF202020;
+static constexpr float INK_WIDTH = 6.0f;
+static constexpr size_t MAX_INK_STROKES = 32;
+
+// Longest the render thread waits for the consumer to release a buffer
+// before giving the frame up
+static constexpr int FENCE_WAIT_TIMEOUT_MS = 100;
+
+// A size that has held this long ends a resize; only then is staging
+// memory given back. Within a resize the window buffers are reallocated at
+// most this often.
+static constexpr std::chrono::milliseconds RESIZE_SETTLE_TIME(250);
+
+// Set in the layer cache keys of display-list layers, keeping them apart
+// from the CachedShape ones
+static constexpr uint32_t LIST_LAYER_KEY = DisplayList::MAX_LAYER_ID;
 
-// Static map to store instances
-static std::unordered_map<std::string, SampleBitMap*> instanceMap;
+// Add the contours of a flattened path to a canvas path
+static void AddToCanvasPath(OH_Drawing_Path* target, const RasterPath& path)
+{
+    const std::vector<RasterPoint>& points = path.GetPoints();
+    for (size_t i = 0; i < path.GetContours().size(); i++) {
+        size_t start = path.GetContours()[i].start;
+        OH_Drawing_PathMoveTo(target, points[start].x, points[start].y);
+        for (size_t j = start + 1; j < path.GetContourEnd(i); j++) {
+            OH_Drawing_PathLineTo(target, points[j].x, points[j].y);
+        }
+        if (path.GetContours()[i].closed) {
+            OH_Drawing_PathClose(target);
+        }
+    }
+}
+
+// Every SampleBitMap, by XComponent id
+static InstanceRegistry<SampleBitMap> instanceRegistry;
 
-SampleBitMap::SampleBitMap()
-    : width_(0),
+SampleBitMap::SampleBitMap(const std::string& id)
+    : id_(id),
+      component_(nullptr),
+      width_(0),
       height_(0),
       cBitmap_(nullptr),
       cCanvas_(nullptr),
       cPath_(nullptr),
       cBrush_(nullptr),
       cPen_(nullptr),
+      cRectBrush_(nullptr),
+      cRectPen_(nullptr),
+      stagingWidth_(0),
+      stagingHeight_(0),
+      resizePending_(false),
+      resizeRedraw_(false),
+      pendingWidth_(0),
+      pendingHeight_(0),
+      pathCache_(ReleaseCachedPath),
+      label_("HELLO"),
+      frameArenaSteadyAllocations_(0),
+      tiledRasterEnabled_(true),
+      aaQuality_(AaQuality::MEDIUM),
+      tiledReplay_(false),
+      layerCacheEnabled_(false),
+      layersInvalidated_(false),
+      layerReplay_(false),
+      layerKey_(0),
+      layerRect_ {0, 0, 0, 0},
+      visible_(true),
+      focused_(false),
+      framePriority_(SurfacePriority::VISIBLE),
+      rasterPool_(nullptr),
+      wakeScheduled_(false),
+      zeroCopyEnabled_(true),
+      renderPath_(RenderPath::NONE),
+      frameIndex_(0),
+      frameClearColor_(0),
+      prevClearColor_(0),
+      hasPrevFrame_(false),
       nativeWindow_(nullptr),
       mappedAddr_(nullptr),
       bufferHandle_(nullptr),
       buffer_(nullptr),
-      fenceFd_(0)
+      fenceFd_(-1),
+      prefetchedCount_(0),
+      buffersInFlight_(3),
+      presentedListId_(nullptr),
+      hasPendingDraw_(false),
+      pendingDraw_(RenderCommandType::DRAW_PATTERN),
+      lastVsyncNs_(0),
+      vsyncPeriodNs_(FALLBACK_VSYNC_PERIOD.count()),
+      frameScheduler_([this]() { renderThread_.RequestTick(); }),
+      renderThread_([this](const RenderCommand& command) { HandleCommand(command); })
 {
-    // Initialize the callback structure
-    renderCallback_.OnSurfaceCreated = nullptr;
-    renderCallback_.OnSurfaceChanged = nullptr;
-    renderCallback_.OnSurfaceDestroyed = nullptr;
-    renderCallback_.DispatchTouchEvent = nullptr;
+    VsyncSource::Callback onVsync = [this](int64_t timestampNs) { frameScheduler_.OnVsync(timestampNs); };
+    vsyncSource_ = NativeVsyncSource::Create("SampleBitMap", onVsync);
+    if (vsyncSource_ == nullptr) {
+        DRAWING_LOGW("SampleBitMap: no native vsync, pacing frames with a timer\n");
+        vsyncSource_ = std::make_unique<TimerVsyncSource>(FALLBACK_VSYNC_PERIOD, onVsync);
+    }
+    frameScheduler_.SetVsyncSource(vsyncSource_.get());
+
+    tileRasterizer_.SetArena(&frameArena_);
+
+    renderThread_.SetTickHandler([this]() { HandleVsync(); });
+    renderThread_.Start();
 }
 
 SampleBitMap::~SampleBitMap() noexcept
 {
+    // Nothing may still be running against the resources below
+    Shutdown();
+
     // Release all resources
     ReleaseBitmapResources();
 
@@ -141,24 +155,45 @@ SampleBitMap::~SampleBitMap() noexcept
     }
 }
 
-SampleBitMap* SampleBitMap::GetInstance(const std::string& id)
+std::shared_ptr<SampleBitMap> SampleBitMap::GetInstance(const std::string& id)
+{
+    return instanceRegistry.FindOrCreate(id, [&id]() { return std::make_shared<SampleBitMap>(id); });
+}
+
+std::shared_ptr<SampleBitMap> SampleBitMap::FindInstance(const std::string& id)
+{
+    return instanceRegistry.Find(id);
+}
+
+std::shared_ptr<SampleBitMap> SampleBitMap::FindInstance(const OH_NativeXComponent* component)
 {
-    auto iter = instanceMap.find(id);
-    if (iter != instanceMap.end()) {
-        return iter->second;
+    if (component == nullptr) {
+        return nullptr;
     }
+    return instanceRegistry.FindIf([component](const SampleBitMap& render) {
+        return render.GetComponent() == component;
+    });
+}
 
-    SampleBitMap* instance = new SampleBitMap();
-    instanceMap[id] = instance;
-    return instance;
+SampleBitMap::Binding SampleBitMap::Bind(const std::shared_ptr<SampleBitMap>& instance)
+{
+    return Binding(instanceRegistry, instance->GetId(), instance);
 }
 
 void SampleBitMap::Release(const std::string& id)
 {
-    auto iter = instanceMap.find(id);
-    if (iter != instanceMap.end()) {
-        delete iter->second;
-        instanceMap.erase(iter);
+    std::shared_ptr<SampleBitMap> instance = instanceRegistry.Remove(id);
+    if (instance != nullptr) {
+        // Finish queued work while the window is still valid; the object
+        // itself goes when the last handle does
+        instance->Shutdown();
+    }
+}
+
+void SampleBitMap::ReleaseAll()
+{
+    for (const std::shared_ptr<SampleBitMap>& instance : instanceRegistry.RemoveAll()) {
+        instance->Shutdown();
     }
 }
 
@@ -177,35 +212,579 @@ void SampleBitMap::SetHeight(uint64_t height)
     height_ = height;
 }
 
-void SampleBitMap::RegisterCallback(OH_NativeXComponent* nativeXComponent)
+void SampleBitMap::SetZeroCopyEnabled(bool enabled)
+{
+    zeroCopyEnabled_ = enabled;
+}
+
+void SampleBitMap::SetBuffersInFlight(uint32_t count)
+{
+    count = std::min(std::max(count, MIN_BUFFERS_IN_FLIGHT), MAX_BUFFERS_IN_FLIGHT);
+    buffersInFlight_.store(count, std::memory_order_relaxed);
+}
+
+void SampleBitMap::ResetBufferPool()
+{
+    ReleaseHeldBuffer();
+    mappedAddr_ = nullptr;
+    bufferPool_.Clear();
+    // New buffers, possibly a new size: the next frame is a full update
+    hasPrevFrame_ = false;
+    presentedList_.reset();
+    presentedListId_.store(nullptr, std::memory_order_release);
+}
+
+bool SampleBitMap::PostCommand(const RenderCommand& command)
+{
+    // Nothing would ever run it, and a blocking post would wait forever
+    if (!renderThread_.IsRunning()) {
+        DRAWING_LOGE("PostCommand: render thread is not running\n");
+        return false;
+    }
+
+    bool isDraw = (command.type == RenderCommandType::DRAW_PATTERN) || (command.type == RenderCommandType::DRAW_TEXT) ||
+        (command.type == RenderCommandType::DRAW_DISPLAY_LIST);
+    if (!isDraw) {
+        // The surface is about to change under whatever list is on screen
+        {
+            std::lock_guard<std::mutex> lock(submitMutex_);
+            submittedList_.reset();
+        }
+        renderThread_.PostBlocking(command);
+        return true;
+    }
+    if (!renderThread_.Post(command)) {
+        DRAWING_LOGE_LIMITED("PostCommand: render queue full, dropping draw request\n");
+        frameStats_.CountDropped();
+        return false;
+    }
+    return true;
+}
+
+void SampleBitMap::Shutdown()
+{
+    // Draws merged into a frame that is still waiting for its vsync are
+    // drawn now, after everything queued before them
+    if (renderThread_.IsRunning()) {
+        renderThread_.PostBlocking(RenderCommand {RenderCommandType::DRAIN, nullptr, 0, 0, nullptr});
+    }
+    renderThread_.Stop();
+
+    // Only a frame that could not get a buffer is left, and it never will
+    hasPendingDraw_ = false;
+    pendingList_.reset();
+    CompletePendingRequests(false);
+
+    // Every frame result has been handed to the listener by now
+    frameListener_.reset();
+}
+
+void SampleBitMap::SetFrameListener(std::unique_ptr<FrameListener> listener)
 {
-    if (nativeXComponent == nullptr) {
-        DRAWING_LOGE("RegisterCallback: nativeXComponent is null\n");
+    frameListener_ = std::move(listener);
+}
+
+void SampleBitMap::CompleteFrameRequest(void* payload, bool presented)
+{
+    if (payload == nullptr) {
+        return;
+    }
+    if (frameListener_ == nullptr) {
+        DRAWING_LOGE_LIMITED("CompleteFrameRequest: no frame listener, dropping the result\n");
         return;
     }
+    frameListener_->OnFrameDone(payload, presented, frameTiming_, renderPath_);
+}
+
+// Payload of DRAW_DISPLAY_LIST; keeps the list alive until it has been replayed
+struct DisplayListRequest {
+    std::shared_ptr<const DisplayList> list;
+};
 
-    // Set up the callback structure
-    renderCallback_.OnSurfaceCreated = OnSurfaceCreatedCB;
-    renderCallback_.OnSurfaceChanged = OnSurfaceChangedCB;
-    renderCallback_.OnSurfaceDestroyed = OnSurfaceDestroyedCB;
-    renderCallback_.DispatchTouchEvent = DispatchTouchEventCB;
+bool SampleBitMap::SubmitDisplayList(const void* data, size_t size)
+{
+    // Held until the list is posted, so threads submitting at once each
+    // compare against what the other actually queued
+    std::lock_guard<std::mutex> lock(submitMutex_);
+    std::shared_ptr<const DisplayList> list = submittedList_;
+    if ((list == nullptr) || !list->Equals(data, size)) {
+        auto loaded = std::make_shared<DisplayList>();
+        if (!loaded->Load(data, size)) {
+            DRAWING_LOGE("SubmitDisplayList: malformed display list (%zu bytes)\n", size);
+            return false;
+        }
+        list = std::move(loaded);
+    } else if (presentedListId_.load(std::memory_order_acquire) == list.get()) {
+        // Unchanged and already on screen: nothing to render
+        return true;
+    }
 
-    // Register the callback with the XComponent
-    OH_NativeXComponent_RegisterCallback(nativeXComponent, &renderCallback_);
+    DisplayListRequest* request = new DisplayListRequest {list};
+    if (!PostCommand(RenderCommand {RenderCommandType::DRAW_DISPLAY_LIST, nullptr, 0, 0, request})) {
+        delete request;
+        return false;
+    }
+    submittedList_ = std::move(list);
+    return true;
 }
 
-void SampleBitMap::ReleaseBitmapResources()
+bool SampleBitMap::SetLabel(const std::string& text)
+{
+    if (!renderThread_.IsRunning()) {
+        DRAWING_LOGE("SetLabel: render thread is not running\n");
+        return false;
+    }
+    // Sent along with draws, so it must not block the caller either
+    std::string* label = new std::string(text);
+    if (!renderThread_.Post(RenderCommand {RenderCommandType::SET_TEXT, nullptr, 0, 0, label})) {
+        DRAWING_LOGE_LIMITED("SetLabel: render queue full, dropping label\n");
+        delete label;
+        return false;
+    }
+    return true;
+}
+
+void SampleBitMap::HandleCommand(const RenderCommand& command)
+{
+    switch (command.type) {
+        case RenderCommandType::DRAW_PATTERN:
+        case RenderCommandType::DRAW_TEXT:
+            QueueDraw(command.type, command.payload);
+            break;
+        case RenderCommandType::DRAW_DISPLAY_LIST: {
+            DisplayListRequest* request = static_cast<DisplayListRequest*>(command.payload);
+            // Resubmitted before the first copy reached the screen, and nothing
+            // queued since would cover it up
+            if ((request->list != presentedList_) || hasPendingDraw_) {
+                pendingList_ = request->list;
+                QueueDraw(command.type, nullptr);
+            }
+            delete request;
+            break;
+        }
+        case RenderCommandType::SET_TEXT: {
+            std::string* text = static_cast<std::string*>(command.payload);
+            label_ = std::move(*text);
+            delete text;
+            break;
+        }
+        case RenderCommandType::SURFACE_CREATED:
+            SetNativeWindow(static_cast<OHNativeWindow*>(command.window));
+            SetHeight(command.height);
+            SetWidth(command.width);
+            resizePending_ = false;
+            ConfigureWindow();
+            break;
+        case RenderCommandType::SURFACE_CHANGED:
+            // Resize animations send one per layout pass; only the latest
+            // before a frame matters
+            pendingWidth_ = command.width;
+            pendingHeight_ = command.height;
+            resizePending_ = true;
+            lastResize_ = FrameClock::now();
+            break;
+        case RenderCommandType::SURFACE_DESTROYED:
+            // Drop everything tied to the window before it goes away,
+            // including a frame that has nowhere to go now
+            ResetBufferPool();
+            nativeWindow_ = nullptr;
+            resizePending_ = false;
+            touchInput_.Reset();
+            ink_.clear();
+            hasPendingDraw_ = false;
+            resizeRedraw_ = false;
+            pendingList_.reset();
+            CompletePendingRequests(false);
+            break;
+        case RenderCommandType::DRAIN:
+            // A resize redraw has nobody waiting on it
+            if (hasPendingDraw_ && !resizeRedraw_) {
+                DrawPendingFrame();
+            }
+            break;
+        default:
+            break;
+    }
+}
+
+void SampleBitMap::QueueDraw(RenderCommandType type, void* payload)
+{
+    // The latest request decides what the frame shows; every async request
+    // since the last frame is resolved by it
+    pendingDraw_ = type;
+    hasPendingDraw_ = true;
+    resizeRedraw_ = false;
+    if (type != RenderCommandType::DRAW_DISPLAY_LIST) {
+        pendingList_.reset();
+    }
+    if (payload != nullptr) {
+        pendingRequests_.push_back(payload);
+    }
+    frameScheduler_.RequestFrame();
+}
+
+void SampleBitMap::PushTouch(const TouchSample& sample)
+{
+    // A sample lost to a full ring still wants the frame the others are in
+    touchInput_.Push(sample);
+    frameScheduler_.RequestFrame();
+}
+
+bool SampleBitMap::UpdateInk()
+{
+    // Touch before the surface exists has nothing to draw on
+    if (nativeWindow_ == nullptr) {
+        touchInput_.Reset();
+        return false;
+    }
+    if (!touchInput_.Collect(vsyncPeriodNs_, touchFrame_)) {
+        // Nothing new, but a prediction still on screen has to be dropped
+        if (touchFrame_.predicting) {
+            frameScheduler_.RequestFrame();
+        }
+        return false;
+    }
+
+    for (const TouchPointer& pointer : touchFrame_.pointers) {
+        InkStroke* stroke = nullptr;
+        if (pointer.began) {
+            if (ink_.size() == MAX_INK_STROKES) {
+                ink_.erase(ink_.begin());
+            }
+            ink_.push_back(InkStroke {pointer.id, true, {}, pointer.predicted});
+            stroke = &ink_.back();
+        } else {
+            for (auto it = ink_.rbegin(); it != ink_.rend(); ++it) {
+                if ((it->pointer == pointer.id) && it->down) {
+                    stroke = &*it;
+                    break;
+                }
+            }
+        }
+        if (stroke == nullptr) {
+            continue;
+        }
+        if (pointer.cancelled) {
+            // The gesture went to someone else; so does its stroke
+            ink_.erase(ink_.begin() + (stroke - ink_.data()));
+            continue;
+        }
+        stroke->points.insert(stroke->points.end(), pointer.path.begin(), pointer.path.end());
+        stroke->predicted = pointer.predicted;
+        stroke->down = pointer.down;
+    }
+    if (touchFrame_.predicting) {
+        frameScheduler_.RequestFrame();
+    }
+
+    // The latest input decides what the frame shows, as a draw request would
+    pendingDraw_ = RenderCommandType::DRAW_INK;
+    hasPendingDraw_ = true;
+    resizeRedraw_ = false;
+    pendingList_.reset();
+    return true;
+}
+
+void SampleBitMap::HandleVsync()
+{
+    // Time for a frame held back by ThrottleFrame() to ask for its vsync
+    if (wakeScheduled_ && (FrameClock::now() >= wakeTime_)) {
+        wakeScheduled_ = false;
+        frameScheduler_.ResumeFrame();
+    }
+    if (!frameScheduler_.FrameDue()) {
+        return;
+    }
+    // Frames only come while something changes, so the shortest gap seen
+    // between two of them is the best guess at the period
+    int64_t vsyncNs = frameScheduler_.GetVsyncTimestamp();
+    int64_t interval = vsyncNs - lastVsyncNs_;
+    if ((lastVsyncNs_ != 0) && (interval >= MIN_VSYNC_PERIOD_NS) && (interval < vsyncPeriodNs_)) {
+        vsyncPeriodNs_ = interval;
+    }
+    lastVsyncNs_ = vsyncNs;
+
+    UpdateInk();
+    if (!hasPendingDraw_) {
+        return;
+    }
+    // Hidden surfaces draw rarely, on the efficiency cores where there are
+    // any, and leave the rest to the surfaces on screen
+    SurfacePriority priority = GetSurfacePriority();
+    RasterScheduler::MoveThread(priority);
+    if ((priority == SurfacePriority::BACKGROUND) &&
+        (FrameClock::now() - lastFrameStart_ < RasterScheduler::BACKGROUND_FRAME_INTERVAL)) {
+        ThrottleFrame(lastFrameStart_ + RasterScheduler::BACKGROUND_FRAME_INTERVAL);
+        return;
+    }
+    // Nothing new to show, only the last frame at a size it cannot have yet
+    if (resizeRedraw_ && resizePending_ && !ResizeDue()) {
+        ThrottleFrame(lastResizeApplied_ + RESIZE_SETTLE_TIME);
+        return;
+    }
+    DrawPendingFrame();
+}
+
+void SampleBitMap::ThrottleFrame(FrameClock::time_point wakeTime)
+{
+    // No vsyncs until then: the render thread sleeps through them
+    frameScheduler_.ThrottleFrame();
+    if (!wakeScheduled_ || (wakeTime < wakeTime_)) {
+        wakeTime_ = wakeTime;
+    }
+    wakeScheduled_ = true;
+    renderThread_.RequestTickAt(wakeTime_);
+}
+
+// The frame every draw request since the last one adds up to
+void SampleBitMap::DrawPendingFrame()
+{
+    SurfacePriority priority = GetSurfacePriority();
+    FrameClock::time_point frameStart = FrameClock::now();
+    resizeRedraw_ = false;
+    ApplyPendingResize();
+    FrameTraceScope frameTrace("SampleBitMap::Frame");
+    frameTiming_ = FrameTiming {};
+
+    // Rather than block the thread on a buffer the consumer still holds,
+    // try again at the next vsync
+    bool acquired = false;
+    {
+        FrameTraceScope acquireTrace("SampleBitMap::Acquire");
+        acquired = AcquireFrameBuffer();
+    }
+    if (!acquired) {
+        frameScheduler_.SkipFrame();
+        return;
+    }
+    frameTiming_.acquireUs = ElapsedUs(frameStart, FrameClock::now());
+    lastFrameStart_ = frameStart;
+    framePriority_ = priority;
+
+    bool presented = false;
+    switch (pendingDraw_) {
+        case RenderCommandType::DRAW_PATTERN:
+            presented = DrawPattern();
+            break;
+        case RenderCommandType::DRAW_TEXT:
+            presented = DrawText();
+            break;
+        case RenderCommandType::DRAW_DISPLAY_LIST:
+            presented = DrawDisplayList(pendingList_);
+            break;
+        case RenderCommandType::DRAW_INK:
+            presented = DrawInk();
+            break;
+        default:
+            break;
+    }
+    // Draws that failed halfway still hold it
+    EndRaster();
+    if (presented) {
+        frameTiming_.totalUs = ElapsedUs(frameStart, FrameClock::now());
+        frameStats_.Record(frameTiming_, vsyncPeriodNs_);
+    } else {
+        frameStats_.CountDropped();
+    }
+    hasPendingDraw_ = false;
+    pendingList_.reset();
+    frameScheduler_.FrameDone();
+    CompletePendingRequests(presented);
+    if (presented && resizePending_) {
+        // Drawn at the size the buffers still have: draw the same again once
+        // the resize applies, even if nothing else asks for a frame
+        hasPendingDraw_ = true;
+        resizeRedraw_ = true;
+        pendingList_ = presentedList_;
+        frameScheduler_.RequestFrame();
+    }
+}
+
+void SampleBitMap::CompletePendingRequests(bool presented)
+{
+    for (void* payload : pendingRequests_) {
+        CompleteFrameRequest(payload, presented);
+    }
+    pendingRequests_.clear();
+}
+
+bool SampleBitMap::AcquireFrameBuffer()
+{
+    // Without a window or a buffer the draw itself fails and reports why
+    if (nativeWindow_ == nullptr) {
+        return true;
+    }
+    if (buffer_ == nullptr) {
+        if (prefetchedCount_ > 0) {
+            buffer_ = prefetched_[0].buffer;
+            fenceFd_ = prefetched_[0].fenceFd;
+            prefetchedCount_--;
+            std::copy(prefetched_ + 1, prefetched_ + 1 + prefetchedCount_, prefetched_);
+        } else if (!RequestWindowBuffer(buffer_, fenceFd_)) {
+            return true;
+        }
+    }
+
+    // A zero-copy frame writes the buffer from its first clear, so the
+    // consumer has to be done with it already; rather than block the thread,
+    // the buffer is kept and the frame tried again at the next vsync. The
+    // staging path only writes it at the final copy and waits there.
+    BufferHandle* handle = OH_NativeWindow_GetBufferHandleFromNative(buffer_);
+    bool direct = zeroCopyEnabled_ && CanRenderDirect(handle);
+    return !direct || (PollFence(fenceFd_) != FenceStatus::PENDING);
+}
+
+bool SampleBitMap::RequestWindowBuffer(struct NativeWindowBuffer*& buffer, int& fenceFd)
+{
+    int32_t ret = OH_NativeWindow_NativeWindowRequestBuffer(nativeWindow_, &buffer, &fenceFd);
+    if (ret != 0) {
+        DRAWING_LOGE_LIMITED("RequestWindowBuffer: RequestBuffer failed, ret = %d\n", ret);
+        buffer = nullptr;
+        fenceFd = -1;
+        return false;
+    }
+    return true;
+}
+
+void SampleBitMap::PrefetchBuffers()
+{
+    // One buffer is on screen and one is being drawn; the rest of the
+    // budget is requested now, so the consumer releases them while this
+    // frame rasters rather than after it is flushed
+    uint32_t ahead = GetBuffersInFlight() - MIN_BUFFERS_IN_FLIGHT;
+    while (prefetchedCount_ > ahead) {
+        HeldBuffer& surplus = prefetched_[--prefetchedCount_];
+        OH_NativeWindow_NativeWindowAbortBuffer(nativeWindow_, surplus.buffer);
+        CloseFence(surplus.fenceFd);
+    }
+    while (prefetchedCount_ < ahead) {
+        HeldBuffer& next = prefetched_[prefetchedCount_];
+        if (!RequestWindowBuffer(next.buffer, next.fenceFd)) {
+            break;
+        }
+        prefetchedCount_++;
+    }
+}
+
+bool SampleBitMap::WaitForBuffer(const char* caller)
+{
+    FenceStatus status = WaitFence(fenceFd_, FENCE_WAIT_TIMEOUT_MS);
+    if (status == FenceStatus::PENDING) {
+        // Still ours; the next frame waits on it again
+        DRAWING_LOGE_LIMITED("%s: buffer not released after %d ms\n", caller, FENCE_WAIT_TIMEOUT_MS);
+        return false;
+    }
+    if (status == FenceStatus::INVALID) {
+        DRAWING_LOGE_LIMITED("%s: invalid release fence %d, not waiting\n", caller, fenceFd_);
+    }
+    CloseFence(fenceFd_);
+    return true;
+}
+
+void SampleBitMap::ReleaseHeldBuffer()
 {
-    // Unmap the memory if previously mapped
-    if (mappedAddr_ != nullptr && bufferHandle_ != nullptr) {
-        int result = munmap(mappedAddr_, bufferHandle_->size);
-        if (result == -1) {
-            DRAWING_LOGE("munmap failed!\n");
+    // Give every buffer we hold back to the window, undrawn
+    if ((buffer_ != nullptr) && (nativeWindow_ != nullptr)) {
+        OH_NativeWindow_NativeWindowAbortBuffer(nativeWindow_, buffer_);
+    }
+    buffer_ = nullptr;
+    bufferHandle_ = nullptr;
+    CloseFence(fenceFd_);
+    for (uint32_t i = 0; i < prefetchedCount_; i++) {
+        if (nativeWindow_ != nullptr) {
+            OH_NativeWindow_NativeWindowAbortBuffer(nativeWindow_, prefetched_[i].buffer);
         }
-        mappedAddr_ = nullptr;
+        CloseFence(prefetched_[i].fenceFd);
+    }
+    prefetchedCount_ = 0;
+}
+
+void SampleBitMap::HandleSurfaceChanged(uint64_t width, uint64_t height)
+{
+    if ((width == width_) && (height == height_)) {
+        return;
+    }
+    // The window reallocates its buffers on resize, so the old mappings are
+    // stale, and buffers already requested have the old size
+    ResetBufferPool();
+    SetHeight(height);
+    SetWidth(width);
+    ConfigureWindow();
+    // Every cached shape is laid out for the old size
+    pathCache_.Clear();
+}
+
+bool SampleBitMap::ResizeDue() const
+{
+    return FrameClock::now() - lastResizeApplied_ >= RESIZE_SETTLE_TIME;
+}
+
+void SampleBitMap::ApplyPendingResize()
+{
+    // Every resize makes the window reallocate its buffers. The first one
+    // in a while applies right away (a rotation); in a drag they apply at
+    // most every RESIZE_SETTLE_TIME, the latest size each time, and frames
+    // in between keep the buffers they have, scaled to the surface.
+    if (resizePending_ && ResizeDue()) {
+        resizePending_ = false;
+        lastResizeApplied_ = FrameClock::now();
+        HandleSurfaceChanged(pendingWidth_, pendingHeight_);
+    }
+}
+
+void SampleBitMap::ConfigureWindow()
+{
+    if ((nativeWindow_ == nullptr) || (width_ == 0) || (height_ == 0)) {
+        return;
+    }
+    // Buffers requested from here on match the surface, rather than
+    // whatever size the window had when the last one was allocated
+    int32_t ret = OH_NativeWindow_NativeWindowHandleOpt(nativeWindow_, SET_BUFFER_GEOMETRY,
+        static_cast<int32_t>(width_), static_cast<int32_t>(height_));
+    if (ret != 0) {
+        DRAWING_LOGE("ConfigureWindow: SET_BUFFER_GEOMETRY failed, ret = %d\n", ret);
+    }
+
+    // Keep a format the frame can be copied into, otherwise ask for the one
+    // the canvas renders directly
+    int32_t format = 0;
+    PixelFormat blitFormat;
+    if ((OH_NativeWindow_NativeWindowHandleOpt(nativeWindow_, GET_FORMAT, &format) != 0) ||
+        !GetBlitFormat(format, blitFormat)) {
+        format = NATIVEBUFFER_PIXEL_FMT_RGBA_8888;
+    }
+    ret = OH_NativeWindow_NativeWindowHandleOpt(nativeWindow_, SET_FORMAT, format);
+    if (ret != 0) {
+        DRAWING_LOGE("ConfigureWindow: SET_FORMAT failed, ret = %d\n", ret);
+    }
+}
+
+void SampleBitMap::BindComponent(OH_NativeXComponent* nativeXComponent)
+{
+    component_.store(nativeXComponent, std::memory_order_release);
+}
+
+void SampleBitMap::InvalidateDrawingResources()
+{
+    ReleaseBitmapResources();
+}
+
+void SampleBitMap::ReleaseBitmapResources()
+{
+    // The mapping itself stays alive in bufferPool_ for the next frame
+    mappedAddr_ = nullptr;
+
+    // Destroy the cached drawing objects
+    if (cRectBrush_ != nullptr) {
+        OH_Drawing_BrushDestroy(cRectBrush_);
+        cRectBrush_ = nullptr;
+    }
+
+    if (cRectPen_ != nullptr) {
+        OH_Drawing_PenDestroy(cRectPen_);
+        cRectPen_ = nullptr;
     }
 
-    // Destroy the created drawing objects
     if (cBrush_ != nullptr) {
         OH_Drawing_BrushDestroy(cBrush_);
         cBrush_ = nullptr;
@@ -226,115 +805,415 @@ void SampleBitMap::ReleaseBitmapResources()
         cCanvas_ = nullptr;
     }
 
+    ReleaseStagingBitmap();
+    stagingMemory_.Release();
+    layerCache_.Release();
+}
+
+void SampleBitMap::ReleaseStagingBitmap()
+{
     if (cBitmap_ != nullptr) {
         OH_Drawing_BitmapDestroy(cBitmap_);
         cBitmap_ = nullptr;
     }
+    stagingWidth_ = 0;
+    stagingHeight_ = 0;
 }
 
-bool SampleBitMap::PrepareDrawing()
+bool SampleBitMap::EnsureDrawingResources()
 {
-    // Clean up any previous resources
+    // None of these depend on the surface size
+    if (cCanvas_ != nullptr) {
+        return true;
+    }
+
     ReleaseBitmapResources();
 
+    // Create a canvas for drawing; the bitmap it renders into is chosen per frame
+    cCanvas_ = OH_Drawing_CanvasCreate();
+    cPath_ = OH_Drawing_PathCreate();
+    cPen_ = OH_Drawing_PenCreate();
+    cBrush_ = OH_Drawing_BrushCreate();
+    cRectPen_ = OH_Drawing_PenCreate();
+    cRectBrush_ = OH_Drawing_BrushCreate();
+    if ((cCanvas_ == nullptr) || (cPath_ == nullptr) || (cPen_ == nullptr) || (cBrush_ == nullptr) ||
+        (cRectPen_ == nullptr) || (cRectBrush_ == nullptr)) {
+        DRAWING_LOGE("EnsureDrawingResources: creating drawing objects failed\n");
+        ReleaseBitmapResources();
+        return false;
+    }
+
+    DRAWING_LOGI("EnsureDrawingResources: drawing objects created\n");
+    return true;
+}
+
+bool SampleBitMap::EnsureStagingBitmap()
+{
+    // Only needed when the window buffer cannot be rendered into directly.
+    // The memory follows the surface through resizes in size classes; only
+    // the bitmap over it is re-created, and shrinking waits for the size to settle.
+    size_t bytes = static_cast<size_t>(width_ * height_ * sizeof(uint32_t));
+    bool settled = FrameClock::now() - lastResize_ >= RESIZE_SETTLE_TIME;
+    void* memory = stagingMemory_.Data();
+    if (!stagingMemory_.Reserve(bytes, settled)) {
+        DRAWING_LOGE("EnsureStagingBitmap: allocating %zu bytes failed\n", bytes);
+        ReleaseStagingBitmap();
+        return false;
+    }
+    if ((cBitmap_ != nullptr) && (stagingMemory_.Data() == memory) && (stagingWidth_ == width_) &&
+        (stagingHeight_ == height_)) {
+        return true;
+    }
+
+    ReleaseStagingBitmap();
+    OH_Drawing_Image_Info info {static_cast<int32_t>(width_), static_cast<int32_t>(height_),
+        COLOR_FORMAT_RGBA_8888, ALPHA_FORMAT_OPAQUE};
+    cBitmap_ = OH_Drawing_BitmapCreateFromPixels(&info, stagingMemory_.Data(),
+        static_cast<uint32_t>(width_ * sizeof(uint32_t)));
+    if (cBitmap_ == nullptr) {
+        DRAWING_LOGE("EnsureStagingBitmap: BitmapCreateFromPixels failed\n");
+        return false;
+    }
+    stagingWidth_ = width_;
+    stagingHeight_ = height_;
+    return true;
+}
+
+bool SampleBitMap::CanRenderDirect(const BufferHandle* handle) const
+{
+    // The canvas writes RGBA_8888 rows; the buffer has to hold exactly that,
+    // at least as large as the surface, with whole pixels per row
+    if ((handle == nullptr) || (handle->format != NATIVEBUFFER_PIXEL_FMT_RGBA_8888)) {
+        return false;
+    }
+    if ((static_cast<uint64_t>(handle->width) < width_) || (static_cast<uint64_t>(handle->height) < height_)) {
+        return false;
+    }
+    return (handle->stride % sizeof(uint32_t) == 0) &&
+        (static_cast<uint64_t>(handle->stride) >= width_ * sizeof(uint32_t));
+}
+
+void SampleBitMap::SetRenderPath(RenderPath path)
+{
+    // Report changes only, not every frame
+    if (path != renderPath_) {
+        DRAWING_LOGI("Render path: %s\n", (path == RenderPath::ZERO_COPY) ? "zero-copy" : "staging bitmap");
+        renderPath_ = path;
+    }
+}
+
+bool SampleBitMap::GetTargetSurface(PixelSurface& surface) const
+{
+    // The pixels the canvas is bound to this frame
+    if (renderPath_ == RenderPath::ZERO_COPY) {
+        surface = PixelSurface {mappedAddr_, static_cast<uint32_t>(width_), static_cast<uint32_t>(height_),
+            static_cast<uint32_t>(bufferHandle_->stride), PixelFormat::RGBA_8888};
+        return true;
+    }
+    void* pixels = (cBitmap_ != nullptr) ? OH_Drawing_BitmapGetPixels(cBitmap_) : nullptr;
+    if (pixels == nullptr) {
+        return false;
+    }
+    surface = PixelSurface {pixels, static_cast<uint32_t>(width_), static_cast<uint32_t>(height_),
+        static_cast<uint32_t>(width_ * sizeof(uint32_t)), PixelFormat::RGBA_8888};
+    return true;
+}
+
+bool SampleBitMap::PrepareDrawing()
+{
+    FrameTraceScope trace("SampleBitMap::Prepare");
+    FrameClock::time_point prepareStart = FrameClock::now();
+
+    // Whatever this frame draws replaces the display list on screen
+    presentedList_.reset();
+    presentedListId_.store(nullptr, std::memory_order_release);
+
     if (nativeWindow_ == nullptr) {
-        DRAWING_LOGE("PrepareDrawing: nativeWindow is null\n");
+        DRAWING_LOGE_LIMITED("PrepareDrawing: nativeWindow is null\n");
         return false;
     }
 
-    // Request a buffer from the native window
-    int32_t ret = OH_NativeWindow_NativeWindowRequestBuffer(nativeWindow_, &buffer_, &fenceFd_);
-    if (ret != 0) {
-        DRAWING_LOGE("PrepareDrawing: RequestBuffer failed, ret = %d\n", ret);
+    // Held since the vsync that found it released
+    if (buffer_ == nullptr) {
+        DRAWING_LOGE_LIMITED("PrepareDrawing: no window buffer\n");
         return false;
     }
 
     // Get the buffer handle
     bufferHandle_ = OH_NativeWindow_GetBufferHandleFromNative(buffer_);
     if (bufferHandle_ == nullptr) {
-        DRAWING_LOGE("PrepareDrawing: GetBufferHandleFromNative failed\n");
+        DRAWING_LOGE_LIMITED("PrepareDrawing: GetBufferHandleFromNative failed\n");
         return false;
     }
 
-    // Map the buffer memory
-    mappedAddr_ = static_cast<uint32_t*>(
-        mmap(bufferHandle_->virAddr, bufferHandle_->size, PROT_READ | PROT_WRITE, MAP_SHARED, bufferHandle_->fd, 0));
-    if (mappedAddr_ == MAP_FAILED) {
-        DRAWING_LOGE("PrepareDrawing: mmap failed\n");
-        mappedAddr_ = nullptr;
+    // Reuse the drawing objects allocated for this surface size. First, since
+    // re-creating them drops the current mapping.
+    if (!EnsureDrawingResources()) {
+        DRAWING_LOGE_LIMITED("PrepareDrawing: EnsureDrawingResources failed\n");
         return false;
     }
 
-    // Create a bitmap for drawing
-    cBitmap_ = OH_Drawing_BitmapCreate();
-    if (cBitmap_ == nullptr) {
-        DRAWING_LOGE("PrepareDrawing: BitmapCreate failed\n");
+    // Reuse the persistent mapping of this buffer, mapping it on first use
+    mappedAddr_ = bufferPool_.Map(bufferHandle_);
+    if (mappedAddr_ == nullptr) {
+        DRAWING_LOGE_LIMITED("PrepareDrawing: mapping buffer failed\n");
         return false;
     }
 
-    // Define the pixel format of the bitmap
-    OH_Drawing_BitmapFormat cFormat {COLOR_FORMAT_RGBA_8888, ALPHA_FORMAT_OPAQUE};
-    
-    // Build the bitmap with the specified format
-    OH_Drawing_BitmapBuild(cBitmap_, width_, height_, &cFormat);
+    // Reset per-frame state left over from the previous frame
+    OH_Drawing_PathReset(cPath_);
+    OH_Drawing_CanvasDetachPen(cCanvas_);
+    OH_Drawing_CanvasDetachBrush(cCanvas_);
 
-    // Create a canvas for drawing
-    cCanvas_ = OH_Drawing_CanvasCreate();
-    if (cCanvas_ == nullptr) {
-        DRAWING_LOGE("PrepareDrawing: CanvasCreate failed\n");
-        return false;
+    // Render straight into the window buffer when its format allows it,
+    // otherwise into the staging bitmap that FinishDrawing copies out
+    OH_Drawing_Bitmap* target = nullptr;
+    if (zeroCopyEnabled_ && CanRenderDirect(bufferHandle_)) {
+        target = bufferPool_.GetDirectBitmap(bufferHandle_, width_, height_);
+    }
+    if (target != nullptr) {
+        // The clear below is the first write to the buffer
+        if (!WaitForBuffer("PrepareDrawing")) {
+            return false;
+        }
+        SetRenderPath(RenderPath::ZERO_COPY);
+    } else {
+        if (!EnsureStagingBitmap()) {
+            DRAWING_LOGE_LIMITED("PrepareDrawing: EnsureStagingBitmap failed\n");
+            return false;
+        }
+        target = cBitmap_;
+        SetRenderPath(RenderPath::STAGING);
     }
 
     // Bind the bitmap to the canvas
-    OH_Drawing_CanvasBind(cCanvas_, cBitmap_);
+    OH_Drawing_CanvasBind(cCanvas_, target);
 
-    // Clear the canvas with white
-    OH_Drawing_CanvasClear(cCanvas_, OH_Drawing_ColorSetArgb(0xFF, 0xFF, 0xFF, 0xFF));
+    // Start a new frame with nothing drawn yet
+    frameIndex_++;
+    sceneBounds_.Clear();
+
+    PrefetchBuffers();
+    FrameClock::time_point slotStart = FrameClock::now();
+    frameTiming_.prepareUs = ElapsedUs(prepareStart, slotStart);
 
+    // The buffer is ready to write; wait for the other surfaces' frames only
+    // now, and hold the slot until the pixels are drawn
+    BeginRaster();
+    rasterStart_ = FrameClock::now();
+    frameTiming_.slotUs = ElapsedUs(slotStart, rasterStart_);
+
+    // Clear the canvas with white
+    ClearCanvas(OH_Drawing_ColorSetArgb(0xFF, 0xFF, 0xFF, 0xFF));
     return true;
 }
 
-void SampleBitMap::FinishDrawing()
+void SampleBitMap::BeginRaster()
+{
+    FrameTraceScope trace("SampleBitMap::WaitForSlot");
+    rasterTurn_.emplace(RasterScheduler::GetShared(), framePriority_);
+    rasterPool_ = rasterTurn_->GetPool();
+}
+
+void SampleBitMap::EndRaster()
+{
+    rasterPool_ = nullptr;
+    rasterTurn_.reset();
+}
+
+void SampleBitMap::ClearCanvas(uint32_t color)
+{
+    OH_Drawing_CanvasClear(cCanvas_, color);
+    frameClearColor_ = color;
+}
+
+void SampleBitMap::MarkDirty(float left, float top, float right, float bottom, float outset)
+{
+    sceneBounds_.AddBounds(left, top, right, bottom, outset);
+}
+
+void SampleBitMap::ComputeFrameChange(DirtyRegion& change) const
 {
-    if (cBitmap_ == nullptr || mappedAddr_ == nullptr) {
-        DRAWING_LOGE("FinishDrawing: bitmap or mappedAddr is null\n");
+    // Pixels that differ from the previous frame: whatever either frame drew,
+    // unless the background itself changed
+    if (!hasPrevFrame_ || (frameClearColor_ != prevClearColor_)) {
+        change.SetFull(width_, height_);
         return;
     }
+    change.Clear();
+    change.Add(prevSceneBounds_);
+    change.Add(sceneBounds_);
+    change.Clip(width_, height_);
+
+    // Past this point one big copy and a full flush are cheaper than many rects
+    if (change.Area() * 4 > width_ * height_ * 3) {
+        change.SetFull(width_, height_);
+    }
+}
 
-    // Get the pixel data from the bitmap
-    void* bitmapAddr = OH_Drawing_BitmapGetPixels(cBitmap_);
-    if (bitmapAddr == nullptr) {
-        DRAWING_LOGE("FinishDrawing: BitmapGetPixels failed\n");
+void SampleBitMap::ComputeBufferUpdate(DirtyRegion& update) const
+{
+    // The buffer holds some earlier frame; bring it up to date with every
+    // change since then, or rewrite it if it is too old to know
+    uint64_t contentFrame = bufferPool_.GetContentFrame(bufferHandle_);
+    if ((contentFrame == 0) || (frameIndex_ - contentFrame > DAMAGE_HISTORY)) {
+        update.SetFull(width_, height_);
         return;
     }
+    update.Clear();
+    for (uint64_t frame = contentFrame + 1; frame <= frameIndex_; frame++) {
+        update.Add(changeHistory_[frame % DAMAGE_HISTORY]);
+    }
+}
+
+bool SampleBitMap::FinishDrawing()
+{
+    bool presented = SubmitFrame();
+    EndFrameArena();
+    return presented;
+}
+
+void SampleBitMap::EndFrameArena()
+{
+    // Nothing drawn into the arena outlives the frame, presented or not
+    frameArena_.Reset();
+#ifndef NDEBUG
+    // Once frames stop growing they must not touch the heap
+    uint64_t steady = frameArena_.GetStats().steadyAllocations;
+    if (steady != frameArenaSteadyAllocations_) {
+        DRAWING_LOGE_LIMITED("FinishDrawing: frame arena allocated in a steady frame (%llu so far)\n",
+            static_cast<unsigned long long>(steady));
+        frameArenaSteadyAllocations_ = steady;
+    }
+#endif
+}
+
+bool SampleBitMap::SubmitFrame()
+{
+    // Copying out and flushing need no raster slot
+    EndRaster();
+    if (mappedAddr_ == nullptr) {
+        DRAWING_LOGE_LIMITED("FinishDrawing: mappedAddr is null\n");
+        return false;
+    }
+    FrameClock::time_point blitStart = FrameClock::now();
+    frameTiming_.rasterUs = ElapsedUs(rasterStart_, blitStart);
+
+    // Remember what changed since the previous frame
+    DirtyRegion& change = changeHistory_[frameIndex_ % DAMAGE_HISTORY];
+    ComputeFrameChange(change);
+
+    // In zero-copy mode the pixels are already in the window buffer
+    if (renderPath_ == RenderPath::STAGING) {
+        FrameTraceScope trace("SampleBitMap::Blit");
+        if (cBitmap_ == nullptr) {
+            DRAWING_LOGE_LIMITED("FinishDrawing: bitmap is null\n");
+            return false;
+        }
+
+        // Get the pixel data from the bitmap
+        void* bitmapAddr = OH_Drawing_BitmapGetPixels(cBitmap_);
+        if (bitmapAddr == nullptr) {
+            DRAWING_LOGE_LIMITED("FinishDrawing: BitmapGetPixels failed\n");
+            return false;
+        }
+
+        PixelFormat dstFormat;
+        if (!GetBlitFormat(bufferHandle_->format, dstFormat)) {
+            DRAWING_LOGE_LIMITED("FinishDrawing: unsupported buffer format %d\n", bufferHandle_->format);
+            return false;
+        }
+
+        // The frame rastered while the consumer may still have been reading
+        // the buffer; the copy below is the first write to it
+        if (!WaitForBuffer("FinishDrawing")) {
+            return false;
+        }
 
-    // Copy the bitmap pixels to the native window buffer
-    uint32_t* value = static_cast<uint32_t*>(bitmapAddr);
-    uint32_t* pixel = static_cast<uint32_t*>(mappedAddr_);
-    for (uint32_t x = 0; x < width_; x++) {
-        for (uint32_t y = 0; y < height_; y++) {
-            *pixel++ = *value++;
+        // Copy the bitmap pixels to the native window buffer, row by row with
+        // the buffer stride, converting to the buffer byte order if needed.
+        // Only the parts that differ from what the buffer already holds are copied.
+        PixelSurface src {bitmapAddr, static_cast<uint32_t>(width_), static_cast<uint32_t>(height_),
+            static_cast<uint32_t>(width_ * sizeof(uint32_t)), PixelFormat::RGBA_8888};
+        PixelSurface dst {mappedAddr_, static_cast<uint32_t>(bufferHandle_->width),
+            static_cast<uint32_t>(bufferHandle_->height), static_cast<uint32_t>(bufferHandle_->stride), dstFormat};
+        DirtyRegion update;
+        ComputeBufferUpdate(update);
+        for (int i = 0; i < update.Count(); i++) {
+            if (!BlitPixels(src, dst, update.Rect(i))) {
+                DRAWING_LOGE_LIMITED("FinishDrawing: BlitPixels failed\n");
+                return false;
+            }
         }
     }
+    bufferPool_.SetContentFrame(bufferHandle_, frameIndex_);
+    FrameClock::time_point flushStart = FrameClock::now();
+    frameTiming_.blitUs = ElapsedUs(blitStart, flushStart);
 
-    // Flush the buffer to display it on the screen
+    // Flush the buffer to display it on the screen, telling the compositor
+    // which parts changed; no rects means the whole buffer
     Region region {nullptr, 0};
-    OH_NativeWindow_NativeWindowFlushBuffer(nativeWindow_, buffer_, fenceFd_, region);
+    if (!change.IsFull() && !change.IsEmpty()) {
+        for (int i = 0; i < change.Count(); i++) {
+            const BlitRect& rect = change.Rect(i);
+            flushRects_[i] = Region::Rect {static_cast<int32_t>(rect.x), static_cast<int32_t>(rect.y), rect.w, rect.h};
+        }
+        region.rects = flushRects_;
+        region.rectNumber = change.Count();
+    }
+    // The CPU is done with the pixels, so there is no acquire fence to pass
+    {
+        FrameTraceScope trace("SampleBitMap::Flush");
+        OH_NativeWindow_NativeWindowFlushBuffer(nativeWindow_, buffer_, -1, region);
+    }
+    buffer_ = nullptr;
+    frameTiming_.flushUs = ElapsedUs(flushStart, FrameClock::now());
 
-    // Release resources
-    ReleaseBitmapResources();
+    // The next frame is compared against this one
+    prevSceneBounds_ = sceneBounds_;
+    prevClearColor_ = frameClearColor_;
+    hasPrevFrame_ = true;
+
+    // The drawing objects are kept for the next frame, only the buffer goes back
+    mappedAddr_ = nullptr;
+    return true;
 }
 
-void SampleBitMap::DrawPattern()
+void SampleBitMap::ReleaseCachedPath(CachedPath& cached)
 {
-    DRAWING_LOGI("DrawPattern: Starting with width=%lu, height=%lu\n", width_, height_);
-    
-    if (!PrepareDrawing()) {
-        DRAWING_LOGE("DrawPattern: PrepareDrawing failed\n");
-        return;
+    if (cached.path != nullptr) {
+        OH_Drawing_PathDestroy(cached.path);
+        cached.path = nullptr;
+    }
+}
+
+const CachedPath* SampleBitMap::GetCachedPath(CachedShape shape)
+{
+    // All current shapes depend on the surface size alone, so style is unused
+    GeometryKey key {static_cast<uint32_t>(shape), static_cast<uint32_t>(width_), static_cast<uint32_t>(height_), 0};
+    CachedPath* cached = pathCache_.Find(key);
+    if (cached != nullptr) {
+        return cached;
     }
-    DRAWING_LOGI("DrawPattern: PrepareDrawing succeeded\n");
 
+    CachedPath built {OH_Drawing_PathCreate(), DrawBounds {0, 0, 0, 0}, RasterPath()};
+    if (built.path == nullptr) {
+        DRAWING_LOGE("GetCachedPath: PathCreate failed\n");
+        return nullptr;
+    }
+    switch (shape) {
+        case CachedShape::PENTAGON:
+            BuildPentagonPath(built);
+            break;
+        case CachedShape::TEXT_FRAME:
+            BuildTextFramePath(built);
+            break;
+    }
+    return pathCache_.Insert(key, built);
+}
+
+void SampleBitMap::BuildPentagonPath(CachedPath& cached)
+{
     // Calculate pentagon vertices
     int len = height_ / 4;
     float aX = width_ / 2;
@@ -348,368 +1227,471 @@ void SampleBitMap::DrawPattern()
     float eX = aX - (len / 2.0);
     float eY = bY;
 
-    // Create a path object for the pentagon
-    cPath_ = OH_Drawing_PathCreate();
-    
     // Specify the start point of the path
-    OH_Drawing_PathMoveTo(cPath_, aX, aY);
+    OH_Drawing_PathMoveTo(cached.path, aX, aY);
     
     // Draw line segments for the pentagon
-    OH_Drawing_PathLineTo(cPath_, bX, bY);
-    OH_Drawing_PathLineTo(cPath_, cX, cY);
-    OH_Drawing_PathLineTo(cPath_, dX, dY);
-    OH_Drawing_PathLineTo(cPath_, eX, eY);
+    OH_Drawing_PathLineTo(cached.path, bX, bY);
+    OH_Drawing_PathLineTo(cached.path, cX, cY);
+    OH_Drawing_PathLineTo(cached.path, dX, dY);
+    OH_Drawing_PathLineTo(cached.path, eX, eY);
     
     // Close the path
-    OH_Drawing_PathClose(cPath_);
+    OH_Drawing_PathClose(cached.path);
 
-    // Create a pen for outlining
-    cPen_ = OH_Drawing_PenCreate();
-    OH_Drawing_PenSetAntiAlias(cPen_, true);
-    OH_Drawing_PenSetColor(cPen_, OH_Drawing_ColorSetArgb(0xFF, 0xFF, 0x00, 0x00)); // Red
-    OH_Drawing_PenSetWidth(cPen_, 10.0);
-    OH_Drawing_PenSetJoin(cPen_, LINE_ROUND_JOIN);
-    
-    // Attach the pen to the canvas
-    OH_Drawing_CanvasAttachPen(cCanvas_, cPen_);
+    cached.raster.MoveTo(aX, aY);
+    cached.raster.LineTo(bX, bY);
+    cached.raster.LineTo(cX, cY);
+    cached.raster.LineTo(dX, dY);
+    cached.raster.LineTo(eX, eY);
+    cached.raster.Close();
 
-    // Create a brush for filling
-    cBrush_ = OH_Drawing_BrushCreate();
-    OH_Drawing_BrushSetColor(cBrush_, OH_Drawing_ColorSetArgb(0xFF, 0x00, 0xFF, 0x00)); // Green
+    cached.bounds = DrawBounds {std::min({aX, bX, cX, dX, eX}), std::min({aY, bY, cY, dY, eY}),
+        std::max({aX, bX, cX, dX, eX}), std::max({aY, bY, cY, dY, eY})};
+}
+
+void SampleBitMap::BuildTextFramePath(CachedPath& cached)
+{
+    float x = width_ / 4;
+    float y = height_ / 4;
+    float w = width_ / 2;
+    float h = height_ / 2;
+    OH_Drawing_PathMoveTo(cached.path, x, y);
+    OH_Drawing_PathLineTo(cached.path, x + w, y);
+    OH_Drawing_PathLineTo(cached.path, x + w, y + h);
+    OH_Drawing_PathLineTo(cached.path, x, y + h);
+    OH_Drawing_PathClose(cached.path);
+    cached.raster.MoveTo(x, y);
+    cached.raster.LineTo(x + w, y);
+    cached.raster.LineTo(x + w, y + h);
+    cached.raster.LineTo(x, y + h);
+    cached.raster.Close();
+    cached.bounds = DrawBounds {x, y, x + w, y + h};
+}
+
+SurfacePriority SampleBitMap::GetSurfacePriority() const
+{
+    if (!visible_.load(std::memory_order_relaxed)) {
+        return SurfacePriority::BACKGROUND;
+    }
+    return focused_.load(std::memory_order_relaxed) ? SurfacePriority::FOCUSED : SurfacePriority::VISIBLE;
+}
+
+bool SampleBitMap::UseTiledRaster(PixelSurface& target)
+{
+    // Large surfaces are split into tiles rasterized on the shared workers,
+    // writing straight into the frame's pixels. Without workers (a single
+    // core, or a background frame) there is nothing to gain over the canvas.
+    if (!tiledRasterEnabled_.load(std::memory_order_relaxed) || (width_ * height_ < TILED_RASTER_MIN_PIXELS) ||
+        (rasterPool_ == nullptr) || !GetTargetSurface(target)) {
+        return false;
+    }
+    tileRasterizer_.SetQuality(GetAaQuality());
+    return true;
+}
+
+bool SampleBitMap::DrawCachedLayer(CachedShape id, const CachedPath& shape, uint32_t fillColor,
+    uint32_t strokeColor, float strokeWidth)
+{
+    PixelSurface target;
+    BlitRect rect;
+    if (!GetLayerTarget(target) || !GetLayerRect(shape.bounds, strokeWidth / 2 + 1, rect)) {
+        return false;
+    }
+
+    // Everything the layer's pixels depend on besides its rect; no padding,
+    // since the cache compares the bytes
+    struct LayerStyle {
+        uint32_t fillColor;
+        uint32_t strokeColor;
+        float strokeWidth;
+        uint32_t quality;
+    };
+    LayerStyle style {fillColor, strokeColor, strokeWidth, static_cast<uint32_t>(GetAaQuality())};
+
+    uint32_t layerId = static_cast<uint32_t>(id);
+    if (!layerCache_.IsValid(layerId, rect, &style, sizeof(style))) {
+        FrameTraceScope trace("SampleBitMap::DrawLayer");
+        PixelSurface layer;
+        if (!layerCache_.Begin(layerId, rect, &style, sizeof(style), layer)) {
+            DRAWING_LOGE_LIMITED("DrawCachedLayer: no memory for a %ux%u layer\n", rect.w, rect.h);
+            return false;
+        }
+        // Drawn once, so on tiles whatever the surface size, on the shared
+        // workers if the frame was given any
+        layerPath_ = shape.raster;
+        layerPath_.Offset(-static_cast<float>(rect.x), -static_cast<float>(rect.y));
+        tileRasterizer_.SetQuality(GetAaQuality());
+        tileRasterizer_.Begin(layer);
+        tileRasterizer_.Fill(layerPath_, fillColor);
+        tileRasterizer_.Stroke(layerPath_, strokeWidth, strokeColor);
+        tileRasterizer_.Flush(rasterPool_);
+    }
+    return layerCache_.Composite(layerId, target);
+}
+
+bool SampleBitMap::GetLayerTarget(PixelSurface& target)
+{
+    if (layersInvalidated_.exchange(false, std::memory_order_relaxed)) {
+        layerCache_.InvalidateAll();
+    }
+    return layerCacheEnabled_.load(std::memory_order_relaxed) && GetTargetSurface(target);
+}
+
+bool SampleBitMap::GetLayerRect(const DrawBounds& bounds, float outset, BlitRect& rect) const
+{
+    // Whole pixels of the surface
+    float left = std::max(std::floor(bounds.left - outset), 0.0f);
+    float top = std::max(std::floor(bounds.top - outset), 0.0f);
+    float right = std::min(std::ceil(bounds.right + outset), static_cast<float>(width_));
+    float bottom = std::min(std::ceil(bounds.bottom + outset), static_cast<float>(height_));
+    if ((right <= left) || (bottom <= top)) {
+        return false;
+    }
+    rect = BlitRect {static_cast<uint32_t>(left), static_cast<uint32_t>(top), static_cast<uint32_t>(right - left),
+        static_cast<uint32_t>(bottom - top)};
+    return true;
+}
+
+void SampleBitMap::DrawCachedPath(CachedShape id, const CachedPath& shape, OH_Drawing_Brush* brush,
+    uint32_t fillColor, OH_Drawing_Pen* pen, uint32_t strokeColor, float strokeWidth)
+{
+    if (DrawCachedLayer(id, shape, fillColor, strokeColor, strokeWidth)) {
+        return;
+    }
+
+    PixelSurface target;
+    if (UseTiledRaster(target)) {
+        tileRasterizer_.Begin(target);
+        tileRasterizer_.Fill(shape.raster, fillColor);
+        tileRasterizer_.Stroke(shape.raster, strokeWidth, strokeColor);
+        tileRasterizer_.Flush(rasterPool_);
+        return;
+    }
+
+    bool antiAlias = GetAaQuality() != AaQuality::NONE;
+    OH_Drawing_PenSetAntiAlias(pen, antiAlias);
+    OH_Drawing_BrushSetAntiAlias(brush, antiAlias);
+    OH_Drawing_PenSetColor(pen, strokeColor);
+    OH_Drawing_PenSetWidth(pen, strokeWidth);
+    OH_Drawing_CanvasAttachPen(cCanvas_, pen);
+    OH_Drawing_BrushSetColor(brush, fillColor);
+    OH_Drawing_CanvasAttachBrush(cCanvas_, brush);
+    OH_Drawing_CanvasDrawPath(cCanvas_, shape.path);
+}
+
+bool SampleBitMap::DrawPattern()
+{
+    DRAWING_LOGD("DrawPattern: Starting with width=%lu, height=%lu\n", width_, height_);
     
-    // Attach the brush to the canvas
-    OH_Drawing_CanvasAttachBrush(cCanvas_, cBrush_);
+    if (!PrepareDrawing()) {
+        DRAWING_LOGE_LIMITED("DrawPattern: PrepareDrawing failed\n");
+        return false;
+    }
+    DRAWING_LOGD("DrawPattern: PrepareDrawing succeeded\n");
 
-    // Draw the pentagon
-    OH_Drawing_CanvasDrawPath(cCanvas_, cPath_);
+    // The pentagon is only rebuilt when the surface size changes
+    const CachedPath* pentagon = GetCachedPath(CachedShape::PENTAGON);
+    if (pentagon == nullptr) {
+        return false;
+    }
+
+    // Green pentagon outlined in red, with round joins
+    OH_Drawing_PenSetJoin(cPen_, LINE_ROUND_JOIN);
+    DrawCachedPath(CachedShape::PENTAGON, *pentagon, cBrush_, OH_Drawing_ColorSetArgb(0xFF, 0x00, 0xFF, 0x00),
+        cPen_, OH_Drawing_ColorSetArgb(0xFF, 0xFF, 0x00, 0x00), 10.0f);
+    const DrawBounds& bounds = pentagon->bounds;
+    MarkDirty(bounds.left, bounds.top, bounds.right, bounds.bottom, 10.0f / 2 + 1);
 
-    DRAWING_LOGI("DrawPattern: Finished drawing, calling FinishDrawing()\n");
+    DRAWING_LOGD("DrawPattern: Finished drawing, calling FinishDrawing()\n");
     // Finish drawing and display the result
-    FinishDrawing();
-    DRAWING_LOGI("DrawPattern: FinishDrawing completed\n");
+    bool presented = FinishDrawing();
+    DRAWING_LOGD("DrawPattern: FinishDrawing completed\n");
+    return presented;
 }
 
-void SampleBitMap::DrawText()
+bool SampleBitMap::DrawText()
 {
-    DRAWING_LOGI("DrawText: Starting with width=%lu, height=%lu\n", width_, height_);
+    DRAWING_LOGD("DrawText: Starting with width=%lu, height=%lu\n", width_, height_);
     
     if (!PrepareDrawing()) {
-        DRAWING_LOGE("DrawText: PrepareDrawing failed\n");
-        return;
+        DRAWING_LOGE_LIMITED("DrawText: PrepareDrawing failed\n");
+        return false;
+    }
+    DRAWING_LOGD("DrawText: PrepareDrawing succeeded\n");
+
+    // The frame path is only rebuilt when the surface size changes
+    const CachedPath* frame = GetCachedPath(CachedShape::TEXT_FRAME);
+    if (frame == nullptr) {
+        return false;
     }
-    DRAWING_LOGI("DrawText: PrepareDrawing succeeded\n");
 
     // Start with a gray background for better contrast
-    OH_Drawing_CanvasClear(cCanvas_, OH_Drawing_ColorSetArgb(0xFF, 0xE0, 0xE0, 0xE0)); // Light gray background
-    
-    // Draw a blue rectangle to help visualize the drawing area
-    OH_Drawing_Pen* rectPen = OH_Drawing_PenCreate();
-    OH_Drawing_PenSetColor(rectPen, OH_Drawing_ColorSetArgb(0xFF, 0x00, 0x00, 0xFF)); // Blue
-    OH_Drawing_PenSetWidth(rectPen, 5.0);
-    OH_Drawing_CanvasAttachPen(cCanvas_, rectPen);
-    
-    OH_Drawing_Brush* rectBrush = OH_Drawing_BrushCreate();
-    OH_Drawing_BrushSetColor(rectBrush, OH_Drawing_ColorSetArgb(0x40, 0x00, 0x00, 0xFF)); // Semi-transparent blue
-    OH_Drawing_CanvasAttachBrush(cCanvas_, rectBrush);
-    
-    OH_Drawing_Path* rectPath = OH_Drawing_PathCreate();
-    float x = width_ / 4;
-    float y = height_ / 4;
-    float w = width_ / 2;
-    float h = height_ / 2;
-    OH_Drawing_PathMoveTo(rectPath, x, y);
-    OH_Drawing_PathLineTo(rectPath, x + w, y);
-    OH_Drawing_PathLineTo(rectPath, x + w, y + h);
-    OH_Drawing_PathLineTo(rectPath, x, y + h);
-    OH_Drawing_PathClose(rectPath);
-    OH_Drawing_CanvasDrawPath(cCanvas_, rectPath);
+    ClearCanvas(OH_Drawing_ColorSetArgb(0xFF, 0xE0, 0xE0, 0xE0)); // Light gray background
     
-    // Clean up the rectangle resources
-    OH_Drawing_PathDestroy(rectPath);
-    OH_Drawing_BrushDestroy(rectBrush);
-    OH_Drawing_PenDestroy(rectPen);
+    // Draw a blue rectangle, semi-transparent inside, to help visualize the drawing area
+    DrawCachedPath(CachedShape::TEXT_FRAME, *frame, cRectBrush_, OH_Drawing_ColorSetArgb(0x40, 0x00, 0x00, 0xFF),
+        cRectPen_, OH_Drawing_ColorSetArgb(0xFF, 0x00, 0x00, 0xFF), 5.0f);
+    MarkDirty(frame->bounds.left, frame->bounds.top, frame->bounds.right, frame->bounds.bottom, 5.0f / 2 + 1);
 
     // ----------------
     // ALTERNATIVE TEXT DRAWING METHOD
     // ----------------
-    // Instead of using the typography API, draw text manually using paths
-    // Create red pen and brush for the text
-    OH_Drawing_Pen* textPen = OH_Drawing_PenCreate();
-    OH_Drawing_PenSetColor(textPen, OH_Drawing_ColorSetArgb(0xFF, 0xFF, 0x00, 0x00)); // Red
-    OH_Drawing_PenSetWidth(textPen, 5.0);
-    OH_Drawing_PenSetAntiAlias(textPen, true);
-    OH_Drawing_CanvasAttachPen(cCanvas_, textPen);
-    
-    OH_Drawing_Brush* textBrush = OH_Drawing_BrushCreate();
-    OH_Drawing_BrushSetColor(textBrush, OH_Drawing_ColorSetArgb(0xFF, 0xFF, 0x00, 0x00)); // Red
-    OH_Drawing_CanvasAttachBrush(cCanvas_, textBrush);
-    
-    // Starting position for text
-    float textX = x + 40;
-    float textY = y + 100;
-    float letterHeight = h / 2;
-    float letterWidth = w / 8;
-    float spacing = letterWidth / 3;
-    
-    DRAWING_LOGI("DrawText: Drawing manual text at position: %f, %f\n", textX, textY);
-    
-    // Draw "HELLO" manually using paths
-    
-    // Draw "H"
-    OH_Drawing_Path* letterH = OH_Drawing_PathCreate();
-    OH_Drawing_PathMoveTo(letterH, textX, textY);
-    OH_Drawing_PathLineTo(letterH, textX, textY + letterHeight);
-    OH_Drawing_PathMoveTo(letterH, textX, textY + letterHeight/2);
-    OH_Drawing_PathLineTo(letterH, textX + letterWidth, textY + letterHeight/2);
-    OH_Drawing_PathMoveTo(letterH, textX + letterWidth, textY);
-    OH_Drawing_PathLineTo(letterH, textX + letterWidth, textY + letterHeight);
-    OH_Drawing_CanvasDrawPath(cCanvas_, letterH);
-    OH_Drawing_PathDestroy(letterH);
-    textX += letterWidth + spacing;
-    
-    // Draw "E"
-    OH_Drawing_Path* letterE = OH_Drawing_PathCreate();
-    OH_Drawing_PathMoveTo(letterE, textX, textY);
-    OH_Drawing_PathLineTo(letterE, textX, textY + letterHeight);
-    OH_Drawing_PathMoveTo(letterE, textX, textY);
-    OH_Drawing_PathLineTo(letterE, textX + letterWidth, textY);
-    OH_Drawing_PathMoveTo(letterE, textX, textY + letterHeight/2);
-    OH_Drawing_PathLineTo(letterE, textX + letterWidth, textY + letterHeight/2);
-    OH_Drawing_PathMoveTo(letterE, textX, textY + letterHeight);
-    OH_Drawing_PathLineTo(letterE, textX + letterWidth, textY + letterHeight);
-    OH_Drawing_CanvasDrawPath(cCanvas_, letterE);
-    OH_Drawing_PathDestroy(letterE);
-    textX += letterWidth + spacing;
-    
-    // Draw "L"
-    OH_Drawing_Path* letterL = OH_Drawing_PathCreate();
-    OH_Drawing_PathMoveTo(letterL, textX, textY);
-    OH_Drawing_PathLineTo(letterL, textX, textY + letterHeight);
-    OH_Drawing_PathMoveTo(letterL, textX, textY + letterHeight);
-    OH_Drawing_PathLineTo(letterL, textX + letterWidth, textY + letterHeight);
-    OH_Drawing_CanvasDrawPath(cCanvas_, letterL);
-    OH_Drawing_PathDestroy(letterL);
-    textX += letterWidth + spacing;
-    
-    // Draw another "L"
-    OH_Drawing_Path* letterL2 = OH_Drawing_PathCreate();
-    OH_Drawing_PathMoveTo(letterL2, textX, textY);
-    OH_Drawing_PathLineTo(letterL2, textX, textY + letterHeight);
-    OH_Drawing_PathMoveTo(letterL2, textX, textY + letterHeight);
-    OH_Drawing_PathLineTo(letterL2, textX + letterWidth, textY + letterHeight);
-    OH_Drawing_CanvasDrawPath(cCanvas_, letterL2);
-    OH_Drawing_PathDestroy(letterL2);
-    textX += letterWidth + spacing;
-    
-    // Draw "O"
-    OH_Drawing_Path* letterO = OH_Drawing_PathCreate();
-    // Draw a circle for the letter O
-    float oRadius = letterWidth / 2;
-    float oCenterX = textX + oRadius;
-    float oCenterY = textY + letterHeight / 2;
-    
-    // Approximating a circle with lines
-    const int numSegments = 20;
-    float angle = 0.0f;
-    float angleIncrement = 2.0f * M_PI / numSegments;
-    
-    float startX = oCenterX + oRadius * cos(angle);
-    float startY = oCenterY + oRadius * sin(angle);
-    OH_Drawing_PathMoveTo(letterO, startX, startY);
-    
-    for (int i = 1; i <= numSegments; i++) {
-        angle += angleIncrement;
-        float x = oCenterX + oRadius * cos(angle);
-        float y = oCenterY + oRadius * sin(angle);
-        OH_Drawing_PathLineTo(letterO, x, y);
+    // Instead of using the typography API, blend the label from the stroke-font
+    // glyph atlas straight into the frame's pixels. The frame underneath is
+    // already there, composited from its layer or drawn by the CPU canvas.
+    PixelSurface target;
+    if (!GetTargetSurface(target)) {
+        DRAWING_LOGE_LIMITED("DrawText: no pixels to draw the label into\n");
+        return false;
+    }
+
+    // The label is clipped to the frame rect, so draw into that part of the target
+    const DrawBounds& box = frame->bounds;
+    uint32_t frameX = static_cast<uint32_t>(std::max(box.left, 0.0f));
+    uint32_t frameY = static_cast<uint32_t>(std::max(box.top, 0.0f));
+    uint32_t frameW = static_cast<uint32_t>(std::max(std::min(box.right, static_cast<float>(width_)) - frameX, 0.0f));
+    uint32_t frameH = static_cast<uint32_t>(std::max(std::min(box.bottom, static_cast<float>(height_)) - frameY, 0.0f));
+    PixelSurface frameSurface {static_cast<uint8_t*>(target.pixels) + frameY * target.stride + frameX * 4, frameW,
+        frameH, target.stride, target.format};
+
+    // Rasterized once per size; a no-op while the surface size is unchanged
+    glyphAtlas_.Build(frameH / 4.0f);
+    int32_t textX = static_cast<int32_t>(glyphAtlas_.GetCapHeight() / 2);
+    int32_t textY = (static_cast<int32_t>(frameH) - static_cast<int32_t>(glyphAtlas_.GetLineHeight())) / 2;
+    BlitRect touched = glyphAtlas_.DrawText(frameSurface, textX, textY, label_,
+        OH_Drawing_ColorSetArgb(0xFF, 0xFF, 0x00, 0x00)); // Red
+    if (touched.w != 0) {
+        MarkDirty(frameX + touched.x, frameY + touched.y, frameX + touched.x + touched.w,
+            frameY + touched.y + touched.h, 0.0f);
     }
     
-    OH_Drawing_CanvasDrawPath(cCanvas_, letterO);
-    OH_Drawing_PathDestroy(letterO);
-    
-    // Clean up text resources
-    OH_Drawing_BrushDestroy(textBrush);
-    OH_Drawing_PenDestroy(textPen);
-    
-    DRAWING_LOGI("DrawText: All text resources cleaned up, calling FinishDrawing()\n");
+    DRAWING_LOGD("DrawText: Finished drawing, calling FinishDrawing()\n");
     // Finish drawing and display the result
-    FinishDrawing();
-    DRAWING_LOGI("DrawText: FinishDrawing completed\n");
+    bool presented = FinishDrawing();
+    DRAWING_LOGD("DrawText: FinishDrawing completed\n");
+    return presented;
 }
 
-// NAPI methods for JavaScript/TypeScript interop
-napi_value SampleBitMap::NapiDrawPattern(napi_env env, napi_callback_info info)
+bool SampleBitMap::DrawDisplayList(const std::shared_ptr<const DisplayList>& list)
 {
-    // Get the current instance
-    void* data = nullptr;
-    napi_get_cb_info(env, info, nullptr, nullptr, nullptr, &data);
-    
-    napi_value thisArg;
-    napi_get_cb_info(env, info, nullptr, nullptr, &thisArg, nullptr);
-    
-    // Get the component ID from XComponent
-    char idStr[OH_XCOMPONENT_ID_LEN_MAX + 1] = {' '};
-    uint64_t idSize = OH_XCOMPONENT_ID_LEN_MAX + 1;
-    napi_value exportInstance;
-    napi_get_named_property(env, thisArg, OH_NATIVE_XCOMPONENT_OBJ, &exportInstance);
-    
-    OH_NativeXComponent* nativeXComponent = nullptr;
-    napi_unwrap(env, exportInstance, reinterpret_cast<void**>(&nativeXComponent));
-    
-    OH_NativeXComponent_GetXComponentId(nativeXComponent, idStr, &idSize);
-    std::string id(idStr);
-    
-    // Get the SampleBitMap instance and draw the pattern
-    auto render = SampleBitMap::GetInstance(id);
-    if (render != nullptr) {
-        render->DrawPattern();
-    } else {
-        DRAWING_LOGE("NapiDrawPattern: render is nullptr\n");
+    if (!PrepareDrawing()) {
+        DRAWING_LOGE_LIMITED("DrawDisplayList: PrepareDrawing failed\n");
+        return false;
     }
-    
-    napi_value result;
-    napi_get_undefined(env, &result);
-    return result;
+
+    BeginSinkDrawing();
+    list->Replay(*this);
+    EndSinkDrawing();
+
+    if (!FinishDrawing()) {
+        return false;
+    }
+    presentedList_ = list;
+    presentedListId_.store(list.get(), std::memory_order_release);
+    return true;
 }
 
-napi_value SampleBitMap::NapiDrawText(napi_env env, napi_callback_info info)
+void SampleBitMap::BeginSinkDrawing()
 {
-    // Get the current instance
-    void* data = nullptr;
-    napi_get_cb_info(env, info, nullptr, nullptr, nullptr, &data);
-    
-    napi_value thisArg;
-    napi_get_cb_info(env, info, nullptr, nullptr, &thisArg, nullptr);
-    
-    // Get the component ID from XComponent
-    char idStr[OH_XCOMPONENT_ID_LEN_MAX + 1] = {' '};
-    uint64_t idSize = OH_XCOMPONENT_ID_LEN_MAX + 1;
-    napi_value exportInstance;
-    napi_get_named_property(env, thisArg, OH_NATIVE_XCOMPONENT_OBJ, &exportInstance);
-    
-    OH_NativeXComponent* nativeXComponent = nullptr;
-    napi_unwrap(env, exportInstance, reinterpret_cast<void**>(&nativeXComponent));
-    
-    OH_NativeXComponent_GetXComponentId(nativeXComponent, idStr, &idSize);
-    std::string id(idStr);
-    
-    // Get the SampleBitMap instance and draw text
-    auto render = SampleBitMap::GetInstance(id);
-    if (render != nullptr) {
-        render->DrawText();
-    } else {
-        DRAWING_LOGE("NapiDrawText: render is nullptr\n");
+    // On tiles everything drawn through the sink is recorded and then
+    // rasterized in one flush
+    PixelSurface target;
+    tiledReplay_ = UseTiledRaster(target);
+    if (tiledReplay_) {
+        tileRasterizer_.Begin(target);
     }
-    
-    napi_value result;
-    napi_get_undefined(env, &result);
-    return result;
 }
 
-void SampleBitMap::Export(napi_env env, napi_value exports)
+void SampleBitMap::EndSinkDrawing()
 {
-    if ((env == nullptr) || (exports == nullptr)) {
-        DRAWING_LOGE("Export: env or exports is null\n");
-        return;
+    if (tiledReplay_) {
+        tileRasterizer_.Flush(rasterPool_);
+        tiledReplay_ = false;
     }
+}
 
-    // Define JavaScript methods
-    napi_property_descriptor desc[] = {
-        {"drawPattern", nullptr, SampleBitMap::NapiDrawPattern, nullptr, nullptr, nullptr, napi_default, nullptr},
-        {"drawText", nullptr, SampleBitMap::NapiDrawText, nullptr, nullptr, nullptr, napi_default, nullptr}
-    };
+bool SampleBitMap::DrawInk()
+{
+    if (!PrepareDrawing()) {
+        DRAWING_LOGE_LIMITED("DrawInk: PrepareDrawing failed\n");
+        return false;
+    }
 
-    // Register methods
-    if (napi_define_properties(env, exports, sizeof(desc) / sizeof(desc[0]), desc) != napi_ok) {
-        DRAWING_LOGE("Export: napi_define_properties failed\n");
+    BeginSinkDrawing();
+    Clear(INK_BACKGROUND);
+    for (const InkStroke& stroke : ink_) {
+        if (stroke.points.empty()) {
+            continue;
+        }
+        const TouchPosition& first = stroke.points.front();
+        DrawBounds bounds {first.x, first.y, first.x, first.y};
+        auto lineTo = [this, &bounds](const TouchPosition& p) {
+            LineTo(p.x, p.y);
+            bounds = DrawBounds {std::min(bounds.left, p.x), std::min(bounds.top, p.y), std::max(bounds.right, p.x),
+                std::max(bounds.bottom, p.y)};
+        };
+        MoveTo(first.x, first.y);
+        for (size_t i = 1; i < stroke.points.size(); i++) {
+            lineTo(stroke.points[i]);
+        }
+        // Up to where the finger should be by the time this is on screen; a
+        // tap is a dot
+        if (stroke.down || (stroke.points.size() == 1)) {
+            lineTo(stroke.down ? stroke.predicted : first);
+        }
+        Stroke(INK_COLOR, INK_WIDTH, bounds);
     }
+    EndSinkDrawing();
+    return FinishDrawing();
 }
 
-// Callback functions
-void OnSurfaceCreatedCB(OH_NativeXComponent* component, void* window)
+void SampleBitMap::Clear(uint32_t color)
 {
-    if ((component == nullptr) || (window == nullptr)) {
-        DRAWING_LOGE("OnSurfaceCreatedCB: component or window is null\n");
-        return;
+    // Everything drawn so far is covered, including draws not yet rasterized
+    PixelSurface target;
+    if (tiledReplay_ && GetTargetSurface(target)) {
+        tileRasterizer_.Begin(target);
     }
-    
-    // Obtain an OHNativeWindow instance
-    OHNativeWindow* nativeWindow = static_cast<OHNativeWindow*>(window);
-    
-    // Get the XComponent ID
-    char idStr[OH_XCOMPONENT_ID_LEN_MAX + 1] = {' '};
-    uint64_t idSize = OH_XCOMPONENT_ID_LEN_MAX + 1;
-    if (OH_NativeXComponent_GetXComponentId(component, idStr, &idSize) != OH_NATIVEXCOMPONENT_RESULT_SUCCESS) {
-        DRAWING_LOGE("OnSurfaceCreatedCB: Unable to get XComponent id\n");
-        return;
+    ClearCanvas(color);
+    sceneBounds_.Clear();
+}
+
+void SampleBitMap::MoveTo(float x, float y)
+{
+    rasterPath_.MoveTo(x, y);
+}
+
+void SampleBitMap::LineTo(float x, float y)
+{
+    rasterPath_.LineTo(x, y);
+}
+
+void SampleBitMap::QuadTo(float x1, float y1, float x2, float y2)
+{
+    rasterPath_.QuadTo(x1, y1, x2, y2, FLATTEN_TOLERANCE);
+}
+
+void SampleBitMap::CubicTo(float x1, float y1, float x2, float y2, float x3, float y3)
+{
+    rasterPath_.CubicTo(x1, y1, x2, y2, x3, y3, FLATTEN_TOLERANCE);
+}
+
+void SampleBitMap::ArcTo(float cx, float cy, float radius, float startAngle, float sweep)
+{
+    rasterPath_.ArcTo(cx, cy, radius, startAngle, sweep, FLATTEN_TOLERANCE);
+}
+
+void SampleBitMap::RoundRect(float left, float top, float right, float bottom, float radius)
+{
+    rasterPath_.AddRoundRect(left, top, right, bottom, radius, FLATTEN_TOLERANCE);
+}
+
+void SampleBitMap::Close()
+{
+    rasterPath_.Close();
+}
+
+void SampleBitMap::Fill(uint32_t color, const DrawBounds& bounds)
+{
+    MarkDirty(bounds.left, bounds.top, bounds.right, bounds.bottom, 1.0f);
+    if (layerReplay_) {
+        rasterPath_.Offset(-static_cast<float>(layerRect_.x), -static_cast<float>(layerRect_.y));
     }
-    
-    std::string id(idStr);
-    auto render = SampleBitMap::GetInstance(id);
-    render->SetNativeWindow(nativeWindow);
-    
-    // Get the size of the XComponent
-    uint64_t width;
-    uint64_t height;
-    int32_t xSize = OH_NativeXComponent_GetXComponentSize(component, window, &width, &height);
-    if ((xSize == OH_NATIVEXCOMPONENT_RESULT_SUCCESS) && (render != nullptr)) {
-        render->SetHeight(height);
-        render->SetWidth(width);
-        DRAWING_LOGI("xComponent width = %lu, height = %lu\n", width, height);
+    if (tiledReplay_ || layerReplay_) {
+        tileRasterizer_.Fill(rasterPath_, color);
+        rasterPath_.Reset();
+        return;
     }
+    AddToCanvasPath(cPath_, rasterPath_);
+    rasterPath_.Reset();
+    OH_Drawing_CanvasDetachPen(cCanvas_);
+    OH_Drawing_BrushSetAntiAlias(cBrush_, GetAaQuality() != AaQuality::NONE);
+    OH_Drawing_BrushSetColor(cBrush_, color);
+    OH_Drawing_CanvasAttachBrush(cCanvas_, cBrush_);
+    OH_Drawing_CanvasDrawPath(cCanvas_, cPath_);
+    OH_Drawing_CanvasDetachBrush(cCanvas_);
+    OH_Drawing_PathReset(cPath_);
 }
 
-void OnSurfaceChangedCB(OH_NativeXComponent* component, void* window)
+void SampleBitMap::Stroke(uint32_t color, float width, const DrawBounds& bounds)
 {
-    if ((component == nullptr) || (window == nullptr)) {
-        DRAWING_LOGE("OnSurfaceChangedCB: component or window is null\n");
-        return;
+    // Round joins keep the stroke within half its width of the path
+    MarkDirty(bounds.left, bounds.top, bounds.right, bounds.bottom, width / 2 + 1);
+    if (layerReplay_) {
+        rasterPath_.Offset(-static_cast<float>(layerRect_.x), -static_cast<float>(layerRect_.y));
     }
-    
-    // Get the XComponent ID
-    char idStr[OH_XCOMPONENT_ID_LEN_MAX + 1] = {' '};
-    uint64_t idSize = OH_XCOMPONENT_ID_LEN_MAX + 1;
-    if (OH_NativeXComponent_GetXComponentId(component, idStr, &idSize) != OH_NATIVEXCOMPONENT_RESULT_SUCCESS) {
-        DRAWING_LOGE("OnSurfaceChangedCB: Unable to get XComponent id\n");
+    if (tiledReplay_ || layerReplay_) {
+        tileRasterizer_.Stroke(rasterPath_, width, color);
+        rasterPath_.Reset();
         return;
     }
-    
-    std::string id(idStr);
-    auto render = SampleBitMap::GetInstance(id);
-    
-    // Get the new size of the XComponent
-    uint64_t width;
-    uint64_t height;
-    int32_t xSize = OH_NativeXComponent_GetXComponentSize(component, window, &width, &height);
-    if ((xSize == OH_NATIVEXCOMPONENT_RESULT_SUCCESS) && (render != nullptr)) {
-        render->SetHeight(height);
-        render->SetWidth(width);
-        DRAWING_LOGI("Surface Changed: xComponent width = %lu, height = %lu\n", width, height);
-    }
+    AddToCanvasPath(cPath_, rasterPath_);
+    rasterPath_.Reset();
+    OH_Drawing_CanvasDetachBrush(cCanvas_);
+    OH_Drawing_PenSetAntiAlias(cPen_, GetAaQuality() != AaQuality::NONE);
+    OH_Drawing_PenSetColor(cPen_, color);
+    OH_Drawing_PenSetWidth(cPen_, width);
+    OH_Drawing_PenSetJoin(cPen_, LINE_ROUND_JOIN);
+    OH_Drawing_CanvasAttachPen(cCanvas_, cPen_);
+    OH_Drawing_CanvasDrawPath(cCanvas_, cPath_);
+    OH_Drawing_CanvasDetachPen(cCanvas_);
+    OH_Drawing_PathReset(cPath_);
 }
 
-void OnSurfaceDestroyedCB(OH_NativeXComponent* component, void* window)
+bool SampleBitMap::BeginLayer(uint32_t id, const DrawBounds& bounds, uint64_t content)
 {
-    if ((component == nullptr) || (window == nullptr)) {
-        DRAWING_LOGE("OnSurfaceDestroyedCB: component or window is null\n");
-        return;
+    // Without the cache the layer is drawn in place like the rest
+    PixelSurface target;
+    BlitRect rect;
+    if (!GetLayerTarget(target) || !GetLayerRect(bounds, 1.0f, rect)) {
+        return true;
     }
-    
-    // Get the XComponent ID
-    char idStr[OH_XCOMPONENT_ID_LEN_MAX + 1] = {' '};
-    uint64_t idSize = OH_XCOMPONENT_ID_LEN_MAX + 1;
-    if (OH_NativeXComponent_GetXComponentId(component, idStr, &idSize) != OH_NATIVEXCOMPONENT_RESULT_SUCCESS) {
-        DRAWING_LOGE("OnSurfaceDestroyedCB: Unable to get XComponent id\n");
-        return;
+    // No padding, since the cache compares the bytes
+    struct LayerParams {
+        uint64_t content;
+        uint64_t quality;
+    };
+    LayerParams params {content, static_cast<uint64_t>(GetAaQuality())};
+    uint32_t key = LIST_LAYER_KEY | id;
+
+    // What was drawn before the layer goes under it
+    if (tiledReplay_) {
+        tileRasterizer_.Flush(rasterPool_);
     }
-    
-    std::string id(idStr);
-    SampleBitMap::Release(id);
-    DRAWING_LOGI("OnSurfaceDestroyedCB: Released instance for id %s\n", id.c_str());
+    if (layerCache_.IsValid(key, rect, &params, sizeof(params))) {
+        MarkDirty(bounds.left, bounds.top, bounds.right, bounds.bottom, 1.0f);
+        layerCache_.Composite(key, target);
+        return false;
+    }
+    PixelSurface layer;
+    if (!layerCache_.Begin(key, rect, &params, sizeof(params), layer)) {
+        DRAWING_LOGE_LIMITED("BeginLayer: no memory for a %ux%u layer\n", rect.w, rect.h);
+        return true;
+    }
+    // Drawn on tiles whatever the surface size, then composited at EndLayer()
+    tileRasterizer_.SetQuality(GetAaQuality());
+    tileRasterizer_.Begin(layer);
+    layerReplay_ = true;
+    layerKey_ = key;
+    layerRect_ = rect;
+    return true;
 }
 
-void DispatchTouchEventCB(OH_NativeXComponent* component, void* window)
+void SampleBitMap::EndLayer()
 {
-    // This callback is not implemented in this example
-    // It would handle touch events if needed
+    if (!layerReplay_) {
+        return;
+    }
+    FrameTraceScope trace("SampleBitMap::DrawLayer");
+    tileRasterizer_.Flush(rasterPool_);
+    layerReplay_ = false;
+    PixelSurface target;
+    if (GetTargetSurface(target)) {
+        layerCache_.Composite(layerKey_, target);
+        // Back to recording the frame itself
+        if (tiledReplay_) {
+            tileRasterizer_.Begin(target);
+        }
+    }
 }
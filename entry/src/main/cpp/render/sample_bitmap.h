@@ -20,70 +20,530 @@
 #include <native_drawing/drawing_pen.h>
 #include <native_drawing/drawing_brush.h>
 #include <native_drawing/drawing_path.h>
-#include <native_drawing/drawing_text_typography.h>
-#include "napi/native_api.h"
+#include "buffer_pool.h"
+#include "dirty_region.h"
+#include "display_list.h"
+#include "fence.h"
+#include "frame_arena.h"
+#include "frame_scheduler.h"
+#include "frame_stats.h"
+#include "frame_timing.h"
+#include "geometry_cache.h"
+#include "glyph_atlas.h"
+#include "instance_registry.h"
+#include "layer_cache.h"
+#include "raster_scheduler.h"
+#include "render_thread.h"
+#include "staging_memory.h"
+#include "tile_raster.h"
+#include "touch_input.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <vector>
 
-// Forward declarations for callbacks
-void OnSurfaceCreatedCB(OH_NativeXComponent* component, void* window);
-void OnSurfaceChangedCB(OH_NativeXComponent* component, void* window);
-void OnSurfaceDestroyedCB(OH_NativeXComponent* component, void* window);
-void DispatchTouchEventCB(OH_NativeXComponent* component, void* window);
+// Where a frame is rasterized before it is flushed
+enum class RenderPath {
+    NONE,
+    // The canvas draws straight into the mapped window buffer
+    ZERO_COPY,
+    // The canvas draws into cBitmap_, which FinishDrawing copies into the buffer
+    STAGING,
+};
 
-class SampleBitMap {
+// Gets every async draw request back once its frame has been presented or
+// given up, with the timing of that frame. Runs on the render thread.
+class FrameListener {
 public:
-    SampleBitMap();
-    ~SampleBitMap() noexcept;
+    virtual ~FrameListener() = default;
+    virtual void OnFrameDone(void* request, bool presented, const FrameTiming& timing, RenderPath path) = 0;
+};
+
+// A built path and the area it covers, before stroke outset
+struct CachedPath {
+    OH_Drawing_Path* path;
+    DrawBounds bounds;
+    // The same shape for the tile rasterizer
+    RasterPath raster;
+};
 
-    // Static methods for instance management
-    static SampleBitMap* GetInstance(const std::string& id);
+// Static shapes kept in the path cache
+enum class CachedShape : uint32_t {
+    PENTAGON = 1,
+    TEXT_FRAME,
+};
+
+// Display lists replay straight onto the cached canvas objects, so the
+// instance is its own (private) sink
+class SampleBitMap : public std::enable_shared_from_this<SampleBitMap>, private DisplayListSink {
+public:
+    explicit SampleBitMap(const std::string& id);
+    ~SampleBitMap() noexcept override;
+
+    // Instance management, safe from any thread. The returned handle keeps
+    // the instance alive even if it is released meanwhile.
+    // GetInstance creates the instance for id on first use; FindInstance
+    // returns null for an id that is not (or no longer) registered.
+    static std::shared_ptr<SampleBitMap> GetInstance(const std::string& id);
+    static std::shared_ptr<SampleBitMap> FindInstance(const std::string& id);
+    // Lookup by the XComponent passed to RegisterCallback, without building
+    // its id string; for the surface callbacks
+    static std::shared_ptr<SampleBitMap> FindInstance(const OH_NativeXComponent* component);
+
+    // Unregister id and stop its render thread; the instance is deleted once
+    // the last handle to it is gone. ReleaseAll does this for every instance.
     static void Release(const std::string& id);
+    static void ReleaseAll();
+
+    // instance's id, bound to it and then to any instance created for the id
+    // after it is released; for the NAPI methods of one XComponent
+    using Binding = InstanceBinding<SampleBitMap>;
+    static Binding Bind(const std::shared_ptr<SampleBitMap>& instance);
 
     // Setters for window and dimensions
     void SetNativeWindow(OHNativeWindow* window);
     void SetWidth(uint64_t width);
     void SetHeight(uint64_t height);
+    uint64_t GetWidth() const
+    {
+        return width_;
+    }
+    uint64_t GetHeight() const
+    {
+        return height_;
+    }
+
+    // Render directly into the window buffer when its format allows (default on).
+    // When off, or when the buffer format does not match, the staging bitmap is used.
+    void SetZeroCopyEnabled(bool enabled);
+    RenderPath GetRenderPath() const
+    {
+        return renderPath_;
+    }
+
+    // Rasterize the static shapes and display lists on tiles in parallel,
+    // rather than on the canvas, when the surface has at least TILED_RASTER_MIN_PIXELS and there
+    // is more than one core to run them (default on). Safe from any thread,
+    // applied from the next frame on.
+    static constexpr uint64_t TILED_RASTER_MIN_PIXELS = 512 * 512;
+    void SetTiledRasterEnabled(bool enabled)
+    {
+        tiledRasterEnabled_.store(enabled, std::memory_order_relaxed);
+    }
+
+    // Anti-aliasing of filled and stroked paths (default MEDIUM). On tiles it
+    // sets the sample rows per pixel; the canvas only has on and off, so NONE
+    // turns it off there. Safe from any thread, applied from the next frame on.
+    void SetAaQuality(AaQuality quality)
+    {
+        aaQuality_.store(quality, std::memory_order_relaxed);
+    }
+    AaQuality GetAaQuality() const
+    {
+        return aaQuality_.load(std::memory_order_relaxed);
+    }
 
-    // Register callbacks with XComponent
+    // Draw static content (the pattern, the text frame, and display-list
+    // layers) into layers of its own once, and composite those onto later
+    // frames, rather than drawing it every frame. Off by default: everything
+    // is drawn each frame through OH_Drawing, or on tiles. A layer is drawn
+    // again when the surface size, what it draws or the anti-aliasing
+    // quality change, or after InvalidateLayers(). Both are safe from any
+    // thread and applied from the next frame on.
+    void SetLayerCacheEnabled(bool enabled)
+    {
+        layerCacheEnabled_.store(enabled, std::memory_order_relaxed);
+    }
+    void InvalidateLayers()
+    {
+        layersInvalidated_.store(true, std::memory_order_relaxed);
+    }
+
+    // Whether the surface is on screen (default true) and has input focus
+    // (default false). Frames of every surface share the CPU through
+    // RasterScheduler: focused surfaces go first, hidden ones are drawn at
+    // most every RasterScheduler::BACKGROUND_FRAME_INTERVAL, off the shared
+    // workers. Safe from any thread, applied from the next frame on.
+    void SetVisible(bool visible)
+    {
+        visible_.store(visible, std::memory_order_relaxed);
+        // A frame held back while hidden is drawn at the next vsync
+        if (visible) {
+            frameScheduler_.ResumeFrame();
+        }
+    }
+    void SetFocused(bool focused)
+    {
+        focused_.store(focused, std::memory_order_relaxed);
+    }
+    SurfacePriority GetSurfacePriority() const;
+
+    // Drop all cached buffer mappings; the next frame maps the new buffers
+    void ResetBufferPool();
+
+    // Window buffers in flight: the one on screen, the one being drawn and
+    // any requested ahead while a frame rasters. 2 is double buffering, 3
+    // (the default) triple. Clamped to 2..MAX_BUFFERS_IN_FLIGHT; safe from
+    // any thread, applied from the next frame on.
+    static constexpr uint32_t MIN_BUFFERS_IN_FLIGHT = 2;
+    static constexpr uint32_t MAX_BUFFERS_IN_FLIGHT = 4;
+    void SetBuffersInFlight(uint32_t count);
+    uint32_t GetBuffersInFlight() const
+    {
+        return buffersInFlight_.load(std::memory_order_relaxed);
+    }
+
+    // Drop the cached bitmap, canvas, pens, brushes, path and layers; they
+    // are re-created at the current size by the next frame
+    void InvalidateDrawingResources();
+
+    // Staging memory allocations so far; safe to read from any thread
+    uint64_t GetStagingAllocations() const
+    {
+        return stagingMemory_.GetAllocations();
+    }
+
+    // Register callbacks with XComponent, and remember it for FindInstance.
+    // Defined with the NAPI glue, in sample_bitmap_napi.cpp.
     void RegisterCallback(OH_NativeXComponent* nativeXComponent);
+    void BindComponent(OH_NativeXComponent* nativeXComponent);
+    const std::string& GetId() const
+    {
+        return id_;
+    }
+    const OH_NativeXComponent* GetComponent() const
+    {
+        return component_.load(std::memory_order_acquire);
+    }
+
+    // Drawing methods, run on the render thread. They return whether a frame
+    // was presented; GetFrameTiming() then describes that frame.
+    bool DrawPattern();
+    bool DrawText();
+    bool DrawDisplayList(const std::shared_ptr<const DisplayList>& list);
+    bool DrawInk();
+    const FrameTiming& GetFrameTiming() const
+    {
+        return frameTiming_;
+    }
+
+    // Path cache counters; safe to read from any thread
+    GeometryCacheStats GetPathCacheStats() const
+    {
+        return pathCache_.GetStats();
+    }
+
+    // Layers drawn and composited; safe to read from any thread
+    LayerCacheStats GetLayerCacheStats() const
+    {
+        return layerCache_.GetStats();
+    }
+
+    // Per-frame arena use; steadyAllocations stays 0 once frames stop
+    // growing. Safe to read from any thread.
+    FrameArenaStats GetFrameArenaStats() const
+    {
+        return frameArena_.GetStats();
+    }
+
+    // Draw requests, frames and skipped vsyncs; safe to read from any thread
+    FrameSchedulerStats GetFrameSchedulerStats() const
+    {
+        return frameScheduler_.GetStats();
+    }
+
+    // Phase percentiles over the latest frames, and frames lost or late;
+    // safe to read from any thread
+    FrameStatsSummary GetFrameStats() const
+    {
+        FrameStatsSummary summary = frameStats_.Summarize();
+        FrameSchedulerStats scheduler = frameScheduler_.GetStats();
+        summary.skipped = scheduler.skipped;
+        summary.throttled = scheduler.throttled;
+        return summary;
+    }
+
+    // Queue work for the render thread. Draw requests are dropped, returning
+    // false, if the queue is full (each one redraws the whole frame, so a later
+    // one supersedes it); surface lifecycle commands always get through.
+    // Everything is refused once the instance has been released.
+    // Draws are not run one by one: all those that arrive within one vsync
+    // interval become a single frame, drawn after the next vsync.
+    // Safe from any thread; each thread's commands run in its order.
+    bool PostCommand(const RenderCommand& command);
 
-    // Drawing methods
-    void DrawPattern();
-    void DrawText();
+    // Where async draw requests (a non-null payload on a draw command) go
+    // once done. Set once, before the first of them is posted, by callers
+    // that agree among themselves who sets it; destroyed by Shutdown after
+    // the render thread has stopped.
+    void SetFrameListener(std::unique_ptr<FrameListener> listener);
+    FrameListener* GetFrameListener() const
+    {
+        return frameListener_.get();
+    }
 
-    // Export NAPI interface
-    void Export(napi_env env, napi_value exports);
+    // Text shown by DrawText from the next frame on (default "HELLO").
+    // Never blocks; false if the label was dropped, like a draw, because the
+    // queue is full or the instance has been released.
+    bool SetLabel(const std::string& text);
 
-    // NAPI methods for JavaScript
-    static napi_value NapiDrawPattern(napi_env env, napi_callback_info info);
-    static napi_value NapiDrawText(napi_env env, napi_callback_info info);
+    // Validate a display list and queue it for the render thread. A list that
+    // is byte-for-byte the one already on screen is not queued at all.
+    // Returns false if the list is malformed or the queue is full.
+    bool SubmitDisplayList(const void* data, size_t size);
+
+    // Native touch input, from the thread XComponent touch events arrive on.
+    // Each finger draws a stroke of ink; all the moves reported within one
+    // vsync interval become a single frame, drawn after the next vsync with
+    // each stroke extended to where its finger is predicted to be by then.
+    void PushTouch(const TouchSample& sample);
+    TouchInputStats GetTouchStats() const
+    {
+        return touchInput_.GetStats();
+    }
+
+    // Run everything still queued, draw the frame it adds up to without
+    // waiting for the vsync, and stop the render thread
+    void Shutdown();
 
 private:
     // Helper methods for drawing
     bool PrepareDrawing();
-    void FinishDrawing();
+    bool FinishDrawing();
+    bool SubmitFrame();
+    void EndFrameArena();
     void ReleaseBitmapResources();
+    bool EnsureDrawingResources();
+    void HandleCommand(const RenderCommand& command);
+    void QueueDraw(RenderCommandType type, void* payload);
+    void HandleVsync();
+    void ThrottleFrame(FrameClock::time_point wakeTime);
+    void DrawPendingFrame();
+    void BeginRaster();
+    void EndRaster();
+    bool UpdateInk();
+    void CompletePendingRequests(bool presented);
+    bool AcquireFrameBuffer();
+    bool RequestWindowBuffer(struct NativeWindowBuffer*& buffer, int& fenceFd);
+    void PrefetchBuffers();
+    bool WaitForBuffer(const char* caller);
+    void ReleaseHeldBuffer();
+    void HandleSurfaceChanged(uint64_t width, uint64_t height);
+    bool ResizeDue() const;
+    void ApplyPendingResize();
+    void ConfigureWindow();
+    void ReleaseStagingBitmap();
+    void CompleteFrameRequest(void* payload, bool presented);
+    bool EnsureStagingBitmap();
+    bool CanRenderDirect(const BufferHandle* handle) const;
+    void SetRenderPath(RenderPath path);
+    bool GetTargetSurface(PixelSurface& surface) const;
+    bool UseTiledRaster(PixelSurface& target);
+    void BeginSinkDrawing();
+    void EndSinkDrawing();
+
+    // Static geometry, built on first use at each surface size
+    const CachedPath* GetCachedPath(CachedShape shape);
+    void BuildPentagonPath(CachedPath& cached);
+    void BuildTextFramePath(CachedPath& cached);
+    static void ReleaseCachedPath(CachedPath& cached);
+    void DrawCachedPath(CachedShape id, const CachedPath& shape, OH_Drawing_Brush* brush, uint32_t fillColor,
+        OH_Drawing_Pen* pen, uint32_t strokeColor, float strokeWidth);
+    bool DrawCachedLayer(CachedShape id, const CachedPath& shape, uint32_t fillColor, uint32_t strokeColor,
+        float strokeWidth);
+    bool GetLayerTarget(PixelSurface& target);
+    bool GetLayerRect(const DrawBounds& bounds, float outset, BlitRect& rect) const;
+
+    // Dirty-region tracking
+    void ClearCanvas(uint32_t color);
+    void MarkDirty(float left, float top, float right, float bottom, float outset);
+    void ComputeFrameChange(DirtyRegion& change) const;
+    void ComputeBufferUpdate(DirtyRegion& update) const;
 
-    // XComponent callback structure
-    OH_NativeXComponent_Callback renderCallback_;
+    // DisplayListSink. Paths are built, curves flattened, in rasterPath_;
+    // draws record it into tileRasterizer_ while tiledReplay_ or
+    // layerReplay_ is set, and otherwise go through cPath_ to the canvas
+    // with cPen_ and cBrush_.
+    void Clear(uint32_t color) override;
+    void MoveTo(float x, float y) override;
+    void LineTo(float x, float y) override;
+    void QuadTo(float x1, float y1, float x2, float y2) override;
+    void CubicTo(float x1, float y1, float x2, float y2, float x3, float y3) override;
+    void ArcTo(float cx, float cy, float radius, float startAngle, float sweep) override;
+    void RoundRect(float left, float top, float right, float bottom, float radius) override;
+    void Close() override;
+    void Fill(uint32_t color, const DrawBounds& bounds) override;
+    void Stroke(uint32_t color, float width, const DrawBounds& bounds) override;
+    bool BeginLayer(uint32_t id, const DrawBounds& bounds, uint64_t content) override;
+    void EndLayer() override;
+
+    // The XComponent this instance renders for
+    const std::string id_;
+    std::atomic<OH_NativeXComponent*> component_;
 
     // Window dimensions
     uint64_t width_;
     uint64_t height_;
 
-    // Drawing resources
+    // Drawing resources, allocated once and reused across frames and sizes.
+    // cBitmap_ is the staging bitmap, only created when zero-copy is not
+    // possible: a view of stagingMemory_ at the current size.
     OH_Drawing_Bitmap* cBitmap_;
     OH_Drawing_Canvas* cCanvas_;
     OH_Drawing_Path* cPath_;
     OH_Drawing_Brush* cBrush_;
     OH_Drawing_Pen* cPen_;
+    OH_Drawing_Brush* cRectBrush_;
+    OH_Drawing_Pen* cRectPen_;
+    StagingMemory stagingMemory_;
+    uint64_t stagingWidth_;
+    uint64_t stagingHeight_;
+
+    // Size from the last SURFACE_CHANGED, applied when a frame starts, so a
+    // burst of resizes between two frames reconfigures once, and at most
+    // every RESIZE_SETTLE_TIME while a resize goes on. resizeRedraw_ marks a
+    // pending frame that only redraws the last one at the new size.
+    bool resizePending_;
+    bool resizeRedraw_;
+    uint64_t pendingWidth_;
+    uint64_t pendingHeight_;
+    FrameClock::time_point lastResize_;
+    FrameClock::time_point lastResizeApplied_;
+
+    // Built paths of the static shapes, dropped when the surface is resized
+    GeometryCache<CachedPath> pathCache_;
+
+    // DrawText label and the glyphs it is drawn with, rasterized per size
+    std::string label_;
+    GlyphAtlas glyphAtlas_;
+
+    // Transient data of the frame being drawn, taken back by FinishDrawing
+    FrameArena frameArena_;
+    uint64_t frameArenaSteadyAllocations_;
+
+    // Large surfaces draw the static shapes and display lists through this,
+    // straight into the target, recording into frameArena_
+    TileRasterizer tileRasterizer_;
+    std::atomic<bool> tiledRasterEnabled_;
+    std::atomic<AaQuality> aaQuality_;
+    RasterPath rasterPath_;
+    bool tiledReplay_;
+
+    // Static content, each drawn once into a layer of its own: the shapes
+    // keyed by their CachedShape, display-list layers by their id with
+    // LIST_LAYER_KEY set. layerPath_ is a shape moved into its layer;
+    // layerReplay_ is set while a display-list layer at layerRect_ is drawn.
+    LayerCache layerCache_;
+    std::atomic<bool> layerCacheEnabled_;
+    std::atomic<bool> layersInvalidated_;
+    RasterPath layerPath_;
+    bool layerReplay_;
+    uint32_t layerKey_;
+    BlitRect layerRect_;
+
+    // Where the surface stands in RasterScheduler. rasterTurn_ is held from
+    // the first write to the frame's pixels to the last, at framePriority_;
+    // rasterPool_ is the workers it was given, null outside it and when it
+    // has none. A throttled frame asks for its vsync again at wakeTime_.
+    std::atomic<bool> visible_;
+    std::atomic<bool> focused_;
+    SurfacePriority framePriority_;
+    std::optional<RasterScheduler::Turn> rasterTurn_;
+    WorkStealingPool* rasterPool_;
+    FrameClock::time_point lastFrameStart_;
+    bool wakeScheduled_;
+    FrameClock::time_point wakeTime_;
+
+    // Zero-copy state; renderPath_ is the path taken by the current frame
+    bool zeroCopyEnabled_;
+    RenderPath renderPath_;
+
+    // Frames whose change regions are remembered; a buffer older than this is
+    // rewritten in full
+    static constexpr int DAMAGE_HISTORY = 4;
+
+    // Dirty-region state. sceneBounds_ covers what this frame drew on top of
+    // its clear color; the change between two frames is the union of both
+    // frames' scene bounds when they were cleared to the same color.
+    uint64_t frameIndex_;
+    DirtyRegion sceneBounds_;
+    DirtyRegion prevSceneBounds_;
+    uint32_t frameClearColor_;
+    uint32_t prevClearColor_;
+    bool hasPrevFrame_;
+    DirtyRegion changeHistory_[DAMAGE_HISTORY];
+    Region::Rect flushRects_[DirtyRegion::MAX_RECTS];
+
+    // Timing of the current frame
+    FrameTiming frameTiming_;
+    FrameStats frameStats_;
+    FrameClock::time_point rasterStart_;
 
     // Native window resources
     OHNativeWindow* nativeWindow_;
+    BufferPool bufferPool_;
     uint32_t* mappedAddr_;
     BufferHandle* bufferHandle_;
+    // buffer_ is held from the vsync that picked it until it is flushed.
+    // fenceFd_ is its release fence, waited on right before the first write
+    // to its pixels and -1 from then on.
     struct NativeWindowBuffer* buffer_;
     int fenceFd_;
+
+    // Buffers requested ahead of their frame, oldest first, with their
+    // release fences still unwaited
+    struct HeldBuffer {
+        struct NativeWindowBuffer* buffer;
+        int fenceFd;
+    };
+    HeldBuffer prefetched_[MAX_BUFFERS_IN_FLIGHT - MIN_BUFFERS_IN_FLIGHT];
+    uint32_t prefetchedCount_;
+    std::atomic<uint32_t> buffersInFlight_;
+
+    // The display list currently on screen, if the last frame was one. The
+    // raw pointer is published for posting threads to compare against.
+    std::shared_ptr<const DisplayList> presentedList_;
+    std::atomic<const DisplayList*> presentedListId_;
+
+    // The last list handed to the render thread, by whichever thread posts
+    std::mutex submitMutex_;
+    std::shared_ptr<const DisplayList> submittedList_;
+
+    // The frame waiting for the next vsync: what the latest draw request
+    // asked for, and the async requests that all resolve with that frame
+    bool hasPendingDraw_;
+    RenderCommandType pendingDraw_;
+    std::shared_ptr<const DisplayList> pendingList_;
+    std::vector<void*> pendingRequests_;
+
+    // Touch input and the strokes drawn from it, oldest first; render
+    // thread only but for touchInput_'s producer side
+    struct InkStroke {
+        int32_t pointer;
+        bool down;
+        std::vector<TouchPosition> points;
+        TouchPosition predicted;
+    };
+    TouchInput touchInput_;
+    TouchFrame touchFrame_;
+    std::vector<InkStroke> ink_;
+    // How far ahead touch is predicted: the measured vsync period
+    int64_t lastVsyncNs_;
+    int64_t vsyncPeriodNs_;
+
+    FrameScheduler frameScheduler_;
+
+    // Receives finished async draw requests
+    std::unique_ptr<FrameListener> frameListener_;
+
+    // Everything above is only touched on this thread once it is running
+    RenderThread renderThread_;
+
+    // Declared last so it goes first: its callback reaches into the
+    // scheduler and the render thread
+    std::unique_ptr<VsyncSource> vsyncSource_;
 };
 
 #endif // SAMPLE_BITMAP_H
\ No newline at end of file
@@ -0,0 +1,702 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+// The ArkTS-facing half of SampleBitMap: NAPI methods and XComponent
+// callbacks. The rendering itself (sample_bitmap.cpp) has no NAPI in it.
+#include "sample_bitmap_napi.h"
+#include "common/drawing_log.h"
+#include <algorithm>
+#include <mutex>
+#include <stdint.h>
+#include <utility>
+#include <vector>
+
+// The same callbacks serve every XComponent; they look up the instance
+static OH_NativeXComponent_Callback renderCallback = {
+    OnSurfaceCreatedCB, OnSurfaceChangedCB, OnSurfaceDestroyedCB, DispatchTouchEventCB};
+
+void SampleBitMap::RegisterCallback(OH_NativeXComponent* nativeXComponent)
+{
+    if (nativeXComponent == nullptr) {
+        DRAWING_LOGE("RegisterCallback: nativeXComponent is null\n");
+        return;
+    }
+
+    BindComponent(nativeXComponent);
+
+    // Register the callback with the XComponent
+    OH_NativeXComponent_RegisterCallback(nativeXComponent, &renderCallback);
+    // Focus and visibility decide the instance's share of the CPU
+    OH_NativeXComponent_RegisterFocusEventCallback(nativeXComponent, OnFocusCB);
+    OH_NativeXComponent_RegisterBlurEventCallback(nativeXComponent, OnBlurCB);
+    OH_NativeXComponent_RegisterSurfaceShowCallback(nativeXComponent, OnSurfaceShowCB);
+    OH_NativeXComponent_RegisterSurfaceHideCallback(nativeXComponent, OnSurfaceHideCB);
+}
+
+// An async draw in flight: created on the thread of the env that made it,
+// filled in on the render thread, resolved back on the first thread through
+// that env's function
+struct FrameRequest {
+    napi_deferred deferred;
+    napi_threadsafe_function resolve;
+    bool presented;
+    FrameTiming timing;
+    RenderPath path;
+};
+
+// What the NAPI methods of one exports object are bound to, through the
+// descriptor data slot: the XComponent's instance, followed to the new one
+// when the surface is destroyed and created again. Freed together with the
+// exports object.
+struct NapiBinding {
+    SampleBitMap::Binding render;
+};
+
+static void DeleteNapiBinding(napi_env env, void* data, void* hint)
+{
+    delete static_cast<NapiBinding*>(data);
+}
+
+// The instance a NAPI method is bound to, reading the arguments in the same
+// napi_get_cb_info call. Null while the XComponent has no instance.
+static std::shared_ptr<SampleBitMap> GetBoundRender(napi_env env, napi_callback_info info, size_t* argc = nullptr,
+    napi_value* args = nullptr)
+{
+    void* data = nullptr;
+    napi_get_cb_info(env, info, argc, args, nullptr, &data);
+    NapiBinding* binding = static_cast<NapiBinding*>(data);
+    return (binding != nullptr) ? binding->render.Get() : nullptr;
+}
+
+static void RejectWithMessage(napi_env env, napi_deferred deferred, const char* message)
+{
+    napi_value msg;
+    napi_value error;
+    napi_create_string_utf8(env, message, NAPI_AUTO_LENGTH, &msg);
+    napi_create_error(env, nullptr, msg, &error);
+    napi_reject_deferred(env, deferred, error);
+}
+
+static void SetUint32Property(napi_env env, napi_value object, const char* name, uint32_t value)
+{
+    napi_value prop;
+    napi_create_uint32(env, value, &prop);
+    napi_set_named_property(env, object, name, prop);
+}
+
+// Runs on the thread of the env that made the request, for every completed
+// async draw
+static void ResolveFrameRequest(napi_env env, napi_value jsCallback, void* context, void* data)
+{
+    FrameRequest* request = static_cast<FrameRequest*>(data);
+    if (request == nullptr) {
+        return;
+    }
+    // env is null when the function is being torn down; the promise is abandoned
+    if (env != nullptr) {
+        if (request->presented) {
+            const FrameTiming& t = request->timing;
+            napi_value result;
+            napi_create_object(env, &result);
+            SetUint32Property(env, result, "acquireUs", t.acquireUs);
+            SetUint32Property(env, result, "prepareUs", t.prepareUs);
+            SetUint32Property(env, result, "rasterUs", t.rasterUs);
+            SetUint32Property(env, result, "blitUs", t.blitUs);
+            SetUint32Property(env, result, "flushUs", t.flushUs);
+            SetUint32Property(env, result, "totalUs", t.totalUs);
+            SetUint32Property(env, result, "slotUs", t.slotUs);
+            napi_value path;
+            napi_create_string_utf8(env, (request->path == RenderPath::ZERO_COPY) ? "zero-copy" : "staging",
+                NAPI_AUTO_LENGTH, &path);
+            napi_set_named_property(env, result, "renderPath", path);
+            napi_resolve_deferred(env, request->deferred, result);
+        } else {
+            RejectWithMessage(env, request->deferred, "frame was not presented");
+        }
+    }
+    delete request;
+}
+
+// Hands finished frames back to the thread that asked for them, which
+// resolves their Promises. Draws may come from the ArkTS main thread and
+// from workers alike, each with an env, and a function, of its own.
+class NapiFrameListener : public FrameListener {
+public:
+    NapiFrameListener() = default;
+
+    ~NapiFrameListener() noexcept override
+    {
+        // The render thread has stopped; every result has been handed over
+        for (const auto& function : functions_) {
+            napi_release_threadsafe_function(function.second, napi_tsfn_release);
+        }
+    }
+
+    // The function resolving env's Promises, created on first use. On env's
+    // thread; null if it cannot be created.
+    napi_threadsafe_function GetFunction(napi_env env)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& function : functions_) {
+            if (function.first == env) {
+                return function.second;
+            }
+        }
+        napi_value name;
+        napi_create_string_utf8(env, "SampleBitMapFrameDone", NAPI_AUTO_LENGTH, &name);
+        napi_threadsafe_function tsfn = nullptr;
+        if (napi_create_threadsafe_function(env, nullptr, nullptr, name, 0, 1, nullptr, nullptr, nullptr,
+            ResolveFrameRequest, &tsfn) != napi_ok) {
+            DRAWING_LOGE("GetFunction: napi_create_threadsafe_function failed\n");
+            return nullptr;
+        }
+        // Pending frames must not keep the app alive on their own
+        napi_unref_threadsafe_function(env, tsfn);
+        functions_.emplace_back(env, tsfn);
+        return tsfn;
+    }
+
+    void OnFrameDone(void* payload, bool presented, const FrameTiming& timing, RenderPath path) override
+    {
+        FrameRequest* request = static_cast<FrameRequest*>(payload);
+        if (request == nullptr) {
+            return;
+        }
+        request->presented = presented;
+        request->timing = timing;
+        request->path = path;
+        if (napi_call_threadsafe_function(request->resolve, request, napi_tsfn_nonblocking) != napi_ok) {
+            DRAWING_LOGE_LIMITED("OnFrameDone: unable to deliver frame result\n");
+            delete request;
+        }
+    }
+
+private:
+    std::mutex mutex_;
+    std::vector<std::pair<napi_env, napi_threadsafe_function>> functions_;
+};
+
+// What resolves render's async draw Promises made on env, giving render its
+// listener on the first async draw from any thread
+static napi_threadsafe_function GetFrameFunction(napi_env env, SampleBitMap& render)
+{
+    static std::mutex listenerMutex;
+    NapiFrameListener* listener = nullptr;
+    {
+        std::lock_guard<std::mutex> lock(listenerMutex);
+        if (render.GetFrameListener() == nullptr) {
+            render.SetFrameListener(std::make_unique<NapiFrameListener>());
+        }
+        listener = static_cast<NapiFrameListener*>(render.GetFrameListener());
+    }
+    return listener->GetFunction(env);
+}
+
+// Queue an async draw and return its Promise
+static napi_value DrawAsync(napi_env env, const std::shared_ptr<SampleBitMap>& render, RenderCommandType type)
+{
+    napi_deferred deferred;
+    napi_value promise;
+    napi_create_promise(env, &deferred, &promise);
+
+    if (render == nullptr) {
+        RejectWithMessage(env, deferred, "no render instance for this XComponent");
+        return promise;
+    }
+    napi_threadsafe_function resolve = GetFrameFunction(env, *render);
+    if (resolve == nullptr) {
+        RejectWithMessage(env, deferred, "unable to create frame callback");
+        return promise;
+    }
+
+    FrameRequest* request = new FrameRequest {deferred, resolve, false, FrameTiming {}, RenderPath::NONE};
+    if (!render->PostCommand(RenderCommand {type, nullptr, 0, 0, request})) {
+        delete request;
+        RejectWithMessage(env, deferred, "render queue is full");
+    }
+    return promise;
+}
+
+// NAPI methods for JavaScript/TypeScript interop
+static napi_value NapiDrawPattern(napi_env env, napi_callback_info info)
+{
+    // Get the SampleBitMap instance and draw the pattern
+    auto render = GetBoundRender(env, info);
+    if (render != nullptr) {
+        render->PostCommand(RenderCommand {RenderCommandType::DRAW_PATTERN, nullptr, 0, 0, nullptr});
+    } else {
+        DRAWING_LOGE("NapiDrawPattern: render is nullptr\n");
+    }
+    
+    napi_value result;
+    napi_get_undefined(env, &result);
+    return result;
+}
+
+// Longest label drawText accepts, in bytes; longer ones are cut
+static constexpr size_t MAX_LABEL_LENGTH = 256;
+
+// If a NAPI text method was given a string, make it the label for the draw
+static void ApplyLabelArgument(napi_env env, size_t argc, const napi_value* args, SampleBitMap* render)
+{
+    napi_valuetype type = napi_undefined;
+    if ((argc < 1) || (napi_typeof(env, args[0], &type) != napi_ok) || (type != napi_string)) {
+        return;
+    }
+    char text[MAX_LABEL_LENGTH + 1] = {0};
+    size_t length = 0;
+    napi_get_value_string_utf8(env, args[0], text, sizeof(text), &length);
+    render->SetLabel(std::string(text, length));
+}
+
+static napi_value NapiDrawText(napi_env env, napi_callback_info info)
+{
+    // Get the SampleBitMap instance and draw text
+    size_t argc = 1;
+    napi_value args[1] = {nullptr};
+    auto render = GetBoundRender(env, info, &argc, args);
+    if (render != nullptr) {
+        ApplyLabelArgument(env, argc, args, render.get());
+        render->PostCommand(RenderCommand {RenderCommandType::DRAW_TEXT, nullptr, 0, 0, nullptr});
+    } else {
+        DRAWING_LOGE("NapiDrawText: render is nullptr\n");
+    }
+    
+    napi_value result;
+    napi_get_undefined(env, &result);
+    return result;
+}
+
+static napi_value NapiDrawPatternAsync(napi_env env, napi_callback_info info)
+{
+    return DrawAsync(env, GetBoundRender(env, info), RenderCommandType::DRAW_PATTERN);
+}
+
+static napi_value NapiDrawTextAsync(napi_env env, napi_callback_info info)
+{
+    size_t argc = 1;
+    napi_value args[1] = {nullptr};
+    auto render = GetBoundRender(env, info, &argc, args);
+    if (render != nullptr) {
+        ApplyLabelArgument(env, argc, args, render.get());
+    }
+    return DrawAsync(env, render, RenderCommandType::DRAW_TEXT);
+}
+
+static napi_value NapiDrawDisplayList(napi_env env, napi_callback_info info)
+{
+    size_t argc = 1;
+    napi_value args[1] = {nullptr};
+    auto render = GetBoundRender(env, info, &argc, args);
+
+    bool submitted = false;
+    bool isArrayBuffer = false;
+    if ((argc >= 1) && (napi_is_arraybuffer(env, args[0], &isArrayBuffer) == napi_ok) && isArrayBuffer) {
+        void* data = nullptr;
+        size_t size = 0;
+        napi_get_arraybuffer_info(env, args[0], &data, &size);
+        if (render != nullptr) {
+            submitted = render->SubmitDisplayList(data, size);
+        } else {
+            DRAWING_LOGE("NapiDrawDisplayList: render is nullptr\n");
+        }
+    } else {
+        DRAWING_LOGE("NapiDrawDisplayList: expected an ArrayBuffer\n");
+    }
+
+    napi_value result;
+    napi_get_boolean(env, submitted, &result);
+    return result;
+}
+
+static void SetUint64Property(napi_env env, napi_value object, const char* name, uint64_t value)
+{
+    napi_value prop;
+    napi_create_int64(env, static_cast<int64_t>(value), &prop);
+    napi_set_named_property(env, object, name, prop);
+}
+
+static napi_value NapiGetPathCacheStats(napi_env env, napi_callback_info info)
+{
+    auto render = GetBoundRender(env, info);
+    if (render == nullptr) {
+        DRAWING_LOGE("NapiGetPathCacheStats: render is nullptr\n");
+        napi_value result;
+        napi_get_undefined(env, &result);
+        return result;
+    }
+
+    GeometryCacheStats stats = render->GetPathCacheStats();
+    napi_value result;
+    napi_create_object(env, &result);
+    SetUint64Property(env, result, "hits", stats.hits);
+    SetUint64Property(env, result, "misses", stats.misses);
+    SetUint64Property(env, result, "evictions", stats.evictions);
+    SetUint32Property(env, result, "size", stats.size);
+    SetUint32Property(env, result, "capacity", stats.capacity);
+    return result;
+}
+
+static napi_value NapiGetLayerCacheStats(napi_env env, napi_callback_info info)
+{
+    auto render = GetBoundRender(env, info);
+    if (render == nullptr) {
+        DRAWING_LOGE("NapiGetLayerCacheStats: render is nullptr\n");
+        napi_value result;
+        napi_get_undefined(env, &result);
+        return result;
+    }
+
+    LayerCacheStats stats = render->GetLayerCacheStats();
+    napi_value result;
+    napi_create_object(env, &result);
+    SetUint64Property(env, result, "builds", stats.builds);
+    SetUint64Property(env, result, "composites", stats.composites);
+    SetUint64Property(env, result, "invalidations", stats.invalidations);
+    SetUint32Property(env, result, "layers", stats.layers);
+    SetUint64Property(env, result, "bytes", stats.bytes);
+    return result;
+}
+
+static napi_value NapiSetLayerCacheEnabled(napi_env env, napi_callback_info info)
+{
+    size_t argc = 1;
+    napi_value args[1] = {nullptr};
+    auto render = GetBoundRender(env, info, &argc, args);
+    bool enabled = false;
+    if (render == nullptr) {
+        DRAWING_LOGE("NapiSetLayerCacheEnabled: render is nullptr\n");
+    } else if ((argc < 1) || (napi_get_value_bool(env, args[0], &enabled) != napi_ok)) {
+        DRAWING_LOGE("NapiSetLayerCacheEnabled: expected a boolean\n");
+    } else {
+        render->SetLayerCacheEnabled(enabled);
+    }
+
+    napi_value result;
+    napi_get_undefined(env, &result);
+    return result;
+}
+
+static napi_value NapiInvalidateLayers(napi_env env, napi_callback_info info)
+{
+    auto render = GetBoundRender(env, info);
+    if (render != nullptr) {
+        render->InvalidateLayers();
+    } else {
+        DRAWING_LOGE("NapiInvalidateLayers: render is nullptr\n");
+    }
+
+    napi_value result;
+    napi_get_undefined(env, &result);
+    return result;
+}
+
+// { p50Us, p95Us, p99Us } under name
+static void SetPercentilesProperty(napi_env env, napi_value object, const char* name, const FramePercentiles& value)
+{
+    napi_value prop;
+    napi_create_object(env, &prop);
+    SetUint32Property(env, prop, "p50Us", value.p50Us);
+    SetUint32Property(env, prop, "p95Us", value.p95Us);
+    SetUint32Property(env, prop, "p99Us", value.p99Us);
+    napi_set_named_property(env, object, name, prop);
+}
+
+static napi_value NapiGetFrameStats(napi_env env, napi_callback_info info)
+{
+    auto render = GetBoundRender(env, info);
+    if (render == nullptr) {
+        DRAWING_LOGE("NapiGetFrameStats: render is nullptr\n");
+        napi_value result;
+        napi_get_undefined(env, &result);
+        return result;
+    }
+
+    FrameStatsSummary stats = render->GetFrameStats();
+    napi_value result;
+    napi_create_object(env, &result);
+    SetUint32Property(env, result, "sampled", stats.sampled);
+    SetPercentilesProperty(env, result, "acquire", stats.acquire);
+    SetPercentilesProperty(env, result, "prepare", stats.prepare);
+    SetPercentilesProperty(env, result, "raster", stats.raster);
+    SetPercentilesProperty(env, result, "blit", stats.blit);
+    SetPercentilesProperty(env, result, "flush", stats.flush);
+    SetPercentilesProperty(env, result, "total", stats.total);
+    SetPercentilesProperty(env, result, "slot", stats.slot);
+    SetUint64Property(env, result, "presented", stats.presented);
+    SetUint64Property(env, result, "late", stats.late);
+    SetUint64Property(env, result, "dropped", stats.dropped);
+    SetUint64Property(env, result, "skipped", stats.skipped);
+    SetUint64Property(env, result, "throttled", stats.throttled);
+    return result;
+}
+
+static napi_value NapiSetBuffersInFlight(napi_env env, napi_callback_info info)
+{
+    size_t argc = 1;
+    napi_value args[1] = {nullptr};
+    auto render = GetBoundRender(env, info, &argc, args);
+    uint32_t count = 0;
+    if (render == nullptr) {
+        DRAWING_LOGE("NapiSetBuffersInFlight: render is nullptr\n");
+    } else if ((argc < 1) || (napi_get_value_uint32(env, args[0], &count) != napi_ok)) {
+        DRAWING_LOGE("NapiSetBuffersInFlight: expected a number\n");
+    } else {
+        render->SetBuffersInFlight(count);
+    }
+
+    napi_value result;
+    napi_get_undefined(env, &result);
+    return result;
+}
+
+static napi_value NapiSetVisible(napi_env env, napi_callback_info info)
+{
+    size_t argc = 1;
+    napi_value args[1] = {nullptr};
+    auto render = GetBoundRender(env, info, &argc, args);
+    bool visible = true;
+    if (render == nullptr) {
+        DRAWING_LOGE("NapiSetVisible: render is nullptr\n");
+    } else if ((argc < 1) || (napi_get_value_bool(env, args[0], &visible) != napi_ok)) {
+        DRAWING_LOGE("NapiSetVisible: expected a boolean\n");
+    } else {
+        render->SetVisible(visible);
+    }
+
+    napi_value result;
+    napi_get_undefined(env, &result);
+    return result;
+}
+
+static napi_value NapiSetAaQuality(napi_env env, napi_callback_info info)
+{
+    size_t argc = 1;
+    napi_value args[1] = {nullptr};
+    auto render = GetBoundRender(env, info, &argc, args);
+    uint32_t level = 0;
+    if (render == nullptr) {
+        DRAWING_LOGE("NapiSetAaQuality: render is nullptr\n");
+    } else if ((argc < 1) || (napi_get_value_uint32(env, args[0], &level) != napi_ok) ||
+        (level > static_cast<uint32_t>(AaQuality::HIGH))) {
+        DRAWING_LOGE("NapiSetAaQuality: expected 0 (none) to 3 (high)\n");
+    } else {
+        render->SetAaQuality(static_cast<AaQuality>(level));
+    }
+
+    napi_value result;
+    napi_get_undefined(env, &result);
+    return result;
+}
+
+void ExportSampleBitMap(napi_env env, napi_value exports, const std::shared_ptr<SampleBitMap>& render)
+{
+    if ((env == nullptr) || (exports == nullptr) || (render == nullptr)) {
+        DRAWING_LOGE("Export: env, exports or render is null\n");
+        return;
+    }
+
+    // Bind the methods to this instance once; the binding lives as long as exports
+    NapiBinding* binding = new NapiBinding {SampleBitMap::Bind(render)};
+    if (napi_add_finalizer(env, exports, binding, DeleteNapiBinding, nullptr, nullptr) != napi_ok) {
+        DRAWING_LOGE("Export: napi_add_finalizer failed\n");
+        delete binding;
+        return;
+    }
+
+    // Define JavaScript methods
+    napi_property_descriptor desc[] = {
+        {"drawPattern", nullptr, NapiDrawPattern, nullptr, nullptr, nullptr, napi_default, binding},
+        {"drawText", nullptr, NapiDrawText, nullptr, nullptr, nullptr, napi_default, binding},
+        {"drawPatternAsync", nullptr, NapiDrawPatternAsync, nullptr, nullptr, nullptr, napi_default, binding},
+        {"drawTextAsync", nullptr, NapiDrawTextAsync, nullptr, nullptr, nullptr, napi_default, binding},
+        {"drawDisplayList", nullptr, NapiDrawDisplayList, nullptr, nullptr, nullptr, napi_default, binding},
+        {"getPathCacheStats", nullptr, NapiGetPathCacheStats, nullptr, nullptr, nullptr, napi_default, binding},
+        {"getLayerCacheStats", nullptr, NapiGetLayerCacheStats, nullptr, nullptr, nullptr, napi_default, binding},
+        {"setLayerCacheEnabled", nullptr, NapiSetLayerCacheEnabled, nullptr, nullptr, nullptr, napi_default, binding},
+        {"invalidateLayers", nullptr, NapiInvalidateLayers, nullptr, nullptr, nullptr, napi_default, binding},
+        {"getFrameStats", nullptr, NapiGetFrameStats, nullptr, nullptr, nullptr, napi_default, binding},
+        {"setBuffersInFlight", nullptr, NapiSetBuffersInFlight, nullptr, nullptr, nullptr, napi_default, binding},
+        {"setAaQuality", nullptr, NapiSetAaQuality, nullptr, nullptr, nullptr, napi_default, binding},
+        {"setVisible", nullptr, NapiSetVisible, nullptr, nullptr, nullptr, napi_default, binding}
+    };
+
+    // Register methods
+    if (napi_define_properties(env, exports, sizeof(desc) / sizeof(desc[0]), desc) != napi_ok) {
+        DRAWING_LOGE("Export: napi_define_properties failed\n");
+    }
+}
+
+// Callback functions
+void OnSurfaceCreatedCB(OH_NativeXComponent* component, void* window)
+{
+    if ((component == nullptr) || (window == nullptr)) {
+        DRAWING_LOGE("OnSurfaceCreatedCB: component or window is null\n");
+        return;
+    }
+    
+    // Obtain an OHNativeWindow instance
+    OHNativeWindow* nativeWindow = static_cast<OHNativeWindow*>(window);
+    
+    // Bound to the XComponent at Export time
+    auto render = SampleBitMap::FindInstance(component);
+    if (render == nullptr) {
+        // Released when an earlier surface was destroyed: start over for the same XComponent
+        char idStr[OH_XCOMPONENT_ID_LEN_MAX + 1] = {'\0'};
+        uint64_t idSize = OH_XCOMPONENT_ID_LEN_MAX + 1;
+        if (OH_NativeXComponent_GetXComponentId(component, idStr, &idSize) != OH_NATIVEXCOMPONENT_RESULT_SUCCESS) {
+            DRAWING_LOGE("OnSurfaceCreatedCB: Unable to get XComponent id\n");
+            return;
+        }
+        std::string id(idStr);
+        render = SampleBitMap::GetInstance(id);
+        render->BindComponent(component);
+    }
+    
+    // Get the size of the XComponent
+    uint64_t width = 0;
+    uint64_t height = 0;
+    int32_t xSize = OH_NativeXComponent_GetXComponentSize(component, window, &width, &height);
+    if (render != nullptr) {
+        // The render thread owns the window from here on
+        render->PostCommand(RenderCommand {RenderCommandType::SURFACE_CREATED, nativeWindow, width, height, nullptr});
+    }
+    if ((xSize == OH_NATIVEXCOMPONENT_RESULT_SUCCESS) && (render != nullptr)) {
+        DRAWING_LOGI("xComponent width = %lu, height = %lu\n", width, height);
+    }
+}
+
+void OnSurfaceChangedCB(OH_NativeXComponent* component, void* window)
+{
+    if ((component == nullptr) || (window == nullptr)) {
+        DRAWING_LOGE("OnSurfaceChangedCB: component or window is null\n");
+        return;
+    }
+    
+    // Bound to the XComponent at Export time
+    auto render = SampleBitMap::FindInstance(component);
+    
+    // Get the new size of the XComponent
+    uint64_t width;
+    uint64_t height;
+    int32_t xSize = OH_NativeXComponent_GetXComponentSize(component, window, &width, &height);
+    if ((xSize == OH_NATIVEXCOMPONENT_RESULT_SUCCESS) && (render != nullptr)) {
+        render->PostCommand(RenderCommand {RenderCommandType::SURFACE_CHANGED, window, width, height, nullptr});
+        DRAWING_LOGI("Surface Changed: xComponent width = %lu, height = %lu\n", width, height);
+    }
+}
+
+void OnSurfaceDestroyedCB(OH_NativeXComponent* component, void* window)
+{
+    if ((component == nullptr) || (window == nullptr)) {
+        DRAWING_LOGE("OnSurfaceDestroyedCB: component or window is null\n");
+        return;
+    }
+    
+    // Bound to the XComponent at Export time
+    auto render = SampleBitMap::FindInstance(component);
+    if (render == nullptr) {
+        DRAWING_LOGE("OnSurfaceDestroyedCB: no instance for this XComponent\n");
+        return;
+    }
+    // Queued after any pending draws; Release below waits for all of them
+    render->PostCommand(RenderCommand {RenderCommandType::SURFACE_DESTROYED, window, 0, 0, nullptr});
+    SampleBitMap::Release(render->GetId());
+    DRAWING_LOGI("OnSurfaceDestroyedCB: Released instance for id %s\n", render->GetId().c_str());
+}
+
+static bool ToTouchAction(OH_NativeXComponent_TouchEventType type, TouchAction& action)
+{
+    switch (type) {
+        case OH_NATIVEXCOMPONENT_DOWN:
+            action = TouchAction::DOWN;
+            return true;
+        case OH_NATIVEXCOMPONENT_UP:
+            action = TouchAction::UP;
+            return true;
+        case OH_NATIVEXCOMPONENT_MOVE:
+            action = TouchAction::MOVE;
+            return true;
+        case OH_NATIVEXCOMPONENT_CANCEL:
+            action = TouchAction::CANCEL;
+            return true;
+        default:
+            return false;
+    }
+}
+
+void DispatchTouchEventCB(OH_NativeXComponent* component, void* window)
+{
+    if ((component == nullptr) || (window == nullptr)) {
+        DRAWING_LOGE_LIMITED("DispatchTouchEventCB: component or window is null\n");
+        return;
+    }
+    auto render = SampleBitMap::FindInstance(component);
+    if (render == nullptr) {
+        return;
+    }
+    OH_NativeXComponent_TouchEvent touchEvent;
+    if (OH_NativeXComponent_GetTouchEvent(component, window, &touchEvent) != OH_NATIVEXCOMPONENT_RESULT_SUCCESS) {
+        DRAWING_LOGE_LIMITED("DispatchTouchEventCB: GetTouchEvent failed\n");
+        return;
+    }
+
+    // The event is for the pointer that changed; on a move the others that
+    // are down have moved too, and are passed on as well
+    TouchAction action;
+    if (ToTouchAction(touchEvent.type, action)) {
+        render->PushTouch(TouchSample {touchEvent.id, action, touchEvent.x, touchEvent.y, touchEvent.timeStamp});
+    }
+    if (touchEvent.type != OH_NATIVEXCOMPONENT_MOVE) {
+        return;
+    }
+    uint32_t count = std::min<uint32_t>(touchEvent.numPoints, OH_MAX_TOUCH_POINTS_NUMBER);
+    for (uint32_t i = 0; i < count; i++) {
+        const OH_NativeXComponent_TouchPoint& point = touchEvent.touchPoints[i];
+        if ((point.id != touchEvent.id) && point.isPressed) {
+            render->PushTouch(TouchSample {point.id, TouchAction::MOVE, point.x, point.y, touchEvent.timeStamp});
+        }
+    }
+}
+
+// Focus moves between XComponents; the focused one is drawn first
+void OnFocusCB(OH_NativeXComponent* component, void* window)
+{
+    (void)window;
+    auto render = SampleBitMap::FindInstance(component);
+    if (render != nullptr) {
+        render->SetFocused(true);
+    }
+}
+
+void OnBlurCB(OH_NativeXComponent* component, void* window)
+{
+    (void)window;
+    auto render = SampleBitMap::FindInstance(component);
+    if (render != nullptr) {
+        render->SetFocused(false);
+    }
+}
+
+// The surface outlives being hidden (e.g. the app in the background); its
+// frames are throttled until it shows again. ArkTS can do the same for
+// surfaces scrolled offscreen with setVisible().
+void OnSurfaceShowCB(OH_NativeXComponent* component, void* window)
+{
+    (void)window;
+    auto render = SampleBitMap::FindInstance(component);
+    if (render != nullptr) {
+        render->SetVisible(true);
+    }
+}
+
+void OnSurfaceHideCB(OH_NativeXComponent* component, void* window)
+{
+    (void)window;
+    auto render = SampleBitMap::FindInstance(component);
+    if (render != nullptr) {
+        render->SetVisible(false);
+    }
+}
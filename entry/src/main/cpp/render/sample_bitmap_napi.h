@@ -0,0 +1,28 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#ifndef SAMPLE_BITMAP_NAPI_H
+#define SAMPLE_BITMAP_NAPI_H
+
+#include <ace/xcomponent/native_interface_xcomponent.h>
+#include "napi/native_api.h"
+#include "sample_bitmap.h"
+#include <memory>
+
+// XComponent callbacks; they find the instance by component
+void OnSurfaceCreatedCB(OH_NativeXComponent* component, void* window);
+void OnSurfaceChangedCB(OH_NativeXComponent* component, void* window);
+void OnSurfaceDestroyedCB(OH_NativeXComponent* component, void* window);
+void DispatchTouchEventCB(OH_NativeXComponent* component, void* window);
+void OnFocusCB(OH_NativeXComponent* component, void* window);
+void OnBlurCB(OH_NativeXComponent* component, void* window);
+void OnSurfaceShowCB(OH_NativeXComponent* component, void* window);
+void OnSurfaceHideCB(OH_NativeXComponent* component, void* window);
+
+// Define the NAPI methods of render on exports. They are bound to render
+// through their data slot, so calling one does no id lookup.
+void ExportSampleBitMap(napi_env env, napi_value exports, const std::shared_ptr<SampleBitMap>& render);
+
+#endif // SAMPLE_BITMAP_NAPI_H
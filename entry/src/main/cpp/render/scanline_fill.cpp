@@ -0,0 +1,228 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#include "scanline_fill.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#define SCANLINE_FILL_X86 1
+#include <emmintrin.h>
+#elif defined(__aarch64__) || defined(__ARM_NEON)
+#define SCANLINE_FILL_NEON 1
+#include <arm_neon.h>
+#endif
+
+namespace {
+
+using ResolveFn = void (*)(int32_t* cells, uint32_t count, uint32_t alpha, uint8_t* coverage);
+// channels are the source bytes in the surface's memory order
+using BlendFn = void (*)(uint8_t* pixels, const uint8_t* coverage, uint32_t count, const uint8_t* channels);
+
+struct FillKernels {
+    ResolveFn resolve;
+    BlendFn blend;
+};
+
+// From cell i on, with sum the coverage up to it
+void ResolveTail(int32_t* cells, uint32_t i, uint32_t count, int32_t sum, uint32_t alpha, uint8_t* coverage)
+{
+    for (; i < count; i++) {
+        sum += cells[i];
+        cells[i] = 0;
+        uint32_t c = static_cast<uint32_t>(std::min(std::max(sum, 0), COVERAGE_FULL - 1));
+        coverage[i] = static_cast<uint8_t>((c * alpha + COVERAGE_FULL / 2) >> 16);
+    }
+    cells[count] = 0;
+    cells[count + 1] = 0;
+}
+
+void ResolveScalar(int32_t* cells, uint32_t count, uint32_t alpha, uint8_t* coverage)
+{
+    ResolveTail(cells, 0, count, 0, alpha, coverage);
+}
+
+inline uint8_t BlendChannel(uint32_t src, uint32_t dst, uint32_t a)
+{
+    return static_cast<uint8_t>((src * a + dst * (255 - a) + 127) / 255);
+}
+
+void BlendScalar(uint8_t* pixels, const uint8_t* coverage, uint32_t count, const uint8_t* channels)
+{
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t a = coverage[i];
+        if (a == 0) {
+            continue;
+        }
+        uint8_t* out = pixels + i * 4;
+        for (int c = 0; c < 4; c++) {
+            out[c] = BlendChannel(channels[c], out[c], a);
+        }
+    }
+}
+
+#if defined(SCANLINE_FILL_X86)
+void ResolveSse2(int32_t* cells, uint32_t count, uint32_t alpha, uint8_t* coverage)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i maxCoverage = _mm_set1_epi32(COVERAGE_FULL - 1);
+    const __m128i bias = _mm_set1_epi32(0x8000);
+    const __m128i signFlip = _mm_set1_epi16(static_cast<int16_t>(0x8000));
+    const __m128i scale = _mm_set1_epi16(static_cast<int16_t>(alpha));
+    __m128i carry = zero;
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(cells + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(cells + i), zero);
+        // Running sum across the four lanes, then on from the last group
+        v = _mm_add_epi32(v, _mm_slli_si128(v, 4));
+        v = _mm_add_epi32(v, _mm_slli_si128(v, 8));
+        v = _mm_add_epi32(v, carry);
+        carry = _mm_shuffle_epi32(v, 0xFF);
+        // Clamp to [0, COVERAGE_FULL - 1]
+        v = _mm_andnot_si128(_mm_srai_epi32(v, 31), v);
+        __m128i over = _mm_cmpgt_epi32(v, maxCoverage);
+        v = _mm_or_si128(_mm_andnot_si128(over, v), _mm_and_si128(over, maxCoverage));
+        // To unsigned 16 bits through the signed saturating pack
+        __m128i c = _mm_xor_si128(_mm_packs_epi32(_mm_sub_epi32(v, bias), zero), signFlip);
+        // (c * alpha + 0x8000) >> 16 is the high half plus the top bit of the low one
+        __m128i a = _mm_add_epi16(_mm_mulhi_epu16(c, scale), _mm_srli_epi16(_mm_mullo_epi16(c, scale), 15));
+        int32_t bytes = _mm_cvtsi128_si32(_mm_packus_epi16(a, zero));
+        memcpy(coverage + i, &bytes, sizeof(bytes));
+    }
+    ResolveTail(cells, i, count, _mm_cvtsi128_si32(carry), alpha, coverage);
+}
+
+// Four 16-bit channels of two pixels
+inline __m128i BlendHalfSse2(__m128i src, __m128i dst, __m128i a)
+{
+    const __m128i full = _mm_set1_epi16(255);
+    const __m128i bias = _mm_set1_epi16(128);
+    __m128i t = _mm_add_epi16(_mm_mullo_epi16(src, a), _mm_mullo_epi16(dst, _mm_sub_epi16(full, a)));
+    t = _mm_add_epi16(t, bias);
+    // Exact (x + 127) / 255 for the whole range t can take
+    return _mm_srli_epi16(_mm_add_epi16(t, _mm_srli_epi16(t, 8)), 8);
+}
+
+void BlendSse2(uint8_t* pixels, const uint8_t* coverage, uint32_t count, const uint8_t* channels)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i src = _mm_set_epi16(channels[3], channels[2], channels[1], channels[0], channels[3],
+        channels[2], channels[1], channels[0]);
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        int32_t alphas;
+        memcpy(&alphas, coverage + i, sizeof(alphas));
+        if (alphas == 0) {
+            continue;
+        }
+        // Each pixel's alpha in all four of its channels
+        __m128i a = _mm_cvtsi32_si128(alphas);
+        a = _mm_unpacklo_epi8(a, a);
+        a = _mm_unpacklo_epi16(a, a);
+        __m128i* out = reinterpret_cast<__m128i*>(pixels + i * 4);
+        __m128i dst = _mm_loadu_si128(out);
+        __m128i lo = BlendHalfSse2(src, _mm_unpacklo_epi8(dst, zero), _mm_unpacklo_epi8(a, zero));
+        __m128i hi = BlendHalfSse2(src, _mm_unpackhi_epi8(dst, zero), _mm_unpackhi_epi8(a, zero));
+        _mm_storeu_si128(out, _mm_packus_epi16(lo, hi));
+    }
+    BlendScalar(pixels + i * 4, coverage + i, count - i, channels);
+}
+#endif // SCANLINE_FILL_X86
+
+#if defined(SCANLINE_FILL_NEON)
+void ResolveNeon(int32_t* cells, uint32_t count, uint32_t alpha, uint8_t* coverage)
+{
+    const int32x4_t zero = vdupq_n_s32(0);
+    const int32x4_t maxCoverage = vdupq_n_s32(COVERAGE_FULL - 1);
+    const uint16x4_t scale = vdup_n_u16(static_cast<uint16_t>(alpha));
+    int32x4_t carry = zero;
+    uint32_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        int32x4_t v = vld1q_s32(cells + i);
+        vst1q_s32(cells + i, zero);
+        v = vaddq_s32(v, vextq_s32(zero, v, 3));
+        v = vaddq_s32(v, vextq_s32(zero, v, 2));
+        v = vaddq_s32(v, carry);
+        carry = vdupq_n_s32(vgetq_lane_s32(v, 3));
+        uint16x4_t c = vmovn_u32(vreinterpretq_u32_s32(vminq_s32(vmaxq_s32(v, zero), maxCoverage)));
+        // Rounding narrow: (c * alpha + 0x8000) >> 16
+        uint16x4_t a = vrshrn_n_u32(vmull_u16(c, scale), 16);
+        uint32_t bytes = vget_lane_u32(vreinterpret_u32_u8(vmovn_u16(vcombine_u16(a, a))), 0);
+        memcpy(coverage + i, &bytes, sizeof(bytes));
+    }
+    ResolveTail(cells, i, count, vgetq_lane_s32(carry, 0), alpha, coverage);
+}
+
+void BlendNeon(uint8_t* pixels, const uint8_t* coverage, uint32_t count, const uint8_t* channels)
+{
+    const uint16x8_t bias = vdupq_n_u16(128);
+    uint32_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        uint8x8_t a = vld1_u8(coverage + i);
+        if (vget_lane_u64(vreinterpret_u64_u8(a), 0) == 0) {
+            continue;
+        }
+        uint8x8_t inverse = vmvn_u8(a);
+        uint8x8x4_t px = vld4_u8(pixels + i * 4);
+        for (int c = 0; c < 4; c++) {
+            uint16x8_t t = vmlal_u8(vmull_u8(vdup_n_u8(channels[c]), a), px.val[c], inverse);
+            t = vaddq_u16(t, bias);
+            px.val[c] = vshrn_n_u16(vsraq_n_u16(t, t, 8), 8);
+        }
+        vst4_u8(pixels + i * 4, px);
+    }
+    BlendScalar(pixels + i * 4, coverage + i, count - i, channels);
+}
+#endif // SCANLINE_FILL_NEON
+
+FillKernels KernelsFor(BlitIsa isa)
+{
+    switch (isa) {
+#if defined(SCANLINE_FILL_X86)
+        // Rows are at most a tile wide; AVX2 gains nothing over SSE2 there
+        case BlitIsa::SSE2:
+        case BlitIsa::AVX2:
+            return {ResolveSse2, BlendSse2};
+#endif
+#if defined(SCANLINE_FILL_NEON)
+        case BlitIsa::NEON:
+            return {ResolveNeon, BlendNeon};
+#endif
+        default:
+            return {ResolveScalar, BlendScalar};
+    }
+}
+
+} // namespace
+
+uint32_t GetAaSampleRows(AaQuality quality)
+{
+    switch (quality) {
+        case AaQuality::NONE:
+            return 1;
+        case AaQuality::LOW:
+            return 2;
+        case AaQuality::HIGH:
+            return 16;
+        case AaQuality::MEDIUM:
+        default:
+            return 4;
+    }
+}
+
+void ResolveCoverage(int32_t* cells, uint32_t count, uint32_t alpha, uint8_t* coverage)
+{
+    KernelsFor(GetBlitIsa()).resolve(cells, count, alpha, coverage);
+}
+
+void BlendCoverage(uint8_t* pixels, const uint8_t* coverage, uint32_t count, uint32_t color, PixelFormat format)
+{
+    uint8_t red = static_cast<uint8_t>(color >> 16);
+    uint8_t blue = static_cast<uint8_t>(color);
+    bool bgra = format == PixelFormat::BGRA_8888;
+    const uint8_t channels[4] = {bgra ? blue : red, static_cast<uint8_t>(color >> 8), bgra ? red : blue, 255};
+    KernelsFor(GetBlitIsa()).blend(pixels, coverage, count, channels);
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#ifndef SCANLINE_FILL_H
+#define SCANLINE_FILL_H
+
+#include "pixel_blit.h"
+#include <cmath>
+#include <cstdint>
+
+// Anti-aliasing of the native polygon filler: how many sample rows each
+// pixel row is cut into. Every level but NONE measures horizontal coverage
+// exactly, to 1/COVERAGE_SUBPIXELS of a pixel.
+enum class AaQuality {
+    // One sample row, edges snapped to whole pixels: no anti-aliasing
+    NONE,
+    // 2 sample rows
+    LOW,
+    // 4 sample rows (the default)
+    MEDIUM,
+    // 16 sample rows
+    HIGH,
+};
+
+uint32_t GetAaSampleRows(AaQuality quality);
+
+// Span ends are placed in 1/COVERAGE_SUBPIXELS steps, and a fully covered
+// pixel accumulates COVERAGE_FULL whatever the number of sample rows.
+//
+// A row of coverage is a run of int32 cells holding the change in coverage
+// from the previous cell: a span adds its start and subtracts its end, split
+// between the two cells either side by subpixel position, and resolving the
+// row is a running sum. Spans cost the same whatever their length, and the
+// running sum, the conversion to alpha and the blend are done with the same
+// SIMD instruction set as the blit kernels (see GetBlitIsa()).
+constexpr int32_t COVERAGE_SUBPIXELS = 256;
+constexpr int32_t COVERAGE_FULL = 65536;
+
+// Coverage weight of one span for the given number of sample rows
+inline int32_t GetSampleWeight(uint32_t sampleRows)
+{
+    return COVERAGE_FULL / (COVERAGE_SUBPIXELS * static_cast<int32_t>(sampleRows));
+}
+
+// x, in pixels, to the nearest subpixel; to the nearest whole pixel when snapped
+inline int32_t ToSubpixel(float x, bool snap)
+{
+    int32_t sub = static_cast<int32_t>(std::lrint(x * COVERAGE_SUBPIXELS));
+    return snap ? ((sub + COVERAGE_SUBPIXELS / 2) & ~(COVERAGE_SUBPIXELS - 1)) : sub;
+}
+
+// Add the span [x0, x1), in subpixels from cell 0, to a row of cells. The
+// span may touch the two cells past the last pixel it covers.
+inline void AccumulateSpan(int32_t* cells, int32_t x0, int32_t x1, int32_t weight)
+{
+    int32_t frac0 = x0 & (COVERAGE_SUBPIXELS - 1);
+    int32_t frac1 = x1 & (COVERAGE_SUBPIXELS - 1);
+    int32_t* first = cells + (x0 / COVERAGE_SUBPIXELS);
+    int32_t* last = cells + (x1 / COVERAGE_SUBPIXELS);
+    first[0] += weight * (COVERAGE_SUBPIXELS - frac0);
+    first[1] += weight * frac0;
+    last[0] -= weight * (COVERAGE_SUBPIXELS - frac1);
+    last[1] -= weight * frac1;
+}
+
+// Resolve count cells into 8-bit alphas, scaled by alpha (0..255):
+// round(min(coverage, COVERAGE_FULL - 1) * alpha / COVERAGE_FULL). Clears
+// count + 2 cells, ready for the next row.
+void ResolveCoverage(int32_t* cells, uint32_t count, uint32_t alpha, uint8_t* coverage);
+
+// Blend color (0xAARRGGBB, its alpha already in coverage) source-over into
+// count pixels: round((src * a + dst * (255 - a)) / 255) per channel, with
+// 255 as the source alpha.
+void BlendCoverage(uint8_t* pixels, const uint8_t* coverage, uint32_t count, uint32_t color, PixelFormat format);
+
+#endif // SCANLINE_FILL_H
@@ -0,0 +1,74 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+
+// Bounded lock-free ring for exactly one producer thread and one consumer
+// thread. Each side keeps a cached copy of the other side's index so the
+// common case touches only its own cache line.
+template <typename T, size_t CAPACITY>
+class SpscQueue {
+    static_assert((CAPACITY & (CAPACITY - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+public:
+    SpscQueue() = default;
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Producer side. Returns false if the queue is full.
+    bool TryPush(const T& item)
+    {
+        size_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - headCache_ == CAPACITY) {
+            headCache_ = head_.load(std::memory_order_acquire);
+            if (tail - headCache_ == CAPACITY) {
+                return false;
+            }
+        }
+        slots_[tail & (CAPACITY - 1)] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side. Returns false if the queue is empty.
+    bool TryPop(T& item)
+    {
+        size_t head = head_.load(std::memory_order_relaxed);
+        if (head == tailCache_) {
+            tailCache_ = tail_.load(std::memory_order_acquire);
+            if (head == tailCache_) {
+                return false;
+            }
+        }
+        item = slots_[head & (CAPACITY - 1)];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Safe from either side; only a snapshot
+    bool Empty() const
+    {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+private:
+    static constexpr size_t CACHE_LINE = 64;
+
+    // Consumer-owned
+    alignas(CACHE_LINE) std::atomic<size_t> head_ {0};
+    size_t tailCache_ = 0;
+
+    // Producer-owned
+    alignas(CACHE_LINE) std::atomic<size_t> tail_ {0};
+    size_t headCache_ = 0;
+
+    alignas(CACHE_LINE) T slots_[CAPACITY];
+};
+
+#endif // SPSC_QUEUE_H
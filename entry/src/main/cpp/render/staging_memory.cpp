@@ -0,0 +1,54 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#include "staging_memory.h"
+#include <algorithm>
+#include <cstdlib>
+
+StagingMemory::~StagingMemory() noexcept
+{
+    Release();
+}
+
+size_t StagingMemory::SizeClass(size_t bytes)
+{
+    if (bytes <= ALIGNMENT) {
+        return ALIGNMENT;
+    }
+    // Quarter steps of the highest power of two below bytes
+    size_t power = ALIGNMENT;
+    while (power * 2 < bytes) {
+        power *= 2;
+    }
+    size_t step = std::max(power / 4, ALIGNMENT);
+    return (bytes + step - 1) / step * step;
+}
+
+bool StagingMemory::Reserve(size_t bytes, bool mayShrink)
+{
+    size_t wanted = SizeClass(bytes + bytes / 4);
+    bool fits = bytes <= capacity_;
+    bool oversized = capacity_ > 2 * wanted;
+    if (fits && !(mayShrink && oversized)) {
+        return true;
+    }
+
+    Release();
+    // aligned_alloc takes a multiple of the alignment, which every class is
+    data_ = std::aligned_alloc(ALIGNMENT, wanted);
+    if (data_ == nullptr) {
+        return false;
+    }
+    capacity_ = wanted;
+    allocations_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void StagingMemory::Release()
+{
+    std::free(data_);
+    data_ = nullptr;
+    capacity_ = 0;
+}
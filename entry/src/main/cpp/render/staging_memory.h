@@ -0,0 +1,61 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#ifndef STAGING_MEMORY_H
+#define STAGING_MEMORY_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+// Pixel memory for a surface-sized staging bitmap that survives resizes.
+// Allocations come in size classes, and growing leaves headroom, so a
+// resize animation reallocates a few times rather than once per frame.
+// Shrinking waits until the caller says the size has settled, and only
+// happens when most of the memory would go unused.
+//
+// Used from one thread; GetAllocations() may be called from any thread.
+class StagingMemory {
+public:
+    static constexpr size_t ALIGNMENT = 64;
+
+    StagingMemory() = default;
+    ~StagingMemory() noexcept;
+
+    StagingMemory(const StagingMemory&) = delete;
+    StagingMemory& operator=(const StagingMemory&) = delete;
+
+    // The allocation size for bytes: rounded up to a quarter of its power
+    // of two, so each class is at most 25% larger than what it holds
+    static size_t SizeClass(size_t bytes);
+
+    // Make Data() hold at least bytes. Growing allocates the class of bytes
+    // plus a quarter for headroom; with mayShrink, memory more than twice
+    // that class is given back. The contents are not kept. False, with
+    // nothing held, if the allocation fails.
+    bool Reserve(size_t bytes, bool mayShrink);
+    void Release();
+
+    void* Data() const
+    {
+        return data_;
+    }
+    size_t Capacity() const
+    {
+        return capacity_;
+    }
+    // Allocations made over the lifetime, for tests and stats
+    uint64_t GetAllocations() const
+    {
+        return allocations_.load(std::memory_order_relaxed);
+    }
+
+private:
+    void* data_ = nullptr;
+    size_t capacity_ = 0;
+    std::atomic<uint64_t> allocations_ {0};
+};
+
+#endif // STAGING_MEMORY_H
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#include "stroke_font.h"
+
+namespace StrokeFont {
+namespace {
+
+constexpr Glyph GLYPHS[] = {
+    {' ', ""},
+    {'!', "4048 4b4c"},
+    {'"', "3033 5053"},
+    {'%', "0c80 1112 6a6b"},
+    {'\'', "4043"},
+    {'(', "6033396c"},
+    {')', "2053592c"},
+    {'+', "1676 4349"},
+    {',', "4a4b3c"},
+    {'-', "1676"},
+    {'.', "4b4c"},
+    {'/', "0c80"},
+    {'0', "2060828a6c2c0a0220 820a"},
+    {'1', "22404c 2c6c"},
+    {'2', "02206082840c8c"},
+    {'3', "022060828486888a6c2c0a 3666"},
+    {'4', "6c600888"},
+    {'5', "80000565878a6c2c0a"},
+    {'6', "7030030a2c6c8a88662608"},
+    {'7', "00803c"},
+    {'8', "206082846626080a2c6c8a8866 26040220"},
+    {'9', "8466260402206082895c1c"},
+    {':', "4344 4a4b"},
+    {'<', "72167a"},
+    {'=', "1474 1878"},
+    {'>', "12761a"},
+    {'?', "02206082844748 4b4c"},
+    {'A', "0c408c 2666"},
+    {'B', "000c5c7a785606 0050727456"},
+    {'C', "826020020a2c6c8a"},
+    {'D', "000c5c89835000"},
+    {'E', "80000c8c 0666"},
+    {'F', "80000c 0666"},
+    {'G', "826020020a2c6c8a8656"},
+    {'H', "000c 808c 0686"},
+    {'I', "2060 404c 2c6c"},
+    {'J', "808a6c2c0a"},
+    {'K', "000c 8007 358c"},
+    {'L', "000c8c"},
+    {'M', "0c0046808c"},
+    {'N', "0c008c80"},
+    {'O', "2060828a6c2c0a0220"},
+    {'P', "0c006082848606"},
+    {'Q', "2060828a6c2c0a0220 598c"},
+    {'R', "0c006082848606 468c"},
+    {'S', "82602002042666888a6c2c0a"},
+    {'T', "0080 404c"},
+    {'U', "000a2c6c8a80"},
+    {'V', "004c80"},
+    {'W', "002c466c80"},
+    {'X', "008c 800c"},
+    {'Y', "004680 464c"},
+    {'Z', "00800c8c"},
+    {'_', "0c8c"},
+};
+
+constexpr int GLYPH_COUNT = static_cast<int>(sizeof(GLYPHS) / sizeof(GLYPHS[0]));
+
+// Index into GLYPHS for every 7-bit character, resolved at compile time
+struct GlyphIndex {
+    uint8_t index[128];
+};
+
+constexpr int FindGlyph(char c)
+{
+    for (int i = 0; i < GLYPH_COUNT; i++) {
+        if (GLYPHS[i].code == c) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+constexpr GlyphIndex BuildGlyphIndex()
+{
+    GlyphIndex table {};
+    int fallback = FindGlyph('?');
+    for (int c = 0; c < 128; c++) {
+        char mapped = static_cast<char>(((c >= 'a') && (c <= 'z')) ? (c - 'a' + 'A') : c);
+        int found = FindGlyph(mapped);
+        table.index[c] = static_cast<uint8_t>((found >= 0) ? found : fallback);
+    }
+    return table;
+}
+
+constexpr GlyphIndex GLYPH_INDEX = BuildGlyphIndex();
+
+static_assert(GLYPH_COUNT < 256, "glyph index must fit in a byte");
+static_assert(GLYPHS[GLYPH_INDEX.index['a']].code == 'A', "lower case maps to upper case");
+static_assert(GLYPHS[GLYPH_INDEX.index['~']].code == '?', "undefined glyphs fall back to '?'");
+
+} // namespace
+
+int GetGlyphIndex(char c)
+{
+    unsigned char code = static_cast<unsigned char>(c);
+    return GLYPH_INDEX.index[(code < 128) ? code : '?'];
+}
+
+int GetGlyphCount()
+{
+    return GLYPH_COUNT;
+}
+
+const Glyph& GetGlyphAt(int index)
+{
+    return GLYPHS[index];
+}
+
+} // namespace StrokeFont
@@ -0,0 +1,70 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#ifndef STROKE_FONT_H
+#define STROKE_FONT_H
+
+#include <cstdint>
+
+// A single-weight stroke font: each glyph is a few polylines on an 8 x 12
+// unit grid, top-left origin, baseline at the bottom. Only upper case,
+// digits and common punctuation are defined; lower case maps to upper case
+// and anything else to '?'.
+namespace StrokeFont {
+
+constexpr int GLYPH_WIDTH = 8;
+constexpr int GLYPH_HEIGHT = 12;
+// Horizontal distance from one glyph to the next, in units
+constexpr int GLYPH_ADVANCE = 11;
+
+// Polylines of one glyph. Each point is two hex digits, x then y; a space
+// lifts the pen. An empty string is a glyph with no ink (space).
+struct Glyph {
+    char code;
+    const char* strokes;
+};
+
+// Position in the glyph table of the glyph drawn for c, after case and
+// fallback mapping
+int GetGlyphIndex(char c);
+
+// Number of glyphs in the table
+int GetGlyphCount();
+const Glyph& GetGlyphAt(int index);
+
+inline const Glyph& GetGlyph(char c)
+{
+    return GetGlyphAt(GetGlyphIndex(c));
+}
+
+// Call fn(x0, y0, x1, y1) for every segment of a glyph, in units
+template <typename Fn>
+void ForEachSegment(const Glyph& glyph, Fn&& fn)
+{
+    auto digit = [](char c) { return (c >= 'a') ? (c - 'a' + 10) : (c - '0'); };
+    bool penDown = false;
+    int lastX = 0;
+    int lastY = 0;
+    for (const char* p = glyph.strokes; *p != '\0';) {
+        if (*p == ' ') {
+            penDown = false;
+            p++;
+            continue;
+        }
+        int x = digit(p[0]);
+        int y = digit(p[1]);
+        if (penDown) {
+            fn(lastX, lastY, x, y);
+        }
+        lastX = x;
+        lastY = y;
+        penDown = true;
+        p += 2;
+    }
+}
+
+} // namespace StrokeFont
+
+#endif // STROKE_FONT_H
@@ -0,0 +1,474 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#include "tile_raster.h"
+#include "scanline_fill.h"
+#include "work_stealing_pool.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+constexpr float PI = 3.14159265358979f;
+// Stroke discs are flattened to FLATTEN_TOLERANCE, but never so coarsely
+// that a thin stroke's joins lose their roundness, nor so finely that a
+// thick one costs more per vertex than its segments
+constexpr uint32_t MIN_DISC_SEGMENTS = 8;
+constexpr uint32_t MAX_DISC_SEGMENTS = 64;
+
+// Paths may reach anywhere; only coordinates brought onto the surface fit
+// an int32_t
+float ClampToSurface(float value, uint32_t size)
+{
+    return std::min(std::max(value, 0.0f), static_cast<float>(size));
+}
+
+struct Crossing {
+    float x;
+    int32_t winding;
+};
+
+// Crossings per sample row are few; insertion sort beats std::sort here
+void SortCrossings(Crossing* crossings, size_t count)
+{
+    for (size_t i = 1; i < count; i++) {
+        Crossing value = crossings[i];
+        size_t j = i;
+        for (; (j > 0) && (crossings[j - 1].x > value.x); j--) {
+            crossings[j] = crossings[j - 1];
+        }
+        crossings[j] = value;
+    }
+}
+
+} // namespace
+
+void RasterPath::MoveTo(float x, float y)
+{
+    contours_.push_back(Contour {points_.size(), false});
+    points_.push_back(RasterPoint {x, y});
+    open_ = true;
+}
+
+void RasterPath::EnsureOpen()
+{
+    if (!open_) {
+        // Like the native path: a line with no open contour starts where the last one did
+        RasterPoint start = contours_.empty() ? RasterPoint {0, 0} : points_[contours_.back().start];
+        MoveTo(start.x, start.y);
+    }
+}
+
+RasterPoint* RasterPath::AppendPoints(size_t count)
+{
+    size_t first = points_.size();
+    points_.resize(first + count);
+    return &points_[first];
+}
+
+void RasterPath::LineTo(float x, float y)
+{
+    EnsureOpen();
+    points_.push_back(RasterPoint {x, y});
+}
+
+void RasterPath::QuadTo(float x1, float y1, float x2, float y2, float tolerance)
+{
+    EnsureOpen();
+    RasterPoint p0 = points_.back();
+    RasterPoint p1 {x1, y1};
+    RasterPoint p2 {x2, y2};
+    uint32_t segments = GetQuadSegments(p0, p1, p2, tolerance);
+    FlattenQuad(p0, p1, p2, segments, AppendPoints(segments));
+}
+
+void RasterPath::CubicTo(float x1, float y1, float x2, float y2, float x3, float y3, float tolerance)
+{
+    EnsureOpen();
+    RasterPoint p0 = points_.back();
+    RasterPoint p1 {x1, y1};
+    RasterPoint p2 {x2, y2};
+    RasterPoint p3 {x3, y3};
+    uint32_t segments = GetCubicSegments(p0, p1, p2, p3, tolerance);
+    FlattenCubic(p0, p1, p2, p3, segments, AppendPoints(segments));
+}
+
+void RasterPath::ArcTo(float cx, float cy, float radius, float startAngle, float sweep, float tolerance)
+{
+    EnsureOpen();
+    uint32_t segments = GetArcSegments(radius, sweep, tolerance);
+    RasterPoint* arc = AppendPoints(segments + 1);
+    FlattenArc(cx, cy, radius, startAngle, sweep, segments, arc);
+    // No zero-length line when the arc starts at the current point
+    const RasterPoint& current = *(arc - 1);
+    if ((arc[0].x == current.x) && (arc[0].y == current.y)) {
+        points_.erase(points_.end() - (segments + 1));
+    }
+}
+
+void RasterPath::AddCircle(float cx, float cy, float radius, float tolerance)
+{
+    uint32_t segments = GetArcSegments(radius, 2 * PI, tolerance);
+    MoveTo(cx + radius, cy);
+    FlattenArc(cx, cy, radius, 0, 2 * PI, segments, AppendPoints(segments) - 1);
+    // The last point is the first again
+    points_.pop_back();
+    Close();
+}
+
+void RasterPath::AddRoundRect(float left, float top, float right, float bottom, float radius, float tolerance)
+{
+    radius = std::min(std::max(radius, 0.0f), std::min(right - left, bottom - top) / 2);
+    MoveTo(left + radius, top);
+    if (radius > 0) {
+        ArcTo(right - radius, top + radius, radius, -PI / 2, PI / 2, tolerance);
+        ArcTo(right - radius, bottom - radius, radius, 0, PI / 2, tolerance);
+        ArcTo(left + radius, bottom - radius, radius, PI / 2, PI / 2, tolerance);
+        ArcTo(left + radius, top + radius, radius, PI, PI / 2, tolerance);
+    } else {
+        LineTo(right, top);
+        LineTo(right, bottom);
+        LineTo(left, bottom);
+    }
+    Close();
+}
+
+void RasterPath::Close()
+{
+    if (open_) {
+        contours_.back().closed = true;
+        open_ = false;
+    }
+}
+
+void RasterPath::Offset(float dx, float dy)
+{
+    for (RasterPoint& point : points_) {
+        point.x += dx;
+        point.y += dy;
+    }
+}
+
+void RasterPath::Reset()
+{
+    points_.clear();
+    contours_.clear();
+    open_ = false;
+}
+
+void TileRasterizer::Begin(const PixelSurface& surface)
+{
+    ClearRecorded();
+
+    surface_ = surface;
+    tilesX_ = (surface.width + TILE_SIZE - 1) / TILE_SIZE;
+    tilesY_ = (surface.height + TILE_SIZE - 1) / TILE_SIZE;
+    // Grows once per surface size; the tiles keep their storage
+    if (tiles_.size() < static_cast<size_t>(tilesX_) * tilesY_) {
+        tiles_.resize(static_cast<size_t>(tilesX_) * tilesY_);
+    }
+}
+
+void TileRasterizer::SetArena(FrameArena* arena)
+{
+    ClearRecorded();
+    arena_ = arena;
+    // Containers take the allocator of what is assigned to them
+    activeTiles_ = FrameVector<uint32_t>(FrameAllocator<uint32_t>(arena_));
+    edges_ = FrameVector<Edge>(FrameAllocator<Edge>(arena_));
+    draws_ = FrameVector<Draw>(FrameAllocator<Draw>(arena_));
+}
+
+void TileRasterizer::ClearRecorded()
+{
+    // Only the tiles binned by a flush hold anything
+    for (uint32_t index : activeTiles_) {
+        Tile& tile = tiles_[index];
+        if (arena_ == nullptr) {
+            tile.draws.clear();
+            tile.edgeIndices.clear();
+        } else {
+            tile = Tile();
+        }
+    }
+    if (arena_ == nullptr) {
+        // The heap storage is kept for the next flush
+        activeTiles_.clear();
+        edges_.clear();
+        draws_.clear();
+        return;
+    }
+    // Arena memory may have been taken back already, so it is let go of
+    // rather than cleared
+    activeTiles_ = FrameVector<uint32_t>(FrameAllocator<uint32_t>(arena_));
+    edges_ = FrameVector<Edge>(FrameAllocator<Edge>(arena_));
+    draws_ = FrameVector<Draw>(FrameAllocator<Draw>(arena_));
+}
+
+void TileRasterizer::Fill(const RasterPath& path, uint32_t color)
+{
+    uint32_t firstEdge = static_cast<uint32_t>(edges_.size());
+    const std::vector<RasterPoint>& points = path.GetPoints();
+    for (size_t i = 0; i < path.GetContours().size(); i++) {
+        size_t start = path.GetContours()[i].start;
+        AddPolygon(&points[start], path.GetContourEnd(i) - start);
+    }
+    EndDraw(firstEdge, color);
+}
+
+void TileRasterizer::Stroke(const RasterPath& path, float width, uint32_t color)
+{
+    OutlineStroke(path, width, strokeOutline_);
+    Fill(strokeOutline_, color);
+}
+
+void TileRasterizer::OutlineStroke(const RasterPath& path, float width, RasterPath& outline)
+{
+    outline.Reset();
+    // A hairline is drawn one pixel wide
+    float halfWidth = std::max(width, 1.0f) / 2;
+    // One disc around the origin, moved to every vertex
+    uint32_t discSegments = GetArcSegments(halfWidth, 2 * PI, FLATTEN_TOLERANCE);
+    discSegments = std::min(std::max(discSegments, MIN_DISC_SEGMENTS), MAX_DISC_SEGMENTS);
+    RasterPoint disc[MAX_DISC_SEGMENTS + 1];
+    FlattenArc(0, 0, halfWidth, 0, 2 * PI, discSegments, disc);
+
+    const std::vector<RasterPoint>& points = path.GetPoints();
+    for (size_t c = 0; c < path.GetContours().size(); c++) {
+        size_t start = path.GetContours()[c].start;
+        size_t count = path.GetContourEnd(c) - start;
+        if (count < 2) {
+            continue;
+        }
+        const RasterPoint* contour = &points[start];
+        size_t segments = path.GetContours()[c].closed ? count : count - 1;
+        for (size_t i = 0; i < segments; i++) {
+            const RasterPoint& a = contour[i];
+            const RasterPoint& b = contour[(i + 1) % count];
+            float dx = b.x - a.x;
+            float dy = b.y - a.y;
+            float length = std::sqrt(dx * dx + dy * dy);
+            if (length == 0) {
+                continue;
+            }
+            float nx = -dy / length * halfWidth;
+            float ny = dx / length * halfWidth;
+            // Quads and discs all go the same way round, so the pieces add up
+            // rather than cancel where they overlap
+            outline.MoveTo(a.x + nx, a.y + ny);
+            outline.LineTo(a.x - nx, a.y - ny);
+            outline.LineTo(b.x - nx, b.y - ny);
+            outline.LineTo(b.x + nx, b.y + ny);
+            outline.Close();
+        }
+        for (size_t i = 0; i < count; i++) {
+            outline.MoveTo(contour[i].x + disc[0].x, contour[i].y + disc[0].y);
+            for (uint32_t s = 1; s < discSegments; s++) {
+                outline.LineTo(contour[i].x + disc[s].x, contour[i].y + disc[s].y);
+            }
+            outline.Close();
+        }
+    }
+}
+
+void TileRasterizer::AddPolygon(const RasterPoint* points, size_t count)
+{
+    if (count < 2) {
+        return;
+    }
+    for (size_t i = 0, j = count - 1; i < count; j = i++) {
+        const RasterPoint& a = points[j];
+        const RasterPoint& b = points[i];
+        if (a.y == b.y) {
+            continue;
+        }
+        Edge edge = (a.y < b.y) ? Edge {a.x, a.y, b.x, b.y, 1, 0} : Edge {b.x, b.y, a.x, a.y, -1, 0};
+        edge.minX = std::min(a.x, b.x);
+        edges_.push_back(edge);
+    }
+}
+
+void TileRasterizer::EndDraw(uint32_t firstEdge, uint32_t color)
+{
+    uint32_t edgeCount = static_cast<uint32_t>(edges_.size()) - firstEdge;
+    if ((edgeCount == 0) || ((color >> 24) == 0)) {
+        edges_.resize(firstEdge);
+        return;
+    }
+    float minX = edges_[firstEdge].minX;
+    float maxX = minX;
+    float minY = edges_[firstEdge].y0;
+    float maxY = edges_[firstEdge].y1;
+    for (uint32_t i = firstEdge; i < firstEdge + edgeCount; i++) {
+        const Edge& edge = edges_[i];
+        minX = std::min(minX, edge.minX);
+        maxX = std::max(maxX, std::max(edge.x0, edge.x1));
+        minY = std::min(minY, edge.y0);
+        maxY = std::max(maxY, edge.y1);
+    }
+    Draw draw {firstEdge, edgeCount, color,
+        static_cast<int32_t>(std::floor(ClampToSurface(minX, surface_.width))),
+        static_cast<int32_t>(std::floor(ClampToSurface(minY, surface_.height))),
+        static_cast<int32_t>(std::ceil(ClampToSurface(maxX, surface_.width))),
+        static_cast<int32_t>(std::ceil(ClampToSurface(maxY, surface_.height)))};
+    if ((draw.right <= draw.left) || (draw.bottom <= draw.top)) {
+        edges_.resize(firstEdge);
+        return;
+    }
+    draws_.push_back(draw);
+}
+
+void TileRasterizer::Flush(WorkStealingPool* pool)
+{
+    if ((surface_.pixels == nullptr) || draws_.empty()) {
+        lastTileCount_ = 0;
+        return;
+    }
+    Bin();
+    lastTileCount_ = static_cast<uint32_t>(activeTiles_.size());
+    if (pool != nullptr) {
+        pool->ParallelFor(lastTileCount_, [this](uint32_t i) { RasterizeTile(activeTiles_[i]); });
+    } else {
+        for (uint32_t index : activeTiles_) {
+            RasterizeTile(index);
+        }
+    }
+    // Ready for the next Begin() or further draws
+    ClearRecorded();
+}
+
+void TileRasterizer::Bin()
+{
+    constexpr int32_t tileSize = static_cast<int32_t>(TILE_SIZE);
+    for (uint32_t d = 0; d < draws_.size(); d++) {
+        const Draw& draw = draws_[d];
+        int32_t tileLeft = draw.left / tileSize;
+        int32_t tileRight = (draw.right - 1) / tileSize;
+        int32_t tileTop = draw.top / tileSize;
+        int32_t tileBottom = (draw.bottom - 1) / tileSize;
+        for (uint32_t e = draw.firstEdge; e < draw.firstEdge + draw.edgeCount; e++) {
+            const Edge& edge = edges_[e];
+            // Sample rows are at pixel + (s + 0.5) / 4; an edge ending on a
+            // tile boundary does not reach into the next tile
+            int32_t y0 = static_cast<int32_t>(std::floor(ClampToSurface(edge.y0, surface_.height)));
+            int32_t y1 = static_cast<int32_t>(std::ceil(ClampToSurface(edge.y1, surface_.height)));
+            int32_t rowFirst = std::max(y0 / tileSize, tileTop);
+            int32_t rowLast = std::min((y1 - 1) / tileSize, tileBottom);
+            // An edge adds to the winding of every tile to its right
+            int32_t minX = static_cast<int32_t>(std::floor(ClampToSurface(edge.minX, surface_.width)));
+            int32_t colFirst = std::max(minX / tileSize, tileLeft);
+            for (int32_t ty = rowFirst; ty <= rowLast; ty++) {
+                for (int32_t tx = colFirst; tx <= tileRight; tx++) {
+                    uint32_t index = static_cast<uint32_t>(ty) * tilesX_ + static_cast<uint32_t>(tx);
+                    Tile& tile = tiles_[index];
+                    if (tile.draws.empty()) {
+                        ActivateTile(index);
+                    }
+                    if (tile.draws.empty() || (tile.draws.back().draw != d)) {
+                        tile.draws.push_back(TileDraw {d, static_cast<uint32_t>(tile.edgeIndices.size()), 0});
+                    }
+                    tile.edgeIndices.push_back(e);
+                    tile.draws.back().indexCount++;
+                }
+            }
+        }
+    }
+}
+
+void TileRasterizer::ActivateTile(uint32_t index)
+{
+    activeTiles_.push_back(index);
+    if (arena_ != nullptr) {
+        Tile& tile = tiles_[index];
+        tile.draws = FrameVector<TileDraw>(FrameAllocator<TileDraw>(arena_));
+        tile.edgeIndices = FrameVector<uint32_t>(FrameAllocator<uint32_t>(arena_));
+    }
+}
+
+void TileRasterizer::RasterizeTile(uint32_t tileIndex) const
+{
+    const Tile& tile = tiles_[tileIndex];
+    int32_t tileLeft = static_cast<int32_t>((tileIndex % tilesX_) * TILE_SIZE);
+    int32_t tileTop = static_cast<int32_t>((tileIndex / tilesX_) * TILE_SIZE);
+    for (const TileDraw& tileDraw : tile.draws) {
+        RasterizeDraw(tile, tileDraw, tileLeft, tileTop);
+    }
+}
+
+void TileRasterizer::RasterizeDraw(const Tile& tile, const TileDraw& tileDraw, int32_t tileLeft,
+    int32_t tileTop) const
+{
+    const Draw& draw = draws_[tileDraw.draw];
+    int32_t left = std::max(tileLeft, draw.left);
+    int32_t right = std::min(tileLeft + static_cast<int32_t>(TILE_SIZE), draw.right);
+    int32_t top = std::max(tileTop, draw.top);
+    int32_t bottom = std::min(tileTop + static_cast<int32_t>(TILE_SIZE), draw.bottom);
+    if ((right <= left) || (bottom <= top)) {
+        return;
+    }
+
+    uint32_t sampleRows = GetAaSampleRows(quality_);
+    float sampleStep = 1.0f / sampleRows;
+    int32_t weight = GetSampleWeight(sampleRows);
+    bool snap = quality_ == AaQuality::NONE;
+
+    // Per thread, kept between tiles
+    thread_local std::vector<Crossing> crossings;
+    // Coverage deltas from the left of the draw's part of the tile, resolved
+    // and cleared row by row
+    int32_t cells[TILE_SIZE + 2] = {};
+    uint8_t coverage[TILE_SIZE];
+    const uint32_t* indices = &tile.edgeIndices[tileDraw.firstIndex];
+    float clipLeft = static_cast<float>(left);
+    float clipRight = static_cast<float>(right);
+    int32_t origin = left * COVERAGE_SUBPIXELS;
+
+    for (int32_t row = top; row < bottom; row++) {
+        int32_t spanLeft = right;
+        int32_t spanRight = left;
+        for (uint32_t s = 0; s < sampleRows; s++) {
+            float y = row + (s + 0.5f) * sampleStep;
+            crossings.clear();
+            for (uint32_t i = 0; i < tileDraw.indexCount; i++) {
+                const Edge& edge = edges_[indices[i]];
+                if ((y < edge.y0) || (y >= edge.y1)) {
+                    continue;
+                }
+                float t = (y - edge.y0) / (edge.y1 - edge.y0);
+                crossings.push_back(Crossing {edge.x0 + t * (edge.x1 - edge.x0), edge.winding});
+            }
+            SortCrossings(crossings.data(), crossings.size());
+            // Edges right of the tile are not binned to it; a span still open
+            // at the last crossing runs to the tile's right side
+            crossings.push_back(Crossing {std::numeric_limits<float>::infinity(), 0});
+
+            int32_t winding = 0;
+            for (size_t i = 0; i + 1 < crossings.size(); i++) {
+                winding += crossings[i].winding;
+                if (winding == 0) {
+                    continue;
+                }
+                // Crossings left of the tile only set the winding
+                int32_t x0 = ToSubpixel(std::max(crossings[i].x, clipLeft), snap) - origin;
+                int32_t x1 = ToSubpixel(std::min(crossings[i + 1].x, clipRight), snap) - origin;
+                if (x1 <= x0) {
+                    continue;
+                }
+                AccumulateSpan(cells, x0, x1, weight);
+                spanLeft = std::min(spanLeft, left + x0 / COVERAGE_SUBPIXELS);
+                spanRight = std::max(spanRight, left + (x1 + COVERAGE_SUBPIXELS - 1) / COVERAGE_SUBPIXELS);
+            }
+        }
+        if (spanRight <= spanLeft) {
+            continue;
+        }
+
+        uint32_t count = static_cast<uint32_t>(spanRight - spanLeft);
+        ResolveCoverage(cells + (spanLeft - left), count, draw.color >> 24, coverage);
+        uint8_t* line = static_cast<uint8_t*>(surface_.pixels) + static_cast<size_t>(row) * surface_.stride;
+        BlendCoverage(line + spanLeft * 4, coverage, count, draw.color, surface_.format);
+    }
+}
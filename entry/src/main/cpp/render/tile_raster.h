@@ -0,0 +1,199 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#ifndef TILE_RASTER_H
+#define TILE_RASTER_H
+
+#include "curve_flatten.h"
+#include "frame_arena.h"
+#include "pixel_blit.h"
+#include "scanline_fill.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+class WorkStealingPool;
+
+// A path of straight segments: one or more contours, each open or closed.
+// Curves and arcs are flattened into it as they are added, to within the
+// tolerance given, in the path's units (see curve_flatten.h).
+class RasterPath {
+public:
+    struct Contour {
+        // Index of the first point in GetPoints()
+        size_t start;
+        bool closed;
+    };
+
+    void MoveTo(float x, float y);
+    void LineTo(float x, float y);
+    void Close();
+    // Curves from the current point
+    void QuadTo(float x1, float y1, float x2, float y2, float tolerance);
+    void CubicTo(float x1, float y1, float x2, float y2, float x3, float y3, float tolerance);
+    // A line from the current point to the start of the arc of radius
+    // around (cx, cy) from startAngle through sweep radians, then the arc
+    void ArcTo(float cx, float cy, float radius, float startAngle, float sweep, float tolerance);
+    // Closed contours of their own
+    void AddCircle(float cx, float cy, float radius, float tolerance);
+    void AddRoundRect(float left, float top, float right, float bottom, float radius, float tolerance);
+    // Move every point by (dx, dy)
+    void Offset(float dx, float dy);
+    // Keeps the storage for the next path
+    void Reset();
+
+    bool IsEmpty() const
+    {
+        return points_.empty();
+    }
+    const std::vector<RasterPoint>& GetPoints() const
+    {
+        return points_;
+    }
+    const std::vector<Contour>& GetContours() const
+    {
+        return contours_;
+    }
+    // Points of contour i are [start, end)
+    size_t GetContourEnd(size_t i) const
+    {
+        return (i + 1 < contours_.size()) ? contours_[i + 1].start : points_.size();
+    }
+
+private:
+    // Reopen the last contour's start, as LineTo does with no open contour
+    void EnsureOpen();
+    // count points added to the open contour, left for the caller to write
+    RasterPoint* AppendPoints(size_t count);
+
+    std::vector<RasterPoint> points_;
+    std::vector<Contour> contours_;
+    bool open_ = false;
+};
+
+// Anti-aliased fill and stroke of RasterPaths straight into a PixelSurface,
+// split into TILE_SIZE x TILE_SIZE tiles rasterized in parallel.
+//
+// Draws are recorded first and rasterized by Flush():
+//
+//   Begin(surface); Fill(...); Stroke(...); ...; Flush(pool);
+//
+// Recording turns each draw into edges; Flush bins the edges of every draw
+// into the tiles it covers, then each tile replays its draws in order, so
+// the result is the same as drawing them one after another, whatever the
+// number of threads. Fills are nonzero, sampled as SetQuality() says with
+// exact horizontal coverage per pixel, accumulated and blended source-over
+// with the scanline_fill kernels. Strokes are filled as the union of a quad
+// per segment and a disc per vertex, which gives round joins and caps.
+//
+// What a flush records lives until the flush is done. With SetArena() it
+// is kept in a FrameArena, and nothing recorded survives the arena's
+// Reset(); a Begin() after it starts afresh.
+//
+// One thread records and flushes; the pool only ever runs tiles.
+class TileRasterizer {
+public:
+    static constexpr uint32_t TILE_SIZE = 64;
+
+    TileRasterizer() = default;
+    TileRasterizer(const TileRasterizer&) = delete;
+    TileRasterizer& operator=(const TileRasterizer&) = delete;
+
+    // Start recording draws for surface. Anything recorded and not flushed
+    // is dropped.
+    void Begin(const PixelSurface& surface);
+
+    // Record into arena, or onto the heap when null (the default). Drops
+    // anything recorded.
+    void SetArena(FrameArena* arena);
+
+    // color is 0xAARRGGBB
+    void Fill(const RasterPath& path, uint32_t color);
+    void Stroke(const RasterPath& path, float width, uint32_t color);
+
+    // Anti-aliasing of the draws rasterized by the next Flush() (default MEDIUM)
+    void SetQuality(AaQuality quality)
+    {
+        quality_ = quality;
+    }
+    AaQuality GetQuality() const
+    {
+        return quality_;
+    }
+
+    // The outline Stroke() fills: a contour per segment and per vertex, all
+    // the same way round
+    static void OutlineStroke(const RasterPath& path, float width, RasterPath& outline);
+
+    // Rasterize everything recorded since Begin() into the surface and
+    // return once it is written. With a null pool, on the calling thread.
+    void Flush(WorkStealingPool* pool);
+
+    // Tiles touched by the last Flush()
+    uint32_t GetLastTileCount() const
+    {
+        return lastTileCount_;
+    }
+
+private:
+    struct Edge {
+        float x0;
+        float y0;
+        float x1;
+        float y1;
+        // +1 going down, -1 going up
+        int32_t winding;
+        float minX;
+    };
+
+    struct Draw {
+        uint32_t firstEdge;
+        uint32_t edgeCount;
+        uint32_t color;
+        // Pixel bounds, clipped to the surface; empty when right <= left
+        int32_t left;
+        int32_t top;
+        int32_t right;
+        int32_t bottom;
+    };
+
+    // The edges of one draw that matter to one tile
+    struct TileDraw {
+        uint32_t draw;
+        uint32_t firstIndex;
+        uint32_t indexCount;
+    };
+
+    struct Tile {
+        FrameVector<TileDraw> draws;
+        // Into edges_, grouped per TileDraw
+        FrameVector<uint32_t> edgeIndices;
+    };
+
+    void AddPolygon(const RasterPoint* points, size_t count);
+    void EndDraw(uint32_t firstEdge, uint32_t color);
+    void Bin();
+    void ActivateTile(uint32_t index);
+    void ClearRecorded();
+    void RasterizeTile(uint32_t tileIndex) const;
+    void RasterizeDraw(const Tile& tile, const TileDraw& tileDraw, int32_t tileLeft, int32_t tileTop) const;
+
+    PixelSurface surface_ {nullptr, 0, 0, 0, PixelFormat::RGBA_8888};
+    uint32_t tilesX_ = 0;
+    uint32_t tilesY_ = 0;
+    FrameArena* arena_ = nullptr;
+    FrameVector<Edge> edges_;
+    FrameVector<Draw> draws_;
+    // One per tile of the largest surface so far; only the bins of the
+    // active ones hold anything
+    std::vector<Tile> tiles_;
+    // Tiles with something to draw this flush
+    FrameVector<uint32_t> activeTiles_;
+    RasterPath strokeOutline_;
+    AaQuality quality_ = AaQuality::MEDIUM;
+    uint32_t lastTileCount_ = 0;
+};
+
+#endif // TILE_RASTER_H
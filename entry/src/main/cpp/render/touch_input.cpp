@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#include "touch_input.h"
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// Weight of the newest move in the smoothed velocity
+constexpr float VELOCITY_SMOOTHING = 0.6f;
+// A gap this long between two moves starts the velocity over
+constexpr int64_t MAX_SAMPLE_GAP_NS = 100000000;
+// Frames a pointer may go without moving before its prediction is dropped;
+// more than one, so touch reported slower than the display does not flicker
+constexpr uint32_t PREDICTION_IDLE_FRAMES = 2;
+
+} // namespace
+
+bool TouchInput::Push(const TouchSample& sample)
+{
+    samples_.fetch_add(1, std::memory_order_relaxed);
+    if (!ring_.TryPush(sample)) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    return true;
+}
+
+bool TouchInput::Collect(int64_t lookaheadNs, TouchFrame& frame)
+{
+    uint32_t used = 0;
+    for (Track& track : tracks_) {
+        track.frameEntry = -1;
+    }
+
+    TouchSample sample;
+    while (ring_.TryPop(sample)) {
+        TouchPosition position {sample.x, sample.y};
+        Track* track = FindTrack(sample.id);
+        if (sample.action == TouchAction::DOWN) {
+            if (track == nullptr) {
+                if (tracks_.size() >= MAX_POINTERS) {
+                    dropped_.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                tracks_.push_back(Track {sample.id, false, -1, position, sample.timeNs, 0, 0, false, 0});
+                track = &tracks_.back();
+            }
+            track->down = true;
+            track->last = position;
+            track->lastTimeNs = sample.timeNs;
+            track->vx = 0;
+            track->vy = 0;
+            track->hasVelocity = false;
+            track->idleFrames = 0;
+            TouchPointer& pointer = BeginEntry(*track, frame, used);
+            pointer.began = true;
+            pointer.path.push_back(position);
+            continue;
+        }
+
+        // Nothing to continue, e.g. its DOWN was lost to a full ring
+        if ((track == nullptr) || !track->down) {
+            continue;
+        }
+        // Other pointers are reported again, unmoved, when one of them moves
+        bool moved = (position.x != track->last.x) || (position.y != track->last.y);
+        if ((sample.action == TouchAction::MOVE) && !moved) {
+            continue;
+        }
+        if (track->frameEntry < 0) {
+            BeginEntry(*track, frame, used);
+        } else if (sample.action == TouchAction::MOVE) {
+            coalesced_.fetch_add(1, std::memory_order_relaxed);
+        }
+        TouchPointer& pointer = frame.pointers[track->frameEntry];
+        if (sample.action == TouchAction::MOVE) {
+            UpdateVelocity(*track, sample);
+        }
+        if (pointer.path.empty() || moved) {
+            pointer.path.push_back(position);
+        }
+        track->last = position;
+        track->lastTimeNs = sample.timeNs;
+        track->idleFrames = 0;
+        if ((sample.action == TouchAction::UP) || (sample.action == TouchAction::CANCEL)) {
+            track->down = false;
+            pointer.down = false;
+            pointer.cancelled = sample.action == TouchAction::CANCEL;
+        }
+    }
+
+    // A pointer that has stopped moving loses its prediction, which takes
+    // a frame of its own to clear
+    for (Track& track : tracks_) {
+        if (!track.down || (track.frameEntry >= 0) || !track.hasVelocity) {
+            continue;
+        }
+        if (++track.idleFrames >= PREDICTION_IDLE_FRAMES) {
+            track.vx = 0;
+            track.vy = 0;
+            track.hasVelocity = false;
+            BeginEntry(track, frame, used);
+        }
+    }
+
+    frame.predicting = false;
+    for (Track& track : tracks_) {
+        if (track.frameEntry < 0) {
+            continue;
+        }
+        TouchPointer& pointer = frame.pointers[track.frameEntry];
+        pointer.predicted = track.last;
+        if (!track.down || !track.hasVelocity) {
+            continue;
+        }
+        float dx = track.vx * lookaheadNs;
+        float dy = track.vy * lookaheadNs;
+        float distance = std::sqrt(dx * dx + dy * dy);
+        if (distance > MAX_PREDICTION) {
+            dx *= MAX_PREDICTION / distance;
+            dy *= MAX_PREDICTION / distance;
+        }
+        pointer.predicted = TouchPosition {track.last.x + dx, track.last.y + dy};
+        frame.predicting = true;
+    }
+    // Pointers still down but not in this frame keep their last prediction
+    for (const Track& track : tracks_) {
+        frame.predicting = frame.predicting || (track.down && track.hasVelocity);
+    }
+
+    tracks_.erase(std::remove_if(tracks_.begin(), tracks_.end(), [](const Track& track) { return !track.down; }),
+        tracks_.end());
+    frame.pointers.resize(used);
+    if (used == 0) {
+        return false;
+    }
+    frames_.fetch_add(1, std::memory_order_relaxed);
+    return true;
+}
+
+void TouchInput::Reset()
+{
+    TouchSample sample;
+    while (ring_.TryPop(sample)) {
+    }
+    tracks_.clear();
+}
+
+TouchInputStats TouchInput::GetStats() const
+{
+    return TouchInputStats {samples_.load(std::memory_order_relaxed), dropped_.load(std::memory_order_relaxed),
+        coalesced_.load(std::memory_order_relaxed), frames_.load(std::memory_order_relaxed)};
+}
+
+TouchInput::Track* TouchInput::FindTrack(int32_t id)
+{
+    for (Track& track : tracks_) {
+        if (track.id == id) {
+            return &track;
+        }
+    }
+    return nullptr;
+}
+
+TouchPointer& TouchInput::BeginEntry(Track& track, TouchFrame& frame, uint32_t& used)
+{
+    // Entries keep their path storage from frame to frame
+    if (used == frame.pointers.size()) {
+        frame.pointers.emplace_back();
+    }
+    TouchPointer& pointer = frame.pointers[used];
+    pointer.id = track.id;
+    pointer.began = false;
+    pointer.down = track.down;
+    pointer.cancelled = false;
+    pointer.path.clear();
+    pointer.predicted = track.last;
+    track.frameEntry = static_cast<int32_t>(used++);
+    return pointer;
+}
+
+void TouchInput::UpdateVelocity(Track& track, const TouchSample& sample)
+{
+    int64_t dt = sample.timeNs - track.lastTimeNs;
+    if (dt <= 0) {
+        return;
+    }
+    float vx = (sample.x - track.last.x) / static_cast<float>(dt);
+    float vy = (sample.y - track.last.y) / static_cast<float>(dt);
+    if (!track.hasVelocity || (dt > MAX_SAMPLE_GAP_NS)) {
+        track.vx = vx;
+        track.vy = vy;
+    } else {
+        track.vx = VELOCITY_SMOOTHING * vx + (1 - VELOCITY_SMOOTHING) * track.vx;
+        track.vy = VELOCITY_SMOOTHING * vy + (1 - VELOCITY_SMOOTHING) * track.vy;
+    }
+    track.hasVelocity = true;
+}
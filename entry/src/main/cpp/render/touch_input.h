@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#ifndef TOUCH_INPUT_H
+#define TOUCH_INPUT_H
+
+#include "spsc_queue.h"
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+enum class TouchAction {
+    DOWN,
+    MOVE,
+    UP,
+    CANCEL,
+};
+
+// One touch event for one pointer, in surface pixels
+struct TouchSample {
+    int32_t id;
+    TouchAction action;
+    float x;
+    float y;
+    // Event time; only differences between samples of a pointer are used
+    int64_t timeNs;
+};
+
+struct TouchPosition {
+    float x;
+    float y;
+};
+
+// What one pointer did since the previous frame
+struct TouchPointer {
+    int32_t id;
+    // Went down during this frame; its path starts a new stroke
+    bool began;
+    // Still down at the end of the frame
+    bool down;
+    // Lifted by a CANCEL rather than an UP
+    bool cancelled;
+    // Every position reported since the previous frame, oldest first; all
+    // the moves of one frame coalesce into this one entry
+    std::vector<TouchPosition> path;
+    // Where the pointer is expected to be one lookahead from its last
+    // position; the last position itself once it is up
+    TouchPosition predicted;
+};
+
+struct TouchFrame {
+    // Pointers with something new this frame. A pointer lifted and put down
+    // again within the frame has an entry per stroke. A pointer that stopped
+    // moving gets an entry with an empty path when its prediction is dropped.
+    std::vector<TouchPointer> pointers;
+    // Some pointer still down has a prediction that a later frame will
+    // move or drop, so another frame should be asked for even without input
+    bool predicting = false;
+};
+
+struct TouchInputStats {
+    // Samples pushed, and those lost to a full ring
+    uint64_t samples;
+    uint64_t dropped;
+    // Moves merged into a frame that already had one for their pointer
+    uint64_t coalesced;
+    // Collect() calls that found something
+    uint64_t frames;
+};
+
+// Native touch input, from the thread events arrive on to the render thread:
+//
+//   input thread:   Push(sample) for every event, then ask for a frame
+//   render thread:  Collect(lookahead, frame) once per frame
+//
+// Samples go through a lock-free ring, so the input thread never waits on
+// the renderer. Collect() drains the ring, coalesces each pointer's samples
+// into one TouchPointer with its path, and predicts where every pointer
+// still down will be one lookahead later from a smoothed velocity, so a
+// frame can draw up to where the finger is rather than where it was.
+class TouchInput {
+public:
+    // At 240 Hz touch reporting, over a quarter of a second of one finger
+    static constexpr size_t RING_CAPACITY = 256;
+    // Pointers tracked at once; samples for more are dropped
+    static constexpr uint32_t MAX_POINTERS = 10;
+    // Predictions are kept within this distance of the last position
+    static constexpr float MAX_PREDICTION = 48.0f;
+
+    TouchInput() = default;
+    TouchInput(const TouchInput&) = delete;
+    TouchInput& operator=(const TouchInput&) = delete;
+
+    // Input thread only. Returns false, dropping the sample, when the ring is full.
+    bool Push(const TouchSample& sample);
+
+    // Render thread only. Fills frame with everything pushed since the last
+    // call and returns whether there was anything.
+    bool Collect(int64_t lookaheadNs, TouchFrame& frame);
+
+    // Render thread only. Forget every pointer, e.g. when the surface goes.
+    void Reset();
+
+    // Safe from any thread
+    TouchInputStats GetStats() const;
+
+private:
+    struct Track {
+        int32_t id;
+        bool down;
+        // Entry in the frame being collected, or -1
+        int32_t frameEntry;
+        TouchPosition last;
+        int64_t lastTimeNs;
+        // Pixels per nanosecond, smoothed over the last few moves
+        float vx;
+        float vy;
+        bool hasVelocity;
+        // Collect() calls since it last moved
+        uint32_t idleFrames;
+    };
+
+    Track* FindTrack(int32_t id);
+    TouchPointer& BeginEntry(Track& track, TouchFrame& frame, uint32_t& used);
+    void UpdateVelocity(Track& track, const TouchSample& sample);
+
+    SpscQueue<TouchSample, RING_CAPACITY> ring_;
+    // Render thread only
+    std::vector<Track> tracks_;
+
+    std::atomic<uint64_t> samples_ {0};
+    std::atomic<uint64_t> dropped_ {0};
+    std::atomic<uint64_t> coalesced_ {0};
+    std::atomic<uint64_t> frames_ {0};
+};
+
+#endif // TOUCH_INPUT_H
@@ -0,0 +1,235 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#include "work_stealing_pool.h"
+#include <algorithm>
+#include <cstdio>
+#if defined(__linux__) || defined(__OHOS__)
+#include <sched.h>
+#endif
+
+WorkStealingPool::WorkStealingPool()
+{
+    uint32_t cores = GetPerformanceCoreCount();
+    Start(std::min(cores > 1 ? cores - 1 : 0, MAX_DEFAULT_WORKERS), {});
+}
+
+WorkStealingPool::WorkStealingPool(uint32_t workerCount)
+{
+    Start(workerCount, {});
+}
+
+WorkStealingPool::WorkStealingPool(uint32_t workerCount, const std::vector<uint32_t>& cpus)
+{
+    Start(workerCount, cpus);
+}
+
+WorkStealingPool::~WorkStealingPool() noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        stopping_ = true;
+    }
+    workAvailable_.notify_all();
+    for (std::thread& thread : threads_) {
+        thread.join();
+    }
+}
+
+void WorkStealingPool::Start(uint32_t workerCount, const std::vector<uint32_t>& cpus)
+{
+    for (uint32_t i = 0; i < workerCount; i++) {
+        deques_.emplace_back(new Deque());
+    }
+    for (uint32_t i = 0; i < workerCount; i++) {
+        threads_.emplace_back(&WorkStealingPool::WorkerLoop, this, i, cpus);
+    }
+}
+
+void WorkStealingPool::ParallelFor(uint32_t count, const IndexFn& fn)
+{
+    if (count == 0) {
+        return;
+    }
+    uint32_t workers = GetWorkerCount();
+    if ((workers == 0) || (count == 1)) {
+        for (uint32_t i = 0; i < count; i++) {
+            fn(i);
+        }
+        return;
+    }
+
+    Job job {&fn, {count}};
+    // Contiguous blocks, pushed last index first so each owner pops them in
+    // order while thieves take from the far end of the block
+    uint32_t block = (count + workers - 1) / workers;
+    for (uint32_t w = 0; w < workers; w++) {
+        uint32_t begin = w * block;
+        uint32_t end = std::min(begin + block, count);
+        if (begin >= end) {
+            break;
+        }
+        Deque& deque = *deques_[w];
+        std::lock_guard<std::mutex> lock(deque.mutex);
+        for (uint32_t i = end; i > begin; i--) {
+            deque.tasks.push_back(Task {&job, i - 1});
+        }
+        queued_.fetch_add(end - begin, std::memory_order_release);
+    }
+    {
+        // Pairs with the workers' predicate check, so none misses the tasks
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+    }
+    workAvailable_.notify_all();
+
+    // Help out until the last index has run
+    while (job.remaining.load(std::memory_order_acquire) != 0) {
+        Task task;
+        if (Steal(static_cast<uint32_t>(deques_.size()), task)) {
+            RunTask(task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        jobDone_.wait(lock, [&] {
+            return (job.remaining.load(std::memory_order_acquire) == 0) ||
+                (queued_.load(std::memory_order_acquire) != 0);
+        });
+    }
+}
+
+namespace {
+
+CpuTopology DetectCpuTopology()
+{
+    uint32_t cpus = std::max(std::thread::hardware_concurrency(), 1u);
+    CpuTopology all;
+    for (uint32_t cpu = 0; cpu < cpus; cpu++) {
+        all.performance.push_back(cpu);
+    }
+    std::vector<unsigned long long> maxKhz(cpus, 0);
+    for (uint32_t cpu = 0; cpu < cpus; cpu++) {
+        char path[96];
+        snprintf(path, sizeof(path), "/sys/devices/system/cpu/cpu%u/cpufreq/cpuinfo_max_freq", cpu);
+        FILE* file = fopen(path, "r");
+        if (file == nullptr) {
+            return all;
+        }
+        bool read = fscanf(file, "%llu", &maxKhz[cpu]) == 1;
+        fclose(file);
+        if (!read) {
+            return all;
+        }
+    }
+    unsigned long long fastest = *std::max_element(maxKhz.begin(), maxKhz.end());
+    CpuTopology topology;
+    for (uint32_t cpu = 0; cpu < cpus; cpu++) {
+        (maxKhz[cpu] == fastest ? topology.performance : topology.efficiency).push_back(cpu);
+    }
+    return topology;
+}
+
+} // namespace
+
+const CpuTopology& WorkStealingPool::GetCpuTopology()
+{
+    static const CpuTopology topology = DetectCpuTopology();
+    return topology;
+}
+
+uint32_t WorkStealingPool::GetPerformanceCoreCount()
+{
+    return std::max(static_cast<uint32_t>(GetCpuTopology().performance.size()), 1u);
+}
+
+bool WorkStealingPool::SetThreadCpus(const std::vector<uint32_t>& cpus)
+{
+#if defined(__linux__) || defined(__OHOS__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    for (uint32_t cpu : cpus) {
+        if (cpu < CPU_SETSIZE) {
+            CPU_SET(cpu, &set);
+        }
+    }
+    return (CPU_COUNT(&set) != 0) && (sched_setaffinity(0, sizeof(set), &set) == 0);
+#else
+    (void)cpus;
+    return false;
+#endif
+}
+
+void WorkStealingPool::WorkerLoop(uint32_t self, const std::vector<uint32_t>& cpus)
+{
+    if (!cpus.empty()) {
+        SetThreadCpus(cpus);
+    }
+    while (true) {
+        Task task;
+        if (PopOwn(self, task) || Steal(self, task)) {
+            RunTask(task);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        workAvailable_.wait(lock, [this] { return stopping_ || (queued_.load(std::memory_order_acquire) != 0); });
+        if (stopping_ && (queued_.load(std::memory_order_acquire) == 0)) {
+            return;
+        }
+    }
+}
+
+bool WorkStealingPool::PopOwn(uint32_t self, Task& task)
+{
+    Deque& deque = *deques_[self];
+    std::lock_guard<std::mutex> lock(deque.mutex);
+    if (deque.head == deque.tasks.size()) {
+        return false;
+    }
+    task = deque.tasks.back();
+    deque.tasks.pop_back();
+    if (deque.head == deque.tasks.size()) {
+        deque.tasks.clear();
+        deque.head = 0;
+    }
+    queued_.fetch_sub(1, std::memory_order_acq_rel);
+    return true;
+}
+
+bool WorkStealingPool::Steal(uint32_t self, Task& task)
+{
+    size_t count = deques_.size();
+    for (size_t n = 1; n <= count; n++) {
+        size_t victim = (self + n) % count;
+        if (victim == self) {
+            continue;
+        }
+        Deque& deque = *deques_[victim];
+        std::lock_guard<std::mutex> lock(deque.mutex);
+        if (deque.head == deque.tasks.size()) {
+            continue;
+        }
+        task = deque.tasks[deque.head++];
+        if (deque.head == deque.tasks.size()) {
+            deque.tasks.clear();
+            deque.head = 0;
+        }
+        queued_.fetch_sub(1, std::memory_order_acq_rel);
+        return true;
+    }
+    return false;
+}
+
+void WorkStealingPool::RunTask(const Task& task)
+{
+    Job* job = task.job;
+    (*job->fn)(task.index);
+    if (job->remaining.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        // The job lives on its caller's stack and may be gone after the
+        // decrement; only the pool is touched from here
+        {
+            std::lock_guard<std::mutex> lock(sleepMutex_);
+        }
+        jobDone_.notify_all();
+    }
+}
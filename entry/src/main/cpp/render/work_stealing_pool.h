@@ -0,0 +1,105 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+#ifndef WORK_STEALING_POOL_H
+#define WORK_STEALING_POOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// CPUs grouped by cluster: performance is every CPU running at the highest
+// maximum frequency (the big cores of a big.LITTLE CPU), efficiency the
+// rest. When the frequencies cannot be read every CPU counts as performance.
+struct CpuTopology {
+    std::vector<uint32_t> performance;
+    std::vector<uint32_t> efficiency;
+};
+
+// A fixed set of worker threads for fork-join work, such as rasterizing the
+// tiles of one frame. Every worker has its own deque: it takes its newest
+// task from the back, and when that runs dry steals the oldest task from the
+// front of another's. ParallelFor hands each worker a contiguous block of
+// indices, so a worker usually walks neighbouring tiles, and the calling
+// thread steals too rather than sitting idle.
+class WorkStealingPool {
+public:
+    using IndexFn = std::function<void(uint32_t index)>;
+
+    // Workers besides the threads calling ParallelFor. With no count, one
+    // per performance core, less the caller.
+    WorkStealingPool();
+    explicit WorkStealingPool(uint32_t workerCount);
+    // Workers that only run on cpus, or anywhere when it is empty
+    WorkStealingPool(uint32_t workerCount, const std::vector<uint32_t>& cpus);
+    ~WorkStealingPool() noexcept;
+
+    WorkStealingPool(const WorkStealingPool&) = delete;
+    WorkStealingPool& operator=(const WorkStealingPool&) = delete;
+
+    uint32_t GetWorkerCount() const
+    {
+        return static_cast<uint32_t>(threads_.size());
+    }
+
+    // Run fn(i) for every i in [0, count) and return once all have run.
+    // Safe from any thread; concurrent calls share the workers.
+    void ParallelFor(uint32_t count, const IndexFn& fn);
+
+    // Read once, on first use
+    static const CpuTopology& GetCpuTopology();
+    // GetCpuTopology().performance.size(), at least 1
+    static uint32_t GetPerformanceCoreCount();
+
+    // Keep the calling thread on cpus. False if cpus is empty or the system
+    // refuses; the thread then stays where it was allowed to run.
+    static bool SetThreadCpus(const std::vector<uint32_t>& cpus);
+
+private:
+    static constexpr size_t CACHE_LINE = 64;
+    static constexpr uint32_t MAX_DEFAULT_WORKERS = 7;
+
+    struct Job {
+        const IndexFn* fn;
+        std::atomic<uint32_t> remaining;
+    };
+
+    struct Task {
+        Job* job;
+        uint32_t index;
+    };
+
+    // Owner pops at the back, thieves at head. Storage is kept between
+    // jobs, so steady-state frames do not allocate.
+    struct alignas(CACHE_LINE) Deque {
+        std::mutex mutex;
+        std::vector<Task> tasks;
+        size_t head = 0;
+    };
+
+    void Start(uint32_t workerCount, const std::vector<uint32_t>& cpus);
+    void WorkerLoop(uint32_t self, const std::vector<uint32_t>& cpus);
+    bool PopOwn(uint32_t self, Task& task);
+    // self is skipped; pass deques_.size() to try them all
+    bool Steal(uint32_t self, Task& task);
+    void RunTask(const Task& task);
+
+    std::vector<std::unique_ptr<Deque>> deques_;
+    std::vector<std::thread> threads_;
+
+    std::mutex sleepMutex_;
+    std::condition_variable workAvailable_;
+    std::condition_variable jobDone_;
+    // Tasks pushed and not yet taken, over all deques
+    std::atomic<uint32_t> queued_ {0};
+    bool stopping_ = false;
+};
+
+#endif // WORK_STEALING_POOL_H
@@ -0,0 +1,274 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+// Host-side checks for curve flattening and the curved RasterPath contours
+#include "render/curve_flatten.h"
+#include "render/pixel_blit.h"
+#include "render/tile_raster.h"
+#include "test/test_check.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+constexpr float PI = 3.14159265358979f;
+
+// Distance from p to the segment a-b
+double SegmentDistance(double px, double py, const RasterPoint& a, const RasterPoint& b)
+{
+    double dx = b.x - a.x;
+    double dy = b.y - a.y;
+    double lengthSq = dx * dx + dy * dy;
+    double t = (lengthSq > 0) ? ((px - a.x) * dx + (py - a.y) * dy) / lengthSq : 0;
+    t = std::min(std::max(t, 0.0), 1.0);
+    double ex = a.x + t * dx - px;
+    double ey = a.y + t * dy - py;
+    return std::sqrt(ex * ex + ey * ey);
+}
+
+// Furthest any of samples is from the polyline
+double PolylineError(const std::vector<RasterPoint>& polyline, const std::vector<RasterPoint>& samples)
+{
+    double worst = 0;
+    for (const RasterPoint& s : samples) {
+        double nearest = 1e30;
+        for (size_t i = 0; i + 1 < polyline.size(); i++) {
+            nearest = std::min(nearest, SegmentDistance(s.x, s.y, polyline[i], polyline[i + 1]));
+        }
+        worst = std::max(worst, nearest);
+    }
+    return worst;
+}
+
+// The exact cubic at many t, in double
+std::vector<RasterPoint> SampleCubic(const RasterPoint* p, int count)
+{
+    std::vector<RasterPoint> samples;
+    for (int i = 0; i <= count; i++) {
+        double t = static_cast<double>(i) / count;
+        double u = 1 - t;
+        double b0 = u * u * u;
+        double b1 = 3 * u * u * t;
+        double b2 = 3 * u * t * t;
+        double b3 = t * t * t;
+        samples.push_back(RasterPoint {static_cast<float>(b0 * p[0].x + b1 * p[1].x + b2 * p[2].x + b3 * p[3].x),
+            static_cast<float>(b0 * p[0].y + b1 * p[1].y + b2 * p[2].y + b3 * p[3].y)});
+    }
+    return samples;
+}
+
+std::vector<RasterPoint> FlattenedCubic(const RasterPoint* p, float tolerance)
+{
+    uint32_t segments = GetCubicSegments(p[0], p[1], p[2], p[3], tolerance);
+    std::vector<RasterPoint> polyline(segments + 1);
+    polyline[0] = p[0];
+    FlattenCubic(p[0], p[1], p[2], p[3], segments, &polyline[1]);
+    return polyline;
+}
+
+std::vector<BlitIsa> SupportedIsas()
+{
+    std::vector<BlitIsa> isas;
+    BlitIsa best = GetBlitIsa();
+    for (BlitIsa isa : {BlitIsa::SCALAR, BlitIsa::SSE2, BlitIsa::AVX2, BlitIsa::NEON}) {
+        if (SetBlitIsa(isa)) {
+            isas.push_back(isa);
+        }
+    }
+    SetBlitIsa(best);
+    return isas;
+}
+
+void TestArcSegments()
+{
+    // More for larger radii and tighter tolerances, never fewer than the quarters
+    EXPECT_TRUE(GetArcSegments(0.2f, 2 * PI, 0.25f) == 4);
+    EXPECT_TRUE(GetArcSegments(0.2f, PI / 2, 0.25f) == 1);
+    // Chords of 2 * acos(1 - 0.25 / 2) = 1.01 radians
+    EXPECT_TRUE(GetArcSegments(2, 2 * PI, 0.25f) == 7);
+    uint32_t small = GetArcSegments(10, 2 * PI, 0.25f);
+    uint32_t large = GetArcSegments(200, 2 * PI, 0.25f);
+    EXPECT_TRUE((small >= 8) && (small <= 16));
+    EXPECT_TRUE((large > 3 * small) && (large < 80));
+    EXPECT_TRUE(GetArcSegments(200, 2 * PI, 0.0625f) > large);
+    // A half sweep needs about half
+    uint32_t half = GetArcSegments(200, -PI, 0.25f);
+    EXPECT_TRUE((half >= large / 2) && (half <= large / 2 + 1));
+
+    // Degenerate and extreme input stays in range
+    EXPECT_TRUE(GetArcSegments(0, 2 * PI, 0.25f) == 1);
+    EXPECT_TRUE(GetArcSegments(10, 0, 0.25f) == 1);
+    EXPECT_TRUE(GetArcSegments(1e9f, 2 * PI, 0.25f) == MAX_FLATTEN_SEGMENTS);
+    EXPECT_TRUE(GetArcSegments(10, 2 * PI, 0) == MAX_FLATTEN_SEGMENTS);
+    EXPECT_TRUE(GetArcSegments(10, NAN, 0.25f) == 1);
+}
+
+void TestArcAccuracy()
+{
+    for (float radius : {3.0f, 40.0f, 900.0f}) {
+        const float tolerance = 0.2f;
+        const float start = 0.3f;
+        const float sweep = 1.7f * PI;
+        uint32_t segments = GetArcSegments(radius, sweep, tolerance);
+        std::vector<RasterPoint> arc(segments + 1);
+        FlattenArc(50, -20, radius, start, sweep, segments, arc.data());
+
+        // Every point on the circle, with the ends where the angles say
+        bool onCircle = true;
+        for (const RasterPoint& p : arc) {
+            onCircle = onCircle && (std::fabs(std::hypot(p.x - 50, p.y + 20) - radius) < 1e-3f * radius);
+        }
+        EXPECT_TRUE(onCircle);
+        EXPECT_TRUE(std::fabs(arc[0].x - (50 + radius * std::cos(start))) < 1e-3f * radius);
+        EXPECT_TRUE(arc.back().x == 50 + static_cast<float>(radius * std::cos(static_cast<double>(start) + sweep)));
+
+        // And the true arc within the tolerance of the chords
+        std::vector<RasterPoint> samples;
+        for (int i = 0; i <= 2000; i++) {
+            double angle = start + sweep * i / 2000.0;
+            samples.push_back(RasterPoint {static_cast<float>(50 + radius * std::cos(angle)),
+                static_cast<float>(-20 + radius * std::sin(angle))});
+        }
+        EXPECT_TRUE(PolylineError(arc, samples) <= tolerance * 1.01 + 1e-5 * radius);
+    }
+}
+
+void TestCurveAccuracy()
+{
+    const RasterPoint cubics[][4] = {
+        {{0, 0}, {30, 80}, {90, -40}, {120, 40}},
+        {{10, 10}, {10, 10}, {300, 300}, {300, 10}},
+        {{0, 0}, {100, 0}, {0, 100}, {100, 100}},
+        {{5, 5}, {6, 5}, {7, 5}, {8, 5}},
+    };
+    for (const auto& cubic : cubics) {
+        std::vector<RasterPoint> samples = SampleCubic(cubic, 4000);
+        for (float tolerance : {1.0f, 0.2f, 0.05f}) {
+            std::vector<RasterPoint> polyline = FlattenedCubic(cubic, tolerance);
+            EXPECT_TRUE(PolylineError(polyline, samples) <= tolerance);
+            EXPECT_TRUE((polyline.back().x == cubic[3].x) && (polyline.back().y == cubic[3].y));
+        }
+    }
+    // A straight "curve" is one segment
+    EXPECT_TRUE(GetCubicSegments(cubics[3][0], cubics[3][1], cubics[3][2], cubics[3][3], 0.2f) == 1);
+    // A quarter of the tolerance, about twice the segments
+    uint32_t coarse = GetCubicSegments(cubics[0][0], cubics[0][1], cubics[0][2], cubics[0][3], 0.4f);
+    uint32_t fine = GetCubicSegments(cubics[0][0], cubics[0][1], cubics[0][2], cubics[0][3], 0.1f);
+    EXPECT_TRUE((fine >= 2 * coarse - 1) && (fine <= 2 * coarse + 1));
+
+    // A quad is the cubic with control points two thirds of the way to its own
+    RasterPoint q0 {0, 100};
+    RasterPoint q1 {60, -50};
+    RasterPoint q2 {140, 90};
+    RasterPoint asCubic[4] = {q0, {q0.x + (q1.x - q0.x) * 2 / 3, q0.y + (q1.y - q0.y) * 2 / 3},
+        {q2.x + (q1.x - q2.x) * 2 / 3, q2.y + (q1.y - q2.y) * 2 / 3}, q2};
+    std::vector<RasterPoint> samples = SampleCubic(asCubic, 4000);
+    uint32_t segments = GetQuadSegments(q0, q1, q2, 0.2f);
+    std::vector<RasterPoint> quad(segments + 1);
+    quad[0] = q0;
+    FlattenQuad(q0, q1, q2, segments, &quad[1]);
+    EXPECT_TRUE(PolylineError(quad, samples) <= 0.2);
+    EXPECT_TRUE((quad.back().x == q2.x) && (quad.back().y == q2.y));
+}
+
+void TestKernelsAgree()
+{
+    const RasterPoint p[4] = {{-3.5f, 12}, {400, -250}, {-120, 380}, {260, 90.25f}};
+    BlitIsa best = GetBlitIsa();
+    EXPECT_TRUE(SetBlitIsa(BlitIsa::SCALAR));
+    // Enough points for the vector loops and their tails
+    for (uint32_t segments : {1u, 3u, 4u, 7u, 64u, 301u}) {
+        std::vector<RasterPoint> expected(segments);
+        EXPECT_TRUE(SetBlitIsa(BlitIsa::SCALAR));
+        FlattenCubic(p[0], p[1], p[2], p[3], segments, expected.data());
+        for (BlitIsa isa : SupportedIsas()) {
+            EXPECT_TRUE(SetBlitIsa(isa));
+            std::vector<RasterPoint> points(segments);
+            FlattenCubic(p[0], p[1], p[2], p[3], segments, points.data());
+            bool same = true;
+            for (uint32_t i = 0; i < segments; i++) {
+                same = same && (std::fabs(points[i].x - expected[i].x) < 1e-3f) &&
+                    (std::fabs(points[i].y - expected[i].y) < 1e-3f);
+            }
+            if (!same) {
+                printf("%s differs at %u segments\n", BlitIsaName(isa), segments);
+            }
+            EXPECT_TRUE(same);
+        }
+    }
+    SetBlitIsa(best);
+}
+
+void TestRasterPathShapes()
+{
+    RasterPath path;
+    path.AddCircle(100, 80, 30, FLATTEN_TOLERANCE);
+    EXPECT_TRUE((path.GetContours().size() == 1) && path.GetContours()[0].closed);
+    EXPECT_TRUE(path.GetPoints().size() == GetArcSegments(30, 2 * PI, FLATTEN_TOLERANCE));
+    bool onCircle = true;
+    for (const RasterPoint& p : path.GetPoints()) {
+        onCircle = onCircle && (std::fabs(std::hypot(p.x - 100, p.y - 80) - 30) < 1e-3f);
+    }
+    EXPECT_TRUE(onCircle);
+
+    // A rounded rect keeps to its box and touches every side
+    path.Reset();
+    path.AddRoundRect(10, 20, 110, 70, 12, FLATTEN_TOLERANCE);
+    float left = 1e9f;
+    float top = 1e9f;
+    float right = -1e9f;
+    float bottom = -1e9f;
+    bool repeats = false;
+    const std::vector<RasterPoint>& points = path.GetPoints();
+    for (size_t i = 0; i < points.size(); i++) {
+        left = std::min(left, points[i].x);
+        top = std::min(top, points[i].y);
+        right = std::max(right, points[i].x);
+        bottom = std::max(bottom, points[i].y);
+        const RasterPoint& next = points[(i + 1) % points.size()];
+        repeats = repeats || ((points[i].x == next.x) && (points[i].y == next.y));
+    }
+    EXPECT_TRUE((std::fabs(left - 10) < 1e-4f) && (std::fabs(top - 20) < 1e-4f));
+    EXPECT_TRUE((std::fabs(right - 110) < 1e-4f) && (std::fabs(bottom - 70) < 1e-4f));
+    // The arcs start where the straight sides end, without a repeated point
+    EXPECT_TRUE(!repeats);
+    EXPECT_TRUE((path.GetContours().size() == 1) && path.GetContours()[0].closed);
+
+    // A radius past half the short side is a pill; no radius a plain rect
+    path.Reset();
+    path.AddRoundRect(0, 0, 100, 20, 50, FLATTEN_TOLERANCE);
+    bool pill = true;
+    for (const RasterPoint& p : path.GetPoints()) {
+        pill = pill && (p.y >= -1e-4f) && (p.y <= 20 + 1e-4f);
+    }
+    EXPECT_TRUE(pill);
+    path.Reset();
+    path.AddRoundRect(0, 0, 100, 20, 0, FLATTEN_TOLERANCE);
+    EXPECT_TRUE(path.GetPoints().size() == 4);
+
+    // Curves continue the open contour, or start one where the native path would
+    path.Reset();
+    path.QuadTo(10, 0, 10, 10, FLATTEN_TOLERANCE);
+    EXPECT_TRUE((path.GetPoints()[0].x == 0) && (path.GetPoints()[0].y == 0));
+    path.CubicTo(10, 20, 20, 20, 30, 30, FLATTEN_TOLERANCE);
+    EXPECT_TRUE(path.GetContours().size() == 1);
+    EXPECT_TRUE((path.GetPoints().back().x == 30) && (path.GetPoints().back().y == 30));
+}
+
+} // namespace
+
+int main()
+{
+    TestArcSegments();
+    TestArcAccuracy();
+    TestCurveAccuracy();
+    TestKernelsAgree();
+    TestRasterPathShapes();
+
+    return FinishTest("curve_flatten_test");
+}
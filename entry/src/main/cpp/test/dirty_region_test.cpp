@@ -0,0 +1,106 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+// Host-side checks for dirty-region accumulation
+#include "render/dirty_region.h"
+#include "test/test_check.h"
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+bool Covers(const DirtyRegion& region, uint32_t x, uint32_t y)
+{
+    for (int i = 0; i < region.Count(); i++) {
+        const BlitRect& r = region.Rect(i);
+        if ((x >= r.x) && (x < r.x + r.w) && (y >= r.y) && (y < r.y + r.h)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void TestMergeOverlapping()
+{
+    DirtyRegion region;
+    region.Add(BlitRect {0, 0, 10, 10});
+    region.Add(BlitRect {5, 5, 10, 10});
+    EXPECT_TRUE(region.Count() == 1);
+    EXPECT_TRUE(region.Rect(0).w == 15 && region.Rect(0).h == 15);
+
+    // Disjoint rects stay separate
+    region.Add(BlitRect {100, 100, 4, 4});
+    EXPECT_TRUE(region.Count() == 2);
+    EXPECT_TRUE(region.Area() == 15 * 15 + 16);
+}
+
+void TestBoundedCount()
+{
+    DirtyRegion region;
+    for (uint32_t i = 0; i < 40; i++) {
+        region.Add(BlitRect {i * 20, (i % 3) * 20, 5, 5});
+    }
+    EXPECT_TRUE(region.Count() <= DirtyRegion::MAX_RECTS);
+    // Every added rect is still covered
+    for (uint32_t i = 0; i < 40; i++) {
+        EXPECT_TRUE(Covers(region, i * 20 + 2, (i % 3) * 20 + 2));
+    }
+}
+
+void TestBoundsAndClip()
+{
+    DirtyRegion region;
+    region.AddBounds(10.4f, 20.6f, 30.2f, 40.0f, 2.0f);
+    EXPECT_TRUE(region.Count() == 1);
+    EXPECT_TRUE(region.Rect(0).x == 8 && region.Rect(0).y == 18);
+    EXPECT_TRUE(region.Rect(0).x + region.Rect(0).w == 33);
+    EXPECT_TRUE(region.Rect(0).y + region.Rect(0).h == 42);
+
+    // Negative coordinates are clamped, overhang is clipped
+    region.AddBounds(-50.0f, -50.0f, 5.0f, 5.0f, 0.0f);
+    region.AddBounds(90.0f, 90.0f, 500.0f, 500.0f, 0.0f);
+    region.Clip(100, 100);
+    for (int i = 0; i < region.Count(); i++) {
+        EXPECT_TRUE(region.Rect(i).x + region.Rect(i).w <= 100);
+        EXPECT_TRUE(region.Rect(i).y + region.Rect(i).h <= 100);
+    }
+    EXPECT_TRUE(Covers(region, 0, 0));
+    EXPECT_TRUE(Covers(region, 99, 99));
+
+    // Bounds far off the surface still cover the part on it
+    DirtyRegion far;
+    far.AddBounds(10.0f, 10.0f, 1e20f, 50.0f, 1.0f);
+    far.Clip(100, 100);
+    EXPECT_TRUE(far.Area() == 91 * 42);
+    EXPECT_TRUE(Covers(far, 99, 30));
+}
+
+void TestFull()
+{
+    DirtyRegion region;
+    region.SetFull(64, 32);
+    region.Add(BlitRect {1, 1, 2, 2});
+    EXPECT_TRUE(region.IsFull() && region.Count() == 1 && region.Area() == 64 * 32);
+
+    DirtyRegion other;
+    other.Add(BlitRect {1, 1, 2, 2});
+    other.Add(region);
+    EXPECT_TRUE(other.IsFull());
+
+    other.Clear();
+    EXPECT_TRUE(other.IsEmpty() && !other.IsFull());
+}
+
+} // namespace
+
+int main()
+{
+    TestMergeOverlapping();
+    TestBoundedCount();
+    TestBoundsAndClip();
+    TestFull();
+
+    return FinishTest("dirty_region_test");
+}
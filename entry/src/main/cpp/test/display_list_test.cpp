@@ -0,0 +1,325 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+// Host-side checks for display-list validation and replay
+#include "render/display_list.h"
+#include "test/test_check.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace {
+
+// Records the calls as text so a replay can be compared in one check
+class TraceSink : public DisplayListSink {
+public:
+    std::string trace;
+    DrawBounds lastBounds {0, 0, 0, 0};
+    // Layers seen, and whether their content is skipped
+    uint64_t lastContent = 0;
+    bool skipLayers = false;
+
+    void Clear(uint32_t color) override
+    {
+        Append("clear %08x;", color);
+    }
+    void MoveTo(float x, float y) override
+    {
+        Append("M%g,%g;", x, y);
+    }
+    void LineTo(float x, float y) override
+    {
+        Append("L%g,%g;", x, y);
+    }
+    void QuadTo(float x1, float y1, float x2, float y2) override
+    {
+        Append("Q%g,%g,%g,%g;", x1, y1, x2, y2);
+    }
+    void CubicTo(float x1, float y1, float x2, float y2, float x3, float y3) override
+    {
+        Append("C%g,%g,%g,%g,%g,%g;", x1, y1, x2, y2, x3, y3);
+    }
+    void ArcTo(float cx, float cy, float radius, float startAngle, float sweep) override
+    {
+        Append("A%g,%g,%g,%g,%g;", cx, cy, radius, startAngle, sweep);
+    }
+    void RoundRect(float left, float top, float right, float bottom, float radius) override
+    {
+        Append("R%g,%g,%g,%g,%g;", left, top, right, bottom, radius);
+    }
+    void Close() override
+    {
+        trace += "Z;";
+    }
+    void Fill(uint32_t color, const DrawBounds& bounds) override
+    {
+        Append("fill %08x;", color);
+        lastBounds = bounds;
+    }
+    void Stroke(uint32_t color, float width, const DrawBounds& bounds) override
+    {
+        Append("stroke %08x %g;", color, width);
+        lastBounds = bounds;
+    }
+    bool BeginLayer(uint32_t id, const DrawBounds& bounds, uint64_t content) override
+    {
+        Append("layer %u;", id);
+        lastBounds = bounds;
+        lastContent = content;
+        return !skipLayers;
+    }
+    void EndLayer() override
+    {
+        trace += "end;";
+    }
+
+private:
+    template <typename... Args>
+    void Append(const char* format, Args... args)
+    {
+        // Sized to the output, so no call is ever cut short
+        int length = snprintf(nullptr, 0, format, args...);
+        if (length <= 0) {
+            return;
+        }
+        size_t start = trace.size();
+        trace.resize(start + length + 1);
+        snprintf(&trace[start], length + 1, format, args...);
+        trace.resize(start + length);
+    }
+};
+
+void TestReplay()
+{
+    DisplayListBuilder builder;
+    builder.Clear(0xFFFFFFFF).Color(0xFF00FF00).MoveTo(10, 20).LineTo(30, 5).LineTo(15, 40).Close().Fill();
+    builder.Color(0xFFFF0000).Width(4).MoveTo(1, 2).LineTo(3, 4).Stroke();
+
+    DisplayList list;
+    EXPECT_TRUE(list.Load(builder.Data(), builder.Size()));
+    EXPECT_TRUE(list.SizeInBytes() == builder.Size());
+
+    TraceSink sink;
+    list.Replay(sink);
+    EXPECT_TRUE(sink.trace == "clear ffffffff;M10,20;L30,5;L15,40;Z;fill ff00ff00;"
+                              "M1,2;L3,4;stroke ffff0000 4;");
+    // Bounds of the last draw only cover its own path
+    EXPECT_TRUE(sink.lastBounds.left == 1 && sink.lastBounds.top == 2);
+    EXPECT_TRUE(sink.lastBounds.right == 3 && sink.lastBounds.bottom == 4);
+}
+
+void TestFillBounds()
+{
+    DisplayListBuilder builder;
+    builder.MoveTo(10, 20).LineTo(30, 5).LineTo(15, 40).Fill();
+    DisplayList list;
+    EXPECT_TRUE(list.Load(builder.Data(), builder.Size()));
+    TraceSink sink;
+    list.Replay(sink);
+    EXPECT_TRUE(sink.lastBounds.left == 10 && sink.lastBounds.top == 5);
+    EXPECT_TRUE(sink.lastBounds.right == 30 && sink.lastBounds.bottom == 40);
+}
+
+void TestCurves()
+{
+    DisplayListBuilder builder;
+    builder.MoveTo(10, 20).QuadTo(50, 0, 60, 30).CubicTo(70, 40, 0, 90, 5, 50).Fill();
+    DisplayList list;
+    EXPECT_TRUE(list.Load(builder.Data(), builder.Size()));
+    TraceSink sink;
+    list.Replay(sink);
+    EXPECT_TRUE(sink.trace == "M10,20;Q50,0,60,30;C70,40,0,90,5,50;fill ff000000;");
+    // Control points count towards the bounds
+    EXPECT_TRUE(sink.lastBounds.left == 0 && sink.lastBounds.top == 0);
+    EXPECT_TRUE(sink.lastBounds.right == 70 && sink.lastBounds.bottom == 90);
+
+    // Every argument is there and finite
+    EXPECT_TRUE(!list.Load(builder.Data(), 6 * sizeof(uint32_t)));
+    DisplayListBuilder nan;
+    nan.MoveTo(0, 0).CubicTo(1, 2, 3, 4, 5, NAN).Fill();
+    EXPECT_TRUE(!list.Load(nan.Data(), nan.Size()));
+}
+
+void TestArcs()
+{
+    DisplayListBuilder builder;
+    builder.MoveTo(50, 50).ArcTo(50, 50, 20, 0, 1.5f).Close().Fill();
+    builder.RoundRect(100, 10, 160, 40, 8).Stroke();
+    DisplayList list;
+    EXPECT_TRUE(list.Load(builder.Data(), builder.Size()));
+    TraceSink sink;
+    list.Replay(sink);
+    EXPECT_TRUE(sink.trace == "M50,50;A50,50,20,0,1.5;Z;fill ff000000;R100,10,160,40,8;stroke ff000000 1;");
+    // The rect alone; the arc's whole circle went to the fill before it
+    EXPECT_TRUE(sink.lastBounds.left == 100 && sink.lastBounds.top == 10);
+    EXPECT_TRUE(sink.lastBounds.right == 160 && sink.lastBounds.bottom == 40);
+
+    DisplayListBuilder arc;
+    arc.MoveTo(0, 0).ArcTo(50, 50, 20, 0, 1.5f).Fill();
+    EXPECT_TRUE(list.Load(arc.Data(), arc.Size()));
+    list.Replay(sink);
+    EXPECT_TRUE(sink.lastBounds.left == 0 && sink.lastBounds.top == 0);
+    EXPECT_TRUE(sink.lastBounds.right == 70 && sink.lastBounds.bottom == 70);
+
+    // A radius of zero is a plain rect; a negative one is refused
+    DisplayListBuilder square;
+    square.RoundRect(0, 0, 10, 10, 0).Fill();
+    EXPECT_TRUE(list.Load(square.Data(), square.Size()));
+    DisplayListBuilder negative;
+    negative.RoundRect(0, 0, 10, 10, -1).Fill();
+    EXPECT_TRUE(!list.Load(negative.Data(), negative.Size()));
+    DisplayListBuilder negativeArc;
+    negativeArc.MoveTo(0, 0).ArcTo(5, 5, -2, 0, 1).Fill();
+    EXPECT_TRUE(!list.Load(negativeArc.Data(), negativeArc.Size()));
+}
+
+void TestLayers()
+{
+    auto build = [](uint32_t inside, uint32_t outside, float width = 4) {
+        DisplayListBuilder builder;
+        builder.Color(outside).MoveTo(0, 0).LineTo(5, 0).LineTo(0, 5).Fill();
+        builder.Width(width).LayerBegin(7).Color(inside).RoundRect(10, 20, 50, 40, 6).Fill();
+        builder.MoveTo(60, 30).LineTo(80, 30).Stroke().LayerEnd().Stroke();
+        return builder;
+    };
+    DisplayListBuilder builder = build(0xFF00FF00, 0xFF0000FF);
+    DisplayList list;
+    EXPECT_TRUE(list.Load(builder.Data(), builder.Size()));
+    TraceSink sink;
+    list.Replay(sink);
+    // The color set inside ends with the layer; the width set before it holds
+    EXPECT_TRUE(sink.trace == "M0,0;L5,0;L0,5;fill ff0000ff;layer 7;R10,20,50,40,6;fill ff00ff00;M60,30;L80,30;"
+        "stroke ff00ff00 4;end;stroke ff0000ff 4;");
+    uint64_t content = sink.lastContent;
+
+    // Bounds of everything inside, the stroke's half width included
+    TraceSink skipping;
+    skipping.skipLayers = true;
+    list.Replay(skipping);
+    EXPECT_TRUE(skipping.trace == "M0,0;L5,0;L0,5;fill ff0000ff;layer 7;stroke ff0000ff 4;");
+    DisplayListBuilder layerOnly;
+    layerOnly.Width(4).LayerBegin(7).Color(0xFF00FF00).RoundRect(10, 20, 50, 40, 6).Fill();
+    layerOnly.MoveTo(60, 30).LineTo(80, 30).Stroke().LayerEnd();
+    EXPECT_TRUE(list.Load(layerOnly.Data(), layerOnly.Size()));
+    list.Replay(skipping);
+    EXPECT_TRUE(skipping.lastBounds.left == 10 && skipping.lastBounds.top == 20);
+    EXPECT_TRUE(skipping.lastBounds.right == 82 && skipping.lastBounds.bottom == 40);
+
+    // The content changes with what is drawn inside, and the width it is
+    // drawn with wherever that was set, not with anything else
+    DisplayListBuilder outside = build(0xFF00FF00, 0xFFFF0000);
+    EXPECT_TRUE(list.Load(outside.Data(), outside.Size()));
+    list.Replay(sink);
+    EXPECT_TRUE(sink.lastContent == content);
+    DisplayListBuilder inside = build(0xFF008000, 0xFF0000FF);
+    EXPECT_TRUE(list.Load(inside.Data(), inside.Size()));
+    list.Replay(sink);
+    EXPECT_TRUE(sink.lastContent != content);
+    DisplayListBuilder wider = build(0xFF00FF00, 0xFF0000FF, 5);
+    EXPECT_TRUE(list.Load(wider.Data(), wider.Size()));
+    list.Replay(sink);
+    EXPECT_TRUE(sink.lastContent != content);
+
+    // A layer that draws nothing is passed over
+    DisplayListBuilder empty;
+    empty.LayerBegin(1).Color(0xFFFFFFFF).LayerEnd().MoveTo(1, 1).LineTo(2, 2).Stroke();
+    EXPECT_TRUE(list.Load(empty.Data(), empty.Size()));
+    TraceSink plain;
+    list.Replay(plain);
+    EXPECT_TRUE(plain.trace == "M1,1;L2,2;stroke ff000000 1;");
+}
+
+void TestRejectsMalformed()
+{
+    DisplayList list;
+
+    // Not a whole number of words
+    uint8_t bytes[6] = {1, 0, 0, 0, 0, 0};
+    EXPECT_TRUE(!list.Load(bytes, sizeof(bytes)));
+
+    // Unknown opcodes
+    uint32_t unknown[] = {0};
+    EXPECT_TRUE(!list.Load(unknown, sizeof(unknown)));
+    uint32_t tooHigh[] = {99};
+    EXPECT_TRUE(!list.Load(tooHigh, sizeof(tooHigh)));
+
+    // MOVE_TO with one of its two arguments
+    DisplayListBuilder builder;
+    builder.MoveTo(1, 2);
+    EXPECT_TRUE(!list.Load(builder.Data(), builder.Size() - sizeof(uint32_t)));
+    EXPECT_TRUE(list.IsEmpty());
+
+    // Non-finite coordinates
+    DisplayListBuilder nan;
+    nan.MoveTo(NAN, 0).Fill();
+    EXPECT_TRUE(!list.Load(nan.Data(), nan.Size()));
+    DisplayListBuilder inf;
+    inf.Width(INFINITY).Stroke();
+    EXPECT_TRUE(!list.Load(inf.Data(), inf.Size()));
+
+    // Layers that nest, do not end, end unopened, clear the surface, cut a
+    // path in two or take an id out of range
+    DisplayListBuilder nested;
+    nested.LayerBegin(1).LayerBegin(2).LayerEnd().LayerEnd();
+    EXPECT_TRUE(!list.Load(nested.Data(), nested.Size()));
+    DisplayListBuilder unended;
+    unended.LayerBegin(1).MoveTo(0, 0).LineTo(1, 1).Fill();
+    EXPECT_TRUE(!list.Load(unended.Data(), unended.Size()));
+    DisplayListBuilder unopened;
+    unopened.LayerEnd();
+    EXPECT_TRUE(!list.Load(unopened.Data(), unopened.Size()));
+    DisplayListBuilder clear;
+    clear.LayerBegin(1).Clear(0xFFFFFFFF).LayerEnd();
+    EXPECT_TRUE(!list.Load(clear.Data(), clear.Size()));
+    DisplayListBuilder split;
+    split.MoveTo(0, 0).LayerBegin(1).LineTo(1, 1).Fill().LayerEnd();
+    EXPECT_TRUE(!list.Load(split.Data(), split.Size()));
+    DisplayListBuilder id;
+    id.LayerBegin(DisplayList::MAX_LAYER_ID).LayerEnd();
+    EXPECT_TRUE(!list.Load(id.Data(), id.Size()));
+    id = DisplayListBuilder();
+    id.LayerBegin(DisplayList::MAX_LAYER_ID - 1).LayerEnd();
+    EXPECT_TRUE(list.Load(id.Data(), id.Size()));
+
+    // Colors may be any bit pattern
+    uint32_t color[] = {static_cast<uint32_t>(DisplayListOp::COLOR), 0x7FC00000};
+    EXPECT_TRUE(list.Load(color, sizeof(color)));
+
+    // An empty list is valid and draws nothing
+    EXPECT_TRUE(list.Load(nullptr, 0));
+    TraceSink sink;
+    list.Replay(sink);
+    EXPECT_TRUE(sink.trace.empty());
+}
+
+void TestEquals()
+{
+    DisplayListBuilder builder;
+    builder.Color(0xFF112233).MoveTo(0, 0).LineTo(5, 5).Stroke();
+    DisplayList list;
+    EXPECT_TRUE(list.Load(builder.Data(), builder.Size()));
+    EXPECT_TRUE(list.Equals(builder.Data(), builder.Size()));
+
+    DisplayListBuilder moved;
+    moved.Color(0xFF112233).MoveTo(0, 0).LineTo(5, 6).Stroke();
+    EXPECT_TRUE(!list.Equals(moved.Data(), moved.Size()));
+    EXPECT_TRUE(!list.Equals(builder.Data(), builder.Size() - sizeof(uint32_t)));
+}
+
+} // namespace
+
+int main()
+{
+    TestReplay();
+    TestFillBounds();
+    TestCurves();
+    TestArcs();
+    TestLayers();
+    TestRejectsMalformed();
+    TestEquals();
+
+    return FinishTest("display_list_test");
+}
@@ -0,0 +1,76 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+// Host-side checks for the logging macros: levels compiled out and the
+// per-call-site rate limit
+#define DRAWING_LOG_LEVEL DRAWING_LOG_LEVEL_WARN
+#include "common/drawing_log.h"
+#include "test/test_check.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+
+namespace {
+
+int g_evaluated = 0;
+
+int Evaluate()
+{
+    return ++g_evaluated;
+}
+
+void TestLevels()
+{
+    g_evaluated = 0;
+    // Below the level: neither written nor evaluated
+    DRAWING_LOGD("drawing_log_test: debug %d\n", Evaluate());
+    DRAWING_LOGI("drawing_log_test: info %d\n", Evaluate());
+    EXPECT_TRUE(g_evaluated == 0);
+
+    DRAWING_LOGW("drawing_log_test: warning %d\n", Evaluate());
+    DRAWING_LOGE("drawing_log_test: error %d\n", Evaluate());
+    EXPECT_TRUE(g_evaluated == 2);
+}
+
+void TestRateLimit()
+{
+    DrawingLog::RateLimit limit;
+    uint32_t suppressed = 99;
+    EXPECT_TRUE(limit.Allow(5000, 1000, suppressed) && (suppressed == 0));
+    EXPECT_TRUE(!limit.Allow(5001, 1000, suppressed));
+    EXPECT_TRUE(!limit.Allow(5999, 1000, suppressed));
+    EXPECT_TRUE(limit.Allow(6000, 1000, suppressed) && (suppressed == 2));
+    EXPECT_TRUE(limit.Allow(9000, 1000, suppressed) && (suppressed == 0));
+
+    // Each call site has its own limit, and a held-back message is not formatted
+    g_evaluated = 0;
+    for (int i = 0; i < 100; i++) {
+        DRAWING_LOGE_LIMITED("drawing_log_test: limited error %d\n", Evaluate());
+    }
+    EXPECT_TRUE(g_evaluated == 1);
+    for (int i = 0; i < 100; i++) {
+        DRAWING_LOGW_LIMITED("drawing_log_test: limited warning %d\n", Evaluate());
+    }
+    EXPECT_TRUE(g_evaluated == 2);
+}
+
+void TestLongMessage()
+{
+    // Cut to MAX_MESSAGE rather than overrun
+    std::string text(4 * DrawingLog::MAX_MESSAGE, 'x');
+    DrawingLog::Write(DRAWING_LOG_LEVEL_WARN, 7, "drawing_log_test: %s\n", text.c_str());
+    DrawingLog::Write(DRAWING_LOG_LEVEL_WARN, 0, "%s", "");
+}
+
+} // namespace
+
+int main()
+{
+    TestLevels();
+    TestRateLimit();
+    TestLongMessage();
+
+    return FinishTest("drawing_log_test");
+}
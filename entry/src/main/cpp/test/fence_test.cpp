@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+// Host-side checks for fence polling, with pipes standing in for sync fences
+#include "render/fence.h"
+#include "test/test_check.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <unistd.h>
+
+namespace {
+
+void TestNoFence()
+{
+    int fence = -1;
+    EXPECT_TRUE(PollFence(fence) == FenceStatus::SIGNALED);
+    EXPECT_TRUE(WaitFence(fence, -1) == FenceStatus::SIGNALED);
+    CloseFence(fence);
+    EXPECT_TRUE(fence == -1);
+}
+
+void TestPendingThenSignaled()
+{
+    int fds[2];
+    if (pipe(fds) != 0) {
+        EXPECT_TRUE(false);
+        return;
+    }
+    int fence = fds[0];
+    EXPECT_TRUE(PollFence(fence) == FenceStatus::PENDING);
+    EXPECT_TRUE(WaitFence(fence, 5) == FenceStatus::PENDING);
+
+    // Signaled from another thread while we wait
+    std::thread signaler([&fds]() {
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        char byte = 1;
+        ssize_t written = write(fds[1], &byte, 1);
+        (void)written;
+    });
+    EXPECT_TRUE(WaitFence(fence, 5000) == FenceStatus::SIGNALED);
+    signaler.join();
+    EXPECT_TRUE(PollFence(fence) == FenceStatus::SIGNALED);
+
+    CloseFence(fence);
+    EXPECT_TRUE(fence == -1);
+    close(fds[1]);
+}
+
+void TestClosedFence()
+{
+    int fds[2];
+    if (pipe(fds) != 0) {
+        EXPECT_TRUE(false);
+        return;
+    }
+    close(fds[0]);
+    close(fds[1]);
+    // A closed fd must not be waited on forever
+    EXPECT_TRUE(WaitFence(fds[0], -1) == FenceStatus::INVALID);
+}
+
+} // namespace
+
+int main()
+{
+    TestNoFence();
+    TestPendingThenSignaled();
+    TestClosedFence();
+
+    return FinishTest("fence_test");
+}
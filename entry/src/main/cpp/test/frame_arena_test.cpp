@@ -0,0 +1,252 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+// Host-side checks for the per-frame arena, and that steady frames of the
+// tile rasterizer stay off the heap
+#include "render/frame_arena.h"
+#include "render/tile_raster.h"
+#include "test/test_check.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <vector>
+
+// Every heap allocation in this program goes through here. Out of line:
+// inlined into a caller, GCC sees malloc or free paired with operator delete
+// or new and warns (-Wmismatched-new-delete) about a pair that matches here.
+static std::atomic<uint64_t> g_heapAllocations {0};
+
+__attribute__((noinline)) void* operator new(size_t size)
+{
+    g_heapAllocations.fetch_add(1, std::memory_order_relaxed);
+    void* pointer = std::malloc(size == 0 ? 1 : size);
+    if (pointer == nullptr) {
+        throw std::bad_alloc();
+    }
+    return pointer;
+}
+
+__attribute__((noinline)) void operator delete(void* pointer) noexcept
+{
+    std::free(pointer);
+}
+
+__attribute__((noinline)) void operator delete(void* pointer, size_t) noexcept
+{
+    std::free(pointer);
+}
+
+namespace {
+
+uint64_t HeapAllocations()
+{
+    return g_heapAllocations.load(std::memory_order_relaxed);
+}
+
+bool IsAligned(const void* pointer, size_t alignment)
+{
+    return reinterpret_cast<uintptr_t>(pointer) % alignment == 0;
+}
+
+void TestBumpAndAlignment()
+{
+    FrameArena arena;
+    EXPECT_TRUE(arena.GetStats().capacity == 0);
+
+    uint8_t* a = static_cast<uint8_t*>(arena.Allocate(3, 1));
+    uint8_t* b = static_cast<uint8_t*>(arena.Allocate(8, 8));
+    uint8_t* c = static_cast<uint8_t*>(arena.Allocate(1, 16));
+    uint8_t* d = static_cast<uint8_t*>(arena.Allocate(100, 4));
+    EXPECT_TRUE(IsAligned(b, 8) && IsAligned(c, 16) && IsAligned(d, 4));
+    // Handed out in order, without overlap
+    EXPECT_TRUE((a + 3 <= b) && (b + 8 <= c) && (c + 1 <= d));
+    EXPECT_TRUE(arena.GetUsedBytes() >= 3 + 8 + 1 + 100);
+    EXPECT_TRUE(arena.GetUsedBytes() <= 3 + 8 + 1 + 100 + 7 + 15 + 3);
+    FrameArenaStats stats = arena.GetStats();
+    EXPECT_TRUE((stats.capacity >= FrameArena::MIN_BLOCK_SIZE) && (stats.blockAllocations == 1));
+
+    // Writable end to end
+    memset(a, 1, 3);
+    memset(d, 2, 100);
+
+    // After a reset the same memory comes back
+    arena.Reset();
+    EXPECT_TRUE(arena.GetUsedBytes() == 0);
+    EXPECT_TRUE(arena.Allocate(3, 1) == a);
+    EXPECT_TRUE(arena.GetStats().blockAllocations == 1);
+}
+
+void TestSpillIsMerged()
+{
+    FrameArena arena;
+    // A frame well past one block
+    const size_t chunk = 10000;
+    const int chunks = 40;
+    for (int i = 0; i < chunks; i++) {
+        memset(arena.Allocate(chunk, 16), i, chunk);
+    }
+    FrameArenaStats grown = arena.GetStats();
+    EXPECT_TRUE(grown.blockAllocations > 1);
+    EXPECT_TRUE(grown.capacity >= chunk * chunks);
+    arena.Reset();
+
+    // One block now holds the whole frame
+    FrameArenaStats merged = arena.GetStats();
+    EXPECT_TRUE(merged.peakBytes >= chunk * chunks);
+    EXPECT_TRUE(merged.capacity >= merged.peakBytes);
+    EXPECT_TRUE(merged.blockAllocations == grown.blockAllocations + 1);
+
+    // Frames of that size or smaller take nothing more from the heap
+    uint64_t heap = HeapAllocations();
+    for (int frame = 0; frame < 10; frame++) {
+        for (int i = 0; i < chunks - frame; i++) {
+            arena.Allocate(chunk, 16);
+        }
+        arena.Reset();
+    }
+    EXPECT_TRUE(HeapAllocations() == heap);
+    EXPECT_TRUE(arena.GetStats().blockAllocations == merged.blockAllocations);
+    EXPECT_TRUE(arena.GetStats().steadyAllocations == 0);
+
+    // A bigger frame grows it again; that is not a steady frame
+    for (int i = 0; i < 2 * chunks; i++) {
+        arena.Allocate(chunk, 16);
+    }
+    arena.Reset();
+    EXPECT_TRUE(arena.GetStats().blockAllocations > merged.blockAllocations);
+    EXPECT_TRUE(arena.GetStats().steadyAllocations == 0);
+
+    arena.Release();
+    EXPECT_TRUE(arena.GetStats().capacity == 0);
+}
+
+void TestFrameVector()
+{
+    // Without an arena: the heap, as std::vector
+    FrameVector<int> onHeap;
+    uint64_t heap = HeapAllocations();
+    for (int i = 0; i < 1000; i++) {
+        onHeap.push_back(i);
+    }
+    EXPECT_TRUE(HeapAllocations() > heap);
+    EXPECT_TRUE((onHeap.size() == 1000) && (onHeap[999] == 999));
+
+    FrameArena arena;
+    auto frame = [&arena]() {
+        // Vectors of a frame, dropped before the arena takes their memory back
+        FrameVector<float> points {FrameAllocator<float>(&arena)};
+        FrameVector<uint16_t> indices {FrameAllocator<uint16_t>(&arena)};
+        for (int i = 0; i < 5000; i++) {
+            points.push_back(static_cast<float>(i));
+            indices.push_back(static_cast<uint16_t>(i));
+        }
+        bool intact = (points[4999] == 4999.0f) && (indices[1234] == 1234);
+        // Moved vectors keep the arena
+        FrameVector<float> moved = std::move(points);
+        moved.push_back(1.0f);
+        intact = intact && (moved.get_allocator().GetArena() == &arena);
+        arena.Reset();
+        return intact;
+    };
+    EXPECT_TRUE(frame());
+    EXPECT_TRUE(frame());
+    heap = HeapAllocations();
+    bool intact = true;
+    for (int i = 0; i < 20; i++) {
+        intact = intact && frame();
+    }
+    EXPECT_TRUE(intact);
+    EXPECT_TRUE(HeapAllocations() == heap);
+}
+
+constexpr uint32_t WIDTH = 640;
+constexpr uint32_t HEIGHT = 480;
+
+// A stroke like a finger drag, with its own start
+void BuildStroke(RasterPath& path, float x, float y)
+{
+    path.Reset();
+    path.MoveTo(x, y);
+    for (int i = 1; i <= 24; i++) {
+        path.LineTo(x + i * 9.0f, y + 40.0f * std::sin(i * 0.4f));
+    }
+}
+
+void DrawFrame(TileRasterizer& rasterizer, const PixelSurface& surface, RasterPath& path, int frame)
+{
+    // Moves over the surface, into tiles the previous frames did not touch
+    float x = static_cast<float>((frame * 37) % (WIDTH - 240));
+    float y = static_cast<float>(50 + (frame * 53) % (HEIGHT - 100));
+    rasterizer.Begin(surface);
+    BuildStroke(path, x, y);
+    rasterizer.Stroke(path, 6.0f, 0xFF202020);
+    path.Reset();
+    path.MoveTo(x, y);
+    path.LineTo(x + 120, y + 10);
+    path.LineTo(x + 60, y + 90);
+    path.Close();
+    rasterizer.Fill(path, 0x8000A0FF);
+    rasterizer.Flush(nullptr);
+}
+
+void TestTileRasterizerSteadyFrames()
+{
+    std::vector<uint32_t> pixels(WIDTH * HEIGHT, 0xFFFFFFFF);
+    std::vector<uint32_t> reference(WIDTH * HEIGHT, 0xFFFFFFFF);
+    PixelSurface surface {pixels.data(), WIDTH, HEIGHT, WIDTH * 4, PixelFormat::RGBA_8888};
+    PixelSurface referenceSurface {reference.data(), WIDTH, HEIGHT, WIDTH * 4, PixelFormat::RGBA_8888};
+    FrameArena arena;
+    TileRasterizer rasterizer;
+    rasterizer.SetArena(&arena);
+    TileRasterizer onHeap;
+    RasterPath path;
+    const int frames = 40;
+
+    // Same pixels as recording on the heap
+    bool same = true;
+    for (int frame = 0; frame < frames; frame++) {
+        DrawFrame(rasterizer, surface, path, frame);
+        arena.Reset();
+        DrawFrame(onHeap, referenceSurface, path, frame);
+        same = same && (pixels == reference);
+    }
+    EXPECT_TRUE(same);
+    EXPECT_TRUE(rasterizer.GetLastTileCount() > 0);
+
+    // The same motion again: every frame fits what the first pass needed
+    uint64_t heap = HeapAllocations();
+    uint64_t blocks = arena.GetStats().blockAllocations;
+    for (int frame = 0; frame < frames; frame++) {
+        DrawFrame(rasterizer, surface, path, frame);
+        arena.Reset();
+    }
+    EXPECT_TRUE(HeapAllocations() == heap);
+    EXPECT_TRUE(arena.GetStats().blockAllocations == blocks);
+    EXPECT_TRUE(arena.GetStats().steadyAllocations == 0);
+
+    // Back on the heap it still draws
+    rasterizer.SetArena(nullptr);
+    std::fill(pixels.begin(), pixels.end(), 0xFFFFFFFF);
+    std::fill(reference.begin(), reference.end(), 0xFFFFFFFF);
+    DrawFrame(rasterizer, surface, path, 0);
+    DrawFrame(onHeap, referenceSurface, path, 0);
+    EXPECT_TRUE(pixels == reference);
+}
+
+} // namespace
+
+int main()
+{
+    TestBumpAndAlignment();
+    TestSpillIsMerged();
+    TestFrameVector();
+    TestTileRasterizerSteadyFrames();
+
+    return FinishTest("frame_arena_test");
+}
@@ -0,0 +1,215 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+// Host-side checks for vsync pacing: coalescing, skipping and the timer source
+#include "render/frame_scheduler.h"
+#include "render/render_thread.h"
+#include "test/test_check.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+namespace {
+
+// Vsyncs delivered by hand, on the calling thread
+class ManualVsyncSource : public VsyncSource {
+public:
+    explicit ManualVsyncSource(FrameScheduler& scheduler) : scheduler_(scheduler) {}
+
+    bool RequestVsync() override
+    {
+        requests++;
+        requested = true;
+        return true;
+    }
+
+    // Deliver the vsync if one was asked for
+    bool Tick(int64_t timestampNs)
+    {
+        if (!requested) {
+            return false;
+        }
+        requested = false;
+        scheduler_.OnVsync(timestampNs);
+        return true;
+    }
+
+    int requests = 0;
+    bool requested = false;
+
+private:
+    FrameScheduler& scheduler_;
+};
+
+void TestCoalescing()
+{
+    int wakes = 0;
+    FrameScheduler scheduler([&wakes]() { wakes++; });
+    ManualVsyncSource source(scheduler);
+    scheduler.SetVsyncSource(&source);
+
+    // Nothing requested: no vsync asked for, nothing due
+    EXPECT_TRUE(!source.Tick(1));
+    EXPECT_TRUE(!scheduler.FrameDue());
+
+    // A burst of requests asks for one vsync and gets one frame
+    for (int i = 0; i < 10; i++) {
+        scheduler.RequestFrame();
+    }
+    EXPECT_TRUE(source.requests == 1);
+    EXPECT_TRUE(!scheduler.FrameDue());
+    EXPECT_TRUE(source.Tick(100));
+    EXPECT_TRUE(wakes == 1);
+    EXPECT_TRUE(scheduler.GetVsyncTimestamp() == 100);
+    EXPECT_TRUE(scheduler.FrameDue());
+    scheduler.FrameDone();
+    EXPECT_TRUE(!scheduler.FrameDue());
+
+    // Idle again: the next vsync is not asked for
+    EXPECT_TRUE(!source.Tick(200));
+
+    // A request during the frame gets the next vsync
+    scheduler.RequestFrame();
+    EXPECT_TRUE(source.Tick(300));
+    EXPECT_TRUE(scheduler.FrameDue());
+    scheduler.RequestFrame();
+    scheduler.FrameDone();
+    EXPECT_TRUE(source.Tick(400));
+    EXPECT_TRUE(scheduler.FrameDue());
+    scheduler.FrameDone();
+
+    FrameSchedulerStats stats = scheduler.GetStats();
+    EXPECT_TRUE(stats.requests == 12);
+    EXPECT_TRUE(stats.frames == 3);
+    EXPECT_TRUE(stats.skipped == 0);
+}
+
+void TestSkipWhileBufferBusy()
+{
+    FrameScheduler scheduler([]() {});
+    ManualVsyncSource source(scheduler);
+    scheduler.SetVsyncSource(&source);
+
+    scheduler.RequestFrame();
+    EXPECT_TRUE(source.Tick(1));
+    EXPECT_TRUE(scheduler.FrameDue());
+    // The buffer is still with the consumer: the frame moves to the next vsync
+    scheduler.SkipFrame();
+    EXPECT_TRUE(source.requested);
+    EXPECT_TRUE(!scheduler.FrameDue());
+    EXPECT_TRUE(source.Tick(2));
+    EXPECT_TRUE(scheduler.FrameDue());
+    scheduler.SkipFrame();
+    EXPECT_TRUE(source.Tick(3));
+    EXPECT_TRUE(scheduler.FrameDue());
+    scheduler.FrameDone();
+    EXPECT_TRUE(!source.Tick(4));
+
+    FrameSchedulerStats stats = scheduler.GetStats();
+    EXPECT_TRUE(stats.requests == 1);
+    EXPECT_TRUE(stats.frames == 1);
+    EXPECT_TRUE(stats.skipped == 2);
+}
+
+void TestThrottle()
+{
+    FrameScheduler scheduler([]() {});
+    ManualVsyncSource source(scheduler);
+    scheduler.SetVsyncSource(&source);
+
+    // Drawn later by choice: counted apart from busy buffers, and no vsync
+    // is asked for until the frame is resumed
+    scheduler.RequestFrame();
+    EXPECT_TRUE(source.Tick(1));
+    EXPECT_TRUE(scheduler.FrameDue());
+    scheduler.ThrottleFrame();
+    EXPECT_TRUE(!source.requested);
+    scheduler.ResumeFrame();
+    EXPECT_TRUE(source.requested);
+    EXPECT_TRUE(source.Tick(2));
+    EXPECT_TRUE(scheduler.FrameDue());
+    scheduler.FrameDone();
+
+    // Nothing pending, nothing to resume
+    scheduler.ResumeFrame();
+    EXPECT_TRUE(!source.requested);
+
+    FrameSchedulerStats stats = scheduler.GetStats();
+    EXPECT_TRUE((stats.frames == 1) && (stats.skipped == 0) && (stats.throttled == 1));
+}
+
+void TestNoSource()
+{
+    // Without a source nothing ever becomes due, and nothing crashes
+    FrameScheduler scheduler([]() {});
+    scheduler.RequestFrame();
+    EXPECT_TRUE(!scheduler.FrameDue());
+}
+
+void TestTimerSourceWithRenderThread()
+{
+    // The full path: producer -> timer vsync -> render thread tick
+    constexpr auto period = std::chrono::milliseconds(4);
+    std::atomic<int> frames {0};
+    std::atomic<int> commands {0};
+    RenderThread thread([&commands](const RenderCommand&) { commands++; });
+    FrameScheduler scheduler([&thread]() { thread.RequestTick(); });
+    thread.SetTickHandler([&scheduler, &frames]() {
+        if (scheduler.FrameDue()) {
+            frames++;
+            scheduler.FrameDone();
+        }
+    });
+    thread.Start();
+    {
+        TimerVsyncSource source(period, [&scheduler](int64_t timestampNs) { scheduler.OnVsync(timestampNs); });
+        scheduler.SetVsyncSource(&source);
+
+        // Requests far faster than vsync: at most one frame per period
+        constexpr int requests = 200;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < requests; i++) {
+            scheduler.RequestFrame();
+            thread.PostBlocking(RenderCommand {RenderCommandType::DRAW_PATTERN, nullptr, 0, 0, nullptr});
+            std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+        std::this_thread::sleep_for(period * 3);
+        auto elapsed = std::chrono::steady_clock::now() - start;
+        long maxFrames = static_cast<long>(elapsed / period) + 2;
+        printf("timer vsync: %d requests, %d frames in %lld ms\n", requests, frames.load(),
+            static_cast<long long>(std::chrono::duration_cast<std::chrono::milliseconds>(elapsed).count()));
+        EXPECT_TRUE(frames.load() > 0);
+        EXPECT_TRUE(frames.load() < requests);
+        EXPECT_TRUE(frames.load() <= maxFrames);
+        EXPECT_TRUE(scheduler.GetStats().frames == static_cast<uint64_t>(frames.load()));
+
+        // A lone request after going idle still gets its frame
+        int before = frames.load();
+        scheduler.RequestFrame();
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(2);
+        while ((frames.load() == before) && (std::chrono::steady_clock::now() < deadline)) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        EXPECT_TRUE(frames.load() == before + 1);
+        scheduler.SetVsyncSource(nullptr);
+    }
+    thread.Stop();
+    EXPECT_TRUE(commands.load() == 200);
+}
+
+} // namespace
+
+int main()
+{
+    TestCoalescing();
+    TestSkipWhileBufferBusy();
+    TestThrottle();
+    TestNoSource();
+    TestTimerSourceWithRenderThread();
+
+    return FinishTest("frame_scheduler_test");
+}
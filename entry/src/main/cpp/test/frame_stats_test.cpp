@@ -0,0 +1,126 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+// Host-side checks for the frame timing ring and its percentiles
+#include "render/frame_stats.h"
+#include "test/test_check.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+namespace {
+
+// 60 Hz
+constexpr int64_t PERIOD_NS = 16666667;
+
+FrameTiming MakeTiming(uint32_t us)
+{
+    return FrameTiming {us, 2 * us, 3 * us, 4 * us, 5 * us, 15 * us, us / 2};
+}
+
+void TestEmpty()
+{
+    FrameStats stats;
+    FrameStatsSummary summary = stats.Summarize();
+    EXPECT_TRUE((summary.sampled == 0) && (summary.presented == 0));
+    EXPECT_TRUE((summary.total.p50Us == 0) && (summary.total.p99Us == 0));
+    EXPECT_TRUE((summary.late == 0) && (summary.dropped == 0));
+}
+
+void TestPercentiles()
+{
+    FrameStats stats;
+    // 1..100, out of order
+    for (uint32_t i = 0; i < 100; i++) {
+        stats.Record(MakeTiming((i * 37) % 100 + 1), PERIOD_NS);
+    }
+    FrameStatsSummary summary = stats.Summarize();
+    EXPECT_TRUE((summary.sampled == 100) && (summary.presented == 100));
+    EXPECT_TRUE((summary.acquire.p50Us == 50) && (summary.acquire.p95Us == 95) && (summary.acquire.p99Us == 99));
+    EXPECT_TRUE((summary.prepare.p50Us == 100) && (summary.raster.p95Us == 285) && (summary.blit.p99Us == 396));
+    EXPECT_TRUE(summary.flush.p50Us == 250);
+    EXPECT_TRUE(summary.slot.p50Us == 25);
+    EXPECT_TRUE((summary.total.p50Us == 750) && (summary.total.p99Us == 1485));
+    EXPECT_TRUE(summary.late == 0);
+
+    // One sample is every percentile
+    FrameStats single;
+    single.Record(MakeTiming(7), PERIOD_NS);
+    summary = single.Summarize();
+    EXPECT_TRUE((summary.acquire.p50Us == 7) && (summary.acquire.p95Us == 7) && (summary.acquire.p99Us == 7));
+}
+
+void TestRingKeepsLatest()
+{
+    FrameStats stats;
+    // Slow frames first, then a full ring of fast ones that push them out
+    for (uint32_t i = 0; i < 100; i++) {
+        stats.Record(MakeTiming(10000), PERIOD_NS);
+    }
+    for (size_t i = 0; i < FrameStats::CAPACITY; i++) {
+        stats.Record(MakeTiming(100), PERIOD_NS);
+    }
+    FrameStatsSummary summary = stats.Summarize();
+    EXPECT_TRUE(summary.sampled == FrameStats::CAPACITY);
+    EXPECT_TRUE(summary.presented == 100 + FrameStats::CAPACITY);
+    EXPECT_TRUE(summary.total.p99Us == 1500);
+    // 150 ms each: all the slow ones were late, whatever the ring holds now
+    EXPECT_TRUE(summary.late == 100);
+}
+
+void TestCounters()
+{
+    FrameStats stats;
+    stats.Record(MakeTiming(1000), PERIOD_NS);
+    stats.Record(MakeTiming(1200), PERIOD_NS);
+    stats.CountDropped();
+    stats.CountDropped();
+    stats.CountDropped();
+    FrameStatsSummary summary = stats.Summarize();
+    // 15 ms is within a 60 Hz period, 18 ms is not
+    EXPECT_TRUE(summary.late == 1);
+    EXPECT_TRUE(summary.dropped == 3);
+    EXPECT_TRUE(summary.presented == 2);
+    // Left to the owner
+    EXPECT_TRUE(summary.skipped == 0);
+}
+
+// The render thread records while another thread summarizes
+void TestAcrossThreads()
+{
+    FrameStats stats;
+    constexpr uint32_t frames = 20000;
+    std::atomic<bool> done {false};
+    std::thread recorder([&] {
+        for (uint32_t i = 0; i < frames; i++) {
+            stats.Record(MakeTiming(i % 50 + 1), PERIOD_NS);
+        }
+        done.store(true);
+    });
+    bool consistent = true;
+    while (!done.load()) {
+        FrameStatsSummary summary = stats.Summarize();
+        consistent = consistent && (summary.sampled <= FrameStats::CAPACITY) &&
+            (summary.total.p50Us <= summary.total.p95Us) && (summary.total.p95Us <= summary.total.p99Us) &&
+            (summary.total.p99Us <= 750);
+    }
+    recorder.join();
+    EXPECT_TRUE(consistent);
+    EXPECT_TRUE(stats.Summarize().presented == frames);
+}
+
+} // namespace
+
+int main()
+{
+    TestEmpty();
+    TestPercentiles();
+    TestRingKeepsLatest();
+    TestCounters();
+    TestAcrossThreads();
+
+    return FinishTest("frame_stats_test");
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+// Host-side checks for the geometry cache
+#include "render/geometry_cache.h"
+#include "test/test_check.h"
+#include <cstdio>
+#include <cstdlib>
+
+namespace {
+
+int g_released = 0;
+
+void ReleaseInt(int& value)
+{
+    g_released++;
+    value = -1;
+}
+
+void TestHitMiss()
+{
+    g_released = 0;
+    GeometryCache<int> cache(ReleaseInt);
+    GeometryKey pentagon {1, 640, 480, 0};
+
+    EXPECT_TRUE(cache.Find(pentagon) == nullptr);
+    int* stored = cache.Insert(pentagon, 42);
+    EXPECT_TRUE(stored != nullptr && *stored == 42);
+
+    int* found = cache.Find(pentagon);
+    EXPECT_TRUE(found != nullptr && *found == 42);
+
+    // Any part of the key changing is a different entry
+    EXPECT_TRUE(cache.Find(GeometryKey {2, 640, 480, 0}) == nullptr);
+    EXPECT_TRUE(cache.Find(GeometryKey {1, 641, 480, 0}) == nullptr);
+    EXPECT_TRUE(cache.Find(GeometryKey {1, 640, 480, 1}) == nullptr);
+
+    GeometryCacheStats stats = cache.GetStats();
+    EXPECT_TRUE(stats.hits == 1);
+    EXPECT_TRUE(stats.misses == 4);
+    EXPECT_TRUE(stats.size == 1);
+    EXPECT_TRUE(stats.capacity == GeometryCache<int>::DEFAULT_CAPACITY);
+}
+
+void TestEvictsLeastRecentlyUsed()
+{
+    g_released = 0;
+    GeometryCache<int> cache(ReleaseInt, 2);
+    GeometryKey a {1, 10, 10, 0};
+    GeometryKey b {2, 10, 10, 0};
+    GeometryKey c {3, 10, 10, 0};
+
+    cache.Insert(a, 1);
+    cache.Insert(b, 2);
+    // Touch a, so b is the oldest
+    EXPECT_TRUE(cache.Find(a) != nullptr);
+    cache.Insert(c, 3);
+
+    EXPECT_TRUE(g_released == 1);
+    EXPECT_TRUE(cache.Find(b) == nullptr);
+    EXPECT_TRUE(cache.Find(a) != nullptr && *cache.Find(a) == 1);
+    EXPECT_TRUE(cache.Find(c) != nullptr && *cache.Find(c) == 3);
+    EXPECT_TRUE(cache.GetStats().evictions == 1);
+    EXPECT_TRUE(cache.GetStats().size == 2);
+}
+
+void TestClearReleasesEverything()
+{
+    g_released = 0;
+    {
+        GeometryCache<int> cache(ReleaseInt);
+        cache.Insert(GeometryKey {1, 10, 10, 0}, 1);
+        cache.Insert(GeometryKey {2, 10, 10, 0}, 2);
+        cache.Clear();
+        EXPECT_TRUE(g_released == 2);
+        EXPECT_TRUE(cache.GetStats().size == 0);
+        EXPECT_TRUE(cache.Find(GeometryKey {1, 10, 10, 0}) == nullptr);
+
+        // Whatever is left goes with the cache
+        cache.Insert(GeometryKey {3, 10, 10, 0}, 3);
+    }
+    EXPECT_TRUE(g_released == 3);
+}
+
+} // namespace
+
+int main()
+{
+    TestHitMiss();
+    TestEvictsLeastRecentlyUsed();
+    TestClearReleasesEverything();
+
+    return FinishTest("geometry_cache_test");
+}
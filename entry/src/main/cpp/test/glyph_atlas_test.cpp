@@ -0,0 +1,180 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+// Host-side checks for the stroke font and its glyph atlas
+#include "render/glyph_atlas.h"
+#include "render/stroke_font.h"
+#include "test/test_check.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t WHITE = 0xFFFFFFFF;
+constexpr uint32_t BLACK = 0xFF000000;
+
+struct Canvas {
+    uint32_t width;
+    uint32_t height;
+    std::vector<uint32_t> pixels;
+
+    Canvas(uint32_t w, uint32_t h) : width(w), height(h), pixels(w * h, WHITE) {}
+
+    PixelSurface Surface()
+    {
+        return PixelSurface {pixels.data(), width, height, width * 4, PixelFormat::RGBA_8888};
+    }
+
+    int CountInk() const
+    {
+        int ink = 0;
+        for (uint32_t p : pixels) {
+            ink += (p != WHITE) ? 1 : 0;
+        }
+        return ink;
+    }
+};
+
+void TestGlyphTable()
+{
+    // Every glyph stays on the grid and has whole points
+    for (int i = 0; i < StrokeFont::GetGlyphCount(); i++) {
+        const StrokeFont::Glyph& glyph = StrokeFont::GetGlyphAt(i);
+        bool inside = true;
+        StrokeFont::ForEachSegment(glyph, [&](int x0, int y0, int x1, int y1) {
+            inside = inside && (x0 >= 0) && (x0 <= StrokeFont::GLYPH_WIDTH) && (x1 >= 0) &&
+                (x1 <= StrokeFont::GLYPH_WIDTH) && (y0 >= 0) && (y0 <= StrokeFont::GLYPH_HEIGHT) && (y1 >= 0) &&
+                (y1 <= StrokeFont::GLYPH_HEIGHT);
+        });
+        EXPECT_TRUE(inside);
+        size_t points = 0;
+        for (const char* p = glyph.strokes; *p != '\0'; p++) {
+            points += (*p != ' ') ? 1 : 0;
+        }
+        EXPECT_TRUE(points % 2 == 0);
+    }
+
+    EXPECT_TRUE(StrokeFont::GetGlyph('h').code == 'H');
+    EXPECT_TRUE(StrokeFont::GetGlyph('@').code == '?');
+    EXPECT_TRUE(StrokeFont::GetGlyph(static_cast<char>(0xE9)).code == '?');
+}
+
+void TestAtlasCoverage()
+{
+    GlyphAtlas atlas;
+    EXPECT_TRUE(!atlas.IsBuilt());
+    atlas.Build(24.0f);
+    EXPECT_TRUE(atlas.IsBuilt());
+    EXPECT_TRUE(atlas.GetCapHeight() == 24.0f);
+
+    // The left stem of H runs down the left of the glyph box; its middle is empty
+    uint32_t mid = atlas.GetLineHeight() / 2;
+    uint8_t stem = 0;
+    for (uint32_t x = 0; x < 6; x++) {
+        stem = std::max(stem, atlas.CoverageAt('H', x, mid / 2));
+    }
+    EXPECT_TRUE(stem == 255);
+    EXPECT_TRUE(atlas.CoverageAt('H', 10, mid / 2) == 0);
+    EXPECT_TRUE(atlas.CoverageAt(' ', 10, mid) == 0);
+
+    // Sizes are clamped
+    GlyphAtlas tiny;
+    tiny.Build(1.0f);
+    EXPECT_TRUE(tiny.GetCapHeight() == GlyphAtlas::MIN_CAP_HEIGHT);
+}
+
+void TestDrawText()
+{
+    GlyphAtlas atlas;
+    atlas.Build(16.0f);
+
+    Canvas canvas(200, 40);
+    BlitRect touched = atlas.DrawText(canvas.Surface(), 10, 5, "HI", BLACK);
+    EXPECT_TRUE(touched.x == 10 && touched.y == 5);
+    EXPECT_TRUE(touched.w == atlas.MeasureWidth("HI"));
+    EXPECT_TRUE(touched.h == atlas.GetLineHeight());
+    EXPECT_TRUE(canvas.CountInk() > 0);
+
+    // Nothing outside the touched rect changed
+    for (uint32_t y = 0; y < canvas.height; y++) {
+        for (uint32_t x = 0; x < canvas.width; x++) {
+            bool inside = (x >= touched.x) && (x < touched.x + touched.w) && (y >= touched.y) &&
+                (y < touched.y + touched.h);
+            if (!inside) {
+                EXPECT_TRUE(canvas.pixels[y * canvas.width + x] == WHITE);
+            }
+        }
+    }
+
+    // Lower case draws the same pixels as upper case
+    Canvas lower(200, 40);
+    atlas.DrawText(lower.Surface(), 10, 5, "hi", BLACK);
+    EXPECT_TRUE(lower.pixels == canvas.pixels);
+}
+
+void TestColorAndFormat()
+{
+    GlyphAtlas atlas;
+    atlas.Build(16.0f);
+
+    // Fully covered texels take the color exactly, in the byte order of dst
+    Canvas rgba(60, 30);
+    atlas.DrawText(rgba.Surface(), 0, 0, "I", 0xFF102030);
+    Canvas bgra(60, 30);
+    PixelSurface bgraSurface = bgra.Surface();
+    bgraSurface.format = PixelFormat::BGRA_8888;
+    atlas.DrawText(bgraSurface, 0, 0, "I", 0xFF102030);
+
+    bool foundSolid = false;
+    for (size_t i = 0; i < rgba.pixels.size(); i++) {
+        const uint8_t* a = reinterpret_cast<const uint8_t*>(&rgba.pixels[i]);
+        const uint8_t* b = reinterpret_cast<const uint8_t*>(&bgra.pixels[i]);
+        if ((a[0] == 0x10) && (a[1] == 0x20) && (a[2] == 0x30)) {
+            foundSolid = true;
+            EXPECT_TRUE(b[0] == 0x30 && b[1] == 0x20 && b[2] == 0x10);
+        }
+    }
+    EXPECT_TRUE(foundSolid);
+
+    // Transparent text draws nothing
+    Canvas clear(60, 30);
+    BlitRect touched = atlas.DrawText(clear.Surface(), 0, 0, "I", 0x00102030);
+    EXPECT_TRUE(touched.w == 0);
+    EXPECT_TRUE(clear.CountInk() == 0);
+}
+
+void TestClipping()
+{
+    GlyphAtlas atlas;
+    atlas.Build(32.0f);
+
+    // Partly off every edge; must not write outside the surface
+    Canvas canvas(20, 20);
+    BlitRect touched = atlas.DrawText(canvas.Surface(), -15, -10, "WWW", BLACK);
+    EXPECT_TRUE(touched.x == 0 && touched.y == 0);
+    EXPECT_TRUE(touched.w == 20 && touched.h == 20);
+    EXPECT_TRUE(canvas.CountInk() > 0);
+
+    // Entirely off the surface
+    Canvas away(20, 20);
+    touched = atlas.DrawText(away.Surface(), 100, 100, "W", BLACK);
+    EXPECT_TRUE(touched.w == 0);
+    EXPECT_TRUE(away.CountInk() == 0);
+}
+
+} // namespace
+
+int main()
+{
+    TestGlyphTable();
+    TestAtlasCoverage();
+    TestDrawText();
+    TestColorAndFormat();
+    TestClipping();
+
+    return FinishTest("glyph_atlas_test");
+}
@@ -0,0 +1,615 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+// Host-side checks for the headless window and raster backend, and for the
+// renderer running end to end on top of them
+#include "render/headless/headless_backend.h"
+#include "render/sample_bitmap.h"
+#include "test/test_check.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t WHITE = 0xFFFFFFFF;
+
+// Pixels are RGBA_8888 in memory, so R is the low byte on a little-endian host
+uint32_t Channel(uint32_t pixel, int index)
+{
+    return (pixel >> (index * 8)) & 0xFF;
+}
+
+// A 0xAARRGGBB color as it reads from an RGBA_8888 frame
+uint32_t FramePixel(uint32_t color)
+{
+    return (color & 0xFF00FF00) | ((color >> 16) & 0xFF) | ((color & 0xFF) << 16);
+}
+
+bool IsRed(uint32_t pixel)
+{
+    return (Channel(pixel, 0) > 200) && (Channel(pixel, 1) < 60) && (Channel(pixel, 2) < 60);
+}
+
+bool IsGreen(uint32_t pixel)
+{
+    return (Channel(pixel, 0) < 60) && (Channel(pixel, 1) > 200) && (Channel(pixel, 2) < 60);
+}
+
+template <typename Pred>
+size_t CountPixels(const std::vector<uint32_t>& pixels, Pred&& pred)
+{
+    size_t count = 0;
+    for (uint32_t pixel : pixels) {
+        count += pred(pixel) ? 1 : 0;
+    }
+    return count;
+}
+
+class CountingListener : public FrameListener {
+public:
+    void OnFrameDone(void* request, bool presented, const FrameTiming& timing, RenderPath path) override
+    {
+        (void)request;
+        (void)timing;
+        (void)path;
+        std::lock_guard<std::mutex> lock(mutex_);
+        done_++;
+        presented_ += presented ? 1 : 0;
+        changed_.notify_all();
+    }
+
+    bool WaitFor(int count)
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        return changed_.wait_for(lock, std::chrono::seconds(5), [&] { return done_ >= count; });
+    }
+
+    int GetPresented()
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return presented_;
+    }
+
+private:
+    std::mutex mutex_;
+    std::condition_variable changed_;
+    int done_ = 0;
+    int presented_ = 0;
+};
+
+void TestWindowBuffers()
+{
+    HeadlessWindow window(64, 32, 2);
+    OHNativeWindow* native = window.GetNativeWindow();
+    OHNativeWindowBuffer* first = nullptr;
+    OHNativeWindowBuffer* second = nullptr;
+    OHNativeWindowBuffer* third = nullptr;
+    int fence = 0;
+
+    EXPECT_TRUE(OH_NativeWindow_NativeWindowRequestBuffer(native, &first, &fence) == 0);
+    EXPECT_TRUE(fence == -1);
+    EXPECT_TRUE(OH_NativeWindow_NativeWindowRequestBuffer(native, &second, &fence) == 0);
+    EXPECT_TRUE(first != second);
+    // Only two buffers, both with the producer
+    EXPECT_TRUE(OH_NativeWindow_NativeWindowRequestBuffer(native, &third, &fence) != 0);
+
+    BufferHandle* handle = OH_NativeWindow_GetBufferHandleFromNative(first);
+    EXPECT_TRUE((handle != nullptr) && (handle->fd >= 0));
+    EXPECT_TRUE((handle->width == 64) && (handle->height == 32));
+    EXPECT_TRUE((handle->stride >= 64 * 4) && (handle->stride % 64 == 0));
+    EXPECT_TRUE(handle->size >= handle->stride * handle->height);
+
+    std::vector<uint32_t> pixels;
+    uint32_t width = 0;
+    uint32_t height = 0;
+    EXPECT_TRUE(!window.ReadFrame(pixels, width, height));
+
+    Region region {nullptr, 0};
+    EXPECT_TRUE(OH_NativeWindow_NativeWindowFlushBuffer(native, first, -1, region) == 0);
+    EXPECT_TRUE(OH_NativeWindow_NativeWindowAbortBuffer(native, second) == 0);
+    EXPECT_TRUE(window.GetFlushCount() == 1);
+    EXPECT_TRUE(window.ReadFrame(pixels, width, height) && (width == 64) && (height == 32));
+    // A flushed buffer cannot be flushed or aborted again
+    EXPECT_TRUE(OH_NativeWindow_NativeWindowAbortBuffer(native, first) != 0);
+
+    // The one on screen stays there; the aborted one comes back
+    EXPECT_TRUE(OH_NativeWindow_NativeWindowRequestBuffer(native, &third, &fence) == 0);
+    EXPECT_TRUE(third == second);
+    EXPECT_TRUE(OH_NativeWindow_NativeWindowAbortBuffer(native, third) == 0);
+
+    int32_t queried = 0;
+    EXPECT_TRUE(OH_NativeWindow_NativeWindowHandleOpt(native, SET_BUFFER_GEOMETRY, 16, 8) == 0);
+    EXPECT_TRUE(OH_NativeWindow_NativeWindowHandleOpt(native, GET_BUFFERQUEUE_SIZE, &queried) == 0);
+    EXPECT_TRUE(queried == 2);
+    EXPECT_TRUE(OH_NativeWindow_NativeWindowRequestBuffer(native, &third, &fence) == 0);
+    handle = OH_NativeWindow_GetBufferHandleFromNative(third);
+    EXPECT_TRUE((handle->width == 16) && (handle->height == 8));
+    EXPECT_TRUE(OH_NativeWindow_NativeWindowAbortBuffer(native, third) == 0);
+}
+
+void TestRasterRect()
+{
+    constexpr uint32_t size = 40;
+    OH_Drawing_Bitmap* bitmap = OH_Drawing_BitmapCreate();
+    OH_Drawing_BitmapFormat format {COLOR_FORMAT_RGBA_8888, ALPHA_FORMAT_OPAQUE};
+    OH_Drawing_BitmapBuild(bitmap, size, size, &format);
+    OH_Drawing_Canvas* canvas = OH_Drawing_CanvasCreate();
+    OH_Drawing_CanvasBind(canvas, bitmap);
+    OH_Drawing_CanvasClear(canvas, OH_Drawing_ColorSetArgb(0xFF, 0xFF, 0xFF, 0xFF));
+
+    // Fill (10.5, 10) - (30.5, 30) in green, anti-aliased
+    OH_Drawing_Path* path = OH_Drawing_PathCreate();
+    OH_Drawing_PathMoveTo(path, 10.5f, 10);
+    OH_Drawing_PathLineTo(path, 30.5f, 10);
+    OH_Drawing_PathLineTo(path, 30.5f, 30);
+    OH_Drawing_PathLineTo(path, 10.5f, 30);
+    OH_Drawing_PathClose(path);
+    OH_Drawing_Brush* brush = OH_Drawing_BrushCreate();
+    OH_Drawing_BrushSetAntiAlias(brush, true);
+    OH_Drawing_BrushSetColor(brush, OH_Drawing_ColorSetArgb(0xFF, 0x00, 0xFF, 0x00));
+    OH_Drawing_CanvasAttachBrush(canvas, brush);
+    OH_Drawing_CanvasDrawPath(canvas, path);
+    OH_Drawing_CanvasDetachBrush(canvas);
+
+    const uint32_t* pixels = static_cast<const uint32_t*>(OH_Drawing_BitmapGetPixels(bitmap));
+    EXPECT_TRUE(pixels[5 * size + 5] == WHITE);
+    EXPECT_TRUE(pixels[20 * size + 20] == 0xFF00FF00);
+    EXPECT_TRUE(pixels[20 * size + 35] == WHITE);
+    // Half of column 10 is covered: half green, half white
+    uint32_t edge = pixels[20 * size + 10];
+    EXPECT_TRUE((Channel(edge, 0) > 100) && (Channel(edge, 0) < 155) && (Channel(edge, 1) == 0xFF));
+
+    // A 4 pixel red outline around the same rect, drawn on top
+    OH_Drawing_Pen* pen = OH_Drawing_PenCreate();
+    OH_Drawing_PenSetAntiAlias(pen, true);
+    OH_Drawing_PenSetColor(pen, OH_Drawing_ColorSetArgb(0xFF, 0xFF, 0x00, 0x00));
+    OH_Drawing_PenSetWidth(pen, 4.0f);
+    OH_Drawing_CanvasAttachPen(canvas, pen);
+    OH_Drawing_CanvasDrawPath(canvas, path);
+    OH_Drawing_CanvasDetachPen(canvas);
+
+    EXPECT_TRUE(IsRed(pixels[10 * size + 20]));
+    EXPECT_TRUE(IsRed(pixels[20 * size + 30]));
+    EXPECT_TRUE(pixels[20 * size + 20] == 0xFF00FF00);
+    EXPECT_TRUE(pixels[20 * size + 35] == WHITE);
+    EXPECT_TRUE(pixels[2 * size + 2] == WHITE);
+
+    OH_Drawing_PenDestroy(pen);
+    OH_Drawing_BrushDestroy(brush);
+    OH_Drawing_PathDestroy(path);
+    OH_Drawing_CanvasDestroy(canvas);
+    OH_Drawing_BitmapDestroy(bitmap);
+}
+
+void TestRendererEndToEnd()
+{
+    constexpr uint32_t width = 320;
+    constexpr uint32_t height = 240;
+    HeadlessWindow window(width, height);
+    auto render = std::make_shared<SampleBitMap>("headless_backend_test");
+    CountingListener* listener = new CountingListener();
+    render->SetFrameListener(std::unique_ptr<FrameListener>(listener));
+
+    int token = 0;
+    EXPECT_TRUE(render->PostCommand(RenderCommand {RenderCommandType::SURFACE_CREATED, window.GetNativeWindow(),
+        width, height, nullptr}));
+    EXPECT_TRUE(render->PostCommand(RenderCommand {RenderCommandType::DRAW_PATTERN, nullptr, 0, 0, &token}));
+    EXPECT_TRUE(listener->WaitFor(1));
+    EXPECT_TRUE(listener->GetPresented() == 1);
+    EXPECT_TRUE(window.GetFlushCount() == 1);
+
+    std::vector<uint32_t> pixels;
+    uint32_t frameWidth = 0;
+    uint32_t frameHeight = 0;
+    EXPECT_TRUE(window.ReadFrame(pixels, frameWidth, frameHeight));
+    EXPECT_TRUE((frameWidth == width) && (frameHeight == height));
+    if (!pixels.empty()) {
+        EXPECT_TRUE(pixels[0] == WHITE);
+        EXPECT_TRUE(CountPixels(pixels, IsGreen) > 100);
+        EXPECT_TRUE(CountPixels(pixels, IsRed) > 100);
+    }
+
+    EXPECT_TRUE(render->SetLabel("HELLO"));
+    EXPECT_TRUE(render->PostCommand(RenderCommand {RenderCommandType::DRAW_TEXT, nullptr, 0, 0, &token}));
+    EXPECT_TRUE(listener->WaitFor(2));
+    EXPECT_TRUE(listener->GetPresented() == 2);
+    EXPECT_TRUE(window.ReadFrame(pixels, frameWidth, frameHeight));
+    if (!pixels.empty()) {
+        EXPECT_TRUE(pixels[0] == 0xFFE0E0E0);
+        EXPECT_TRUE(CountPixels(pixels, IsRed) > 50);
+    }
+
+    // Both frames timed, neither lost
+    FrameStatsSummary stats = render->GetFrameStats();
+    EXPECT_TRUE((stats.presented == 2) && (stats.sampled == 2));
+    EXPECT_TRUE((stats.dropped == 0) && (stats.skipped == 0));
+    EXPECT_TRUE((stats.total.p99Us > 0) && (stats.total.p99Us >= stats.raster.p99Us));
+    // Whatever the frames kept in the arena, a second one as big took nothing more
+    EXPECT_TRUE(render->GetFrameArenaStats().steadyAllocations == 0);
+
+    render->Shutdown();
+    // Refused, not left queued
+    EXPECT_TRUE(!render->SetLabel("HELLO"));
+}
+
+// Resizing sets the window's buffer geometry, so every frame has the size
+// of the surface at the time, and the staging memory is not reallocated per step
+void TestResize()
+{
+    HeadlessWindow window(320, 240, 3, NATIVEBUFFER_PIXEL_FMT_BGRA_8888);
+    auto render = std::make_shared<SampleBitMap>("headless_backend_test");
+    CountingListener* listener = new CountingListener();
+    render->SetFrameListener(std::unique_ptr<FrameListener>(listener));
+
+    int token = 0;
+    int frames = 0;
+    std::vector<uint32_t> pixels;
+    uint32_t frameWidth = 0;
+    uint32_t frameHeight = 0;
+    EXPECT_TRUE(render->PostCommand(RenderCommand {RenderCommandType::SURFACE_CREATED, window.GetNativeWindow(),
+        320, 240, nullptr}));
+    EXPECT_TRUE(render->PostCommand(RenderCommand {RenderCommandType::DRAW_PATTERN, nullptr, 0, 0, &token}));
+    EXPECT_TRUE(listener->WaitFor(++frames));
+    EXPECT_TRUE(window.ReadFrame(pixels, frameWidth, frameHeight) && (frameWidth == 320) && (frameHeight == 240));
+    // A format the frame can be copied into is kept
+    EXPECT_TRUE(window.GetFormat() == NATIVEBUFFER_PIXEL_FMT_BGRA_8888);
+    EXPECT_TRUE(render->GetRenderPath() == RenderPath::STAGING);
+
+    // A resize animation: a new size and a draw every frame. Every frame
+    // has a size the surface had, but the buffers are not reallocated for
+    // each of them.
+    std::vector<std::pair<uint32_t, uint32_t>> sizes {{320, 240}};
+    uint64_t geometryChanges = window.GetGeometryChanges();
+    bool sized = true;
+    for (uint32_t i = 1; i <= 12; i++) {
+        sizes.emplace_back(320 + 20 * i, 240 + 10 * i);
+        render->PostCommand(RenderCommand {RenderCommandType::SURFACE_CHANGED, window.GetNativeWindow(),
+            sizes.back().first, sizes.back().second, nullptr});
+        render->PostCommand(RenderCommand {RenderCommandType::DRAW_PATTERN, nullptr, 0, 0, &token});
+        EXPECT_TRUE(listener->WaitFor(++frames));
+        sized = sized && window.ReadFrame(pixels, frameWidth, frameHeight) && (pixels[0] == WHITE) &&
+            (std::find(sizes.begin(), sizes.end(), std::make_pair(frameWidth, frameHeight)) != sizes.end());
+    }
+    EXPECT_TRUE(sized);
+    EXPECT_TRUE(window.GetGeometryChanges() - geometryChanges < 12);
+    // The last frame is drawn again at the final size without being asked
+    bool settled = false;
+    for (int i = 0; (i < 100) && !settled; i++) {
+        settled = window.ReadFrame(pixels, frameWidth, frameHeight) && (frameWidth == sizes.back().first) &&
+            (frameHeight == sizes.back().second) && (pixels[0] == WHITE);
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    EXPECT_TRUE(settled);
+    EXPECT_TRUE(listener->GetPresented() == frames);
+    // 13 sizes, growing the area 2.6 times; a quarter headroom per allocation
+    EXPECT_TRUE(render->GetStagingAllocations() <= 4);
+
+    // Several resizes before one frame, after a pause: drawn once, at the
+    // last size
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    uint64_t flushes = window.GetFlushCount();
+    for (uint32_t width = 600; width >= 400; width -= 50) {
+        render->PostCommand(RenderCommand {RenderCommandType::SURFACE_CHANGED, window.GetNativeWindow(), width, 300,
+            nullptr});
+    }
+    render->PostCommand(RenderCommand {RenderCommandType::DRAW_PATTERN, nullptr, 0, 0, &token});
+    EXPECT_TRUE(listener->WaitFor(++frames));
+    EXPECT_TRUE(window.GetFlushCount() == flushes + 1);
+    EXPECT_TRUE(window.ReadFrame(pixels, frameWidth, frameHeight) && (frameWidth == 400) && (frameHeight == 300));
+    EXPECT_TRUE(listener->GetPresented() == frames);
+
+    render->Shutdown();
+}
+
+// With the layer cache on, the text frame comes from a layer drawn once,
+// until something it depends on changes or it is invalidated
+void TestLayers()
+{
+    constexpr uint32_t width = 320;
+    constexpr uint32_t height = 240;
+    HeadlessWindow window(width, height);
+    auto render = std::make_shared<SampleBitMap>("headless_backend_test");
+    CountingListener* listener = new CountingListener();
+    render->SetFrameListener(std::unique_ptr<FrameListener>(listener));
+
+    int token = 0;
+    int frames = 0;
+    std::vector<uint32_t> first;
+    std::vector<uint32_t> pixels;
+    uint32_t frameWidth = 0;
+    uint32_t frameHeight = 0;
+    auto drawText = [&]() {
+        render->PostCommand(RenderCommand {RenderCommandType::DRAW_TEXT, nullptr, 0, 0, &token});
+        return listener->WaitFor(++frames) && window.ReadFrame(pixels, frameWidth, frameHeight);
+    };
+    EXPECT_TRUE(render->PostCommand(RenderCommand {RenderCommandType::SURFACE_CREATED, window.GetNativeWindow(),
+        width, height, nullptr}));
+    // Off by default
+    EXPECT_TRUE(drawText());
+    EXPECT_TRUE(render->GetLayerCacheStats().builds == 0);
+    render->SetLayerCacheEnabled(true);
+    EXPECT_TRUE(drawText());
+    first = pixels;
+    EXPECT_TRUE(drawText() && (pixels == first));
+    EXPECT_TRUE(drawText() && (pixels == first));
+    LayerCacheStats stats = render->GetLayerCacheStats();
+    EXPECT_TRUE((stats.builds == 1) && (stats.composites == 3) && (stats.layers == 1));
+    // Inside the frame, the blue blended over the gray
+    uint32_t inside = first[(height / 4 + 10) * width + width / 4 + 10];
+    EXPECT_TRUE((Channel(inside, 2) > Channel(inside, 0)) && (Channel(inside, 0) < 0xE0));
+
+    // Another quality draws it again, as does invalidating it
+    render->SetAaQuality(AaQuality::HIGH);
+    EXPECT_TRUE(drawText());
+    EXPECT_TRUE(render->GetLayerCacheStats().builds == 2);
+    render->InvalidateLayers();
+    EXPECT_TRUE(drawText());
+    stats = render->GetLayerCacheStats();
+    EXPECT_TRUE((stats.builds == 3) && (stats.invalidations == 1));
+
+    // Without layers the frame is drawn in place, and looks the same
+    render->SetLayerCacheEnabled(false);
+    render->SetAaQuality(AaQuality::MEDIUM);
+    EXPECT_TRUE(drawText());
+    EXPECT_TRUE(render->GetLayerCacheStats().composites == stats.composites);
+    EXPECT_TRUE((pixels[0] == 0xFFE0E0E0) && (CountPixels(pixels, IsRed) > 50));
+    size_t different = 0;
+    for (size_t i = 0; i < pixels.size(); i++) {
+        different += (pixels[i] != first[i]) ? 1 : 0;
+    }
+    // The anti-aliased edges may differ, nothing else
+    EXPECT_TRUE(different < pixels.size() / 50);
+
+    render->Shutdown();
+}
+
+// Display lists mark their static content as layers: drawn once while it
+// stays the same, whatever changes around it
+void TestDisplayListLayers()
+{
+    constexpr uint32_t width = 320;
+    constexpr uint32_t height = 240;
+    HeadlessWindow window(width, height);
+    auto render = std::make_shared<SampleBitMap>("headless_backend_test");
+    EXPECT_TRUE(render->PostCommand(RenderCommand {RenderCommandType::SURFACE_CREATED, window.GetNativeWindow(),
+        width, height, nullptr}));
+    render->SetLayerCacheEnabled(true);
+
+    std::vector<uint32_t> pixels;
+    uint32_t frameWidth = 0;
+    uint32_t frameHeight = 0;
+    auto draw = [&](uint32_t cardColor, float dotX) {
+        DisplayListBuilder builder;
+        builder.Clear(0xFFE0E0E0);
+        builder.LayerBegin(1).Color(cardColor).RoundRect(40, 40, 200, 160, 16).Fill();
+        builder.Color(0xFF000000).Width(3).RoundRect(40, 40, 200, 160, 16).Stroke().LayerEnd();
+        builder.Color(0xFFFF0000).MoveTo(dotX, 200).LineTo(dotX + 10, 200).LineTo(dotX + 10, 210).Close().Fill();
+        uint64_t flushes = window.GetFlushCount();
+        if (!render->SubmitDisplayList(builder.Data(), builder.Size())) {
+            return false;
+        }
+        for (int i = 0; (i < 1000) && (window.GetFlushCount() == flushes); i++) {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return window.ReadFrame(pixels, frameWidth, frameHeight);
+    };
+    EXPECT_TRUE(draw(0xFF2060C0, 10));
+    std::vector<uint32_t> first = pixels;
+    EXPECT_TRUE(pixels[100 * width + 100] == FramePixel(0xFF2060C0));
+    // Only the dot moves: the card is composited
+    EXPECT_TRUE(draw(0xFF2060C0, 250));
+    EXPECT_TRUE((pixels[100 * width + 100] == FramePixel(0xFF2060C0)) && IsRed(pixels[202 * width + 258]));
+    EXPECT_TRUE(pixels[202 * width + 18] == 0xFFE0E0E0);
+    LayerCacheStats stats = render->GetLayerCacheStats();
+    EXPECT_TRUE((stats.builds == 1) && (stats.composites == 2) && (stats.layers == 1));
+    // Another card color is another card
+    EXPECT_TRUE(draw(0xFF20C060, 250));
+    EXPECT_TRUE(pixels[100 * width + 100] == FramePixel(0xFF20C060));
+    EXPECT_TRUE(render->GetLayerCacheStats().builds == 2);
+
+    // Without the cache the same list looks the same
+    render->SetLayerCacheEnabled(false);
+    EXPECT_TRUE(draw(0xFF2060C0, 10));
+    EXPECT_TRUE(render->GetLayerCacheStats().composites == 3);
+    size_t different = 0;
+    for (size_t i = 0; i < pixels.size(); i++) {
+        different += (pixels[i] != first[i]) ? 1 : 0;
+    }
+    // The anti-aliased edges may differ, nothing else
+    EXPECT_TRUE(different < pixels.size() / 50);
+
+    render->Shutdown();
+}
+
+bool IsInk(uint32_t pixel)
+{
+    return (Channel(pixel, 0) < 100) && (Channel(pixel, 1) < 100) && (Channel(pixel, 2) < 100);
+}
+
+// Touch goes straight to the render thread and is drawn on the next frame,
+// with no request behind it
+void TestTouchInk()
+{
+    constexpr uint32_t width = 320;
+    constexpr uint32_t height = 240;
+    constexpr float row = 120;
+    HeadlessWindow window(width, height);
+    auto render = std::make_shared<SampleBitMap>("headless_backend_test");
+    CountingListener* listener = new CountingListener();
+    render->SetFrameListener(std::unique_ptr<FrameListener>(listener));
+    // A first frame, so the surface is there before the touch
+    int token = 0;
+    EXPECT_TRUE(render->PostCommand(RenderCommand {RenderCommandType::SURFACE_CREATED, window.GetNativeWindow(),
+        width, height, nullptr}));
+    EXPECT_TRUE(render->PostCommand(RenderCommand {RenderCommandType::DRAW_PATTERN, nullptr, 0, 0, &token}));
+    EXPECT_TRUE(listener->WaitFor(1));
+
+    constexpr int64_t stepNs = 4000000;
+    render->PushTouch(TouchSample {0, TouchAction::DOWN, 40, row, 0});
+    for (int i = 1; i <= 24; i++) {
+        render->PushTouch(TouchSample {0, TouchAction::MOVE, 40.0f + i * 10, row, i * stepNs});
+    }
+    render->PushTouch(TouchSample {0, TouchAction::UP, 280, row, 25 * stepNs});
+
+    // The whole stroke, without the prediction past its end once it is up
+    auto stroked = [](const std::vector<uint32_t>& pixels) {
+        auto at = [&pixels](uint32_t x, uint32_t y) { return pixels[y * width + x]; };
+        return IsInk(at(45, 120)) && IsInk(at(160, 120)) && IsInk(at(275, 120)) && (at(160, 60) == WHITE) &&
+            (at(300, 120) == WHITE);
+    };
+    std::vector<uint32_t> pixels;
+    uint32_t frameWidth = 0;
+    uint32_t frameHeight = 0;
+    bool drawn = false;
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!drawn && (std::chrono::steady_clock::now() < deadline)) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        drawn = window.ReadFrame(pixels, frameWidth, frameHeight) && stroked(pixels);
+    }
+    EXPECT_TRUE(drawn);
+    TouchInputStats stats = render->GetTouchStats();
+    EXPECT_TRUE((stats.samples == 26) && (stats.dropped == 0) && (stats.frames >= 1));
+
+    render->Shutdown();
+}
+
+// What the NAPI methods go through: a binding made at export time still
+// reaches the instance after the surface is destroyed and created again
+void TestRecreatedSurface()
+{
+    constexpr uint32_t width = 160;
+    constexpr uint32_t height = 120;
+    const std::string id = "headless_backend_test_recreated";
+    HeadlessWindow window(width, height);
+    SampleBitMap::Binding binding = SampleBitMap::Bind(SampleBitMap::GetInstance(id));
+    std::shared_ptr<SampleBitMap> first = binding.Get();
+    EXPECT_TRUE(first != nullptr);
+    EXPECT_TRUE(first->PostCommand(RenderCommand {RenderCommandType::SURFACE_CREATED, window.GetNativeWindow(),
+        width, height, nullptr}));
+
+    // OnSurfaceDestroyedCB, then OnSurfaceCreatedCB for the same XComponent
+    EXPECT_TRUE(first->PostCommand(RenderCommand {RenderCommandType::SURFACE_DESTROYED, window.GetNativeWindow(),
+        0, 0, nullptr}));
+    SampleBitMap::Release(id);
+    first.reset();
+    EXPECT_TRUE(binding.Get() == nullptr);
+    std::shared_ptr<SampleBitMap> second = SampleBitMap::GetInstance(id);
+    EXPECT_TRUE(second->PostCommand(RenderCommand {RenderCommandType::SURFACE_CREATED, window.GetNativeWindow(),
+        width, height, nullptr}));
+
+    std::shared_ptr<SampleBitMap> render = binding.Get();
+    EXPECT_TRUE(render == second);
+    if (render != nullptr) {
+        CountingListener* listener = new CountingListener();
+        render->SetFrameListener(std::unique_ptr<FrameListener>(listener));
+        int token = 0;
+        EXPECT_TRUE(render->PostCommand(RenderCommand {RenderCommandType::DRAW_PATTERN, nullptr, 0, 0, &token}));
+        EXPECT_TRUE(listener->WaitFor(1) && (listener->GetPresented() == 1));
+    }
+    render.reset();
+    second.reset();
+    SampleBitMap::Release(id);
+}
+
+// Draws still waiting for their vsync are drawn on shutdown, not dropped
+void TestShutdownDrains()
+{
+    HeadlessWindow window(160, 120);
+    auto render = std::make_shared<SampleBitMap>("headless_backend_test");
+    EXPECT_TRUE(render->PostCommand(RenderCommand {RenderCommandType::SURFACE_CREATED, window.GetNativeWindow(),
+        160, 120, nullptr}));
+    EXPECT_TRUE(render->PostCommand(RenderCommand {RenderCommandType::DRAW_PATTERN, nullptr, 0, 0, nullptr}));
+    EXPECT_TRUE(render->PostCommand(RenderCommand {RenderCommandType::DRAW_TEXT, nullptr, 0, 0, nullptr}));
+    render->Shutdown();
+
+    // Drawn before the thread stopped: merged into one frame, or two if a
+    // vsync came between the requests, the text last either way
+    FrameStatsSummary stats = render->GetFrameStats();
+    EXPECT_TRUE((stats.presented >= 1) && (stats.presented <= 2) && (stats.dropped == 0));
+    EXPECT_TRUE(window.GetFlushCount() == stats.presented);
+    std::vector<uint32_t> pixels;
+    uint32_t frameWidth = 0;
+    uint32_t frameHeight = 0;
+    EXPECT_TRUE(window.ReadFrame(pixels, frameWidth, frameHeight) && (pixels[0] == 0xFFE0E0E0));
+}
+
+// A hidden surface draws at most every BACKGROUND_FRAME_INTERVAL, while one
+// on screen keeps up with vsync
+void TestBackgroundThrottle()
+{
+    constexpr uint32_t width = 160;
+    constexpr uint32_t height = 120;
+    constexpr int frameCount = 3;
+    HeadlessWindow shownWindow(width, height);
+    HeadlessWindow hiddenWindow(width, height);
+    auto shown = std::make_shared<SampleBitMap>("headless_backend_test");
+    auto hidden = std::make_shared<SampleBitMap>("headless_backend_test_hidden");
+    CountingListener* shownListener = new CountingListener();
+    CountingListener* hiddenListener = new CountingListener();
+    shown->SetFrameListener(std::unique_ptr<FrameListener>(shownListener));
+    hidden->SetFrameListener(std::unique_ptr<FrameListener>(hiddenListener));
+    shown->SetFocused(true);
+    hidden->SetVisible(false);
+    EXPECT_TRUE(shown->GetSurfacePriority() == SurfacePriority::FOCUSED);
+    EXPECT_TRUE(hidden->GetSurfacePriority() == SurfacePriority::BACKGROUND);
+
+    int token = 0;
+    auto drawFrames = [&token](SampleBitMap& render, CountingListener& listener) {
+        auto start = std::chrono::steady_clock::now();
+        for (int frame = 1; frame <= frameCount; frame++) {
+            render.PostCommand(RenderCommand {RenderCommandType::DRAW_PATTERN, nullptr, 0, 0, &token});
+            EXPECT_TRUE(listener.WaitFor(frame));
+        }
+        return std::chrono::steady_clock::now() - start;
+    };
+    EXPECT_TRUE(shown->PostCommand(RenderCommand {RenderCommandType::SURFACE_CREATED, shownWindow.GetNativeWindow(),
+        width, height, nullptr}));
+    EXPECT_TRUE(hidden->PostCommand(RenderCommand {RenderCommandType::SURFACE_CREATED,
+        hiddenWindow.GetNativeWindow(), width, height, nullptr}));
+    auto shownTime = drawFrames(*shown, *shownListener);
+    auto hiddenTime = drawFrames(*hidden, *hiddenListener);
+
+    // The first hidden frame is drawn right away, every later one waits
+    EXPECT_TRUE(hiddenTime >= (frameCount - 1) * RasterScheduler::BACKGROUND_FRAME_INTERVAL);
+    EXPECT_TRUE(shownTime < hiddenTime);
+    EXPECT_TRUE(hiddenListener->GetPresented() == frameCount);
+    EXPECT_TRUE(hidden->GetFrameStats().throttled > 0);
+    // Held back once per frame, then woken by the timer rather than polled
+    // every vsync
+    EXPECT_TRUE(hidden->GetFrameStats().throttled <= frameCount);
+    EXPECT_TRUE(shown->GetFrameStats().throttled == 0);
+    RasterSchedulerStats stats = RasterScheduler::GetShared().GetStats();
+    EXPECT_TRUE(stats.frames[static_cast<uint32_t>(SurfacePriority::FOCUSED)] >= frameCount);
+    EXPECT_TRUE(stats.frames[static_cast<uint32_t>(SurfacePriority::BACKGROUND)] == frameCount);
+
+    shown->Shutdown();
+    hidden->Shutdown();
+}
+
+} // namespace
+
+int main()
+{
+    TestWindowBuffers();
+    TestRasterRect();
+    TestRendererEndToEnd();
+    TestResize();
+    TestLayers();
+    TestDisplayListLayers();
+    TestTouchInk();
+    TestShutdownDrains();
+    TestRecreatedSurface();
+    TestBackgroundThrottle();
+
+    return FinishTest("headless_backend_test");
+}
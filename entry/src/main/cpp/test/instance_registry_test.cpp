@@ -0,0 +1,179 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+// Host-side checks for the instance registry, including concurrent lookups
+#include "render/instance_registry.h"
+#include "test/test_check.h"
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+
+namespace {
+
+std::atomic<int> g_live {0};
+
+struct Instance {
+    explicit Instance(int v) : value(v)
+    {
+        g_live++;
+    }
+    ~Instance()
+    {
+        // Poisoned so a use after free shows up as a wrong value
+        value = -1;
+        g_live--;
+    }
+    int value;
+};
+
+using Registry = InstanceRegistry<Instance>;
+
+void TestFindOrCreate()
+{
+    Registry registry;
+    int created = 0;
+    auto make = [&created]() {
+        created++;
+        return std::make_shared<Instance>(7);
+    };
+
+    EXPECT_TRUE(registry.Find("a") == nullptr);
+    Registry::Handle a = registry.FindOrCreate("a", make);
+    EXPECT_TRUE(a != nullptr && a->value == 7);
+    // Same id, same instance, not created again
+    EXPECT_TRUE(registry.FindOrCreate("a", make) == a);
+    EXPECT_TRUE(registry.Find("a") == a);
+    EXPECT_TRUE(created == 1);
+    EXPECT_TRUE(registry.FindIf([](const Instance& instance) { return instance.value == 7; }) == a);
+    EXPECT_TRUE(registry.FindIf([](const Instance& instance) { return instance.value == 8; }) == nullptr);
+
+    registry.FindOrCreate("b", make);
+    EXPECT_TRUE(registry.Size() == 2);
+    EXPECT_TRUE(created == 2);
+
+    // A failed create registers nothing
+    EXPECT_TRUE(registry.FindOrCreate("c", []() { return Registry::Handle(); }) == nullptr);
+    EXPECT_TRUE(registry.Size() == 2);
+}
+
+void TestRemoveKeepsHandlesAlive()
+{
+    {
+        Registry registry;
+        Registry::Handle held = registry.FindOrCreate("a", []() { return std::make_shared<Instance>(1); });
+        registry.FindOrCreate("b", []() { return std::make_shared<Instance>(2); });
+        EXPECT_TRUE(g_live == 2);
+
+        Registry::Handle removed = registry.Remove("a");
+        EXPECT_TRUE(removed == held);
+        EXPECT_TRUE(registry.Find("a") == nullptr);
+        EXPECT_TRUE(registry.Remove("a") == nullptr);
+
+        // Still referenced by the two handles
+        removed.reset();
+        EXPECT_TRUE(g_live == 2 && held->value == 1);
+        held.reset();
+        EXPECT_TRUE(g_live == 1);
+
+        std::vector<Registry::Handle> rest = registry.RemoveAll();
+        EXPECT_TRUE(rest.size() == 1 && rest[0]->value == 2);
+        EXPECT_TRUE(registry.Size() == 0);
+        EXPECT_TRUE(g_live == 1);
+    }
+    EXPECT_TRUE(g_live == 0);
+}
+
+void TestBindingFollowsId()
+{
+    Registry registry;
+    Registry::Handle first = registry.FindOrCreate("a", []() { return std::make_shared<Instance>(1); });
+    InstanceBinding<Instance> binding(registry, "a", first);
+    EXPECT_TRUE((binding.Get() == first) && (binding.GetId() == "a"));
+
+    // Released: nothing to bind to, and the binding keeps nothing alive
+    registry.Remove("a");
+    first.reset();
+    EXPECT_TRUE(g_live == 0);
+    EXPECT_TRUE(binding.Get() == nullptr);
+
+    // Created again under the same id: the binding moves to the new one
+    Registry::Handle second = registry.FindOrCreate("a", []() { return std::make_shared<Instance>(2); });
+    EXPECT_TRUE((binding.Get() == second) && (binding.Get()->value == 2));
+    registry.FindOrCreate("b", []() { return std::make_shared<Instance>(3); });
+    EXPECT_TRUE(binding.Get() == second);
+    registry.RemoveAll();
+}
+
+void TestConcurrentLookups()
+{
+    constexpr int IDS = 4;
+    constexpr int READERS = 3;
+    constexpr int WRITES = 2000;
+    const char* ids[IDS] = {"x0", "x1", "x2", "x3"};
+
+    Registry registry;
+    std::atomic<bool> done {false};
+    std::atomic<int> badValues {0};
+    std::atomic<long> hits {0};
+    std::atomic<int> started {0};
+
+    std::vector<std::thread> readers;
+    for (int r = 0; r < READERS; r++) {
+        readers.emplace_back([&, r]() {
+            int i = r;
+            started++;
+            while (!done.load()) {
+                Registry::Handle handle = registry.Find(ids[i % IDS]);
+                if (handle != nullptr) {
+                    // Each instance holds the index of its id, for its whole life
+                    if (handle->value != i % IDS) {
+                        badValues++;
+                    }
+                    hits++;
+                }
+                i++;
+                std::this_thread::yield();
+            }
+        });
+    }
+
+    while (started.load() != READERS) {
+        std::this_thread::yield();
+    }
+
+    // Keep adding and removing instances under the readers
+    for (int w = 0; w < WRITES; w++) {
+        int index = w % IDS;
+        if ((w / IDS) % 2 == 0) {
+            registry.FindOrCreate(ids[index], [index]() { return std::make_shared<Instance>(index); });
+        } else {
+            registry.Remove(ids[index]);
+        }
+        std::this_thread::yield();
+    }
+    done.store(true);
+    for (std::thread& reader : readers) {
+        reader.join();
+    }
+
+    EXPECT_TRUE(badValues == 0);
+    registry.RemoveAll();
+    EXPECT_TRUE(g_live == 0);
+    printf("concurrent lookups: %ld hits\n", hits.load());
+}
+
+} // namespace
+
+int main()
+{
+    TestFindOrCreate();
+    TestRemoveKeepsHandlesAlive();
+    TestBindingFollowsId();
+    TestConcurrentLookups();
+
+    return FinishTest("instance_registry_test");
+}
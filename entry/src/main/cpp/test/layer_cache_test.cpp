@@ -0,0 +1,183 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+// Host-side checks for the layer cache: when layers are drawn again, and that
+// a shape composited from its layer looks the same as the shape drawn in place
+#include "render/layer_cache.h"
+#include "render/tile_raster.h"
+#include "test/test_check.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+struct Style {
+    uint32_t color;
+    float width;
+};
+
+void TestValidity()
+{
+    LayerCache cache;
+    const BlitRect rect {10, 20, 30, 40};
+    Style style {0xFF0000FF, 2.0f};
+    EXPECT_TRUE(!cache.IsValid(1, rect, &style, sizeof(style)));
+
+    PixelSurface surface;
+    EXPECT_TRUE(cache.Begin(1, rect, &style, sizeof(style), surface));
+    EXPECT_TRUE((surface.width == 30) && (surface.height == 40) && (surface.stride == 30 * 4));
+    // Cleared to transparent
+    const uint32_t* pixels = static_cast<const uint32_t*>(surface.pixels);
+    EXPECT_TRUE((pixels[0] == 0) && (pixels[30 * 40 - 1] == 0));
+    EXPECT_TRUE(cache.IsValid(1, rect, &style, sizeof(style)));
+    EXPECT_TRUE(!cache.IsValid(2, rect, &style, sizeof(style)));
+
+    // Other params or another rect need drawing again
+    Style wider {0xFF0000FF, 3.0f};
+    EXPECT_TRUE(!cache.IsValid(1, rect, &wider, sizeof(wider)));
+    EXPECT_TRUE(!cache.IsValid(1, BlitRect {10, 20, 30, 41}, &style, sizeof(style)));
+    EXPECT_TRUE(!cache.IsValid(1, rect, nullptr, 0));
+
+    cache.Invalidate(1);
+    EXPECT_TRUE(!cache.IsValid(1, rect, &style, sizeof(style)));
+    // Invalid layers are not composited
+    std::vector<uint32_t> target(64 * 64, 0xFFFFFFFF);
+    PixelSurface targetSurface {target.data(), 64, 64, 64 * 4, PixelFormat::RGBA_8888};
+    EXPECT_TRUE(!cache.Composite(1, targetSurface));
+
+    // Drawing it again reuses its memory
+    LayerCacheStats before = cache.GetStats();
+    EXPECT_TRUE(cache.Begin(1, rect, &style, sizeof(style), surface));
+    EXPECT_TRUE(cache.Begin(2, BlitRect {0, 0, 8, 8}, nullptr, 0, surface));
+    EXPECT_TRUE(cache.Composite(1, targetSurface) && cache.Composite(2, targetSurface));
+    cache.InvalidateAll();
+    EXPECT_TRUE(!cache.IsValid(1, rect, &style, sizeof(style)));
+    EXPECT_TRUE(!cache.IsValid(2, BlitRect {0, 0, 8, 8}, nullptr, 0));
+
+    LayerCacheStats stats = cache.GetStats();
+    EXPECT_TRUE((stats.builds == before.builds + 2) && (stats.composites == 2));
+    EXPECT_TRUE((stats.invalidations == 3) && (stats.layers == 2));
+    EXPECT_TRUE(stats.bytes >= (30 * 40 + 8 * 8) * 4);
+
+    cache.Release();
+    stats = cache.GetStats();
+    EXPECT_TRUE((stats.layers == 0) && (stats.bytes == 0));
+    EXPECT_TRUE(!cache.Composite(1, targetSurface));
+}
+
+void TestEvictionAndFailure()
+{
+    LayerCache cache;
+    PixelSurface surface;
+    const BlitRect rect {0, 0, 4, 4};
+    std::vector<uint32_t> target(16, 0);
+    PixelSurface targetSurface {target.data(), 4, 4, 16, PixelFormat::RGBA_8888};
+    for (uint32_t id = 1; id <= LayerCache::MAX_LAYERS; id++) {
+        EXPECT_TRUE(cache.Begin(id, rect, nullptr, 0, surface));
+    }
+    // Layer 1 was used last, so 2 makes way for one more
+    EXPECT_TRUE(cache.Composite(1, targetSurface));
+    EXPECT_TRUE(cache.Begin(100, rect, nullptr, 0, surface));
+    EXPECT_TRUE(cache.IsValid(1, rect, nullptr, 0) && cache.IsValid(100, rect, nullptr, 0));
+    EXPECT_TRUE(!cache.IsValid(2, rect, nullptr, 0) && cache.IsValid(3, rect, nullptr, 0));
+    EXPECT_TRUE(cache.GetStats().layers == LayerCache::MAX_LAYERS);
+
+    // Nothing to draw, or params it cannot keep: the layer is dropped
+    uint8_t params[LayerCache::MAX_PARAMS_SIZE + 1] = {};
+    EXPECT_TRUE(!cache.Begin(1, BlitRect {0, 0, 0, 4}, nullptr, 0, surface));
+    EXPECT_TRUE(!cache.IsValid(1, rect, nullptr, 0));
+    EXPECT_TRUE(!cache.Begin(3, rect, params, sizeof(params), surface));
+    EXPECT_TRUE(!cache.IsValid(3, rect, nullptr, 0));
+    EXPECT_TRUE(cache.GetStats().layers == LayerCache::MAX_LAYERS - 2);
+}
+
+uint32_t Channel(uint32_t pixel, int index)
+{
+    return (pixel >> (index * 8)) & 0xFF;
+}
+
+bool Close(uint32_t a, uint32_t b)
+{
+    for (int i = 0; i < 4; i++) {
+        int difference = static_cast<int>(Channel(a, i)) - static_cast<int>(Channel(b, i));
+        if ((difference < -1) || (difference > 1)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// A translucent card with an opaque outline, at (x, y)
+void DrawCard(TileRasterizer& rasterizer, const PixelSurface& surface, float x, float y)
+{
+    RasterPath path;
+    path.AddRoundRect(x + 4, y + 4, x + 116, y + 76, 12, FLATTEN_TOLERANCE);
+    rasterizer.Begin(surface);
+    rasterizer.Fill(path, 0x400000FF);
+    rasterizer.Stroke(path, 5.0f, 0xFF0000FF);
+    rasterizer.Flush(nullptr);
+}
+
+void TestMatchesDirect()
+{
+    constexpr uint32_t width = 200;
+    constexpr uint32_t height = 150;
+    constexpr uint32_t background = 0xFFE0E0E0;
+    std::vector<uint32_t> direct(width * height, background);
+    std::vector<uint32_t> composited(width * height, background);
+    PixelSurface directSurface {direct.data(), width, height, width * 4, PixelFormat::RGBA_8888};
+    PixelSurface compositedSurface {composited.data(), width, height, width * 4, PixelFormat::RGBA_8888};
+    TileRasterizer rasterizer;
+
+    // The layer hangs off the bottom right of the surface
+    const BlitRect rect {100, 90, 120, 80};
+    DrawCard(rasterizer, directSurface, static_cast<float>(rect.x), static_cast<float>(rect.y));
+
+    LayerCache cache;
+    PixelSurface layer;
+    EXPECT_TRUE(cache.Begin(7, rect, nullptr, 0, layer));
+    DrawCard(rasterizer, layer, 0, 0);
+    // Drawn once, composited every frame
+    for (int frame = 0; frame < 3; frame++) {
+        std::fill(composited.begin(), composited.end(), background);
+        EXPECT_TRUE(cache.Composite(7, compositedSurface));
+    }
+
+    bool close = true;
+    bool outsideUntouched = true;
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < width; x++) {
+            close = close && Close(direct[y * width + x], composited[y * width + x]);
+            if ((x < rect.x) || (y < rect.y)) {
+                outsideUntouched = outsideUntouched && (composited[y * width + x] == background);
+            }
+        }
+    }
+    EXPECT_TRUE(close && outsideUntouched);
+    // The outline is opaque, the inside blended over the background
+    EXPECT_TRUE(composited[(rect.y + 4) * width + rect.x + 60] == 0xFFFF0000);
+    EXPECT_TRUE(Close(composited[(rect.y + 30) * width + rect.x + 60], direct[(rect.y + 30) * width + rect.x + 60]));
+    EXPECT_TRUE(composited[(rect.y + 30) * width + rect.x + 60] != background);
+
+    // A layer entirely off the target composites nothing
+    std::vector<uint32_t> small(50 * 50, background);
+    PixelSurface smallSurface {small.data(), 50, 50, 50 * 4, PixelFormat::RGBA_8888};
+    EXPECT_TRUE(cache.Composite(7, smallSurface));
+    EXPECT_TRUE(small == std::vector<uint32_t>(50 * 50, background));
+}
+
+} // namespace
+
+int main()
+{
+    TestValidity();
+    TestEvictionAndFailure();
+    TestMatchesDirect();
+
+    return FinishTest("layer_cache_test");
+}
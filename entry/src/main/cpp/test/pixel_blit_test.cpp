@@ -0,0 +1,242 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+// Host-side checks for the pixel blit module, run against synthetic buffers
+#include "render/pixel_blit.h"
+#include "test/test_check.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <vector>
+
+namespace {
+
+struct TestBuffer {
+    std::vector<uint32_t> storage;
+    PixelSurface surface;
+
+    TestBuffer(uint32_t width, uint32_t height, uint32_t padPixels, PixelFormat format)
+        : storage(static_cast<size_t>(width + padPixels) * height, 0xDEADBEEFu),
+          surface {storage.data(), width, height, (width + padPixels) * 4, format}
+    {
+    }
+
+    uint32_t At(uint32_t x, uint32_t y) const
+    {
+        return storage[static_cast<size_t>(y) * (surface.stride / 4) + x];
+    }
+};
+
+void FillRandom(TestBuffer& buffer, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    for (auto& pixel : buffer.storage) {
+        pixel = rng();
+    }
+}
+
+uint32_t Channel(uint32_t p, int index)
+{
+    return (p >> (index * 8)) & 0xFFu;
+}
+
+// Straightforward reference for one pixel
+uint32_t Reference(uint32_t p, bool swapRb, bool premultiply)
+{
+    uint32_t c[4] = {Channel(p, 0), Channel(p, 1), Channel(p, 2), Channel(p, 3)};
+    if (premultiply) {
+        for (int i = 0; i < 3; i++) {
+            // round(c * a / 255)
+            c[i] = (c[i] * c[3] * 2 + 255) / 510;
+        }
+    }
+    if (swapRb) {
+        uint32_t tmp = c[0];
+        c[0] = c[2];
+        c[2] = tmp;
+    }
+    return c[0] | (c[1] << 8) | (c[2] << 16) | (c[3] << 24);
+}
+
+void CheckBlit(uint32_t width, uint32_t height, PixelFormat dstFormat, bool premultiply, const BlitRect& rect)
+{
+    TestBuffer src(width, height, 3, PixelFormat::RGBA_8888);
+    TestBuffer dst(width, height, 7, dstFormat);
+    FillRandom(src, width * 31 + height);
+    std::vector<uint32_t> before = dst.storage;
+
+    EXPECT_TRUE(BlitPixels(src.surface, dst.surface, rect, premultiply));
+
+    const bool swapRb = dstFormat != PixelFormat::RGBA_8888;
+    const uint32_t dstStride = dst.surface.stride / 4;
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < dstStride; x++) {
+            bool inside = (x < width) && (x >= rect.x) && (x < rect.x + rect.w) && (y >= rect.y) &&
+                (y < rect.y + rect.h);
+            uint32_t expected = inside ? Reference(src.At(x, y), swapRb, premultiply) :
+                before[static_cast<size_t>(y) * dstStride + x];
+            if (dst.At(x, y) != expected) {
+                printf("FAILED %s: %ux%u isa=%s swap=%d premul=%d at (%u,%u): got %08x want %08x\n", __func__,
+                    width, height, BlitIsaName(GetBlitIsa()), swapRb, premultiply, x, y, dst.At(x, y), expected);
+                g_failures++;
+                return;
+            }
+        }
+    }
+}
+
+void TestAllOps()
+{
+    const uint32_t sizes[][2] = {{1, 1}, {3, 5}, {17, 9}, {64, 33}, {257, 7}};
+    const PixelFormat formats[] = {PixelFormat::RGBA_8888, PixelFormat::BGRA_8888};
+    for (auto& size : sizes) {
+        for (PixelFormat format : formats) {
+            for (int premultiply = 0; premultiply < 2; premultiply++) {
+                CheckBlit(size[0], size[1], format, premultiply != 0, BlitRect {0, 0, size[0], size[1]});
+                CheckBlit(size[0], size[1], format, premultiply != 0, BlitRect {size[0] / 3, size[1] / 2,
+                    size[0] / 2 + 1, size[1]});
+            }
+        }
+    }
+}
+
+// Premultiplied pixels in runs of 1 to 20, each transparent, opaque or
+// translucent, so every kernel meets all three on both sides of its groups
+void FillPremultiplied(TestBuffer& buffer, uint32_t seed)
+{
+    std::mt19937 rng(seed);
+    size_t i = 0;
+    while (i < buffer.storage.size()) {
+        uint32_t kind = rng() % 3;
+        size_t run = 1 + rng() % 20;
+        for (; (run > 0) && (i < buffer.storage.size()); run--, i++) {
+            uint32_t a = (kind == 0) ? 0 : ((kind == 1) ? 255 : rng() % 256);
+            uint32_t pixel = a << 24;
+            for (int c = 0; c < 3; c++) {
+                pixel |= ((a == 0) ? 0 : rng() % (a + 1)) << (c * 8);
+            }
+            buffer.storage[i] = pixel;
+        }
+    }
+}
+
+uint32_t CompositeReference(uint32_t s, uint32_t d, bool swapRb)
+{
+    s = swapRb ? Reference(s, true, false) : s;
+    uint32_t inverse = 255 - Channel(s, 3);
+    uint32_t out = 0;
+    for (int i = 0; i < 4; i++) {
+        // s + round(d * (255 - a) / 255)
+        uint32_t c = Channel(s, i) + (Channel(d, i) * inverse * 2 + 255) / 510;
+        out |= std::min(c, 255u) << (i * 8);
+    }
+    return out;
+}
+
+void CheckComposite(uint32_t width, uint32_t height, PixelFormat dstFormat, const BlitRect& rect)
+{
+    TestBuffer src(width, height, 5, PixelFormat::RGBA_8888);
+    TestBuffer dst(width, height, 3, dstFormat);
+    FillPremultiplied(src, width * 17 + height);
+    FillRandom(dst, width + height * 13);
+    std::vector<uint32_t> before = dst.storage;
+
+    EXPECT_TRUE(CompositePixels(src.surface, dst.surface, rect));
+
+    const bool swapRb = dstFormat != PixelFormat::RGBA_8888;
+    const uint32_t dstStride = dst.surface.stride / 4;
+    for (uint32_t y = 0; y < height; y++) {
+        for (uint32_t x = 0; x < dstStride; x++) {
+            bool inside = (x < width) && (x >= rect.x) && (x < rect.x + rect.w) && (y >= rect.y) &&
+                (y < rect.y + rect.h);
+            uint32_t old = before[static_cast<size_t>(y) * dstStride + x];
+            uint32_t expected = inside ? CompositeReference(src.At(x, y), old, swapRb) : old;
+            if (dst.At(x, y) != expected) {
+                printf("FAILED %s: %ux%u isa=%s swap=%d at (%u,%u): got %08x want %08x\n", __func__, width, height,
+                    BlitIsaName(GetBlitIsa()), swapRb, x, y, dst.At(x, y), expected);
+                g_failures++;
+                return;
+            }
+        }
+    }
+}
+
+void TestComposite()
+{
+    const uint32_t sizes[][2] = {{1, 1}, {3, 5}, {17, 9}, {64, 33}, {257, 7}};
+    const PixelFormat formats[] = {PixelFormat::RGBA_8888, PixelFormat::BGRA_8888};
+    for (auto& size : sizes) {
+        for (PixelFormat format : formats) {
+            CheckComposite(size[0], size[1], format, BlitRect {0, 0, size[0], size[1]});
+            CheckComposite(size[0], size[1], format, BlitRect {size[0] / 3, size[1] / 2, size[0] / 2 + 1,
+                size[1]});
+        }
+    }
+
+    // Opaque source replaces, transparent leaves alone, exactly
+    TestBuffer src(8, 1, 0, PixelFormat::RGBA_8888);
+    TestBuffer dst(8, 1, 0, PixelFormat::RGBA_8888);
+    for (uint32_t x = 0; x < 8; x++) {
+        src.storage[x] = (x < 4) ? 0xFF102030u : 0;
+        dst.storage[x] = 0x80604020u;
+    }
+    EXPECT_TRUE(CompositePixels(src.surface, dst.surface));
+    EXPECT_TRUE((dst.At(0, 0) == 0xFF102030u) && (dst.At(3, 0) == 0xFF102030u));
+    EXPECT_TRUE((dst.At(4, 0) == 0x80604020u) && (dst.At(7, 0) == 0x80604020u));
+}
+
+void TestClipping()
+{
+    TestBuffer src(8, 8, 0, PixelFormat::RGBA_8888);
+    TestBuffer dst(8, 8, 0, PixelFormat::RGBA_8888);
+    FillRandom(src, 7);
+
+    // Entirely outside: succeeds and touches nothing
+    std::vector<uint32_t> before = dst.storage;
+    EXPECT_TRUE(BlitPixels(src.surface, dst.surface, BlitRect {8, 0, 4, 4}));
+    EXPECT_TRUE(dst.storage == before);
+
+    // Overhanging the right and bottom edges is clipped
+    EXPECT_TRUE(BlitPixels(src.surface, dst.surface, BlitRect {6, 6, 100, 100}));
+    EXPECT_TRUE(dst.At(7, 7) == src.At(7, 7));
+    EXPECT_TRUE(dst.At(5, 5) == before[5 * 8 + 5]);
+}
+
+void TestInvalidInput()
+{
+    TestBuffer src(4, 4, 0, PixelFormat::RGBA_8888);
+    TestBuffer dst(4, 4, 0, PixelFormat::RGBA_8888);
+    PixelSurface badStride = dst.surface;
+    badStride.stride = 6;
+    EXPECT_TRUE(!BlitPixels(src.surface, badStride));
+    PixelSurface noPixels = src.surface;
+    noPixels.pixels = nullptr;
+    EXPECT_TRUE(!BlitPixels(noPixels, dst.surface));
+    EXPECT_TRUE(!CompositePixels(noPixels, dst.surface));
+    EXPECT_TRUE(!CompositePixels(src.surface, badStride));
+}
+
+} // namespace
+
+int main()
+{
+    const BlitIsa isas[] = {BlitIsa::SCALAR, BlitIsa::SSE2, BlitIsa::AVX2, BlitIsa::NEON};
+    const BlitIsa best = GetBlitIsa();
+    for (BlitIsa isa : isas) {
+        if (!SetBlitIsa(isa)) {
+            printf("skipping %s: not supported on this CPU\n", BlitIsaName(isa));
+            continue;
+        }
+        TestAllOps();
+        TestComposite();
+        TestClipping();
+        TestInvalidInput();
+    }
+    SetBlitIsa(best);
+
+    return FinishTest("pixel_blit_test");
+}
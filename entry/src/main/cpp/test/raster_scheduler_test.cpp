@@ -0,0 +1,166 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+// Host-side checks for the raster scheduler: how many frames run at once,
+// the order waiting frames are let in, and who gets the shared workers
+#include "render/raster_scheduler.h"
+#include "test/test_check.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace {
+
+// Poll until count frames are waiting, or give up after a second
+bool WaitForWaiting(const RasterScheduler& scheduler, uint32_t count)
+{
+    for (int i = 0; i < 1000; i++) {
+        if (scheduler.GetStats().waiting == count) {
+            return true;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+}
+
+void TestPriorityOrder()
+{
+    RasterScheduler scheduler(1, 0);
+    std::mutex orderMutex;
+    std::vector<int> order;
+    std::vector<std::thread> threads;
+    {
+        RasterScheduler::Turn held(scheduler, SurfacePriority::VISIBLE);
+        // Queued least important first, each behind the last
+        const SurfacePriority queued[] = {SurfacePriority::BACKGROUND, SurfacePriority::VISIBLE,
+            SurfacePriority::BACKGROUND, SurfacePriority::FOCUSED, SurfacePriority::VISIBLE};
+        for (int i = 0; i < 5; i++) {
+            SurfacePriority priority = queued[i];
+            threads.emplace_back([&scheduler, &orderMutex, &order, priority, i]() {
+                RasterScheduler::Turn turn(scheduler, priority);
+                std::lock_guard<std::mutex> lock(orderMutex);
+                order.push_back(i);
+            });
+            EXPECT_TRUE(WaitForWaiting(scheduler, i + 1));
+        }
+        EXPECT_TRUE(scheduler.GetStats().running == 1);
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    // Focused, then visible and background, each in arrival order
+    EXPECT_TRUE(order == (std::vector<int> {3, 1, 4, 0, 2}));
+
+    RasterSchedulerStats stats = scheduler.GetStats();
+    EXPECT_TRUE((stats.slots == 1) && (stats.running == 0) && (stats.waiting == 0));
+    EXPECT_TRUE(stats.frames[static_cast<uint32_t>(SurfacePriority::FOCUSED)] == 1);
+    EXPECT_TRUE(stats.frames[static_cast<uint32_t>(SurfacePriority::VISIBLE)] == 3);
+    EXPECT_TRUE(stats.frames[static_cast<uint32_t>(SurfacePriority::BACKGROUND)] == 2);
+    EXPECT_TRUE(stats.waited == 5);
+}
+
+void TestSlotLimit()
+{
+    constexpr uint32_t slots = 2;
+    RasterScheduler scheduler(slots, 0);
+    std::atomic<uint32_t> running {0};
+    std::atomic<uint32_t> mostRunning {0};
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 6; i++) {
+        threads.emplace_back([&scheduler, &running, &mostRunning, i]() {
+            RasterScheduler::Turn turn(scheduler, (i % 2 == 0) ? SurfacePriority::VISIBLE : SurfacePriority::FOCUSED);
+            uint32_t now = ++running;
+            uint32_t most = mostRunning.load();
+            while ((now > most) && !mostRunning.compare_exchange_weak(most, now)) {
+            }
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            running--;
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    EXPECT_TRUE((mostRunning.load() >= 1) && (mostRunning.load() <= slots));
+    RasterSchedulerStats stats = scheduler.GetStats();
+    EXPECT_TRUE(stats.frames[0] + stats.frames[1] + stats.frames[2] == 6);
+    EXPECT_TRUE((stats.running == 0) && (stats.waiting == 0));
+}
+
+void TestPools()
+{
+    RasterScheduler scheduler(2, 2);
+    {
+        RasterScheduler::Turn focused(scheduler, SurfacePriority::FOCUSED);
+        RasterScheduler::Turn visible(scheduler, SurfacePriority::VISIBLE);
+        EXPECT_TRUE((focused.GetPool() != nullptr) && (focused.GetPool() == visible.GetPool()));
+        EXPECT_TRUE(focused.GetPool()->GetWorkerCount() == 2);
+        // Both slots taken without waiting
+        EXPECT_TRUE(scheduler.GetStats().waited == 0);
+    }
+    {
+        // Background frames draw on their own thread
+        RasterScheduler::Turn turn(scheduler, SurfacePriority::BACKGROUND);
+        EXPECT_TRUE(turn.GetPool() == nullptr);
+    }
+    {
+        // No workers, no pool
+        RasterScheduler single(1, 0);
+        RasterScheduler::Turn turn(single, SurfacePriority::FOCUSED);
+        EXPECT_TRUE(turn.GetPool() == nullptr);
+        EXPECT_TRUE(single.GetStats().workers == 0);
+    }
+
+    // The shared scheduler: the frames drawn at once and the workers they
+    // share together take the performance cores, no more
+    RasterSchedulerStats shared = RasterScheduler::GetShared().GetStats();
+    EXPECT_TRUE(shared.slots >= 1);
+    EXPECT_TRUE(shared.slots + shared.workers == WorkStealingPool::GetPerformanceCoreCount());
+}
+
+void TestTopology()
+{
+    const CpuTopology& topology = WorkStealingPool::GetCpuTopology();
+    uint32_t cpus = std::max(std::thread::hardware_concurrency(), 1u);
+    EXPECT_TRUE(!topology.performance.empty());
+    EXPECT_TRUE(topology.performance.size() + topology.efficiency.size() == cpus);
+    EXPECT_TRUE(WorkStealingPool::GetPerformanceCoreCount() == topology.performance.size());
+
+    // Every CPU once
+    std::vector<uint32_t> all(topology.performance);
+    all.insert(all.end(), topology.efficiency.begin(), topology.efficiency.end());
+    std::sort(all.begin(), all.end());
+    EXPECT_TRUE(std::unique(all.begin(), all.end()) == all.end());
+    EXPECT_TRUE(all.back() < cpus);
+
+    // Nothing to pin to is refused; moving a thread back and forth is harmless
+    EXPECT_TRUE(!WorkStealingPool::SetThreadCpus({}));
+    std::thread([]() {
+        RasterScheduler::MoveThread(SurfacePriority::BACKGROUND);
+        RasterScheduler::MoveThread(SurfacePriority::FOCUSED);
+    }).join();
+
+    // Workers kept on the performance cores still run everything
+    WorkStealingPool pool(2, topology.performance);
+    std::atomic<uint32_t> sum {0};
+    pool.ParallelFor(100, [&sum](uint32_t index) { sum += index; });
+    EXPECT_TRUE(sum.load() == 99 * 100 / 2);
+}
+
+} // namespace
+
+int main()
+{
+    TestPriorityOrder();
+    TestSlotLimit();
+    TestPools();
+    TestTopology();
+
+    return FinishTest("raster_scheduler_test");
+}
@@ -0,0 +1,198 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+// Host-side checks for the SPSC queue and the render thread built on it
+#include "render/render_thread.h"
+#include "test/test_check.h"
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+namespace {
+
+void TestQueueSingleThread()
+{
+    SpscQueue<int, 4> queue;
+    int value = 0;
+    EXPECT_TRUE(queue.Empty());
+    EXPECT_TRUE(!queue.TryPop(value));
+    for (int i = 0; i < 4; i++) {
+        EXPECT_TRUE(queue.TryPush(i));
+    }
+    EXPECT_TRUE(!queue.TryPush(4));
+    EXPECT_TRUE(queue.TryPop(value) && value == 0);
+    EXPECT_TRUE(queue.TryPush(4));
+    for (int i = 1; i <= 4; i++) {
+        EXPECT_TRUE(queue.TryPop(value) && value == i);
+    }
+    EXPECT_TRUE(queue.Empty());
+}
+
+void TestQueueTwoThreads()
+{
+    constexpr int count = 200000;
+    SpscQueue<int, 256> queue;
+    bool ordered = true;
+    std::thread consumer([&] {
+        int expected = 0;
+        int value = 0;
+        while (expected < count) {
+            if (queue.TryPop(value)) {
+                ordered = ordered && (value == expected);
+                expected++;
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+    for (int i = 0; i < count; i++) {
+        while (!queue.TryPush(i)) {
+            std::this_thread::yield();
+        }
+    }
+    consumer.join();
+    EXPECT_TRUE(ordered);
+    EXPECT_TRUE(queue.Empty());
+}
+
+void TestStopDrainsQueue()
+{
+    std::vector<uint64_t> seen;
+    RenderThread thread([&](const RenderCommand& command) {
+        // Slow consumer, so the queue fills up and Stop has work to drain
+        std::this_thread::sleep_for(std::chrono::microseconds(50));
+        seen.push_back(command.width);
+    });
+    thread.Start();
+    EXPECT_TRUE(thread.IsRunning());
+
+    constexpr uint64_t count = 500;
+    for (uint64_t i = 0; i < count; i++) {
+        thread.PostBlocking(RenderCommand {RenderCommandType::DRAW_PATTERN, nullptr, i, 0, nullptr});
+    }
+    thread.Stop();
+    EXPECT_TRUE(!thread.IsRunning());
+    EXPECT_TRUE(seen.size() == count);
+    for (uint64_t i = 0; i < seen.size(); i++) {
+        if (seen[i] != i) {
+            EXPECT_TRUE(seen[i] == i);
+            break;
+        }
+    }
+
+    // A second Stop is a no-op
+    thread.Stop();
+}
+
+void TestPostWhenFull()
+{
+    std::atomic<bool> release {false};
+    std::atomic<int> handled {0};
+    RenderThread thread([&](const RenderCommand&) {
+        while (!release.load()) {
+            std::this_thread::yield();
+        }
+        handled++;
+    });
+    thread.Start();
+
+    // The first command blocks the thread; the rest fill the queue
+    int accepted = 0;
+    for (int i = 0; i < 1000; i++) {
+        if (thread.Post(RenderCommand {RenderCommandType::DRAW_TEXT, nullptr, 0, 0, nullptr})) {
+            accepted++;
+        }
+    }
+    EXPECT_TRUE(accepted < 1000);
+    release = true;
+    thread.Stop();
+    EXPECT_TRUE(handled.load() == accepted);
+}
+
+// Several threads posting at once: nothing lost, each thread's commands in
+// the order it posted them
+void TestManyProducers()
+{
+    constexpr uint64_t producers = 4;
+    constexpr uint64_t count = 2000;
+    std::vector<uint64_t> next(producers, 0);
+    bool ordered = true;
+    RenderThread thread([&](const RenderCommand& command) {
+        uint64_t& expected = next[command.height];
+        ordered = ordered && (command.width == expected);
+        expected++;
+    });
+    thread.Start();
+    std::vector<std::thread> threads;
+    for (uint64_t p = 0; p < producers; p++) {
+        threads.emplace_back([&thread, p]() {
+            for (uint64_t i = 0; i < count; i++) {
+                RenderCommand command {RenderCommandType::DRAW_PATTERN, nullptr, i, p, nullptr};
+                // Alternate, so both kinds of post race each other
+                if (i % 2 == 0) {
+                    thread.PostBlocking(command);
+                    continue;
+                }
+                while (!thread.Post(command)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+    for (std::thread& producer : threads) {
+        producer.join();
+    }
+    thread.Stop();
+    EXPECT_TRUE(ordered);
+    for (uint64_t p = 0; p < producers; p++) {
+        EXPECT_TRUE(next[p] == count);
+    }
+}
+
+// A tick asked for at a time runs then, with nothing else to wake the
+// thread, and the earliest of several requests wins
+void TestTickAt()
+{
+    using Clock = std::chrono::steady_clock;
+    constexpr std::chrono::milliseconds delay(30);
+    RenderThread thread([](const RenderCommand&) {});
+    std::atomic<int> ticks {0};
+    Clock::time_point first;
+    Clock::time_point second;
+    thread.SetTickHandler([&]() {
+        if (ticks.load() == 0) {
+            first = Clock::now();
+            thread.RequestTickAt(first + 10 * delay);
+            thread.RequestTickAt(first + delay);
+        } else {
+            second = Clock::now();
+        }
+        ticks++;
+    });
+    thread.Start();
+    thread.RequestTick();
+    for (int i = 0; (i < 1000) && (ticks.load() < 2); i++) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    thread.Stop();
+    EXPECT_TRUE(ticks.load() == 2);
+    EXPECT_TRUE((second - first >= delay) && (second - first < 10 * delay));
+}
+
+} // namespace
+
+int main()
+{
+    TestQueueSingleThread();
+    TestQueueTwoThreads();
+    TestStopDrainsQueue();
+    TestPostWhenFull();
+    TestManyProducers();
+    TestTickAt();
+
+    return FinishTest("render_thread_test");
+}
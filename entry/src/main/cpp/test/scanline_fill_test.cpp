@@ -0,0 +1,454 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+// Host-side checks for the scanline coverage kernels: the tile rasterizer,
+// with every instruction set and quality level, against a per-pixel
+// reference rasterizer, byte for byte
+#include "render/display_list.h"
+#include "render/scanline_fill.h"
+#include "render/stroke_font.h"
+#include "render/tile_raster.h"
+#include "render/work_stealing_pool.h"
+#include "test/test_check.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t WIDTH = 300;
+constexpr uint32_t HEIGHT = 200;
+// Padded rows, so a stride other than width * 4 is covered too
+constexpr uint32_t STRIDE = WIDTH * 4 + 20;
+
+const AaQuality QUALITIES[] = {AaQuality::NONE, AaQuality::LOW, AaQuality::MEDIUM, AaQuality::HIGH};
+const char* const QUALITY_NAMES[] = {"none", "low", "medium", "high"};
+
+struct Canvas {
+    std::vector<uint8_t> bytes;
+    PixelSurface surface;
+
+    explicit Canvas(PixelFormat format = PixelFormat::RGBA_8888) : bytes(STRIDE * HEIGHT, 0xFF)
+    {
+        surface = PixelSurface {bytes.data(), WIDTH, HEIGHT, STRIDE, format};
+    }
+
+    uint8_t* Pixel(uint32_t x, uint32_t y)
+    {
+        return bytes.data() + y * STRIDE + x * 4;
+    }
+};
+
+struct FillDraw {
+    RasterPath path;
+    uint32_t color;
+};
+
+// The fill rule of TileRasterizer written out the slow way: every edge
+// against every sample row of the surface, and each pixel's coverage summed
+// from the spans overlapping it, with no tiles and no accumulation.
+void ReferenceFill(Canvas& canvas, const FillDraw& draw, AaQuality quality)
+{
+    struct RefEdge {
+        float x0;
+        float y0;
+        float x1;
+        float y1;
+        int32_t winding;
+    };
+    std::vector<RefEdge> edges;
+    const std::vector<RasterPoint>& points = draw.path.GetPoints();
+    for (size_t c = 0; c < draw.path.GetContours().size(); c++) {
+        size_t start = draw.path.GetContours()[c].start;
+        size_t count = draw.path.GetContourEnd(c) - start;
+        for (size_t i = 0, j = count - 1; (count >= 2) && (i < count); j = i++) {
+            const RasterPoint& a = points[start + j];
+            const RasterPoint& b = points[start + i];
+            if (a.y < b.y) {
+                edges.push_back(RefEdge {a.x, a.y, b.x, b.y, 1});
+            } else if (a.y > b.y) {
+                edges.push_back(RefEdge {b.x, b.y, a.x, a.y, -1});
+            }
+        }
+    }
+
+    uint32_t sampleRows = GetAaSampleRows(quality);
+    int32_t weight = GetSampleWeight(sampleRows);
+    bool snap = quality == AaQuality::NONE;
+    std::vector<int64_t> coverage(WIDTH);
+    for (uint32_t row = 0; row < HEIGHT; row++) {
+        std::fill(coverage.begin(), coverage.end(), 0);
+        for (uint32_t s = 0; s < sampleRows; s++) {
+            float y = row + (s + 0.5f) * (1.0f / sampleRows);
+            std::vector<std::pair<float, int32_t>> crossings;
+            for (const RefEdge& edge : edges) {
+                if ((y >= edge.y0) && (y < edge.y1)) {
+                    float t = (y - edge.y0) / (edge.y1 - edge.y0);
+                    crossings.emplace_back(edge.x0 + t * (edge.x1 - edge.x0), edge.winding);
+                }
+            }
+            std::sort(crossings.begin(), crossings.end());
+            int32_t winding = 0;
+            for (size_t i = 0; i < crossings.size(); i++) {
+                winding += crossings[i].second;
+                if (winding == 0) {
+                    continue;
+                }
+                float next = (i + 1 < crossings.size()) ? crossings[i + 1].first : static_cast<float>(WIDTH);
+                int32_t x0 = ToSubpixel(std::min(std::max(crossings[i].first, 0.0f), static_cast<float>(WIDTH)), snap);
+                int32_t x1 = ToSubpixel(std::min(std::max(next, 0.0f), static_cast<float>(WIDTH)), snap);
+                for (int32_t x = 0; x < static_cast<int32_t>(WIDTH); x++) {
+                    int32_t overlap = std::min(x1, (x + 1) * COVERAGE_SUBPIXELS) -
+                        std::max(x0, x * COVERAGE_SUBPIXELS);
+                    if (overlap > 0) {
+                        coverage[x] += static_cast<int64_t>(overlap) * weight;
+                    }
+                }
+            }
+        }
+
+        bool bgra = canvas.surface.format == PixelFormat::BGRA_8888;
+        uint32_t red = (draw.color >> 16) & 0xFF;
+        uint32_t blue = draw.color & 0xFF;
+        uint32_t src[4] = {bgra ? blue : red, (draw.color >> 8) & 0xFF, bgra ? red : blue, 255};
+        for (uint32_t x = 0; x < WIDTH; x++) {
+            int64_t c = std::min<int64_t>(coverage[x], COVERAGE_FULL - 1);
+            uint32_t a = static_cast<uint32_t>((c * (draw.color >> 24) + COVERAGE_FULL / 2) / COVERAGE_FULL);
+            uint8_t* out = canvas.Pixel(x, row);
+            for (int k = 0; k < 4; k++) {
+                out[k] = static_cast<uint8_t>((src[k] * a + out[k] * (255 - a) + 127) / 255);
+            }
+        }
+    }
+}
+
+// Records every draw both for the tile rasterizer and for the reference
+class RecordingSink : public DisplayListSink {
+public:
+    RecordingSink(TileRasterizer& raster, std::vector<FillDraw>& reference) : raster_(raster), reference_(reference)
+    {
+    }
+
+    void Clear(uint32_t) override
+    {
+    }
+    void MoveTo(float x, float y) override
+    {
+        path_.MoveTo(x, y);
+    }
+    void LineTo(float x, float y) override
+    {
+        path_.LineTo(x, y);
+    }
+    void QuadTo(float x1, float y1, float x2, float y2) override
+    {
+        path_.QuadTo(x1, y1, x2, y2, FLATTEN_TOLERANCE);
+    }
+    void CubicTo(float x1, float y1, float x2, float y2, float x3, float y3) override
+    {
+        path_.CubicTo(x1, y1, x2, y2, x3, y3, FLATTEN_TOLERANCE);
+    }
+    void ArcTo(float cx, float cy, float radius, float startAngle, float sweep) override
+    {
+        path_.ArcTo(cx, cy, radius, startAngle, sweep, FLATTEN_TOLERANCE);
+    }
+    void RoundRect(float left, float top, float right, float bottom, float radius) override
+    {
+        path_.AddRoundRect(left, top, right, bottom, radius, FLATTEN_TOLERANCE);
+    }
+    void Close() override
+    {
+        path_.Close();
+    }
+    void Fill(uint32_t color, const DrawBounds&) override
+    {
+        raster_.Fill(path_, color);
+        reference_.push_back(FillDraw {path_, color});
+        path_.Reset();
+    }
+    void Stroke(uint32_t color, float width, const DrawBounds&) override
+    {
+        raster_.Stroke(path_, width, color);
+        FillDraw outline {RasterPath(), color};
+        TileRasterizer::OutlineStroke(path_, width, outline.path);
+        reference_.push_back(std::move(outline));
+        path_.Reset();
+    }
+
+private:
+    TileRasterizer& raster_;
+    std::vector<FillDraw>& reference_;
+    RasterPath path_;
+};
+
+std::vector<BlitIsa> SupportedIsas()
+{
+    std::vector<BlitIsa> isas;
+    BlitIsa best = GetBlitIsa();
+    for (BlitIsa isa : {BlitIsa::SCALAR, BlitIsa::SSE2, BlitIsa::AVX2, BlitIsa::NEON}) {
+        if (SetBlitIsa(isa)) {
+            isas.push_back(isa);
+        }
+    }
+    SetBlitIsa(best);
+    return isas;
+}
+
+// Replays list into the tile rasterizer with every instruction set, quality,
+// format and pool, and into the reference, and compares the results
+void CheckAgainstReference(const char* name, const DisplayListBuilder& builder)
+{
+    DisplayList list;
+    EXPECT_TRUE(list.Load(builder.Data(), builder.Size()));
+    BlitIsa best = GetBlitIsa();
+    WorkStealingPool pool(3);
+    TileRasterizer raster;
+    for (PixelFormat format : {PixelFormat::RGBA_8888, PixelFormat::BGRA_8888}) {
+        for (AaQuality quality : QUALITIES) {
+            Canvas expected(format);
+            std::vector<FillDraw> draws;
+            TileRasterizer unused;
+            RecordingSink referenceSink(unused, draws);
+            list.Replay(referenceSink);
+            for (const FillDraw& draw : draws) {
+                ReferenceFill(expected, draw, quality);
+            }
+
+            for (BlitIsa isa : SupportedIsas()) {
+                SetBlitIsa(isa);
+                for (WorkStealingPool* runOn : {static_cast<WorkStealingPool*>(nullptr), &pool}) {
+                    Canvas actual(format);
+                    std::vector<FillDraw> ignored;
+                    RecordingSink sink(raster, ignored);
+                    raster.SetQuality(quality);
+                    raster.Begin(actual.surface);
+                    list.Replay(sink);
+                    raster.Flush(runOn);
+                    bool same = actual.bytes == expected.bytes;
+                    if (!same) {
+                        printf("%s: %s, %s quality, %s differs from the reference\n", name, BlitIsaName(isa),
+                            QUALITY_NAMES[static_cast<int>(quality)], runOn == nullptr ? "serial" : "parallel");
+                    }
+                    EXPECT_TRUE(same);
+                }
+            }
+        }
+    }
+    SetBlitIsa(best);
+}
+
+// The shape DrawPattern fills and outlines, at this surface's size
+void TestPentagon()
+{
+    float len = HEIGHT / 4;
+    float aX = WIDTH / 2;
+    float aY = HEIGHT / 4;
+    float dX = aX - len * std::sin(18.0f);
+    float dY = aY + len * std::cos(18.0f);
+    float cX = aX + len * std::sin(18.0f);
+    float bX = aX + len / 2;
+    float bY = aY + std::sqrt((cX - dX) * (cX - dX) + (len / 2) * (len / 2));
+    float eX = aX - len / 2;
+
+    auto outline = [&](DisplayListBuilder& builder) {
+        builder.MoveTo(aX, aY).LineTo(bX, bY).LineTo(cX, dY).LineTo(dX, dY).LineTo(eX, bY).Close();
+    };
+    DisplayListBuilder builder;
+    builder.Color(0xFF00FF00);
+    outline(builder);
+    builder.Fill().Color(0xFFFF0000).Width(10.0f);
+    outline(builder);
+    builder.Stroke();
+    CheckAgainstReference("pentagon", builder);
+}
+
+// The label's letters from the stroke font, stroked as the glyph atlas draws them
+void TestLetters()
+{
+    DisplayListBuilder builder;
+    const char* label = "HELLO";
+    float scale = 4.5f;
+    float originX = 12.25f;
+    float originY = 40.5f;
+    for (const char* c = label; *c != '\0'; c++) {
+        builder.Color(0xE0000000 | static_cast<uint32_t>((c - label) * 0x331177)).Width(scale * 1.4f);
+        StrokeFont::ForEachSegment(StrokeFont::GetGlyph(*c), [&](int x0, int y0, int x1, int y1) {
+            builder.MoveTo(originX + x0 * scale, originY + y0 * scale);
+            builder.LineTo(originX + x1 * scale, originY + y1 * scale);
+        });
+        builder.Stroke();
+        originX += StrokeFont::GLYPH_ADVANCE * scale;
+    }
+    CheckAgainstReference("letters", builder);
+}
+
+// Rounded UI: a card with cubic corners, a pill of quads, and a curved stroke
+void TestCurves()
+{
+    // Cubic control points this far along a quarter circle's tangents make it round
+    const float k = 0.5523f;
+    float left = 20.5f;
+    float top = 30.25f;
+    float right = 180.0f;
+    float bottom = 130.0f;
+    float r = 24.0f;
+    DisplayListBuilder builder;
+    builder.Color(0xC02060A0).MoveTo(left + r, top).LineTo(right - r, top);
+    builder.CubicTo(right - r + k * r, top, right, top + r - k * r, right, top + r).LineTo(right, bottom - r);
+    builder.CubicTo(right, bottom - r + k * r, right - r + k * r, bottom, right - r, bottom).LineTo(left + r, bottom);
+    builder.CubicTo(left + r - k * r, bottom, left, bottom - r + k * r, left, bottom - r).LineTo(left, top + r);
+    builder.CubicTo(left, top + r - k * r, left + r - k * r, top, left + r, top).Close().Fill();
+
+    builder.Color(0xFFFF8000).MoveTo(210, 40).LineTo(260, 40).QuadTo(280, 40, 280, 60).QuadTo(280, 80, 260, 80);
+    builder.LineTo(210, 80).QuadTo(190, 80, 190, 60).QuadTo(190, 40, 210, 40).Close().Fill();
+
+    builder.Color(0xE0000000).Width(3.5f).MoveTo(30, 170).CubicTo(90, 100, 150, 260, 270, 150).Stroke();
+    CheckAgainstReference("curves", builder);
+}
+
+// Arcs and rounded rects, the shapes most UI is made of: a pie slice, a ring
+// stroked around a full turn, and cards filled and outlined
+void TestArcs()
+{
+    const float pi = 3.14159265f;
+    DisplayListBuilder builder;
+    builder.Color(0xFF3070C0).MoveTo(70.5f, 70.5f).ArcTo(70.5f, 70.5f, 45, -pi / 2, 2.2f).Close().Fill();
+    builder.Color(0xA0C04000).Width(6).MoveTo(230, 70).ArcTo(190, 70, 40, 0, 2 * pi).Stroke();
+    builder.Color(0xC0208040).RoundRect(20.25f, 125.5f, 150, 190, 18).Fill();
+    // A radius past half the shorter side makes a pill
+    builder.Color(0xFF000000).Width(2.5f).RoundRect(170, 125, 290, 185, 60).Stroke();
+    builder.Color(0x80FFFFFF).RoundRect(40, 135, 120, 180, 0).RoundRect(60, 145, 100, 170, 10).Fill();
+    CheckAgainstReference("arcs", builder);
+}
+
+// Pseudo-random lists: self-intersecting and multi-contour fills, open and
+// closed strokes, translucent colors, shapes off the surface's edges
+void TestRandomDisplayLists()
+{
+    uint32_t seed = 2024;
+    auto next = [&seed](float range) {
+        seed = seed * 1664525u + 1013904223u;
+        return (seed >> 8) / static_cast<float>(1u << 24) * range;
+    };
+    for (int list = 0; list < 4; list++) {
+        DisplayListBuilder builder;
+        for (int draw = 0; draw < 12; draw++) {
+            builder.Color((static_cast<uint32_t>(1 + next(254)) << 24) | static_cast<uint32_t>(next(16777216.0f)));
+            int contours = 1 + static_cast<int>(next(3));
+            for (int c = 0; c < contours; c++) {
+                builder.MoveTo(next(WIDTH + 60) - 30, next(HEIGHT + 60) - 30);
+                int points = 2 + static_cast<int>(next(6));
+                for (int p = 1; p < points; p++) {
+                    builder.LineTo(next(WIDTH + 60) - 30, next(HEIGHT + 60) - 30);
+                }
+                if (next(1) < 0.7f) {
+                    builder.Close();
+                }
+            }
+            if (next(1) < 0.4f) {
+                builder.Width(0.5f + next(14)).Stroke();
+            } else {
+                builder.Fill();
+            }
+        }
+        char name[32];
+        snprintf(name, sizeof(name), "random list %d", list);
+        CheckAgainstReference(name, builder);
+    }
+}
+
+// The kernels on their own: random spans resolved by every instruction set
+void TestKernelsMatchScalar()
+{
+    uint32_t seed = 99;
+    auto next = [&seed](uint32_t range) {
+        seed = seed * 1664525u + 1013904223u;
+        return (seed >> 8) % range;
+    };
+    BlitIsa best = GetBlitIsa();
+    for (uint32_t count = 1; count <= TileRasterizer::TILE_SIZE; count++) {
+        std::vector<int32_t> spans;
+        for (uint32_t i = 0; i < 6; i++) {
+            int32_t x0 = static_cast<int32_t>(next(count * COVERAGE_SUBPIXELS));
+            int32_t x1 = x0 + 1 + static_cast<int32_t>(next(count * COVERAGE_SUBPIXELS - x0));
+            spans.push_back(x0);
+            spans.push_back(x1);
+        }
+        uint32_t alpha = 1 + next(255);
+        uint32_t color = (alpha << 24) | next(1u << 24);
+        std::vector<uint8_t> pixels(count * 4);
+        for (uint8_t& byte : pixels) {
+            byte = static_cast<uint8_t>(next(256));
+        }
+
+        std::vector<uint8_t> expectedCoverage;
+        std::vector<uint8_t> expectedPixels;
+        for (BlitIsa isa : SupportedIsas()) {
+            SetBlitIsa(isa);
+            std::vector<int32_t> cells(count + 2, 0);
+            for (size_t i = 0; i < spans.size(); i += 2) {
+                AccumulateSpan(cells.data(), spans[i], spans[i + 1], GetSampleWeight(16));
+            }
+            std::vector<uint8_t> coverage(count);
+            ResolveCoverage(cells.data(), count, alpha, coverage.data());
+            EXPECT_TRUE(std::all_of(cells.begin(), cells.end(), [](int32_t cell) { return cell == 0; }));
+            std::vector<uint8_t> blended = pixels;
+            BlendCoverage(blended.data(), coverage.data(), count, color, PixelFormat::RGBA_8888);
+            if (isa == BlitIsa::SCALAR) {
+                expectedCoverage = coverage;
+                expectedPixels = blended;
+            }
+            EXPECT_TRUE(coverage == expectedCoverage);
+            EXPECT_TRUE(blended == expectedPixels);
+        }
+    }
+    SetBlitIsa(best);
+}
+
+// Without anti-aliasing a pixel is either untouched or fully painted
+void TestNoneIsAliased()
+{
+    TileRasterizer raster;
+    Canvas canvas;
+    RasterPath triangle;
+    triangle.MoveTo(10.3f, 10.7f);
+    triangle.LineTo(250.6f, 30.2f);
+    triangle.LineTo(40.1f, 190.9f);
+    raster.SetQuality(AaQuality::NONE);
+    raster.Begin(canvas.surface);
+    raster.Fill(triangle, 0xFF000000);
+    raster.Flush(nullptr);
+    bool binary = true;
+    uint32_t painted = 0;
+    for (uint32_t y = 0; y < HEIGHT; y++) {
+        for (uint32_t x = 0; x < WIDTH; x++) {
+            uint8_t* pixel = canvas.Pixel(x, y);
+            binary = binary && ((pixel[0] == 0) || (pixel[0] == 255));
+            painted += (pixel[0] == 0) ? 1 : 0;
+        }
+    }
+    EXPECT_TRUE(binary);
+    // Twice the triangle's area is the cross product of two of its sides
+    double area = std::fabs((250.6 - 10.3) * (190.9 - 10.7) - (40.1 - 10.3) * (30.2 - 10.7)) / 2;
+    EXPECT_TRUE(std::fabs(painted - area) < area * 0.01);
+}
+
+} // namespace
+
+int main()
+{
+    TestKernelsMatchScalar();
+    TestNoneIsAliased();
+    TestPentagon();
+    TestLetters();
+    TestCurves();
+    TestArcs();
+    TestRandomDisplayLists();
+
+    return FinishTest("scanline_fill_test");
+}
@@ -0,0 +1,110 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+// Host-side checks for the size-classed staging memory
+#include "render/staging_memory.h"
+#include "test/test_check.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+size_t SurfaceBytes(size_t width, size_t height)
+{
+    return width * height * sizeof(uint32_t);
+}
+
+void TestSizeClasses()
+{
+    EXPECT_TRUE(StagingMemory::SizeClass(0) == StagingMemory::ALIGNMENT);
+    EXPECT_TRUE(StagingMemory::SizeClass(1) == StagingMemory::ALIGNMENT);
+    EXPECT_TRUE(StagingMemory::SizeClass(1 << 20) == (1 << 20));
+    // A quarter step above a power of two
+    EXPECT_TRUE(StagingMemory::SizeClass((1 << 20) + 1) == (1 << 20) + (1 << 18));
+
+    bool holds = true;
+    bool tight = true;
+    bool aligned = true;
+    bool ordered = true;
+    size_t previous = 0;
+    for (size_t bytes = 1; bytes < (64u << 20); bytes = bytes * 9 / 8 + 13) {
+        size_t size = StagingMemory::SizeClass(bytes);
+        holds = holds && (size >= bytes);
+        tight = tight && (size <= bytes + bytes / 4 + StagingMemory::ALIGNMENT);
+        aligned = aligned && (size % StagingMemory::ALIGNMENT == 0);
+        ordered = ordered && (size >= previous);
+        previous = size;
+    }
+    EXPECT_TRUE(holds);
+    EXPECT_TRUE(tight);
+    EXPECT_TRUE(aligned);
+    EXPECT_TRUE(ordered);
+}
+
+void TestGrowWithHeadroom()
+{
+    StagingMemory memory;
+    EXPECT_TRUE((memory.Data() == nullptr) && (memory.Capacity() == 0));
+    EXPECT_TRUE(memory.Reserve(SurfaceBytes(1000, 600), false));
+    EXPECT_TRUE(memory.Data() != nullptr);
+    EXPECT_TRUE(reinterpret_cast<uintptr_t>(memory.Data()) % StagingMemory::ALIGNMENT == 0);
+    EXPECT_TRUE(memory.Capacity() >= SurfaceBytes(1000, 600) + SurfaceBytes(1000, 600) / 4);
+    // Writable end to end
+    memset(memory.Data(), 0xAB, SurfaceBytes(1000, 600));
+
+    // A resize animation growing the surface frame by frame
+    const int steps = 30;
+    for (int i = 1; i <= steps; i++) {
+        size_t width = 1000 + 280 * i / steps;
+        size_t height = 600 + 200 * i / steps;
+        EXPECT_TRUE(memory.Reserve(SurfaceBytes(width, height), false));
+        EXPECT_TRUE(memory.Capacity() >= SurfaceBytes(width, height));
+    }
+    EXPECT_TRUE(memory.GetAllocations() <= 3);
+}
+
+void TestShrinkLazily()
+{
+    StagingMemory memory;
+    EXPECT_TRUE(memory.Reserve(SurfaceBytes(2560, 1600), false));
+    size_t large = memory.Capacity();
+    void* data = memory.Data();
+
+    // Smaller sizes while still resizing keep the memory
+    for (size_t width = 2560; width >= 640; width -= 64) {
+        EXPECT_TRUE(memory.Reserve(SurfaceBytes(width, width * 5 / 8), false));
+    }
+    EXPECT_TRUE((memory.Capacity() == large) && (memory.Data() == data));
+    EXPECT_TRUE(memory.GetAllocations() == 1);
+
+    // Settled at a size that uses most of it: kept
+    EXPECT_TRUE(memory.Reserve(SurfaceBytes(2400, 1500), true));
+    EXPECT_TRUE((memory.Capacity() == large) && (memory.GetAllocations() == 1));
+
+    // Settled far smaller: given back
+    EXPECT_TRUE(memory.Reserve(SurfaceBytes(640, 400), true));
+    EXPECT_TRUE(memory.Capacity() < large / 4);
+    EXPECT_TRUE(memory.Capacity() >= SurfaceBytes(640, 400));
+    EXPECT_TRUE(memory.GetAllocations() == 2);
+
+    // And asking again changes nothing
+    EXPECT_TRUE(memory.Reserve(SurfaceBytes(640, 400), true));
+    EXPECT_TRUE(memory.GetAllocations() == 2);
+
+    memory.Release();
+    EXPECT_TRUE((memory.Data() == nullptr) && (memory.Capacity() == 0));
+}
+
+} // namespace
+
+int main()
+{
+    TestSizeClasses();
+    TestGrowWithHeadroom();
+    TestShrinkLazily();
+
+    return FinishTest("staging_memory_test");
+}
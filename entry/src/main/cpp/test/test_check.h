@@ -0,0 +1,37 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+// What every host test program checks with, and how it reports
+#ifndef TEST_CHECK_H
+#define TEST_CHECK_H
+
+#include <cstdio>
+#include <cstdlib>
+
+// Checks failed so far in this program
+inline int g_failures = 0;
+
+// Report a condition that does not hold and carry on with the test
+#define EXPECT_TRUE(cond)                                                     \
+    do {                                                                      \
+        if (!(cond)) {                                                        \
+            printf("FAILED %s:%d: %s\n", __FILE__, __LINE__, #cond);          \
+            g_failures++;                                                     \
+        }                                                                     \
+    } while (0)
+
+// main()'s result: how many checks failed, or that the program named name
+// passed
+inline int FinishTest(const char* name)
+{
+    if (g_failures != 0) {
+        printf("%d failure(s)\n", g_failures);
+        return EXIT_FAILURE;
+    }
+    printf("%s passed\n", name);
+    return EXIT_SUCCESS;
+}
+
+#endif // TEST_CHECK_H
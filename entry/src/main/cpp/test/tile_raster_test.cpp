@@ -0,0 +1,248 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+// Host-side checks for the work-stealing pool and the tile rasterizer
+#include "render/tile_raster.h"
+#include "render/work_stealing_pool.h"
+#include "test/test_check.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t WIDTH = 300;
+constexpr uint32_t HEIGHT = 200;
+
+struct Canvas {
+    std::vector<uint32_t> pixels;
+    PixelSurface surface;
+
+    explicit Canvas(uint32_t fill = 0xFFFFFFFF) : pixels(WIDTH * HEIGHT, fill)
+    {
+        surface = PixelSurface {pixels.data(), WIDTH, HEIGHT, WIDTH * 4, PixelFormat::RGBA_8888};
+    }
+};
+
+void TestPoolRunsEveryIndexOnce()
+{
+    WorkStealingPool pool(4);
+    EXPECT_TRUE(pool.GetWorkerCount() == 4);
+    for (uint32_t count : {1u, 3u, 4u, 5u, 97u, 1000u}) {
+        std::vector<std::atomic<uint32_t>> hits(count);
+        pool.ParallelFor(count, [&](uint32_t i) { hits[i].fetch_add(1); });
+        bool once = true;
+        for (auto& hit : hits) {
+            once = once && (hit.load() == 1);
+        }
+        EXPECT_TRUE(once);
+    }
+
+    // No workers: everything on the calling thread
+    WorkStealingPool inlinePool(0);
+    uint32_t sum = 0;
+    inlinePool.ParallelFor(10, [&](uint32_t i) { sum += i; });
+    EXPECT_TRUE(sum == 45);
+}
+
+void TestPoolConcurrentCallers()
+{
+    WorkStealingPool pool(3);
+    constexpr uint32_t rounds = 200;
+    constexpr uint32_t count = 64;
+    std::atomic<uint32_t> total {0};
+    auto caller = [&] {
+        for (uint32_t r = 0; r < rounds; r++) {
+            std::atomic<uint32_t> done {0};
+            pool.ParallelFor(count, [&](uint32_t) {
+                done.fetch_add(1);
+                total.fetch_add(1);
+            });
+            // Returns only once its own indices have all run
+            EXPECT_TRUE(done.load() == count);
+        }
+    };
+    std::thread other(caller);
+    caller();
+    other.join();
+    EXPECT_TRUE(total.load() == 2 * rounds * count);
+}
+
+// Alpha of a draw in black over a transparent surface is its coverage
+double CoveredArea(const Canvas& canvas)
+{
+    double area = 0;
+    for (uint32_t pixel : canvas.pixels) {
+        area += (pixel >> 24) / 255.0;
+    }
+    return area;
+}
+
+void TestFillCoverage()
+{
+    TileRasterizer raster;
+    Canvas canvas(0);
+    RasterPath rect;
+    // Crosses tile boundaries both ways, with fractional edges
+    rect.MoveTo(40.25f, 30.5f);
+    rect.LineTo(180.75f, 30.5f);
+    rect.LineTo(180.75f, 150.0f);
+    rect.LineTo(40.25f, 150.0f);
+    rect.Close();
+    raster.Begin(canvas.surface);
+    raster.Fill(rect, 0xFF000000);
+    raster.Flush(nullptr);
+    EXPECT_TRUE(raster.GetLastTileCount() == 3 * 3);
+    EXPECT_TRUE(std::fabs(CoveredArea(canvas) - 140.5 * 119.5) < 1.0);
+    EXPECT_TRUE(canvas.pixels[100 * WIDTH + 100] == 0xFF000000);
+    EXPECT_TRUE(canvas.pixels[100 * WIDTH + 200] == 0);
+    EXPECT_TRUE(canvas.pixels[10 * WIDTH + 100] == 0);
+
+    // A triangle: half of its bounding box
+    Canvas triangleCanvas(0);
+    RasterPath triangle;
+    triangle.MoveTo(10, 10);
+    triangle.LineTo(210, 10);
+    triangle.LineTo(10, 190);
+    raster.Begin(triangleCanvas.surface);
+    raster.Fill(triangle, 0xFF000000);
+    raster.Flush(nullptr);
+    EXPECT_TRUE(std::fabs(CoveredArea(triangleCanvas) - 200.0 * 180.0 / 2) < 2.0);
+}
+
+void TestStrokeAndOrder()
+{
+    TileRasterizer raster;
+    Canvas canvas;
+    RasterPath rect;
+    rect.MoveTo(60, 60);
+    rect.LineTo(140, 60);
+    rect.LineTo(140, 140);
+    rect.LineTo(60, 140);
+    rect.Close();
+    raster.Begin(canvas.surface);
+    raster.Fill(rect, 0xFF00FF00);
+    raster.Stroke(rect, 10.0f, 0xFFFF0000);
+    raster.Flush(nullptr);
+
+    // RGBA in memory: red is the low byte
+    EXPECT_TRUE(canvas.pixels[100 * WIDTH + 100] == 0xFF00FF00);
+    // The stroke is drawn over the fill, 5 pixels either side of the edge
+    EXPECT_TRUE(canvas.pixels[60 * WIDTH + 100] == 0xFF0000FF);
+    EXPECT_TRUE(canvas.pixels[63 * WIDTH + 100] == 0xFF0000FF);
+    EXPECT_TRUE(canvas.pixels[56 * WIDTH + 100] == 0xFF0000FF);
+    EXPECT_TRUE(canvas.pixels[66 * WIDTH + 100] == 0xFF00FF00);
+    EXPECT_TRUE(canvas.pixels[53 * WIDTH + 100] == 0xFFFFFFFF);
+    // Round join: the corner is cut on the diagonal
+    EXPECT_TRUE(canvas.pixels[57 * WIDTH + 57] == 0xFF0000FF);
+    EXPECT_TRUE(canvas.pixels[55 * WIDTH + 55] == 0xFFFFFFFF);
+}
+
+// Pseudo-random polygons over the whole surface, some off its edges
+void DrawScene(TileRasterizer& raster, const PixelSurface& surface, WorkStealingPool* pool)
+{
+    uint32_t seed = 12345;
+    auto next = [&seed](float range) {
+        seed = seed * 1664525u + 1013904223u;
+        return (seed >> 8) / static_cast<float>(1u << 24) * range;
+    };
+    raster.Begin(surface);
+    RasterPath path;
+    for (int i = 0; i < 40; i++) {
+        path.Reset();
+        path.MoveTo(next(WIDTH + 40) - 20, next(HEIGHT + 40) - 20);
+        int points = 3 + static_cast<int>(next(5));
+        for (int p = 1; p < points; p++) {
+            path.LineTo(next(WIDTH + 40) - 20, next(HEIGHT + 40) - 20);
+        }
+        path.Close();
+        uint32_t color = (static_cast<uint32_t>(64 + next(191)) << 24) | (static_cast<uint32_t>(next(16777216.0f)));
+        if (i % 3 == 0) {
+            raster.Stroke(path, 1 + next(12), color);
+        } else {
+            raster.Fill(path, color);
+        }
+    }
+    raster.Flush(pool);
+}
+
+void TestParallelMatchesSerial()
+{
+    TileRasterizer raster;
+    Canvas serial;
+    DrawScene(raster, serial.surface, nullptr);
+
+    WorkStealingPool pool(4);
+    for (int run = 0; run < 5; run++) {
+        Canvas parallel;
+        DrawScene(raster, parallel.surface, &pool);
+        EXPECT_TRUE(memcmp(serial.pixels.data(), parallel.pixels.data(), serial.pixels.size() * 4) == 0);
+    }
+
+    // BGRA swaps red and blue, nothing else
+    Canvas bgra;
+    bgra.surface.format = PixelFormat::BGRA_8888;
+    DrawScene(raster, bgra.surface, &pool);
+    bool swapped = true;
+    for (size_t i = 0; i < serial.pixels.size(); i++) {
+        uint32_t p = serial.pixels[i];
+        uint32_t expected = (p & 0xFF00FF00) | ((p & 0xFF) << 16) | ((p >> 16) & 0xFF);
+        swapped = swapped && (bgra.pixels[i] == expected);
+    }
+    EXPECT_TRUE(swapped);
+}
+
+void TestEmptyAndOffscreen()
+{
+    TileRasterizer raster;
+    Canvas canvas;
+    RasterPath path;
+    raster.Begin(canvas.surface);
+    raster.Fill(path, 0xFF000000);
+    path.MoveTo(-50, -50);
+    path.LineTo(-10, -50);
+    path.LineTo(-10, -10);
+    path.Close();
+    raster.Fill(path, 0xFF000000);
+    raster.Flush(nullptr);
+    EXPECT_TRUE(raster.GetLastTileCount() == 0);
+    bool untouched = std::all_of(canvas.pixels.begin(), canvas.pixels.end(), [](uint32_t p) {
+        return p == 0xFFFFFFFF;
+    });
+    EXPECT_TRUE(untouched);
+
+    // A vertex far off the surface still fills the part on it
+    Canvas far(0);
+    RasterPath wedge;
+    wedge.MoveTo(10, 10);
+    wedge.LineTo(1e20f, 10);
+    wedge.LineTo(100, 100);
+    wedge.LineTo(10, 100);
+    wedge.Close();
+    raster.Begin(far.surface);
+    raster.Fill(wedge, 0xFF000000);
+    raster.Flush(nullptr);
+    EXPECT_TRUE(raster.GetLastTileCount() > 0);
+    EXPECT_TRUE(far.pixels[50 * WIDTH + 50] == 0xFF000000);
+}
+
+} // namespace
+
+int main()
+{
+    TestPoolRunsEveryIndexOnce();
+    TestPoolConcurrentCallers();
+    TestFillCoverage();
+    TestStrokeAndOrder();
+    TestParallelMatchesSerial();
+    TestEmptyAndOffscreen();
+
+    return FinishTest("tile_raster_test");
+}
@@ -0,0 +1,223 @@
+/*
+ * Copyright (c) 2023 Your Organization
+ * Licensed under the Apache License, Version 2.0
+ */
+
+// Host-side checks for the touch ring: coalescing, prediction and the
+// hand-over between the input and render threads
+#include "render/touch_input.h"
+#include "test/test_check.h"
+#include <atomic>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+
+namespace {
+
+constexpr int64_t MS = 1000000;
+// 60 Hz
+constexpr int64_t LOOKAHEAD = 16 * MS;
+
+bool Near(float a, float b)
+{
+    return std::fabs(a - b) < 0.01f;
+}
+
+void TestMovesCoalescePerFrame()
+{
+    TouchInput input;
+    TouchFrame frame;
+    EXPECT_TRUE(!input.Collect(LOOKAHEAD, frame));
+    EXPECT_TRUE(frame.pointers.empty());
+
+    input.Push(TouchSample {7, TouchAction::DOWN, 10, 20, 0});
+    for (int i = 1; i <= 5; i++) {
+        input.Push(TouchSample {7, TouchAction::MOVE, 10.0f + i, 20, i * MS});
+    }
+    EXPECT_TRUE(input.Collect(LOOKAHEAD, frame));
+    EXPECT_TRUE(frame.pointers.size() == 1);
+    if (frame.pointers.size() == 1) {
+        const TouchPointer& pointer = frame.pointers[0];
+        EXPECT_TRUE((pointer.id == 7) && pointer.began && pointer.down && !pointer.cancelled);
+        EXPECT_TRUE(pointer.path.size() == 6);
+        EXPECT_TRUE(Near(pointer.path.back().x, 15));
+    }
+    // All five moves merge into the entry the DOWN started
+    EXPECT_TRUE(input.GetStats().coalesced == 5);
+    EXPECT_TRUE(input.GetStats().frames == 1);
+
+    // The next frame continues the stroke
+    input.Push(TouchSample {7, TouchAction::MOVE, 16, 20, 6 * MS});
+    input.Push(TouchSample {7, TouchAction::UP, 16, 20, 7 * MS});
+    EXPECT_TRUE(input.Collect(LOOKAHEAD, frame));
+    EXPECT_TRUE(frame.pointers.size() == 1);
+    if (frame.pointers.size() == 1) {
+        const TouchPointer& pointer = frame.pointers[0];
+        EXPECT_TRUE(!pointer.began && !pointer.down);
+        EXPECT_TRUE(pointer.path.size() == 1);
+        // Up: no prediction
+        EXPECT_TRUE(Near(pointer.predicted.x, 16) && Near(pointer.predicted.y, 20));
+    }
+    EXPECT_TRUE(!frame.predicting);
+
+    // Lifted: later moves for it are ignored
+    input.Push(TouchSample {7, TouchAction::MOVE, 30, 20, 8 * MS});
+    EXPECT_TRUE(!input.Collect(LOOKAHEAD, frame));
+}
+
+void TestPrediction()
+{
+    TouchInput input;
+    TouchFrame frame;
+    // 0.5 px/ms to the right, 0.25 px/ms down
+    input.Push(TouchSample {1, TouchAction::DOWN, 100, 100, 0});
+    for (int i = 1; i <= 8; i++) {
+        input.Push(TouchSample {1, TouchAction::MOVE, 100 + i * 4.0f, 100 + i * 2.0f, i * 8 * MS});
+    }
+    EXPECT_TRUE(input.Collect(LOOKAHEAD, frame));
+    EXPECT_TRUE(frame.predicting);
+    if (frame.pointers.size() == 1) {
+        const TouchPosition& last = frame.pointers[0].path.back();
+        const TouchPosition& predicted = frame.pointers[0].predicted;
+        EXPECT_TRUE(std::fabs(predicted.x - (last.x + 8)) < 0.1f);
+        EXPECT_TRUE(std::fabs(predicted.y - (last.y + 4)) < 0.1f);
+    }
+
+    // A fling is held to MAX_PREDICTION
+    input.Push(TouchSample {1, TouchAction::MOVE, 1000, 132, 72 * MS});
+    input.Push(TouchSample {1, TouchAction::MOVE, 2000, 132, 73 * MS});
+    EXPECT_TRUE(input.Collect(LOOKAHEAD, frame));
+    if (frame.pointers.size() == 1) {
+        const TouchPosition& predicted = frame.pointers[0].predicted;
+        EXPECT_TRUE(predicted.x > 2000);
+        EXPECT_TRUE(std::hypot(predicted.x - 2000, predicted.y - 132) <= TouchInput::MAX_PREDICTION + 0.01f);
+    }
+
+    // Once the finger stops, the prediction goes after a frame's grace
+    EXPECT_TRUE(!input.Collect(LOOKAHEAD, frame));
+    EXPECT_TRUE(frame.predicting);
+    EXPECT_TRUE(input.Collect(LOOKAHEAD, frame));
+    EXPECT_TRUE(!frame.predicting);
+    if (frame.pointers.size() == 1) {
+        EXPECT_TRUE(frame.pointers[0].path.empty() && frame.pointers[0].down);
+        EXPECT_TRUE(Near(frame.pointers[0].predicted.x, 2000) && Near(frame.pointers[0].predicted.y, 132));
+    }
+    EXPECT_TRUE(!input.Collect(LOOKAHEAD, frame));
+
+    // Another pointer reporting this one again, unmoved, does not slow it down
+    input.Push(TouchSample {1, TouchAction::MOVE, 2010, 132, 100 * MS});
+    input.Push(TouchSample {1, TouchAction::MOVE, 2020, 132, 110 * MS});
+    input.Push(TouchSample {1, TouchAction::MOVE, 2020, 132, 111 * MS});
+    EXPECT_TRUE(input.Collect(LOOKAHEAD, frame));
+    if (frame.pointers.size() == 1) {
+        EXPECT_TRUE(frame.pointers[0].path.size() == 2);
+        EXPECT_TRUE(frame.pointers[0].predicted.x > 2030);
+    }
+}
+
+void TestPointersAndStrokes()
+{
+    TouchInput input;
+    TouchFrame frame;
+    // Two fingers, and a quick double tap by a third within one frame
+    input.Push(TouchSample {1, TouchAction::DOWN, 0, 0, 0});
+    input.Push(TouchSample {2, TouchAction::DOWN, 50, 50, 0});
+    input.Push(TouchSample {3, TouchAction::DOWN, 90, 90, 0});
+    input.Push(TouchSample {3, TouchAction::UP, 90, 90, MS});
+    input.Push(TouchSample {3, TouchAction::DOWN, 95, 95, 2 * MS});
+    input.Push(TouchSample {1, TouchAction::MOVE, 5, 0, 2 * MS});
+    input.Push(TouchSample {2, TouchAction::CANCEL, 50, 50, 3 * MS});
+    EXPECT_TRUE(input.Collect(LOOKAHEAD, frame));
+    EXPECT_TRUE(frame.pointers.size() == 4);
+    if (frame.pointers.size() == 4) {
+        EXPECT_TRUE((frame.pointers[0].id == 1) && (frame.pointers[0].path.size() == 2));
+        EXPECT_TRUE((frame.pointers[1].id == 2) && frame.pointers[1].cancelled && !frame.pointers[1].down);
+        EXPECT_TRUE((frame.pointers[2].id == 3) && !frame.pointers[2].down);
+        EXPECT_TRUE((frame.pointers[3].id == 3) && frame.pointers[3].began && frame.pointers[3].down);
+    }
+
+    // No more than MAX_POINTERS at once
+    TouchInput crowded;
+    for (int32_t id = 0; id < 12; id++) {
+        crowded.Push(TouchSample {id, TouchAction::DOWN, 0, 0, 0});
+    }
+    EXPECT_TRUE(crowded.Collect(LOOKAHEAD, frame));
+    EXPECT_TRUE(frame.pointers.size() == TouchInput::MAX_POINTERS);
+    EXPECT_TRUE(crowded.GetStats().dropped == 2);
+}
+
+void TestRingFull()
+{
+    TouchInput input;
+    TouchFrame frame;
+    input.Push(TouchSample {1, TouchAction::DOWN, 0, 0, 0});
+    size_t accepted = 1;
+    for (int i = 1; i < 300; i++) {
+        accepted += input.Push(TouchSample {1, TouchAction::MOVE, static_cast<float>(i), 0, i * MS}) ? 1 : 0;
+    }
+    EXPECT_TRUE(accepted == TouchInput::RING_CAPACITY);
+    EXPECT_TRUE(input.GetStats().samples == 300);
+    EXPECT_TRUE(input.GetStats().dropped == 300 - TouchInput::RING_CAPACITY);
+    EXPECT_TRUE(input.Collect(LOOKAHEAD, frame));
+    EXPECT_TRUE((frame.pointers.size() == 1) && (frame.pointers[0].path.size() == TouchInput::RING_CAPACITY));
+    // Room again once drained
+    EXPECT_TRUE(input.Push(TouchSample {1, TouchAction::MOVE, 1000, 0, 1000 * MS}));
+}
+
+// The input thread pushes a stroke while the render thread collects frames:
+// every point arrives, in order
+void TestAcrossThreads()
+{
+    TouchInput input;
+    constexpr int moves = 20000;
+    std::atomic<bool> done {false};
+    std::thread producer([&] {
+        input.Push(TouchSample {1, TouchAction::DOWN, 0, 0, 0});
+        for (int i = 1; i <= moves; i++) {
+            while (!input.Push(TouchSample {1, TouchAction::MOVE, static_cast<float>(i), 0, i * MS})) {
+                std::this_thread::yield();
+            }
+        }
+        while (!input.Push(TouchSample {1, TouchAction::UP, static_cast<float>(moves), 0, (moves + 1) * MS})) {
+            std::this_thread::yield();
+        }
+        done.store(true);
+    });
+
+    TouchFrame frame;
+    float expected = 0;
+    bool ordered = true;
+    bool lifted = false;
+    while (!lifted) {
+        bool finished = done.load();
+        if (input.Collect(LOOKAHEAD, frame)) {
+            for (const TouchPointer& pointer : frame.pointers) {
+                for (const TouchPosition& position : pointer.path) {
+                    ordered = ordered && (position.x == expected);
+                    expected++;
+                }
+                lifted = lifted || !pointer.down;
+            }
+        } else if (finished) {
+            break;
+        }
+    }
+    producer.join();
+    EXPECT_TRUE(ordered);
+    EXPECT_TRUE(lifted);
+    EXPECT_TRUE(expected == moves + 1);
+}
+
+} // namespace
+
+int main()
+{
+    TestMovesCoalescePerFrame();
+    TestPrediction();
+    TestPointersAndStrokes();
+    TestRingFull();
+    TestAcrossThreads();
+
+    return FinishTest("touch_input_test");
+}
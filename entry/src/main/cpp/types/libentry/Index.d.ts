@@ -1,2 +1,80 @@
-
 export const add: (a: number, b: number) => number;
+
+// The methods below are defined on the exports an XComponent loads, bound to
+// that component's renderer.
+
+// Where a presented frame's time went, in microseconds
+export interface FrameTiming {
+  acquireUs: number;
+  prepareUs: number;
+  rasterUs: number;
+  blitUs: number;
+  flushUs: number;
+  totalUs: number;
+  // Waiting for a raster slot while other surfaces' frames drew; part of totalUs
+  slotUs: number;
+  renderPath: 'zero-copy' | 'staging';
+}
+
+export interface FramePercentiles {
+  p50Us: number;
+  p95Us: number;
+  p99Us: number;
+}
+
+export interface FrameStats {
+  // Presented frames the percentiles are over
+  sampled: number;
+  acquire: FramePercentiles;
+  prepare: FramePercentiles;
+  raster: FramePercentiles;
+  blit: FramePercentiles;
+  flush: FramePercentiles;
+  total: FramePercentiles;
+  slot: FramePercentiles;
+  presented: number;
+  // Presented later than a vsync period
+  late: number;
+  // Turned away by a full render queue, or never presented
+  dropped: number;
+  // Vsyncs passed up because the previous buffer was still in use
+  skipped: number;
+  // Vsyncs passed up on purpose, e.g. for a hidden surface
+  throttled: number;
+}
+
+export interface PathCacheStats {
+  hits: number;
+  misses: number;
+  evictions: number;
+  size: number;
+  capacity: number;
+}
+
+export interface LayerCacheStats {
+  builds: number;
+  composites: number;
+  invalidations: number;
+  layers: number;
+  bytes: number;
+}
+
+export const drawPattern: () => void;
+// label, if given, is the text drawn from this frame on
+export const drawText: (label?: string) => void;
+// Resolve once the frame is presented, reject if it is dropped
+export const drawPatternAsync: () => Promise<FrameTiming>;
+export const drawTextAsync: (label?: string) => Promise<FrameTiming>;
+// A serialized display list; false if it is malformed or the queue is full
+export const drawDisplayList: (list: ArrayBuffer) => boolean;
+// undefined while the component has no renderer
+export const getPathCacheStats: () => PathCacheStats | undefined;
+export const getLayerCacheStats: () => LayerCacheStats | undefined;
+export const setLayerCacheEnabled: (enabled: boolean) => void;
+export const invalidateLayers: () => void;
+export const getFrameStats: () => FrameStats | undefined;
+// 2 (double buffering) to 4
+export const setBuffersInFlight: (count: number) => void;
+// 0 (none) to 3 (high)
+export const setAaQuality: (level: number) => void;
+export const setVisible: (visible: boolean) => void;